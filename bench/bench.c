@@ -0,0 +1,552 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "LockFreeQueue.h"
+#include "kiss_fftr.h"
+
+#include "core/History.h"
+#include "core/colormap/colormap.h"
+#include "core/definitions.h"
+#include "core/intensity.h"
+#include "core/waveform.h"
+#include "dsp/filters.h"
+#include "dsp/large_fft.h"
+#include "dsp/partials.h"
+#include "dsp/window.h"
+#include "harness.h"
+
+#define MAX_RESULTS 64
+
+#if !defined(SPECTRE_BENCH_BUILD_TYPE)
+#define SPECTRE_BENCH_BUILD_TYPE "unknown"
+#endif
+
+static void* xcalloc(size_t n, size_t size)
+{
+    void* p = calloc(n, size);
+    if (p == NULL) {
+        fprintf(stderr, "oom\n");
+        exit(1);
+    }
+    return p;
+}
+
+// deterministic white-ish noise in [-1, 1), so every run sees the same data
+static void fill_noise(float* data, SizeType n)
+{
+    uint32_t state = 0x12345678u;
+    for (SizeType i = 0; i < n; ++i) {
+        state = state * 1664525u + 1013904223u;
+        data[i] = (float)(state >> 8) / (float)(1u << 23) - 1.0f;
+    }
+}
+
+// ---- kernels ---------------------------------------------------------------
+
+typedef struct {
+    float* data;
+    float* window;
+    SizeType size;
+} WindowCtx;
+
+static void bench_window_apply(void* ctx)
+{
+    WindowCtx* c = ctx;
+    window_apply(c->data, c->window, c->size);
+    bench_consume(c->data);
+}
+
+typedef struct {
+    OnePoleFilter filter;
+    float* data;
+    SizeType size;
+} FilterCtx;
+
+static void bench_hpf(void* ctx)
+{
+    FilterCtx* c = ctx;
+    filter_hpf_process(&c->filter, c->data, c->size);
+    bench_consume(c->data);
+}
+
+static void bench_lpf(void* ctx)
+{
+    FilterCtx* c = ctx;
+    filter_lpf_process(&c->filter, c->data, c->size);
+    bench_consume(c->data);
+}
+
+typedef struct {
+    kiss_fftr_cfg plan;
+    float* input;
+    kiss_fft_cpx* output;
+} FFTCtx;
+
+static void bench_kiss_fftr(void* ctx)
+{
+    FFTCtx* c = ctx;
+    kiss_fftr(c->plan, c->input, c->output);
+    bench_consume(c->output);
+}
+
+typedef struct {
+    LargeFFT* fft;
+    float* input;
+    kiss_fft_cpx* output;
+} LargeFFTCtx;
+
+static void bench_large_fft(void* ctx)
+{
+    LargeFFTCtx* c = ctx;
+    large_fft_process(c->fft, c->input, c->output);
+    bench_consume(c->output);
+}
+
+typedef struct {
+    FFTHistory history;
+    Complex* row;
+} HistoryCtx;
+
+static void bench_history_push(void* ctx)
+{
+    HistoryCtx* c = ctx;
+    fft_history_push(&c->history, c->row);
+    bench_consume(c->history.data);
+}
+
+typedef struct {
+    Complex* bins;
+    uint8_t (*pixels)[4];
+    SizeType n_bins;
+    float power_reference;
+} ColorCtx;
+
+// mirrors the per-column work of LinearSpectrogram
+static void bench_color_column(void* ctx)
+{
+    ColorCtx* c = ctx;
+    for (SizeType b = 0; b < c->n_bins; ++b) {
+        const float intensity =
+            intensity_from_bin(c->bins[b], c->power_reference, -60.0f);
+        memcpy(c->pixels[b], colormap_sample(plasma_rgba, intensity), 4);
+    }
+    bench_consume(c->pixels);
+}
+
+typedef struct {
+    LockFreeQueueProducer tx;
+    LockFreeQueueConsumer rx;
+    float* data;
+    SizeType size;
+} QueueCtx;
+
+// single-threaded round trip: measures the queue's own overhead, not the
+// cost of cache-line ping-pong between two cores
+static void bench_queue_round_trip(void* ctx)
+{
+    QueueCtx* c = ctx;
+    clfq_push_partial(&c->tx, c->data, c->size, 1);
+    clfq_pop(&c->rx, c->data, c->size);
+    bench_consume(c->data);
+}
+
+typedef struct {
+    WaveformPyramid pyramid;
+    float* data;
+    SizeType size;
+    uint64_t span;  // samples across the columns
+    SizeType columns;
+} WaveformCtx;
+
+static void bench_waveform_push(void* ctx)
+{
+    WaveformCtx* c = ctx;
+    waveform_pyramid_push(&c->pyramid, c->data, c->size);
+    bench_consume(&c->pyramid);
+}
+
+// mirrors the per-frame work of WaveformVisualizer, minus the drawing
+static void bench_waveform_columns(void* ctx)
+{
+    WaveformCtx* c = ctx;
+    const SizeType level =
+        waveform_pyramid_level_for((float)c->span / (float)c->columns);
+    const uint64_t end = c->pyramid.samples;
+    float sum = 0.0f;
+    for (SizeType col = 0; col < c->columns; ++col) {
+        const WaveformSpan s = waveform_pyramid_span(
+            &c->pyramid, level, end - c->span + c->span * col / c->columns,
+            end - c->span + c->span * (col + 1) / c->columns);
+        sum += s.max - s.min;
+    }
+    bench_consume(&sum);
+}
+
+typedef struct {
+    PartialTracker tracker;
+    Complex* rows;  // two frames a stride apart
+} PartialsCtx;
+
+// the same pair of rows over and over: every track continues, the steady
+// state of a held chord
+static void bench_partials(void* ctx)
+{
+    PartialsCtx* c = ctx;
+    const SizeType n_bins = c->tracker.n_bins;
+    partial_tracker_process(&c->tracker, c->rows + n_bins, c->rows);
+    bench_consume(c->tracker.points.hz);
+}
+
+// ---- driver ----------------------------------------------------------------
+
+typedef struct {
+    BenchConfig cfg;
+    const char* filter;  // substring match on the benchmark name, or NULL
+    BenchResult results[MAX_RESULTS];
+    SizeType n_results;
+} Bench;
+
+static void run(Bench* b,
+                const char* name,
+                uint64_t samples_per_call,
+                BenchFn fn,
+                void* ctx)
+{
+    if (b->filter != NULL && strstr(name, b->filter) == NULL) {
+        return;
+    }
+    if (b->n_results == MAX_RESULTS) {
+        fprintf(stderr, "too many benchmarks, bump MAX_RESULTS\n");
+        exit(1);
+    }
+
+    const BenchResult r = bench_run(&b->cfg, name, samples_per_call, fn, ctx);
+    bench_print(stdout, &r);
+    fflush(stdout);
+    b->results[b->n_results++] = r;
+}
+
+static void run_window(Bench* b)
+{
+    const SizeType n = FFT_SIZE;
+    WindowCtx ctx = {
+        .data = xcalloc(n, sizeof(float)),
+        .window = xcalloc(n, sizeof(float)),
+        .size = n,
+    };
+    // keep the data bounded: the same buffer is windowed over and over
+    for (SizeType i = 0; i < n; ++i) {
+        ctx.data[i] = 1.0f;
+        ctx.window[i] = 1.0f;
+    }
+    run(b, "window_apply/2048", n, bench_window_apply, &ctx);
+    free(ctx.data);
+    free(ctx.window);
+}
+
+static void run_filters(Bench* b)
+{
+    const SizeType n = FFT_SIZE / 2;  // one stride
+    FilterCtx ctx = {
+        .filter = filter_init(10.0f, 48000.0f),
+        .data = xcalloc(n, sizeof(float)),
+        .size = n,
+    };
+    fill_noise(ctx.data, n);
+    run(b, "filter_hpf_process/1024", n, bench_hpf, &ctx);
+    fill_noise(ctx.data, n);
+    run(b, "filter_lpf_process/1024", n, bench_lpf, &ctx);
+    free(ctx.data);
+}
+
+static void run_ffts(Bench* b)
+{
+    static char names[16][32];
+    SizeType k = 0;
+
+    for (SizeType n = 256; n <= 65536; n *= 2, ++k) {
+        FFTCtx ctx = {
+            .plan = kiss_fftr_alloc((int)n, 0, NULL, NULL),
+            .input = xcalloc(n, sizeof(float)),
+            .output = xcalloc(n / 2 + 1, sizeof(kiss_fft_cpx)),
+        };
+        if (ctx.plan == NULL) {
+            fprintf(stderr, "oom\n");
+            exit(1);
+        }
+        fill_noise(ctx.input, n);
+
+        snprintf(names[k], sizeof(names[k]), "kiss_fftr/%u", n);
+        run(b, names[k], n, bench_kiss_fftr, &ctx);
+
+        kiss_fftr_free(ctx.plan);
+        free(ctx.input);
+        free(ctx.output);
+    }
+}
+
+// past run_ffts: the frames FFT_LARGE_SIZE is about, inline and on every core
+static void run_large_ffts(Bench* b)
+{
+    static char names[8][32];
+    SizeType k = 0;
+    const SizeType threads = large_fft_default_threads();
+
+    for (SizeType n = 262144; n <= 1048576; n *= 4, k += 2) {
+        FFTCtx inline_ctx = {
+            .plan = kiss_fftr_alloc((int)n, 0, NULL, NULL),
+            .input = xcalloc(n, sizeof(float)),
+            .output = xcalloc(n / 2 + 1, sizeof(kiss_fft_cpx)),
+        };
+        LargeFFTCtx ctx = {
+            .fft = large_fft_new(n, threads),
+            .input = inline_ctx.input,
+            .output = inline_ctx.output,
+        };
+        if (inline_ctx.plan == NULL || ctx.fft == NULL) {
+            fprintf(stderr, "oom\n");
+            exit(1);
+        }
+        fill_noise(ctx.input, n);
+
+        snprintf(names[k], sizeof(names[k]), "kiss_fftr/%u", n);
+        run(b, names[k], n, bench_kiss_fftr, &inline_ctx);
+        snprintf(names[k + 1], sizeof(names[k + 1]), "large_fft/%u/%ut", n,
+                 threads);
+        run(b, names[k + 1], n, bench_large_fft, &ctx);
+
+        large_fft_free(ctx.fft);
+        kiss_fftr_free(inline_ctx.plan);
+        free(inline_ctx.input);
+        free(inline_ctx.output);
+    }
+}
+
+static void run_history(Bench* b)
+{
+    const SizeType n_bins = FFT_SIZE / 2;
+    HistoryCtx ctx = {
+        .history = fft_history_new(HISTORY_SIZE, n_bins),
+        .row = xcalloc(n_bins, sizeof(Complex)),
+    };
+    if (!fft_history_ok(&ctx.history)) {
+        fprintf(stderr, "oom\n");
+        exit(1);
+    }
+    run(b, "fft_history_push/1024", n_bins, bench_history_push, &ctx);
+    fft_history_free(&ctx.history);
+    free(ctx.row);
+}
+
+static void run_waveform(Bench* b)
+{
+    // ten minutes at 48 kHz, pushed a stride at a time
+    const uint64_t span = 600 * 48000;
+    WaveformCtx ctx = {
+        .pyramid = waveform_pyramid_new(span),
+        .data = xcalloc(FFT_SIZE / 2, sizeof(float)),
+        .size = FFT_SIZE / 2,
+        .columns = 1600,
+    };
+    if (!waveform_pyramid_ok(&ctx.pyramid)) {
+        fprintf(stderr, "oom\n");
+        exit(1);
+    }
+    fill_noise(ctx.data, ctx.size);
+    run(b, "waveform_pyramid_push/1024", ctx.size, bench_waveform_push, &ctx);
+
+    while (ctx.pyramid.samples < span) {
+        waveform_pyramid_push(&ctx.pyramid, ctx.data, ctx.size);
+    }
+    ctx.span = 10 * 48000;
+    run(b, "waveform_columns/10s", ctx.columns, bench_waveform_columns, &ctx);
+    ctx.span = span;
+    run(b, "waveform_columns/600s", ctx.columns, bench_waveform_columns, &ctx);
+
+    waveform_pyramid_free(&ctx.pyramid);
+    free(ctx.data);
+}
+
+static void run_partials(Bench* b)
+{
+    // 24 harmonics of 110 Hz over noise 60 dB down, two frames of it
+    const SizeType size = FFT_SIZE;
+    const SizeType stride = FFT_SIZE / 2;
+    const SizeType n_bins = size / 2;
+    const float rate = 48000.0f;
+    float* samples = xcalloc(size + stride, sizeof(float));
+    fill_noise(samples, size + stride);
+    for (SizeType i = 0; i < size + stride; ++i) {
+        samples[i] *= 1e-3f;
+        for (SizeType h = 1; h <= 24; ++h) {
+            samples[i] += sinf(2.0f * PI * 110.0f * (float)(h * i) / rate) /
+                          (float)h;
+        }
+    }
+
+    float* window = xcalloc(size, sizeof(float));
+    float* frame = xcalloc(size, sizeof(float));
+    kiss_fft_cpx* out = xcalloc(n_bins + 1, sizeof(kiss_fft_cpx));
+    kiss_fftr_cfg plan = kiss_fftr_alloc((int)size, 0, NULL, NULL);
+    PartialsCtx ctx = {
+        .rows = xcalloc(2 * n_bins, sizeof(Complex)),
+    };
+    window_make_hann(window, size);
+    for (SizeType r = 0; r < 2; ++r) {
+        memcpy(frame, samples + r * stride, size * sizeof(float));
+        window_apply(frame, window, size);
+        kiss_fftr(plan, frame, out);
+        memcpy(ctx.rows + r * n_bins, out + 1, n_bins * sizeof(Complex));
+    }
+
+    const PartialConfig cfg = {
+        .size = size,
+        .stride = stride,
+        .sample_rate = rate,
+        .power_reference = 0.25f * (float)(size * size),
+        .min_dB = -100.0f,
+        .threshold_dB = PARTIAL_THRESHOLD_DB,
+        .max_peaks = PARTIAL_MAX_PEAKS,
+        .cap = PARTIAL_MAX_PEAKS * HISTORY_SIZE,
+    };
+    ctx.tracker = partial_tracker_new(&cfg);
+    if (!partial_tracker_ok(&ctx.tracker)) {
+        fprintf(stderr, "oom\n");
+        exit(1);
+    }
+    run(b, "partials/1024", n_bins, bench_partials, &ctx);
+
+    partial_tracker_free(&ctx.tracker);
+    kiss_fftr_free(plan);
+    free(ctx.rows);
+    free(out);
+    free(frame);
+    free(window);
+    free(samples);
+}
+
+static void run_color(Bench* b)
+{
+    const SizeType n_bins = FFT_SIZE / 2;
+    ColorCtx ctx = {
+        .bins = xcalloc(n_bins, sizeof(Complex)),
+        .pixels = xcalloc(n_bins, 4),
+        .n_bins = n_bins,
+        .power_reference = 0.25f * (float)(FFT_SIZE * FFT_SIZE),
+    };
+    // spread the bins over the whole dynamic range so every branch is taken
+    float* noise = xcalloc(2 * n_bins, sizeof(float));
+    fill_noise(noise, 2 * n_bins);
+    for (SizeType i = 0; i < n_bins; ++i) {
+        const float scale = (float)FFT_SIZE * (float)(i % 64) / 64.0f;
+        ctx.bins[i] = scale * noise[2 * i] + scale * noise[2 * i + 1] * I;
+    }
+    free(noise);
+
+    run(b, "intensity_color/1024", n_bins, bench_color_column, &ctx);
+    free(ctx.bins);
+    free(ctx.pixels);
+}
+
+static void run_queue(Bench* b)
+{
+    LockFreeQueue* queue = xcalloc(1, sizeof(*queue));
+    clfq_new(queue);
+
+    const SizeType n = FFT_SIZE / 2;
+    QueueCtx ctx = {
+        .tx = clfq_producer(queue),
+        .rx = clfq_consumer(queue),
+        .data = xcalloc(n, sizeof(float)),
+        .size = n,
+    };
+    run(b, "clfq_push_pop/1024", n, bench_queue_round_trip, &ctx);
+    free(ctx.data);
+    free(queue);
+}
+
+static void write_json(const Bench* b, const char* path)
+{
+    FILE* f = fopen(path, "w");
+    if (f == NULL) {
+        fprintf(stderr, "failed to open %s\n", path);
+        exit(1);
+    }
+
+    fprintf(f, "{\n  \"build_type\": \"%s\",\n", SPECTRE_BENCH_BUILD_TYPE);
+    fprintf(f, "  \"warmup\": %u,\n  \"reps\": %u,\n", b->cfg.warmup,
+            b->cfg.reps);
+    fprintf(f, "  \"results\": [\n");
+    for (SizeType i = 0; i < b->n_results; ++i) {
+        fprintf(f, "    ");
+        bench_print_json(f, &b->results[i]);
+        fprintf(f, "%s\n", (i + 1 < b->n_results) ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+
+    if (fclose(f) != 0) {
+        fprintf(stderr, "failed to write %s\n", path);
+        exit(1);
+    }
+}
+
+static void usage_and_exit(void)
+{
+    fprintf(stderr,
+            "Usage: spectre_bench [--json <output>] [--reps <n>] [filter]\n");
+    exit(1);
+}
+
+int main(int ac, char* av[])
+{
+    static Bench b = {
+        .cfg =
+            {
+                .warmup = 64,
+                .reps = 31,
+                .min_batch_ns = 2000000,  // 2 ms
+            },
+        .filter = NULL,
+        .n_results = 0,
+    };
+    const char* json_path = NULL;
+
+    for (int i = 1; i < ac; ++i) {
+        if (strcmp(av[i], "--json") == 0 && i + 1 < ac) {
+            json_path = av[++i];
+        } else if (strcmp(av[i], "--reps") == 0 && i + 1 < ac) {
+            const int reps = atoi(av[++i]);
+            if (reps <= 0) {
+                usage_and_exit();
+            }
+            b.cfg.reps = (uint32_t)reps;
+        } else if (av[i][0] == '-') {
+            usage_and_exit();
+        } else {
+            b.filter = av[i];
+        }
+    }
+
+    if (strcmp(SPECTRE_BENCH_BUILD_TYPE, "Release") != 0) {
+        fprintf(stderr, "warning: %s build, numbers are not representative\n",
+                SPECTRE_BENCH_BUILD_TYPE);
+    }
+
+    run_window(&b);
+    run_filters(&b);
+    run_ffts(&b);
+    run_large_ffts(&b);
+    run_history(&b);
+    run_waveform(&b);
+    run_partials(&b);
+    run_color(&b);
+    run_queue(&b);
+
+    if (json_path != NULL) {
+        write_json(&b, json_path);
+    }
+
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include "harness.h"
+
+#include <stdlib.h>
+
+#include "trace/clock.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_CYCLES 1
+static uint64_t bench_cycles(void)
+{
+    return __rdtsc();
+}
+#else
+#define BENCH_HAS_CYCLES 0
+static uint64_t bench_cycles(void)
+{
+    return 0;
+}
+#endif
+
+static volatile uintptr_t s_sink;
+
+void bench_consume(const void* p)
+{
+    s_sink ^= (uintptr_t)p;
+}
+
+static void run_batch(BenchFn fn, void* ctx, uint64_t inner)
+{
+    for (uint64_t i = 0; i < inner; ++i) {
+        fn(ctx);
+    }
+}
+
+static int compare_double(const void* a, const void* b)
+{
+    const double x = *(const double*)a;
+    const double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// doubles the batch size until one batch lasts long enough
+static uint64_t calibrate_inner(const BenchConfig* cfg, BenchFn fn, void* ctx)
+{
+    uint64_t inner = 1;
+    for (;;) {
+        const uint64_t t0 = clock_now_ns();
+        run_batch(fn, ctx, inner);
+        const uint64_t elapsed = clock_now_ns() - t0;
+
+        if (elapsed >= cfg->min_batch_ns || inner >= (1ull << 30)) {
+            return inner;
+        }
+        inner *= 2;
+    }
+}
+
+BenchResult bench_run(const BenchConfig* cfg,
+                      const char* name,
+                      uint64_t samples_per_call,
+                      BenchFn fn,
+                      void* ctx)
+{
+    run_batch(fn, ctx, cfg->warmup);
+    const uint64_t inner = calibrate_inner(cfg, fn, ctx);
+
+    double* ns = malloc(cfg->reps * sizeof(*ns));
+    if (ns == NULL) {
+        fprintf(stderr, "oom\n");
+        exit(1);
+    }
+
+    double min_cycles = -1.0;
+    for (uint32_t r = 0; r < cfg->reps; ++r) {
+        const uint64_t c0 = bench_cycles();
+        const uint64_t t0 = clock_now_ns();
+        run_batch(fn, ctx, inner);
+        const uint64_t t1 = clock_now_ns();
+        const uint64_t c1 = bench_cycles();
+
+        ns[r] = (double)(t1 - t0) / (double)inner;
+
+        if (BENCH_HAS_CYCLES) {
+            const double cycles = (double)(c1 - c0) / (double)inner;
+            if (min_cycles < 0.0 || cycles < min_cycles) {
+                min_cycles = cycles;
+            }
+        }
+    }
+
+    qsort(ns, cfg->reps, sizeof(*ns), compare_double);
+    const BenchResult result = {
+        .name = name,
+        .samples_per_call = samples_per_call,
+        .inner = inner,
+        .min_ns = ns[0],
+        .median_ns = ns[cfg->reps / 2],
+        .min_cycles = min_cycles,
+    };
+    free(ns);
+
+    return result;
+}
+
+void bench_print(FILE* f, const BenchResult* r)
+{
+    const double n = (double)r->samples_per_call;
+    fprintf(f, "%-28s min %12.1f ns  median %12.1f ns  %8.3f ns/sample",
+            r->name, r->min_ns, r->median_ns, r->min_ns / n);
+    if (r->min_cycles >= 0.0) {
+        fprintf(f, "  %8.3f cycles/sample", r->min_cycles / n);
+    }
+    fprintf(f, "\n");
+}
+
+void bench_print_json(FILE* f, const BenchResult* r)
+{
+    const double n = (double)r->samples_per_call;
+    fprintf(f,
+            "{\"name\": \"%s\", \"samples_per_call\": %llu, \"inner\": %llu, "
+            "\"min_ns\": %.3f, \"median_ns\": %.3f, \"ns_per_sample\": %.6f, ",
+            r->name, (unsigned long long)r->samples_per_call,
+            (unsigned long long)r->inner, r->min_ns, r->median_ns,
+            r->min_ns / n);
+    if (r->min_cycles >= 0.0) {
+        fprintf(f, "\"cycles_per_sample\": %.6f}", r->min_cycles / n);
+    } else {
+        fprintf(f, "\"cycles_per_sample\": null}");
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// minimal micro-benchmark harness
+//
+// a kernel is run `warmup` times untimed, then `reps` timed batches of
+// `inner` calls each. `inner` is calibrated so a batch lasts at least
+// `min_batch_ns`, which keeps clock granularity out of the numbers
+//
+// min is the best estimate of the kernel's cost, median tells how noisy the
+// machine was. cycles come from the TSC on x86 and are not available elsewhere
+
+typedef void (*BenchFn)(void* ctx);
+
+typedef struct {
+    uint32_t warmup;
+    uint32_t reps;
+    uint64_t min_batch_ns;
+} BenchConfig;
+
+typedef struct {
+    const char* name;
+    uint64_t samples_per_call;  // normalization unit, e.g. the FFT size
+    uint64_t inner;
+    double min_ns;     // per call
+    double median_ns;  // per call
+    double min_cycles;  // per call, < 0 if unavailable
+} BenchResult;
+
+BenchResult bench_run(const BenchConfig* cfg,
+                      const char* name,
+                      uint64_t samples_per_call,
+                      BenchFn fn,
+                      void* ctx);
+
+// human readable, one line
+void bench_print(FILE* f, const BenchResult* r);
+
+// JSON object for a single result, no trailing comma or newline
+void bench_print_json(FILE* f, const BenchResult* r);
+
+// defeats dead-code elimination of benchmarked results
+void bench_consume(const void* p);
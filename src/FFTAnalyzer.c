@@ -1,31 +1,197 @@
 #include "FFTAnalyzer.h"
 
-#include <stdlib.h>
+#include <math.h>
 #include <string.h>
 
 #include "dsp/window.h"
+#include "trace/clock.h"
+#include "trace/trace.h"
 
-FFTAnalyzer fft_analyzer_new(const FFTConfig* cfg, LockFreeQueueConsumer rx)
+SizeType fft_decimation_for(float sample_rate)
+{
+    // clamped as a float, the cast of anything out of range is undefined
+    const float factor = sample_rate / FFT_MIN_ANALYSIS_RATE;
+    if (!(factor > 1.0f)) {
+        return 1;
+    }
+    return factor < (float)RESAMPLER_MAX_FACTOR ? (SizeType)factor
+                                                : RESAMPLER_MAX_FACTOR;
+}
+
+// raw samples popped at once before decimation: at most a stride, or a
+// single decimator step when that's longer
+static SizeType fft_raw_size(const FFTConfig* cfg)
 {
-    // TODO: allocations can fail
-    float* input = calloc(cfg->size, sizeof(float));
-    float* buffer = calloc(cfg->size, sizeof(float));
-    float* window = malloc(cfg->size * sizeof(float));
+    return cfg->decimation > cfg->stride ? cfg->decimation : cfg->stride;
+}
+
+// everything the analyzer carves from its arena for a configuration, in
+// the order it's carved: the buffers touched on every hop come first, next
+// to each other, then the plan and the histories
+static size_t fft_analyzer_footprint(const FFTConfig* cfg, size_t plan_size)
+{
+    const SizeType n_bins = cfg->size / 2;
+    const size_t frame = cfg->size * sizeof(float);
+    const size_t ring = cfg->history_size * sizeof(float);
+
+    size_t footprint = 0;
+    footprint += arena_footprint(frame);  // input
+    footprint += arena_footprint(frame);  // buffer
+    footprint += arena_footprint((1 + n_bins) * sizeof(kiss_fft_cpx));
+    footprint += arena_footprint(frame);  // window
+    footprint += arena_footprint(n_bins * sizeof(float));  // merge_power
+    if (cfg->decimation > 1) {
+        footprint += arena_footprint(fft_raw_size(cfg) * sizeof(float));
+    }
+    if (cfg->stereo) {
+        const size_t spectrum = cfg->size * sizeof(kiss_fft_cpx);
+        footprint += arena_footprint(frame);  // side.input
+        footprint += arena_footprint((1 + n_bins) * sizeof(kiss_fft_cpx));
+        footprint += arena_footprint(spectrum);  // stereo_buffer
+        footprint += arena_footprint(spectrum);  // stereo_spectrum
+        if (cfg->decimation > 1) {
+            footprint += arena_footprint(fft_raw_size(cfg) * sizeof(float));
+        }
+    }
+    footprint += arena_footprint(plan_size);  // 0 with cfg->threads
+    footprint += arena_footprint(sizeof(Complex) * cfg->history_size * n_bins);
+    if (cfg->features) {
+        footprint += 5 * arena_footprint(ring);
+    }
+    if (cfg->pitch) {
+        footprint += 2 * arena_footprint(ring);
+    }
+    return footprint;
+}
+
+// takes ownership of `arena`, which only grows if cfg needs more room
+static FFTAnalyzer fft_analyzer_new_in(const FFTConfig* cfg,
+                                       LockFreeQueueConsumer rx,
+                                       Arena arena)
+{
+    // the workers have their own plan
+    const bool threaded = cfg->threads > 1;
+    if (threaded && cfg->stereo) {
+        return (FFTAnalyzer){.cfg = *cfg, .rx = rx};
+    }
+
+    // only sizes it; stereo takes a complex plan instead
+    size_t plan_size = 0;
+    if (cfg->stereo) {
+        kiss_fft_alloc((int)cfg->size, 0, NULL, &plan_size);
+    } else if (!threaded) {
+        kiss_fftr_alloc((int)cfg->size, 0, NULL, &plan_size);
+    }
+
+    if (!arena_reset(&arena, fft_analyzer_footprint(cfg, plan_size))) {
+        return (FFTAnalyzer){.cfg = *cfg, .rx = rx};
+    }
+
+    const SizeType n_bins = cfg->size / 2;  // ditch DC
+    const size_t frame = cfg->size * sizeof(float);
+    const size_t ring = cfg->history_size * sizeof(float);
+
+    float* input = arena_push_zero(&arena, frame);
+    float* buffer = arena_push_zero(&arena, frame);
+    kiss_fft_cpx* output =
+        arena_push(&arena, (1 + n_bins) * sizeof(kiss_fft_cpx));
+    float* window = arena_push(&arena, frame);
     window_make_hann(window, cfg->size);
+    float* merge_power = arena_push_zero(&arena, n_bins * sizeof(float));
 
     const float power_reference = window_power_reference(window, cfg->size);
 
-    kiss_fft_cpx* output = malloc((1 + cfg->size / 2) * sizeof(kiss_fft_cpx));
-    kiss_fftr_cfg plan = kiss_fftr_alloc((int)cfg->size, 0, NULL, NULL);
+    const SizeType decimation = cfg->decimation > 1 ? cfg->decimation : 1;
 
-    const SizeType n_bins = cfg->size / 2;  // ditch DC
-    FFTHistory history = fft_history_new(cfg->history_size, n_bins);
+    // the DC blocker runs after decimation
+    OnePoleFilter dc_blocker = filter_init(
+        cfg->dc_blocker_frequency, cfg->sample_rate / (float)decimation);
 
-    OnePoleFilter dc_blocker =
-        filter_init(cfg->dc_blocker_frequency, cfg->sample_rate);
+    Resampler decimator = {0};
+    float* raw = NULL;
+    if (decimation > 1) {
+        decimator = resampler_new(1, decimation, fft_raw_size(cfg));
+        raw = arena_push(&arena, fft_raw_size(cfg) * sizeof(float));
+    }
+
+    float* side_input = NULL;
+    kiss_fft_cpx* side_output = NULL;
+    kiss_fft_cpx* stereo_buffer = NULL;
+    kiss_fft_cpx* stereo_spectrum = NULL;
+    float* side_raw = NULL;
+    Resampler side_decimator = {0};
+    if (cfg->stereo) {
+        const size_t spectrum = cfg->size * sizeof(kiss_fft_cpx);
+        side_input = arena_push_zero(&arena, frame);
+        side_output = arena_push(&arena, (1 + n_bins) * sizeof(kiss_fft_cpx));
+        stereo_buffer = arena_push(&arena, spectrum);
+        stereo_spectrum = arena_push(&arena, spectrum);
+        if (decimation > 1) {
+            side_decimator = resampler_new(1, decimation, fft_raw_size(cfg));
+            side_raw = arena_push(&arena, fft_raw_size(cfg) * sizeof(float));
+        }
+    }
+
+    kiss_fftr_cfg plan = NULL;
+    kiss_fft_cfg stereo_plan = NULL;
+    LargeFFT* large = NULL;
+    if (threaded) {
+        large = large_fft_new(cfg->size, cfg->threads);
+    } else if (cfg->stereo) {
+        stereo_plan = kiss_fft_alloc((int)cfg->size, 0,
+                                     arena_push(&arena, plan_size), &plan_size);
+    } else {
+        plan = kiss_fftr_alloc((int)cfg->size, 0,
+                               arena_push(&arena, plan_size), &plan_size);
+    }
+
+    FFTHistory history = fft_history_from(
+        arena_push(&arena, sizeof(Complex) * cfg->history_size * n_bins),
+        cfg->history_size, n_bins);
+
+    SpectralFeatureExtractor extractor = {0};
+    FloatHistory centroid = {0};
+    FloatHistory bandwidth = {0};
+    FloatHistory rolloff = {0};
+    FloatHistory flatness = {0};
+    FloatHistory flux = {0};
+    if (cfg->features) {
+        // levels below -80 dB of a full-scale sine are all the same silence
+        const float bin_hz =
+            cfg->sample_rate / (float)decimation / (float)cfg->size;
+        extractor =
+            spectral_features_new(n_bins, bin_hz, 1e-8f * power_reference);
+        const SizeType cap = cfg->history_size;
+        centroid = fhistory_from(arena_push(&arena, ring), cap);
+        bandwidth = fhistory_from(arena_push(&arena, ring), cap);
+        rolloff = fhistory_from(arena_push(&arena, ring), cap);
+        flatness = fhistory_from(arena_push(&arena, ring), cap);
+        flux = fhistory_from(arena_push(&arena, ring), cap);
+    }
+
+    PitchTracker pitch_tracker = {0};
+    FloatHistory f0 = {0};
+    FloatHistory clarity = {0};
+    if (cfg->pitch) {
+        const float rate = cfg->sample_rate / (float)decimation;
+        const SizeType size = pitch_frame_size_for(rate, PITCH_MIN_HZ);
+        pitch_tracker = pitch_tracker_new(size < cfg->size ? size : cfg->size,
+                                          rate, PITCH_MIN_HZ, PITCH_MAX_HZ);
+        f0 = fhistory_from(arena_push(&arena, ring), cfg->history_size);
+        clarity = fhistory_from(arena_push(&arena, ring), cfg->history_size);
+    }
+
+    StereoMeter stereo = {0};
+    if (cfg->stereo) {
+        const float rate = cfg->sample_rate / (float)decimation;
+        stereo = stereo_meter_new(n_bins, rate / (float)cfg->size,
+                                  rate / (float)cfg->stride,
+                                  cfg->history_size);
+    }
 
     return (FFTAnalyzer){
         .cfg = *cfg,
+        .arena = arena,
         .plan = plan,
         .input = input,
         .output = output,
@@ -36,48 +202,505 @@ FFTAnalyzer fft_analyzer_new(const FFTConfig* cfg, LockFreeQueueConsumer rx)
         .history = history,
         .dc_blocker = dc_blocker,
         .rx = rx,
+        .decimator = decimator,
+        .raw = raw,
+        .pending = 0,
+        .taps = {{0}},
+        .n_taps = 0,
+        .extractor = extractor,
+        .features = {
+            .centroid = centroid,
+            .bandwidth = bandwidth,
+            .rolloff = rolloff,
+            .flatness = flatness,
+            .flux = flux,
+        },
+        .pitch_tracker = pitch_tracker,
+        .row_pitch = {0},
+        .pitch = {
+            .f0 = f0,
+            .clarity = clarity,
+        },
+        .side = {
+            .rx = {0},
+            .attached = false,
+            .input = side_input,
+            .raw = side_raw,
+            .decimator = side_decimator,
+            .dc_blocker = dc_blocker,
+            .output = side_output,
+        },
+        .stereo_plan = stereo_plan,
+        .stereo_buffer = stereo_buffer,
+        .stereo_spectrum = stereo_spectrum,
+        .stereo = stereo,
+        .large = large,
+        .in_flight = false,
+        .merge = 1,
+        .merge_pooling = POOL_MEAN,
+        .merge_power = merge_power,
+        .merged = 0,
+        .phase_rows = 0,
+        .frames = 0,
     };
 }
 
+FFTAnalyzer fft_analyzer_new(const FFTConfig* cfg, LockFreeQueueConsumer rx)
+{
+    return fft_analyzer_new_in(cfg, rx, (Arena){0});
+}
+
+FFTAnalyzer fft_analyzer_reconfigure(FFTAnalyzer* analyzer,
+                                     const FFTConfig* cfg)
+{
+    // the workers may still be writing into the arena
+    if (analyzer->in_flight) {
+        large_fft_wait(analyzer->large);
+    }
+
+    Arena arena = analyzer->arena;
+    analyzer->arena = (Arena){0};
+
+    FFTAnalyzer next = fft_analyzer_new_in(cfg, analyzer->rx, arena);
+    memcpy(next.taps, analyzer->taps, sizeof(next.taps));
+    next.n_taps = analyzer->n_taps;
+    next.side.rx = analyzer->side.rx;
+    next.side.attached = analyzer->side.attached;
+
+    fft_analyzer_free(analyzer);
+    return next;
+}
+
+bool fft_analyzer_ok(const FFTAnalyzer* analyzer)
+{
+    if (!analyzer) {
+        return false;
+    }
+
+    const bool decimated = analyzer->cfg.decimation > 1;
+    const bool decimator_ok =
+        !decimated || (resampler_ok(&analyzer->decimator) && analyzer->raw);
+    const bool features_ok =
+        !analyzer->cfg.features ||
+        (spectral_features_ok(&analyzer->extractor) &&
+         analyzer->features.centroid.data &&
+         analyzer->features.bandwidth.data &&
+         analyzer->features.rolloff.data &&
+         analyzer->features.flatness.data && analyzer->features.flux.data);
+
+    const bool pitch_ok =
+        !analyzer->cfg.pitch ||
+        (pitch_tracker_ok(&analyzer->pitch_tracker) &&
+         analyzer->pitch.f0.data && analyzer->pitch.clarity.data);
+
+    const bool stereo_ok =
+        !analyzer->cfg.stereo ||
+        (analyzer->stereo_plan && analyzer->side.input &&
+         analyzer->side.output && analyzer->stereo_buffer &&
+         analyzer->stereo_spectrum && stereo_meter_ok(&analyzer->stereo) &&
+         (!decimated ||
+          (resampler_ok(&analyzer->side.decimator) && analyzer->side.raw)));
+
+    const bool fft_ok = analyzer->cfg.threads > 1 ? analyzer->large != NULL
+                        : analyzer->cfg.stereo    ? true
+                                                  : analyzer->plan != NULL;
+
+    return arena_ok(&analyzer->arena) && fft_ok && analyzer->input &&
+           analyzer->buffer && analyzer->window && analyzer->output &&
+           analyzer->merge_power &&
+           fft_history_ok(&analyzer->history) && decimator_ok &&
+           features_ok && pitch_ok && stereo_ok;
+}
+
 void fft_analyzer_free(FFTAnalyzer* analyzer)
 {
     if (!analyzer) {
         return;
     }
 
-    kiss_fftr_free(analyzer->plan);
-    free(analyzer->input);
-    free(analyzer->output);
-    free(analyzer->buffer);
-    free(analyzer->window);
-    fft_history_free(&analyzer->history);
+    // waits for a frame in flight, which writes into the arena
+    large_fft_free(analyzer->large);
+    analyzer->large = NULL;
+    analyzer->in_flight = false;
+
+    // the plan, buffers and histories all live in the arena
+    arena_free(&analyzer->arena);
+    resampler_free(&analyzer->decimator);
+    spectral_features_free(&analyzer->extractor);
+    pitch_tracker_free(&analyzer->pitch_tracker);
+    resampler_free(&analyzer->side.decimator);
+    stereo_meter_free(&analyzer->stereo);
+}
+
+void fft_analyzer_attach_side(FFTAnalyzer* analyzer,
+                              LockFreeQueueConsumer side_rx)
+{
+    analyzer->side.rx = side_rx;
+    analyzer->side.attached = true;
+}
+
+bool fft_analyzer_add_tap(FFTAnalyzer* analyzer, FFTSampleTap tap, void* ctx)
+{
+    if (analyzer->n_taps == FFT_MAX_TAPS) {
+        return false;
+    }
+
+    analyzer->taps[analyzer->n_taps].fn = tap;
+    analyzer->taps[analyzer->n_taps].ctx = ctx;
+    ++analyzer->n_taps;
+    return true;
+}
+
+void fft_analyzer_set_merge(FFTAnalyzer* analyzer,
+                            SizeType merge,
+                            RowPooling pooling)
+{
+    analyzer->merge = merge > 1 ? merge : 1;
+    analyzer->merge_pooling = pooling;
+}
+
+float fft_analyzer_sample_rate(const FFTAnalyzer* analyzer)
+{
+    return fft_config_sample_rate(&analyzer->cfg);
+}
+
+float fft_config_sample_rate(const FFTConfig* cfg)
+{
+    const SizeType decimation = cfg->decimation > 1 ? cfg->decimation : 1;
+    return cfg->sample_rate / (float)decimation;
+}
+
+// the side samples that go with `size` mid samples just popped, silence
+// until a side channel is attached
+static void fft_analyzer_pop_side(FFTAnalyzer* analyzer,
+                                  float* side,
+                                  SizeType size)
+{
+    if (!analyzer->side.attached ||
+        !clfq_pop(&analyzer->side.rx, side, size)) {
+        memset(side, 0, size * sizeof(float));
+    }
+}
+
+// DC blocks a block of fresh samples at input + at, then hands it to the
+// taps while it's still in cache
+static void fft_analyzer_take(FFTAnalyzer* analyzer, SizeType at, SizeType n)
+{
+    {
+        // remove DC information from incoming slice
+        TRACE_SCOPE(TRACE_DC_BLOCKER);
+        filter_hpf_process(&analyzer->dc_blocker, analyzer->input + at, n);
+        if (analyzer->cfg.stereo) {
+            filter_hpf_process(&analyzer->side.dc_blocker,
+                               analyzer->side.input + at, n);
+        }
+    }
+
+    for (SizeType t = 0; t < analyzer->n_taps; ++t) {
+        analyzer->taps[t].fn(analyzer->taps[t].ctx, analyzer->input + at, n);
+    }
+}
+
+// the next block of at most `missing` fresh samples at input + at, either
+// straight from the queue or through the decimator; returns how many, 0
+// once the queue can't complete a block
+//
+// the decimator is fed whole multiples of its factor, so each pop of
+// k * decimation raw samples yields exactly k inputs; a pop never asks for
+// more than fft_raw_size raw samples, a single step when the factor is
+// longer than a stride, which RESAMPLER_MAX_FACTOR keeps within the queue
+static SizeType fft_analyzer_pop(FFTAnalyzer* analyzer,
+                                 SizeType at,
+                                 SizeType missing)
+{
+    const SizeType stride = analyzer->cfg.stride;
+    const SizeType block = stride < FFT_TAP_BLOCK ? stride : FFT_TAP_BLOCK;
+
+    if (analyzer->raw == NULL) {
+        const SizeType k = missing < block ? missing : block;
+        TRACE_SCOPE(TRACE_QUEUE_POP);
+        if (!clfq_pop(&analyzer->rx, analyzer->input + at, k)) {
+            return 0;
+        }
+        if (analyzer->cfg.stereo) {
+            fft_analyzer_pop_side(analyzer, analyzer->side.input + at, k);
+        }
+        return k;
+    }
+
+    const SizeType decimation = analyzer->cfg.decimation;
+    const SizeType per_pop = block / decimation > 0 ? block / decimation : 1;
+    const SizeType k = missing < per_pop ? missing : per_pop;
+
+    {
+        TRACE_SCOPE(TRACE_QUEUE_POP);
+        if (!clfq_pop(&analyzer->rx, analyzer->raw, k * decimation)) {
+            return 0;
+        }
+        if (analyzer->cfg.stereo) {
+            fft_analyzer_pop_side(analyzer, analyzer->side.raw,
+                                  k * decimation);
+        }
+    }
+
+    TRACE_SCOPE(TRACE_DECIMATE);
+    if (analyzer->cfg.stereo) {
+        // both decimators have seen as many samples, so they yield as many
+        resampler_process(&analyzer->side.decimator, analyzer->side.raw,
+                          k * decimation, analyzer->side.input + at);
+    }
+    return resampler_process(&analyzer->decimator, analyzer->raw,
+                             k * decimation, analyzer->input + at);
+}
+
+// fills the stride worth of fresh samples at input + to_keep a block at a
+// time, each block going through fft_analyzer_take as soon as it's in, so
+// the taps lag the queue by a block rather than a hop; `pending` counts
+// the samples in so far and carries over when the queue runs dry
+static bool fft_analyzer_fill(FFTAnalyzer* analyzer,
+                              SizeType to_keep,
+                              SizeType to_read)
+{
+    while (analyzer->pending < to_read) {
+        const SizeType at = to_keep + analyzer->pending;
+        const SizeType n =
+            fft_analyzer_pop(analyzer, at, to_read - analyzer->pending);
+        if (n == 0) {
+            return false;
+        }
+        fft_analyzer_take(analyzer, at, n);
+        analyzer->pending += n;
+    }
+
+    analyzer->pending = 0;
+    return true;
+}
+
+// pools the power of `output` into merge_power; once `merge` frames are in,
+// `output` is overwritten with their magnitudes and true is returned
+static bool fft_analyzer_merge(FFTAnalyzer* analyzer)
+{
+    const float* re_im = (const float*)(analyzer->output + 1);
+    float* power = analyzer->merge_power;
+    const size_t n_bins = analyzer->n_bins;
+
+    // the first frame of a row overwrites whatever the last row left
+    if (analyzer->merge_pooling == POOL_MAX && analyzer->merged > 0) {
+        for (size_t b = 0; b < n_bins; ++b) {
+            const float re = re_im[2 * b];
+            const float im = re_im[2 * b + 1];
+            power[b] = fmaxf(power[b], re * re + im * im);
+        }
+    } else {
+        const float keep = analyzer->merged > 0 ? 1.0f : 0.0f;
+        for (size_t b = 0; b < n_bins; ++b) {
+            const float re = re_im[2 * b];
+            const float im = re_im[2 * b + 1];
+            power[b] = keep * power[b] + re * re + im * im;
+        }
+    }
+
+    if (++analyzer->merged < analyzer->merge) {
+        return false;
+    }
+
+    const float scale = analyzer->merge_pooling == POOL_MAX
+                            ? 1.0f
+                            : 1.0f / (float)analyzer->merged;
+    kiss_fft_cpx* bins = analyzer->output + 1;
+    for (size_t b = 0; b < n_bins; ++b) {
+        bins[b] = (kiss_fft_cpx){.r = sqrtf(scale * power[b]), .i = 0.0f};
+    }
+    analyzer->merged = 0;
+    return true;
+}
+
+// one complex FFT of z = w (mid + i side) into `output` and side.output:
+// with Z[k] and conj Z[N - k], M[k] = (Z[k] + conj Z[N - k]) / 2 and
+// S[k] = (Z[k] - conj Z[N - k]) / 2i, the spectra of the two real frames
+static void fft_analyzer_transform_stereo(FFTAnalyzer* analyzer)
+{
+    const SizeType size = analyzer->cfg.size;
+    {
+        TRACE_SCOPE(TRACE_WINDOW);
+        kiss_fft_cpx* z = analyzer->stereo_buffer;
+        const float* mid = analyzer->input;
+        const float* side = analyzer->side.input;
+        const float* window = analyzer->window;
+        for (size_t i = 0; i < size; ++i) {
+            z[i] = (kiss_fft_cpx){.r = window[i] * mid[i],
+                                  .i = window[i] * side[i]};
+        }
+    }
+
+    TRACE_SCOPE(TRACE_FFT);
+    kiss_fft(analyzer->stereo_plan, analyzer->stereo_buffer,
+             analyzer->stereo_spectrum);
+
+    const kiss_fft_cpx* z = analyzer->stereo_spectrum;
+    kiss_fft_cpx* mid = analyzer->output;
+    kiss_fft_cpx* side = analyzer->side.output;
+    for (size_t k = 0; k <= size / 2; ++k) {
+        const kiss_fft_cpx zk = z[k];
+        const kiss_fft_cpx zn = z[k == 0 ? 0 : size - k];
+        mid[k] = (kiss_fft_cpx){.r = 0.5f * (zk.r + zn.r),
+                                .i = 0.5f * (zk.i - zn.i)};
+        side[k] = (kiss_fft_cpx){.r = 0.5f * (zk.i + zn.i),
+                                 .i = 0.5f * (zn.r - zk.r)};
+    }
+}
+
+// features and history for the spectrum in `output`, false while a merged
+// row is still being gathered
+static bool fft_analyzer_push(FFTAnalyzer* analyzer)
+{
+    ++analyzer->frames;
+    if (analyzer->cfg.stereo) {
+        // every frame, before a merge turns it into magnitudes
+        TRACE_SCOPE(TRACE_STEREO);
+        stereo_meter_process(&analyzer->stereo,
+                             (const Complex*)(analyzer->output + 1),
+                             (const Complex*)(analyzer->side.output + 1));
+    }
+
+    if (analyzer->merge > 1 || analyzer->merged > 0) {
+        if (!fft_analyzer_merge(analyzer)) {
+            return false;
+        }
+        analyzer->phase_rows = 0;
+    } else if (analyzer->phase_rows < analyzer->history.cap) {
+        ++analyzer->phase_rows;
+    }
+
+    if (analyzer->cfg.features) {
+        // same bins as the history row, before they leave the cache
+        TRACE_SCOPE(TRACE_FEATURES);
+        const SpectralFeatures f = spectral_features_process(
+            &analyzer->extractor, (const Complex*)(analyzer->output + 1));
+        fhistory_push(&analyzer->features.centroid, f.centroid);
+        fhistory_push(&analyzer->features.bandwidth, f.bandwidth);
+        fhistory_push(&analyzer->features.rolloff, f.rolloff);
+        fhistory_push(&analyzer->features.flatness, f.flatness);
+        fhistory_push(&analyzer->features.flux, f.flux);
+    }
+
+    if (analyzer->cfg.stereo) {
+        stereo_meter_push(&analyzer->stereo);
+    }
+
+    if (analyzer->cfg.pitch) {
+        fhistory_push(&analyzer->pitch.f0, analyzer->row_pitch.f0);
+        fhistory_push(&analyzer->pitch.clarity, analyzer->row_pitch.clarity);
+    }
+
+    {
+        // the pointer shift means we ditch the DC bin
+        TRACE_SCOPE(TRACE_HISTORY_PUSH);
+        fft_history_push(&analyzer->history, (Complex*)(analyzer->output + 1));
+    }
+    return true;
 }
 
 // returns number of frames pushed onto the history
 SizeType fft_analyzer_update(FFTAnalyzer* analyzer)
+{
+    return fft_analyzer_update_until(analyzer, UINT64_MAX);
+}
+
+SizeType fft_analyzer_update_until(FFTAnalyzer* analyzer,
+                                   uint64_t deadline_ns)
 {
     const SizeType to_keep = analyzer->cfg.size - analyzer->cfg.stride;
     const SizeType to_read = analyzer->cfg.stride;
 
     SizeType n = 0;
-    while (clfq_pop(&analyzer->rx, analyzer->input + to_keep, to_read)) {
-        // remove DC information from incoming slice
-        filter_hpf_process(&analyzer->dc_blocker, analyzer->input + to_keep,
-                           to_read);
+    SizeType started = 0;
+    for (;;) {
+        // `buffer` and `output` are the workers' until they're done
+        if (analyzer->in_flight && large_fft_done(analyzer->large)) {
+            analyzer->in_flight = false;
+            n += fft_analyzer_push(analyzer) ? 1 : 0;
+        }
 
-        memcpy(analyzer->buffer, analyzer->input,
-               analyzer->cfg.size * sizeof(float));
-        window_apply(analyzer->buffer, analyzer->window, analyzer->cfg.size);
-        kiss_fftr(analyzer->plan, analyzer->buffer, analyzer->output);
+        // one frame at least, whatever the clock says
+        if (started > 0 && deadline_ns != UINT64_MAX &&
+            clock_now_ns() >= deadline_ns) {
+            break;
+        }
 
-        // the pointer shift means we ditch the DC bin
-        fft_history_push(&analyzer->history, (Complex*)(analyzer->output + 1));
+        // `input` isn't the workers', the next stride can come in meanwhile
+        if (!fft_analyzer_fill(analyzer, to_keep, to_read)) {
+            break;
+        }
+
+        if (analyzer->in_flight) {
+            // a whole stride is waiting already: the workers are behind the
+            // input, and only waiting for them keeps the queue from backing
+            // up for good when display frames come slower than hops
+            large_fft_wait(analyzer->large);
+            analyzer->in_flight = false;
+            n += fft_analyzer_push(analyzer) ? 1 : 0;
+        }
+
+        if (analyzer->cfg.pitch) {
+            // the frame is still unwindowed here, which is what it wants
+            TRACE_SCOPE(TRACE_PITCH);
+            const SizeType size = analyzer->pitch_tracker.size;
+            const Pitch pitch = pitch_tracker_process(
+                &analyzer->pitch_tracker,
+                analyzer->input + analyzer->cfg.size - size);
+            if (analyzer->merged == 0 ||
+                pitch.clarity > analyzer->row_pitch.clarity) {
+                analyzer->row_pitch = pitch;
+            }
+        }
+
+        if (!analyzer->cfg.stereo) {
+            // stereo windows both channels straight into its own buffer
+            TRACE_SCOPE(TRACE_WINDOW);
+            memcpy(analyzer->buffer, analyzer->input,
+                   analyzer->cfg.size * sizeof(float));
+            window_apply(analyzer->buffer, analyzer->window,
+                         analyzer->cfg.size);
+        }
+
+        if (analyzer->large != NULL) {
+            // only the hand-off shows up here, the workers take it from there
+            TRACE_SCOPE(TRACE_FFT);
+            large_fft_start(analyzer->large, analyzer->buffer,
+                            analyzer->output);
+            analyzer->in_flight = true;
+        } else if (analyzer->cfg.stereo) {
+            fft_analyzer_transform_stereo(analyzer);
+            n += fft_analyzer_push(analyzer) ? 1 : 0;
+        } else {
+            {
+                TRACE_SCOPE(TRACE_FFT);
+                kiss_fftr(analyzer->plan, analyzer->buffer, analyzer->output);
+            }
+            n += fft_analyzer_push(analyzer) ? 1 : 0;
+        }
+
+        ++started;
 
         // make way for the next frame
         memmove(analyzer->input, analyzer->input + to_read,
                 to_keep * sizeof(float));
-        ++n;
+        if (analyzer->cfg.stereo) {
+            memmove(analyzer->side.input, analyzer->side.input + to_read,
+                    to_keep * sizeof(float));
+        }
     }
 
     return n;
 }
+
+SizeType fft_analyzer_flush(FFTAnalyzer* analyzer)
+{
+    SizeType n = fft_analyzer_update(analyzer);
+    while (analyzer->in_flight) {
+        large_fft_wait(analyzer->large);
+        n += fft_analyzer_update(analyzer);
+    }
+    return n;
+}
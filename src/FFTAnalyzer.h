@@ -1,11 +1,21 @@
 #pragma once
 
+#include <stdbool.h>
+
 #include "LockFreeQueue.h"
+#include "kiss_fft.h"
 #include "kiss_fftr.h"
 
 #include "core/History.h"
+#include "core/arena.h"
 #include "core/definitions.h"
+#include "core/sparse.h"
 #include "dsp/filters.h"
+#include "dsp/large_fft.h"
+#include "dsp/pitch.h"
+#include "dsp/resample.h"
+#include "dsp/spectral_features.h"
+#include "dsp/stereo.h"
 
 typedef struct {
     const SizeType size;
@@ -13,12 +23,58 @@ typedef struct {
     const float sample_rate;
     const float dc_blocker_frequency;
     const SizeType history_size;
+    // analyze at sample_rate / decimation, 0 or 1 leaves the stream alone
+    // size and stride count decimated samples
+    const SizeType decimation;
+    // compute SpectralFeatures of every frame into FFTAnalyzer.features
+    const bool features;
+    // track the fundamental of every frame into FFTAnalyzer.pitch, over its
+    // newest pitch_frame_size_for(rate, PITCH_MIN_HZ) samples at most
+    const bool pitch;
+    // meter the stereo image of every frame into FFTAnalyzer.stereo, from
+    // a side channel popped in step with the queue once
+    // fft_analyzer_attach_side is called; not with threads
+    const bool stereo;
+    // 0 or 1 runs kiss_fftr inside fft_analyzer_update; more splits every
+    // frame across that many workers (dsp/large_fft.h) and pushes it on a
+    // later update, pays off from FFT_LARGE_SIZE
+    const SizeType threads;
 } FFTConfig;
 
+// sees every block of fresh samples right after the DC blocker, before the
+// FFT, at fft_analyzer_sample_rate; lets other analyses share the stream
+// without a second queue
+typedef void (*FFTSampleTap)(void* ctx, const float* samples, SizeType size);
+
+#define FFT_MAX_TAPS 4
+
+// samples are popped this many at a time, or a stride if that's shorter,
+// and the taps see each block as soon as it's popped: they lag the queue by
+// a block, not a hop
+#define FFT_TAP_BLOCK 64
+
+// streams faster than this are worth decimating: nothing we draw lives above
+// ~20 kHz, so 96/192 kHz material can cost the same as 48 kHz
+#define FFT_MIN_ANALYSIS_RATE 44100.0f
+
+// from about here a kiss_fftr stops being small next to a display frame, at
+// 1M points it takes a couple of them
+#define FFT_LARGE_SIZE 65536
+
+// largest integer factor that keeps sample_rate at or above
+// FFT_MIN_ANALYSIS_RATE, 1 for anything slower, RESAMPLER_MAX_FACTOR at most
+SizeType fft_decimation_for(float sample_rate);
+
 typedef struct {
     FFTConfig cfg;
 
-    kiss_fftr_cfg plan;
+    // one block for the plan, the frame and spectrum buffers and the
+    // histories below, sized for cfg. the decimators, the feature
+    // extractor, the pitch tracker, the stereo meter and the large FFT's
+    // workers allocate their own, and are rebuilt by a reconfigure
+    Arena arena;
+
+    kiss_fftr_cfg plan;  // unset with cfg.threads
     float* input;   // where we collect the samples
     float* buffer;  // where we filter, window and FFT the samples
     float* window;  // this is a Hann function for now
@@ -29,11 +85,126 @@ typedef struct {
     FFTHistory history;
     OnePoleFilter dc_blocker;
 
+    // only with decimation: raw samples are popped into `raw` and decimated
+    // into `input`
+    Resampler decimator;
+    float* raw;
+    // fresh samples of the next frame already in `input`, DC blocked and
+    // tapped
+    SizeType pending;
+
+    // called in the order they were added
+    struct {
+        FFTSampleTap fn;
+        void* ctx;
+    } taps[FFT_MAX_TAPS];
+    SizeType n_taps;
+
+    // only with cfg.features: one entry per frame in each ring, pushed in
+    // step with the FFTHistory while the frame is still in cache
+    SpectralFeatureExtractor extractor;
+    struct {
+        FloatHistory centroid;
+        FloatHistory bandwidth;
+        FloatHistory rolloff;
+        FloatHistory flatness;
+        FloatHistory flux;
+    } features;
+
+    // only with cfg.pitch: rings in step with the FFTHistory like the
+    // features; a merged row keeps the clearest pitch of its frames
+    PitchTracker pitch_tracker;
+    Pitch row_pitch;
+    struct {
+        FloatHistory f0;
+        FloatHistory clarity;
+    } pitch;
+
+    // only with cfg.stereo: the side channel goes the same way as the mid
+    // one, its own DC blocker and decimator included, and is silence until
+    // attached. the windowed mid and side frames are the real and the
+    // imaginary part of one complex FFT, taking the place of the kiss_fftr:
+    // the history gets the mid's spectrum and the meter both
+    struct {
+        LockFreeQueueConsumer rx;
+        bool attached;
+        float* input;
+        float* raw;
+        Resampler decimator;
+        OnePoleFilter dc_blocker;
+        kiss_fft_cpx* output;  // [1 + n_bins] like `output`
+    } side;
+    kiss_fft_cfg stereo_plan;
+    kiss_fft_cpx* stereo_buffer;    // [size] mid + i side, windowed
+    kiss_fft_cpx* stereo_spectrum;  // [size]
+    StereoMeter stereo;
+
+    // only with cfg.threads: `buffer` is being transformed into `output`
+    // while in_flight, the frame is pushed once the workers are done
+    LargeFFT* large;
+    bool in_flight;
+
+    // frames per history row, 1 unless fft_analyzer_set_merge says
+    // otherwise; `merge_power` gathers the rows' power until there are
+    // enough of them
+    SizeType merge;
+    RowPooling merge_pooling;
+    float* merge_power;
+    SizeType merged;
+    // how many of the newest rows hold phase, back to the last merged one:
+    // that holds magnitudes only, even if merge was lowered to 1 meanwhile.
+    // at most the history's cap
+    SizeType phase_rows;
+    uint64_t frames;  // analyzed since creation, merged or not
+
     float power_reference;  // pre-computed from the window
 } FFTAnalyzer;
 
+// the buffers in `arena` come from one ARENA_ALIGNMENT aligned block, the
+// optional stages' own allocations on top of it; if any of it failed,
+// fft_analyzer_ok is false
 FFTAnalyzer fft_analyzer_new(const FFTConfig* cfg, LockFreeQueueConsumer rx);
+bool fft_analyzer_ok(const FFTAnalyzer* analyzer);
 void fft_analyzer_free(FFTAnalyzer* analyzer);
 
-// returns number of frames pushed onto the history
+// an analyzer for cfg on the same queue, with the same taps, in the old
+// one's arena unless cfg needs more room, the stages outside it built anew;
+// `analyzer` is freed, history and filter state start over
+FFTAnalyzer fft_analyzer_reconfigure(FFTAnalyzer* analyzer,
+                                     const FFTConfig* cfg);
+
+// the side channel's queue for cfg.stereo, kept across reconfigures; the
+// producer has to push side before mid (audio_callback.h)
+void fft_analyzer_attach_side(FFTAnalyzer* analyzer,
+                              LockFreeQueueConsumer side_rx);
+
+// returns false once FFT_MAX_TAPS are attached
+bool fft_analyzer_add_tap(FFTAnalyzer* analyzer, FFTSampleTap tap, void* ctx);
+
+// from now on every `merge` consecutive frames become a single history row,
+// their power pooled with POOL_MAX or averaged with anything else; merged
+// rows hold magnitudes, no phase. a row being gathered is finished with as
+// many frames as it has once there are at least `merge`
+void fft_analyzer_set_merge(FFTAnalyzer* analyzer,
+                            SizeType merge,
+                            RowPooling pooling);
+
+// rate of the samples that reach the FFT, after decimation
+float fft_analyzer_sample_rate(const FFTAnalyzer* analyzer);
+float fft_config_sample_rate(const FFTConfig* cfg);
+
+// returns number of rows pushed onto the history, frames with no merging
+//
+// with cfg.threads a frame in flight is pushed once done; the workers are
+// only waited for when the next stride is already queued, so the analysis
+// keeps up with the input however seldom it's called
 SizeType fft_analyzer_update(FFTAnalyzer* analyzer);
+
+// update, starting no frame once clock_now_ns() has passed deadline_ns but
+// the first: the rest stays queued for the next call. UINT64_MAX never stops
+SizeType fft_analyzer_update_until(FFTAnalyzer* analyzer,
+                                   uint64_t deadline_ns);
+
+// update, blocking on frames in flight until the queue can't complete
+// another; what offline analyses call once the input has run out
+SizeType fft_analyzer_flush(FFTAnalyzer* analyzer);
@@ -0,0 +1,100 @@
+#include "FrameScheduler.h"
+
+// how quickly the smoothed costs and rates follow the measurements
+#define FRAME_SCHEDULER_SMOOTHING 0.125f
+
+static float smooth(float average, float sample)
+{
+    return average + FRAME_SCHEDULER_SMOOTHING * (sample - average);
+}
+
+FrameScheduler frame_scheduler_new(const FrameSchedulerConfig* cfg)
+{
+    return (FrameScheduler){
+        .cfg = *cfg,
+        .merge = 1,
+    };
+}
+
+uint64_t frame_scheduler_analysis_deadline(const FrameScheduler* scheduler,
+                                           uint64_t start_ns)
+{
+    return scheduler->cfg.budget_ns > 0 ? start_ns + scheduler->cfg.budget_ns
+                                        : UINT64_MAX;
+}
+
+void frame_scheduler_on_analyzed(FrameScheduler* scheduler,
+                                 SizeType rows,
+                                 SizeType cap,
+                                 uint64_t analysis_ns)
+{
+    // rows older than the history are gone, and so is the need to draw them
+    const uint64_t behind = (uint64_t)scheduler->behind + rows;
+    scheduler->behind = behind < cap ? (SizeType)behind : cap;
+    scheduler->rows = smooth(scheduler->rows, (float)rows);
+
+    const uint64_t budget_ns = scheduler->cfg.budget_ns;
+    if (budget_ns == 0 || scheduler->column_ns <= 0.0f) {
+        scheduler->columns = scheduler->behind;
+        return;
+    }
+
+    const uint64_t left_ns = analysis_ns < budget_ns ? budget_ns - analysis_ns
+                                                     : 0;
+    const float affordable = (float)left_ns / scheduler->column_ns;
+    scheduler->affordable = smooth(scheduler->affordable, affordable);
+
+    // one column at least, or a slow analysis would stall the display
+    SizeType columns = affordable < (float)scheduler->behind
+                           ? (SizeType)affordable
+                           : scheduler->behind;
+    if (columns == 0 && scheduler->behind > 0) {
+        columns = 1;
+    }
+    scheduler->columns = columns;
+}
+
+void frame_scheduler_on_columns(FrameScheduler* scheduler,
+                                uint64_t columns_ns)
+{
+    const SizeType columns = scheduler->columns;
+    if (columns > 0) {
+        const float column_ns = (float)columns_ns / (float)columns;
+        scheduler->column_ns = scheduler->column_ns > 0.0f
+                                   ? smooth(scheduler->column_ns, column_ns)
+                                   : column_ns;
+    }
+    scheduler->behind -= columns;
+    scheduler->columns = 0;
+
+    if (scheduler->cfg.budget_ns == 0) {
+        return;
+    }
+
+    if (scheduler->behind > 0) {
+        // a backlog that's shrinking needs no merging, only time
+        scheduler->idle = 0;
+        if (scheduler->rows < scheduler->affordable) {
+            scheduler->overloaded = 0;
+            return;
+        }
+        if (++scheduler->overloaded >= FRAME_SCHEDULER_PATIENCE &&
+            scheduler->merge < scheduler->cfg.max_merge) {
+            scheduler->merge *= 2;
+            scheduler->overloaded = 0;
+        }
+        return;
+    }
+
+    // unmerging doubles the rows, which must still fit
+    scheduler->overloaded = 0;
+    if (scheduler->merge > 1 &&
+        2.0f * scheduler->rows < scheduler->affordable) {
+        if (++scheduler->idle >= FRAME_SCHEDULER_PATIENCE) {
+            scheduler->merge /= 2;
+            scheduler->idle = 0;
+        }
+    } else {
+        scheduler->idle = 0;
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "core/definitions.h"
+
+// keeps the analysis and column updates of a display frame within a time
+// budget
+//
+// the analysis starts no new FFT frame past the budget, the samples left
+// wait in the queue for the next display frame; the queue only absorbs a
+// spike that fits in it, past that the callback drops audio as ever. then
+// columns are drawn oldest first, as many as the budget left after the
+// analysis affords, at least one: a backlog is worked off over the next
+// frames instead of in one long frame that would only make it grow. when
+// rows keep coming faster than they can be drawn for
+// FRAME_SCHEDULER_PATIENCE frames, the analyzer is asked to merge twice as
+// many frames per history row, up to max_merge, so there are fewer columns
+// to draw while the audio is still all consumed. merging halves again once
+// there's room for twice the rows
+#define FRAME_SCHEDULER_PATIENCE 30
+
+typedef struct {
+    uint64_t budget_ns;  // 0 draws every column, never merges
+    SizeType max_merge;  // power of 2, 1 never merges
+} FrameSchedulerConfig;
+
+typedef struct {
+    FrameSchedulerConfig cfg;
+
+    SizeType behind;   // history rows not drawn yet, oldest first
+    SizeType columns;  // to draw this frame
+    SizeType merge;    // frames per history row
+
+    // smoothed, per display frame
+    float column_ns;   // cost of one column, 0 until measured
+    float rows;        // rows pushed
+    float affordable;  // columns the budget had room for
+
+    SizeType overloaded;  // consecutive frames that fell further behind
+    SizeType idle;        // consecutive frames with room to unmerge
+} FrameScheduler;
+
+FrameScheduler frame_scheduler_new(const FrameSchedulerConfig* cfg);
+
+// when an analysis started at start_ns should stop starting frames,
+// UINT64_MAX without a budget
+uint64_t frame_scheduler_analysis_deadline(const FrameScheduler* scheduler,
+                                           uint64_t start_ns);
+
+// the analysis pushed `rows` onto a history of `cap` rows in analysis_ns;
+// sets `columns`
+void frame_scheduler_on_analyzed(FrameScheduler* scheduler,
+                                 SizeType rows,
+                                 SizeType cap,
+                                 uint64_t analysis_ns);
+
+// `columns` were drawn in columns_ns; may change `merge`
+void frame_scheduler_on_columns(FrameScheduler* scheduler,
+                                uint64_t columns_ns);
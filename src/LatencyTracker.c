@@ -0,0 +1,244 @@
+#include "LatencyTracker.h"
+
+#include <stdlib.h>
+
+#include "trace/clock.h"
+
+#define LATENCY_STAMP_MASK (LATENCY_STAMPS - 1)
+#define LATENCY_PENDING_MASK (LATENCY_PENDING - 1)
+
+// 0.25 ms bins up to 1 s
+#define LATENCY_BIN_MS 0.25f
+#define LATENCY_BINS 4000
+
+static const char* const s_stage_names[LATENCY_STAGE_COUNT] = {
+    [LATENCY_TOTAL] = "total",
+    [LATENCY_ANALYSIS] = "analysis",
+    [LATENCY_COLUMN] = "column",
+    [LATENCY_PRESENT] = "present",
+};
+
+const char* latency_stage_name(LatencyStage stage)
+{
+    return (stage < LATENCY_STAGE_COUNT) ? s_stage_names[stage] : "unknown";
+}
+
+LatencyTracker* latency_tracker_new(SizeType stride, FILE* log)
+{
+    LatencyTracker* tracker = calloc(1, sizeof(*tracker));
+    if (tracker == NULL) {
+        return NULL;
+    }
+
+    for (SizeType s = 0; s < LATENCY_STAGE_COUNT; ++s) {
+        tracker->histograms[s] = histogram_new(LATENCY_BIN_MS, LATENCY_BINS);
+        if (!histogram_ok(&tracker->histograms[s])) {
+            latency_tracker_free(tracker);
+            return NULL;
+        }
+    }
+
+    atomic_init(&tracker->stamps_written, 0);
+    tracker->stride = stride;
+    tracker->report_period_ns = 1000000000ull;  // 1 s
+    tracker->last_report_ns = clock_now_ns();
+    tracker->log = log;
+
+    if (log != NULL) {
+        fprintf(log, "# t_s n");
+        for (SizeType s = 0; s < LATENCY_STAGE_COUNT; ++s) {
+            const char* name = latency_stage_name((LatencyStage)s);
+            fprintf(log, " %s_p50_ms %s_p95_ms %s_p99_ms", name, name, name);
+        }
+        fprintf(log, "\n");
+    }
+
+    return tracker;
+}
+
+void latency_tracker_free(LatencyTracker* tracker)
+{
+    if (!tracker) {
+        return;
+    }
+
+    for (SizeType s = 0; s < LATENCY_STAGE_COUNT; ++s) {
+        histogram_free(&tracker->histograms[s]);
+    }
+    free(tracker);
+}
+
+void latency_tracker_on_block(LatencyTracker* tracker, SizeType pushed)
+{
+    const uint64_t now = clock_now_ns();
+    tracker->samples_pushed += pushed;
+
+    // if the main thread stalls for LATENCY_STAMPS blocks we overwrite its
+    // oldest stamps: it only ever needs the ones around the analyzer's cursor
+    const SizeType w =
+        atomic_load_explicit(&tracker->stamps_written, memory_order_relaxed);
+    LatencyStamp* stamp = &tracker->stamps[w & LATENCY_STAMP_MASK];
+    atomic_store_explicit(&stamp->t_ns, now, memory_order_relaxed);
+    atomic_store_explicit(&stamp->sample_end, tracker->samples_pushed,
+                          memory_order_relaxed);
+    atomic_store_explicit(&tracker->stamps_written, w + 1,
+                          memory_order_release);
+}
+
+// time at which the block holding sample `sample_end` reached the callback
+// 0 if that block's stamp was lost
+static uint64_t latency_tracker_find_block(LatencyTracker* tracker,
+                                           uint64_t sample_end)
+{
+    SizeType w =
+        atomic_load_explicit(&tracker->stamps_written, memory_order_acquire);
+
+    // lapped by the audio thread: skip to the oldest stamp still there
+    if (w - tracker->stamps_read > LATENCY_STAMPS - 1) {
+        tracker->stamps_read = w - (LATENCY_STAMPS - 1);
+    }
+
+    while (tracker->stamps_read != w) {
+        const LatencyStamp* stamp =
+            &tracker->stamps[tracker->stamps_read & LATENCY_STAMP_MASK];
+        const uint64_t end =
+            atomic_load_explicit(&stamp->sample_end, memory_order_relaxed);
+        const uint64_t t_ns =
+            atomic_load_explicit(&stamp->t_ns, memory_order_relaxed);
+
+        // the slot of stamp `after` may be being written to right now, which
+        // clobbers stamp after - LATENCY_STAMPS: if ours is that old it may
+        // be torn, skip to the oldest one that can't be
+        atomic_thread_fence(memory_order_acquire);
+        const SizeType after = atomic_load_explicit(&tracker->stamps_written,
+                                                    memory_order_relaxed);
+        if (after - tracker->stamps_read > LATENCY_STAMPS - 1) {
+            tracker->stamps_read = after - (LATENCY_STAMPS - 1);
+            w = after;
+            continue;
+        }
+
+        if (end >= sample_end) {
+            // the next frame may end in this same block, keep it around
+            return t_ns;
+        }
+        ++tracker->stamps_read;
+    }
+
+    return 0;
+}
+
+void latency_tracker_on_analyzed(LatencyTracker* tracker,
+                                 SizeType n_frames,
+                                 SizeType n_rows,
+                                 SizeType gathering)
+{
+    const uint64_t now = clock_now_ns();
+    tracker->frames_seen += n_frames;
+    if (n_rows == 0) {
+        return;
+    }
+
+    // the rows split the frames since the last row evenly, as they do while
+    // the merge stays put
+    const uint64_t first = tracker->row_end;
+    const uint64_t last = tracker->frames_seen - gathering;
+    for (SizeType i = 0; i < n_rows; ++i) {
+        const uint64_t end = first + (last - first) * (i + 1) / n_rows;
+        const uint64_t t =
+            latency_tracker_find_block(tracker, end * tracker->stride);
+
+        if (t == 0) {
+            continue;  // stamp lost
+        }
+        // more rows than we can follow: the latest ones matter most
+        if (tracker->rows_pushed - tracker->rows_presented == LATENCY_PENDING) {
+            ++tracker->rows_presented;
+            if (tracker->rows_uploaded < tracker->rows_presented) {
+                tracker->rows_uploaded = tracker->rows_presented;
+            }
+        }
+        tracker->rows[tracker->rows_pushed++ & LATENCY_PENDING_MASK] =
+            (LatencyRow){.callback_ns = t, .analyzed_ns = now};
+    }
+    tracker->row_end = last;
+}
+
+void latency_tracker_on_columns(LatencyTracker* tracker,
+                                SizeType uploaded,
+                                SizeType behind)
+{
+    const uint64_t now = clock_now_ns();
+
+    // the newest `behind` rows are still waiting. of the older ones, those
+    // past the `uploaded` newest fell off the history or the scheduler's
+    // count undrawn; rows whose stamps were lost are the oldest, so counting
+    // from the newest keeps the rest lined up
+    const SizeType waiting = tracker->rows_pushed - tracker->rows_uploaded;
+    const SizeType done = waiting > behind ? waiting - behind : 0;
+    const SizeType dropped = done > uploaded ? done - uploaded : 0;
+    for (SizeType i = 0; i < done; ++i) {
+        LatencyRow* row =
+            &tracker->rows[(tracker->rows_uploaded + i) & LATENCY_PENDING_MASK];
+        row->column_ns = i < dropped ? 0 : now;
+    }
+    tracker->rows_uploaded += done;
+}
+
+static void latency_tracker_make_report(LatencyTracker* tracker, uint64_t now)
+{
+    LatencyReport* r = &tracker->report;
+    r->count = tracker->histograms[LATENCY_TOTAL].total;
+
+    for (SizeType s = 0; s < LATENCY_STAGE_COUNT; ++s) {
+        Histogram* h = &tracker->histograms[s];
+        r->p50_ms[s] = histogram_percentile(h, 0.50f);
+        r->p95_ms[s] = histogram_percentile(h, 0.95f);
+        r->p99_ms[s] = histogram_percentile(h, 0.99f);
+        histogram_reset(h);
+    }
+
+    if (tracker->log != NULL) {
+        fprintf(tracker->log, "%.3f %llu", (double)now * 1e-9,
+                (unsigned long long)r->count);
+        for (SizeType s = 0; s < LATENCY_STAGE_COUNT; ++s) {
+            fprintf(tracker->log, " %.2f %.2f %.2f", (double)r->p50_ms[s],
+                    (double)r->p95_ms[s], (double)r->p99_ms[s]);
+        }
+        fprintf(tracker->log, "\n");
+        fflush(tracker->log);
+    }
+}
+
+void latency_tracker_on_present(LatencyTracker* tracker)
+{
+    const uint64_t now = clock_now_ns();
+
+    for (; tracker->rows_presented != tracker->rows_uploaded;
+         ++tracker->rows_presented) {
+        const LatencyRow* row =
+            &tracker->rows[tracker->rows_presented & LATENCY_PENDING_MASK];
+        if (row->column_ns == 0) {
+            continue;
+        }
+        Histogram* h = tracker->histograms;
+        histogram_add(&h[LATENCY_TOTAL],
+                      (float)(now - row->callback_ns) * 1e-6f);
+        histogram_add(&h[LATENCY_ANALYSIS],
+                      (float)(row->analyzed_ns - row->callback_ns) * 1e-6f);
+        histogram_add(&h[LATENCY_COLUMN],
+                      (float)(row->column_ns - row->analyzed_ns) * 1e-6f);
+        histogram_add(&h[LATENCY_PRESENT],
+                      (float)(now - row->column_ns) * 1e-6f);
+    }
+
+    if (now - tracker->last_report_ns >= tracker->report_period_ns) {
+        latency_tracker_make_report(tracker, now);
+        tracker->last_report_ns = now;
+    }
+}
+
+const LatencyReport* latency_tracker_report(const LatencyTracker* tracker)
+{
+    return &tracker->report;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "core/definitions.h"
+#include "core/histogram.h"
+
+// audio-to-pixel latency
+//
+// the audio callback stamps every block with the time it was handed to us and
+// the running count of samples it pushed. on the main thread, every history
+// row is matched with the block holding its newest sample, then followed
+// through the upload of its column, which the frame scheduler may put off for
+// a few display frames, and the EndDrawing that presents it
+//
+// EndDrawing also sleeps to honour the target frame rate, so the presentation
+// stamp is an upper bound by up to one frame
+
+#define LATENCY_STAMPS 256  // blocks in flight, power of 2
+#define LATENCY_PENDING 64  // rows waiting to be presented, power of 2
+
+// atomic so the main thread may read a slot while the audio thread rewrites
+// it; what it read is only trusted once stamps_written says the slot wasn't
+// reached meanwhile, like the trace rings
+typedef struct {
+    _Atomic uint64_t t_ns;
+    // running count of pushed samples, block included
+    _Atomic uint64_t sample_end;
+} LatencyStamp;
+
+typedef enum {
+    LATENCY_TOTAL,     // callback -> EndDrawing
+    LATENCY_ANALYSIS,  // callback -> row pushed, i.e. queue wait + FFT
+    LATENCY_COLUMN,    // row pushed -> its column uploaded
+    LATENCY_PRESENT,   // column uploaded -> EndDrawing
+    LATENCY_STAGE_COUNT,
+} LatencyStage;
+
+typedef struct {
+    float p50_ms[LATENCY_STAGE_COUNT];
+    float p95_ms[LATENCY_STAGE_COUNT];
+    float p99_ms[LATENCY_STAGE_COUNT];
+    uint64_t count;
+} LatencyReport;
+
+// a history row on its way to the screen, column_ns is 0 for one that was
+// never drawn
+typedef struct {
+    uint64_t callback_ns;
+    uint64_t analyzed_ns;
+    uint64_t column_ns;
+} LatencyRow;
+
+typedef struct {
+    // written by the audio thread
+    LatencyStamp stamps[LATENCY_STAMPS];
+    _Atomic SizeType stamps_written;
+    uint64_t samples_pushed;
+
+    // main thread only
+    SizeType stamps_read;
+    SizeType stride;         // samples per FFT frame
+    uint64_t frames_seen;
+    uint64_t row_end;  // frame the last complete row ends with
+    // rows_presented <= rows_uploaded <= rows_pushed, running counts
+    LatencyRow rows[LATENCY_PENDING];
+    SizeType rows_pushed;
+    SizeType rows_uploaded;
+    SizeType rows_presented;
+
+    Histogram histograms[LATENCY_STAGE_COUNT];
+    uint64_t report_period_ns;
+    uint64_t last_report_ns;
+    LatencyReport report;  // last complete period
+    FILE* log;             // optional, one line per report
+} LatencyTracker;
+
+LatencyTracker* latency_tracker_new(SizeType stride, FILE* log);
+void latency_tracker_free(LatencyTracker* tracker);
+
+const char* latency_stage_name(LatencyStage stage);
+
+// audio thread, after pushing `pushed` samples onto the queue
+void latency_tracker_on_block(LatencyTracker* tracker, SizeType pushed);
+
+// main thread, in pipeline order, once per display frame
+
+// the analyzer ran `n_frames` frames and pushed `n_rows` rows, `gathering` of
+// the frames are still waiting for their merged row
+void latency_tracker_on_analyzed(LatencyTracker* tracker,
+                                 SizeType n_frames,
+                                 SizeType n_rows,
+                                 SizeType gathering);
+// the oldest `uploaded` of the rows not drawn yet were, `behind` are left
+void latency_tracker_on_columns(LatencyTracker* tracker,
+                                SizeType uploaded,
+                                SizeType behind);
+void latency_tracker_on_present(LatencyTracker* tracker);
+
+// percentiles of the last complete report period
+const LatencyReport* latency_tracker_report(const LatencyTracker* tracker);
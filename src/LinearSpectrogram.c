@@ -1,42 +1,76 @@
 #include "LinearSpectrogram.h"
 
-#include <math.h>
-#include <stdlib.h>
-
 #include "core/History.h"
 #include "core/intensity.h"
+#include "trace/trace.h"
 
 LinearSpectrogramConfig linear_spectrogram_config(Rectangle screen,
                                                   Colormap cmap,
-                                                  const FFTConfig* analyzer_cfg)
+                                                  const FFTConfig* analyzer_cfg,
+                                                  FrequencyAxis axis,
+                                                  RowPooling pooling)
 {
     const SizeType fft_size = analyzer_cfg->size;
-    const SizeType logical_height = fft_size / 2;
-    const SizeType logical_width = analyzer_cfg->history_size;
+    const SizeType n_bins = fft_size / 2;
+    const float bin_hz =
+        fft_config_sample_rate(analyzer_cfg) / (float)fft_size;
 
-    const float power_reference = 0.25f * (float)(fft_size * fft_size);
-    const float min_dB = -60.0f;  // -60 dB should be quiet enough
+    const LinearSpectrogramConfig linear = linear_spectrogram_config_bins(
+        screen, cmap, n_bins, fft_size, analyzer_cfg->history_size, pooling);
+    const SizeType panel_rows = (SizeType)screen.height;
 
     return (LinearSpectrogramConfig){
         .screen = screen,
-        .logical_height = logical_height,
-        .logical_width = logical_width,
-        .power_reference = power_reference,
-        .min_dB = min_dB,
+        .logical_height =
+            axis == AXIS_LINEAR ? linear.logical_height : panel_rows,
+        .logical_width = linear.logical_width,
         .cmap = cmap,
+        .n_bins = n_bins,
+        .bin_hz = bin_hz,
+        .axis = axis_range_for_bins(axis, n_bins, bin_hz),
+        .pooling = pooling,
+        .power_reference = linear.power_reference,
+        .min_dB = linear.min_dB,
     };
 }
 
-static float clamp_unit(float f)
+LinearSpectrogramConfig linear_spectrogram_config_bins(Rectangle screen,
+                                                       Colormap cmap,
+                                                       SizeType n_bins,
+                                                       SizeType frame_size,
+                                                       SizeType history_size,
+                                                       RowPooling pooling)
 {
-    return fminf(fmaxf(f, 0.0f), 1.0f);
+    const float size = (float)frame_size;
+    const float power_reference = 0.25f * size * size;
+    const float min_dB = -60.0f;  // -60 dB should be quiet enough
+
+    // more rows than pixels is upload and colour work nobody sees
+    const SizeType panel_rows = (SizeType)screen.height;
+    const SizeType rows =
+        (panel_rows > 0 && panel_rows < n_bins) ? panel_rows : n_bins;
+
+    // the bins' real spacing doesn't matter on a linear axis, unit spacing
+    // puts bin b at b + 1
+    const float bin_hz = 1.0f;
+
+    return (LinearSpectrogramConfig){
+        .screen = screen,
+        .logical_height = rows,
+        .logical_width = history_size,
+        .cmap = cmap,
+        .n_bins = n_bins,
+        .bin_hz = bin_hz,
+        .axis = axis_range_for_bins(AXIS_LINEAR, n_bins, bin_hz),
+        .pooling = pooling,
+        .power_reference = power_reference,
+        .min_dB = min_dB,
+    };
 }
 
-static Color float_to_color(float intensity, Colormap cmap, SizeType cmap_size)
+static Color float_to_color(float intensity, Colormap cmap)
 {
-    const float clamped = clamp_unit(intensity);
-    const int index = (int)(clamped * ((float)cmap_size - 0.0001f));
-    return *(const Color*)cmap[index];
+    return *(const Color*)colormap_sample(cmap, intensity);
 }
 
 LinearSpectrogram linear_spectrogram_new(const LinearSpectrogramConfig* cfg)
@@ -48,15 +82,48 @@ LinearSpectrogram linear_spectrogram_new(const LinearSpectrogramConfig* cfg)
     UnloadImage(img);
     SetTextureFilter(texture, TEXTURE_FILTER_BILINEAR);
 
-    Color* column_buffer = malloc(sizeof(Color) * cfg->logical_height);
+    // every CPU side buffer in one block, the remap grows on its own
+    const bool remapped = cfg->logical_height != cfg->n_bins;
+    const size_t column_size = sizeof(Color) * cfg->logical_height;
+    const size_t power_size = sizeof(float) * cfg->n_bins;
+    const size_t rows_size = sizeof(float) * cfg->logical_height;
+    Arena arena = arena_new(arena_footprint(power_size) +
+                            arena_footprint(rows_size) +
+                            arena_footprint(column_size));
+
+    float* power = arena_push(&arena, power_size);
+    float* rows = remapped ? arena_push(&arena, rows_size) : NULL;
+    Color* column_buffer = arena_push(&arena, column_size);
+
+    // any row count other than one per bin goes through the remap
+    SparseRows remap = {0};
+    if (remapped) {
+        remap = axis_remap_new(&cfg->axis, cfg->n_bins, cfg->bin_hz,
+                               cfg->logical_height);
+    }
 
     return (LinearSpectrogram){
         .texture = texture,
+        .arena = arena,
         .column_buffer = column_buffer,
+        .power = power,
+        .remap = remap,
+        .rows = rows,
         .cfg = *cfg,
     };
 }
 
+bool linear_spectrogram_ok(const LinearSpectrogram* spec)
+{
+    if (!spec) {
+        return false;
+    }
+
+    const bool remapped = spec->cfg.logical_height != spec->cfg.n_bins;
+    return spec->column_buffer && spec->power &&
+           (!remapped || (sparse_rows_ok(&spec->remap) && spec->rows));
+}
+
 void linear_spectrogram_destroy(LinearSpectrogram* spec)
 {
     if (!spec) {
@@ -64,26 +131,49 @@ void linear_spectrogram_destroy(LinearSpectrogram* spec)
     }
 
     UnloadTexture(spec->texture);
-    free(spec->column_buffer);
+    arena_free(&spec->arena);
+    sparse_rows_free(&spec->remap);
 }
 
 static Color linear_spectrogram_assign_color(const LinearSpectrogram* spec,
-                                             Complex bin)
+                                             float power)
 {
     const LinearSpectrogramConfig* cfg = &spec->cfg;
     const float intensity =
-        intensity_from_bin(bin, cfg->power_reference, cfg->min_dB);
-    return float_to_color(intensity, cfg->cmap, COLORMAP_SIZE);
+        intensity_from_power(power, cfg->power_reference, cfg->min_dB);
+    return float_to_color(intensity, cfg->cmap);
 }
 
 static void linear_spectrogram_update_column(LinearSpectrogram* spec,
                                              const Complex* bins,
                                              SizeType index)
 {
-    for (SizeType b = 0; b < spec->cfg.logical_height; b++) {
-        spec->column_buffer[b] = linear_spectrogram_assign_color(spec, bins[b]);
+    // a plain pass the compiler vectorizes, bins are interleaved re/im
+    const float* re_im = (const float*)bins;
+    for (SizeType b = 0; b < spec->cfg.n_bins; b++) {
+        const float re = re_im[2 * b];
+        const float im = re_im[2 * b + 1];
+        spec->power[b] = re * re + im * im;
+    }
+
+    // colour and upload work is per row from here on
+    const float* rows = spec->power;
+    if (spec->rows != NULL) {
+        TRACE_SCOPE(TRACE_REMAP);
+        sparse_rows_apply_pooled(&spec->remap, spec->cfg.pooling, spec->power,
+                                 spec->rows);
+        rows = spec->rows;
     }
 
+    {
+        TRACE_SCOPE(TRACE_COLOR);
+        for (SizeType r = 0; r < spec->cfg.logical_height; r++) {
+            spec->column_buffer[r] =
+                linear_spectrogram_assign_color(spec, rows[r]);
+        }
+    }
+
+    TRACE_SCOPE(TRACE_UPLOAD);
     UpdateTextureRec(
         spec->texture,
         (Rectangle){(float)index, 0, 1, (float)spec->cfg.logical_height},
@@ -93,11 +183,20 @@ static void linear_spectrogram_update_column(LinearSpectrogram* spec,
 void linear_spectrogram_update(LinearSpectrogram* spec,
                                const FFTHistory* h,
                                SizeType n)
+{
+    linear_spectrogram_catch_up(spec, h, n, n);
+}
+
+void linear_spectrogram_catch_up(LinearSpectrogram* spec,
+                                 const FFTHistory* h,
+                                 SizeType behind,
+                                 SizeType n)
 {
     // h->cap aliases spec->cfg.logical_width as the texture is the fft history
     // but on the GPU. hence how `i` indexes both the history and the texture
-    n = (n >= h->cap) ? h->cap : n;
-    const SizeType start = (h->tail - n + h->cap) % h->cap;
+    behind = (behind >= h->cap) ? h->cap : behind;
+    n = (n >= behind) ? behind : n;
+    const SizeType start = (h->tail - behind + h->cap) % h->cap;
 
     for (SizeType i = 0; i < n; i++) {
         const SizeType index = (start + i) % h->cap;
@@ -107,23 +206,33 @@ void linear_spectrogram_update(LinearSpectrogram* spec,
 }
 
 void linear_spectrogram_render_wrap(const LinearSpectrogram* spec,
-                                    const FFTHistory* h)
+                                    const FFTHistory* h,
+                                    SizeType behind)
 {
+    // the newest `behind` columns aren't uploaded yet: the texture is only
+    // good up to `drawn`, which is where the cursor goes
+    behind = behind < h->len ? behind : h->len;
+    const SizeType drawn = (h->tail + h->cap - behind) % h->cap;
+    const SizeType width = h->len < h->cap ? h->len - behind : h->len;
+
     //                    REVERSED HORIZONTALLY v
-    const Rectangle src = {0, 0, (float)h->len,
+    const Rectangle src = {0, 0, (float)width,
                            -(float)spec->cfg.logical_height};
 
     const Rectangle* screen = &spec->cfg.screen;
     const float screen_draw_width =
-        ((float)h->len / (float)h->cap) * screen->width;
+        ((float)width / (float)h->cap) * screen->width;
     const Rectangle dest = {screen->x, screen->y, screen_draw_width,
                             screen->height};
 
-    DrawTexturePro(spec->texture, src, dest, (Vector2){0, 0}, 0.0f, WHITE);
+    {
+        TRACE_SCOPE(TRACE_DRAW);
+        DrawTexturePro(spec->texture, src, dest, (Vector2){0, 0}, 0.0f, WHITE);
+    }
 
     if (h->len >= h->cap) {
         const float cursor_x =
-            screen->x + ((float)h->tail / h->cap) * screen->width;
+            screen->x + ((float)drawn / (float)h->cap) * screen->width;
         DrawLineV((Vector2){cursor_x, screen->y},
                   (Vector2){cursor_x, screen->y + screen->height}, RED);
     }
@@ -3,37 +3,76 @@
 #include <raylib.h>
 
 #include "FFTAnalyzer.h"
+#include "core/arena.h"
 #include "core/colormap/colormap.h"
 #include "core/definitions.h"
+#include "core/frequency_axis.h"
+#include "core/sparse.h"
 
+// linear in time; in frequency at most one texture row per pixel of the
+// panel: bins are pooled down to the panel height before colour mapping and
+// upload, so the CPU work follows the panel size rather than the FFT size.
+// Panels taller than a linear bin count keep one row per bin
 typedef struct {
     // the actual config
     const Rectangle screen;
-    const SizeType logical_height;  // aliases the number of FFT bins
+    const SizeType logical_height;  // texture rows, bins or panel pixels
     const SizeType
         logical_width;  // number of datapoints, aliases the history size
     Colormap cmap;
+    const SizeType n_bins;  // per history row
+    const float bin_hz;     // bin b is centred on (b + 1) * bin_hz
+    const AxisRange axis;   // only used when remapping
+    const RowPooling pooling;  // how the bins of a pixel row combine
 
     // some cached values
     const float power_reference;  // defines 0dB
     const float min_dB;
 } LinearSpectrogramConfig;
 
+// AXIS_LINEAR pools only when the bins outnumber the panel's pixels, the
+// others always remap to the panel height
 LinearSpectrogramConfig linear_spectrogram_config(
     Rectangle screen,
     Colormap cmap,
-    const FFTConfig* analyzer_cfg);
+    const FFTConfig* analyzer_cfg,
+    FrequencyAxis axis,
+    RowPooling pooling);
+
+// for histories that don't come from an FFTAnalyzer: n_bins evenly spaced
+// bins computed from frames of frame_size samples, 0 dB is a full-scale sine
+// over a frame
+LinearSpectrogramConfig linear_spectrogram_config_bins(Rectangle screen,
+                                                       Colormap cmap,
+                                                       SizeType n_bins,
+                                                       SizeType frame_size,
+                                                       SizeType history_size,
+                                                       RowPooling pooling);
 
 typedef struct {
     Texture2D texture;
+    Arena arena;           // backs the buffers below but the remap
     Color* column_buffer;  // precomputed buffer to move data from CPU to GPU
+    float* power;          // |X|^2 of the column being drawn, per bin
+    SparseRows remap;      // bins to rows, unset for one row per bin
+    float* rows;           // pooled power, per row
     const LinearSpectrogramConfig cfg;
 } LinearSpectrogram;
 
 LinearSpectrogram linear_spectrogram_new(const LinearSpectrogramConfig* cfg);
+bool linear_spectrogram_ok(const LinearSpectrogram* spec);
 void linear_spectrogram_destroy(LinearSpectrogram* spec);
 void linear_spectrogram_update(LinearSpectrogram* spec,
                                const FFTHistory* h,
                                SizeType n);
+// draws the oldest n of the last `behind` rows of h, the rest is left for
+// later calls
+void linear_spectrogram_catch_up(LinearSpectrogram* spec,
+                                 const FFTHistory* h,
+                                 SizeType behind,
+                                 SizeType n);
+// h as far as it's been drawn, i.e. but for its newest `behind` rows; the
+// cursor marks the newest column drawn
 void linear_spectrogram_render_wrap(const LinearSpectrogram* spec,
-                                    const FFTHistory* h);
+                                    const FFTHistory* h,
+                                    SizeType behind);
@@ -0,0 +1,57 @@
+#include "LoudnessAnalyzer.h"
+
+LoudnessAnalyzer loudness_analyzer_new(float sample_rate,
+                                       LockFreeQueueConsumer sample_rx)
+{
+    return (LoudnessAnalyzer){
+        .hop = {0},
+        .meter = loudness_meter_new(sample_rate, LOUDNESS_RMS_SIZE),
+        .rx = sample_rx,
+        .rms = fhistory_new(HISTORY_SIZE),
+        .sample_peak = fhistory_new(HISTORY_SIZE),
+        .true_peak = fhistory_new(HISTORY_SIZE),
+        .momentary = fhistory_new(HISTORY_SIZE),
+        .short_term = fhistory_new(HISTORY_SIZE),
+    };
+}
+
+bool loudness_analyzer_ok(const LoudnessAnalyzer* analyzer)
+{
+    if (!analyzer) {
+        return false;
+    }
+
+    return loudness_meter_ok(&analyzer->meter);
+}
+
+void loudness_analyzer_destroy(LoudnessAnalyzer* analyzer)
+{
+    if (!analyzer) {
+        return;
+    }
+
+    loudness_meter_free(&analyzer->meter);
+    fhistory_destroy(analyzer->rms);
+    fhistory_destroy(analyzer->sample_peak);
+    fhistory_destroy(analyzer->true_peak);
+    fhistory_destroy(analyzer->momentary);
+    fhistory_destroy(analyzer->short_term);
+}
+
+SizeType loudness_analyzer_update(LoudnessAnalyzer* analyzer)
+{
+    SizeType n = 0;
+    while (clfq_pop(&analyzer->rx, analyzer->hop, LOUDNESS_STRIDE)) {
+        const LoudnessReading r = loudness_meter_process(
+            &analyzer->meter, analyzer->hop, LOUDNESS_STRIDE);
+
+        fhistory_push(&analyzer->rms, r.rms);
+        fhistory_push(&analyzer->sample_peak, r.sample_peak);
+        fhistory_push(&analyzer->true_peak, r.true_peak);
+        fhistory_push(&analyzer->momentary, r.momentary);
+        fhistory_push(&analyzer->short_term, r.short_term);
+        ++n;
+    }
+
+    return n;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "LockFreeQueue.h"
+
+#include "core/History.h"
+#include "dsp/loudness.h"
+
+#define LOUDNESS_RMS_SIZE 1024
+#define LOUDNESS_STRIDE (LOUDNESS_RMS_SIZE / 2)
+
+// one history entry per metric per stride
+typedef struct {
+    float hop[LOUDNESS_STRIDE];
+    LoudnessMeter meter;
+    LockFreeQueueConsumer rx;
+    FloatHistory rms;
+    FloatHistory sample_peak;
+    FloatHistory true_peak;
+    FloatHistory momentary;
+    FloatHistory short_term;
+} LoudnessAnalyzer;
+
+LoudnessAnalyzer loudness_analyzer_new(float sample_rate,
+                                       LockFreeQueueConsumer sample_rx);
+bool loudness_analyzer_ok(const LoudnessAnalyzer* analyzer);
+void loudness_analyzer_destroy(LoudnessAnalyzer* analyzer);
+
+// returns number of entries pushed onto each of its histories
+SizeType loudness_analyzer_update(LoudnessAnalyzer* analyzer);
@@ -0,0 +1,88 @@
+#include "PartialOverlay.h"
+
+#include "core/colormap/palette.h"
+
+// the quietest tracks still show
+#define PARTIAL_OVERLAY_MIN_ALPHA 0.25f
+
+PartialOverlay partial_overlay_new(Rectangle panel,
+                                   AxisRange axis,
+                                   float min_dB)
+{
+    return (PartialOverlay){
+        .panel = panel,
+        .axis = axis,
+        .min_dB = min_dB,
+        .visible = true,
+    };
+}
+
+void partial_overlay_toggle(PartialOverlay* overlay)
+{
+    overlay->visible = !overlay->visible;
+}
+
+// the history slot of the row a point was found in, false once it's gone
+static bool partial_overlay_slot(const PartialTracker* tracker,
+                                 const FFTHistory* h,
+                                 uint32_t frame,
+                                 SizeType* slot)
+{
+    const uint32_t behind = tracker->frames - 1 - frame;
+    if (behind >= h->len) {
+        return false;
+    }
+
+    *slot = (h->tail + h->cap - 1 - behind) % h->cap;
+    return true;
+}
+
+void partial_overlay_render(const PartialOverlay* overlay,
+                            const PartialTracker* tracker,
+                            const FFTHistory* h)
+{
+    if (!overlay->visible) {
+        return;
+    }
+
+    const Rectangle* panel = &overlay->panel;
+    const AxisRange* axis = &overlay->axis;
+    const PartialPoints* points = &tracker->points;
+    const float column_width = panel->width / (float)h->cap;
+
+    for (SizeType n = 0; n < points->len; ++n) {
+        const SizeType i = (points->head + n) % points->cap;
+        SizeType link;
+        SizeType to;
+        SizeType from;
+        if (!partial_points_link(points, i, &link) ||
+            !partial_overlay_slot(tracker, h, points->frame[i], &to) ||
+            !partial_overlay_slot(tracker, h, points->frame[link], &from) ||
+            from > to) {
+            continue;
+        }
+
+        const float f0 = points->hz[link];
+        const float f1 = points->hz[i];
+        if (f0 < axis->f_min || f0 > axis->f_max || f1 < axis->f_min ||
+            f1 > axis->f_max) {
+            continue;
+        }
+
+        // low frequencies at the bottom, like the spectrogram
+        const Vector2 start = {
+            panel->x + ((float)from + 0.5f) * column_width,
+            panel->y + panel->height * (1.0f - axis_range_position(axis, f0)),
+        };
+        const Vector2 end = {
+            panel->x + ((float)to + 0.5f) * column_width,
+            panel->y + panel->height * (1.0f - axis_range_position(axis, f1)),
+        };
+        const float loudness = 1.0f - points->dB[i] / overlay->min_dB;
+        const float alpha = loudness < PARTIAL_OVERLAY_MIN_ALPHA
+                                ? PARTIAL_OVERLAY_MIN_ALPHA
+                            : loudness > 1.0f ? 1.0f
+                                              : loudness;
+        DrawLineV(start, end, Fade(PARTIAL_COLOR, alpha));
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <raylib.h>
+#include <stdbool.h>
+
+#include "core/History.h"
+#include "core/definitions.h"
+#include "core/frequency_axis.h"
+#include "dsp/partials.h"
+
+// the tracks of a PartialTracker fed with every row of an FFTHistory, drawn
+// over its spectrogram: a segment from each point to the one before it in
+// its track, on the columns of the rows they were found in, fainter the
+// quieter. nothing is drawn across the write cursor or out of the axis
+typedef struct {
+    Rectangle panel;  // the spectrogram it sits on
+    AxisRange axis;   // and its frequency axis
+    float min_dB;     // the faintest, 0 dB is opaque
+    bool visible;
+} PartialOverlay;
+
+PartialOverlay partial_overlay_new(Rectangle panel,
+                                   AxisRange axis,
+                                   float min_dB);
+void partial_overlay_toggle(PartialOverlay* overlay);
+void partial_overlay_render(const PartialOverlay* overlay,
+                            const PartialTracker* tracker,
+                            const FFTHistory* h);
@@ -0,0 +1,90 @@
+#include "PitchOverlay.h"
+
+#include <stdlib.h>
+
+#include "core/colormap/palette.h"
+
+PitchOverlay pitch_overlay_new(Rectangle panel, AxisRange axis, SizeType cap)
+{
+    return (PitchOverlay){
+        .panel = panel,
+        .axis = axis,
+        .points = malloc(cap * sizeof(Vector2)),
+        .cap = cap,
+        .visible = true,
+    };
+}
+
+bool pitch_overlay_ok(const PitchOverlay* overlay)
+{
+    if (!overlay) {
+        return false;
+    }
+
+    return overlay->points != NULL;
+}
+
+void pitch_overlay_free(PitchOverlay* overlay)
+{
+    if (!overlay) {
+        return;
+    }
+
+    free(overlay->points);
+    overlay->points = NULL;
+}
+
+void pitch_overlay_toggle(PitchOverlay* overlay)
+{
+    overlay->visible = !overlay->visible;
+}
+
+static void pitch_overlay_flush(const PitchOverlay* overlay, SizeType n)
+{
+    if (n > 1) {
+        DrawLineStrip(overlay->points, (int)n, PITCH_COLOR);
+    }
+}
+
+void pitch_overlay_render(PitchOverlay* overlay,
+                          const FloatHistory* f0,
+                          const FloatHistory* clarity)
+{
+    if (!overlay->visible) {
+        return;
+    }
+
+    const Rectangle* panel = &overlay->panel;
+    const float column_width = panel->width / (float)f0->cap;
+    const SizeType newest = (f0->tail + f0->cap - 1) % f0->cap;
+
+    // slots in texture order, filled ones only until the rings wrap
+    SizeType n = 0;
+    float last_f = 0.0f;
+    for (SizeType i = 0; i < f0->len && i < overlay->cap; ++i) {
+        const float f = f0->data[i];
+        const bool clear = clarity->data[i] >= PITCH_OVERLAY_MIN_CLARITY &&
+                           f >= overlay->axis.f_min &&
+                           f <= overlay->axis.f_max;
+        const bool jump = n > 0 && (f > PITCH_OVERLAY_MAX_JUMP * last_f ||
+                                    last_f > PITCH_OVERLAY_MAX_JUMP * f);
+        if (!clear || jump) {
+            pitch_overlay_flush(overlay, n);
+            n = 0;
+        }
+        if (clear) {
+            // low frequencies at the bottom, like the spectrogram
+            const float position = axis_range_position(&overlay->axis, f);
+            overlay->points[n++] = (Vector2){
+                panel->x + ((float)i + 0.5f) * column_width,
+                panel->y + panel->height * (1.0f - position),
+            };
+            last_f = f;
+        }
+        if (i == newest) {
+            pitch_overlay_flush(overlay, n);
+            n = 0;
+        }
+    }
+    pitch_overlay_flush(overlay, n);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <raylib.h>
+#include <stdbool.h>
+
+#include "core/History.h"
+#include "core/definitions.h"
+#include "core/frequency_axis.h"
+
+// the f0 track of an FFTAnalyzer with cfg.pitch, drawn over its spectrogram
+// as polylines: slot i of the rings sits on texture column i like the
+// history rows they were pushed with. a line breaks where the pitch is
+// unclear, out of the axis' range, jumps by more than PITCH_OVERLAY_MAX_JUMP
+// or where the write cursor joins the newest column to the oldest
+#define PITCH_OVERLAY_MIN_CLARITY 0.8f
+#define PITCH_OVERLAY_MAX_JUMP 1.2f
+
+typedef struct {
+    Rectangle panel;  // the spectrogram it sits on
+    AxisRange axis;   // and its frequency axis
+    Vector2* points;  // [cap], one line's worth
+    SizeType cap;
+    bool visible;
+} PitchOverlay;
+
+// cap is the size of the rings it will draw
+PitchOverlay pitch_overlay_new(Rectangle panel, AxisRange axis, SizeType cap);
+bool pitch_overlay_ok(const PitchOverlay* overlay);
+void pitch_overlay_free(PitchOverlay* overlay);
+void pitch_overlay_toggle(PitchOverlay* overlay);
+void pitch_overlay_render(PitchOverlay* overlay,
+                          const FloatHistory* f0,
+                          const FloatHistory* clarity);
@@ -1,23 +1,12 @@
 #include "RMSAnalyzer.h"
 
 #include <math.h>
-#include <string.h>
-
-static float compute_rms(const float* restrict data, SizeType size)
-{
-    float sum = 0;
-
-    for (SizeType i = 0; i < size; i++) {
-        sum += data[i] * data[i];
-    }
-
-    return sqrtf(sum / (float)size);
-}
 
 RMSAnalyzer rms_analyzer_new(LockFreeQueueConsumer sample_rx)
 {
     return (RMSAnalyzer){
-        .buffer = {0},
+        .hop = {0},
+        .squares = sliding_sum_new(RMS_SIZE),
         .size = RMS_SIZE,
         .stride = RMS_STRIDE,
         .rx = sample_rx,
@@ -25,30 +14,40 @@ RMSAnalyzer rms_analyzer_new(LockFreeQueueConsumer sample_rx)
     };
 }
 
+bool rms_analyzer_ok(const RMSAnalyzer* analyzer)
+{
+    if (!analyzer) {
+        return false;
+    }
+
+    return sliding_sum_ok(&analyzer->squares);
+}
+
 void rms_analyzer_destroy(RMSAnalyzer* analyzer)
 {
     if (!analyzer) {
         return;
     }
 
+    sliding_sum_free(&analyzer->squares);
     fhistory_destroy(analyzer->history);
 }
 
 // returns number of elements pushed onto its history
 SizeType rms_analyzer_update(RMSAnalyzer* analyzer)
 {
-    // stride is the number of sample we discard and also the number of new
-    // samples we need to read
-    const SizeType to_keep = analyzer->size - analyzer->stride;
-    const SizeType to_read = analyzer->stride;
-
+    // only the new samples are touched, the window's sum of squares slides
+    // along with them
     SizeType n = 0;
-    while (clfq_pop(&analyzer->rx, analyzer->buffer + to_keep, to_read)) {
-        const float rms_value = compute_rms(analyzer->buffer, analyzer->size);
-        fhistory_push(&analyzer->history, rms_value);
-        // ditch the first to_read samples
-        memmove(analyzer->buffer, analyzer->buffer + to_read,
-                to_keep * sizeof(float));
+    while (clfq_pop(&analyzer->rx, analyzer->hop, analyzer->stride)) {
+        for (SizeType i = 0; i < analyzer->stride; ++i) {
+            const float x = analyzer->hop[i];
+            sliding_sum_push(&analyzer->squares, x * x);
+        }
+
+        const float mean_square = sliding_sum_mean(&analyzer->squares);
+        fhistory_push(&analyzer->history,
+                      mean_square > 0.0f ? sqrtf(mean_square) : 0.0f);
         ++n;
     }
 
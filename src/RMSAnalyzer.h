@@ -1,14 +1,18 @@
 #pragma once
 
+#include <stdbool.h>
+
 #include "LockFreeQueue.h"
 
 #include "core/History.h"
+#include "dsp/sliding.h"
 
 #define RMS_SIZE 1024
 #define RMS_STRIDE (RMS_SIZE / 2)
 
 typedef struct {
-    float buffer[RMS_SIZE];
+    float hop[RMS_STRIDE];
+    SlidingSum squares;
     SizeType size;
     SizeType stride;
     LockFreeQueueConsumer rx;
@@ -16,6 +20,7 @@ typedef struct {
 } RMSAnalyzer;
 
 RMSAnalyzer rms_analyzer_new(LockFreeQueueConsumer sample_rx);
+bool rms_analyzer_ok(const RMSAnalyzer* analyzer);
 void rms_analyzer_destroy(RMSAnalyzer* analyzer);
 
 // returns number of elements pushed onto its history
@@ -1,6 +1,9 @@
 #include "RMSVisualizer.h"
 
 #include <math.h>
+#include <stdlib.h>
+
+#include <rlgl.h>
 
 #include "core/colormap/colormap.h"
 
@@ -9,22 +12,15 @@ static float clamp_unit(float f)
     return fminf(fmaxf(f, 0.0f), 1.0f);
 }
 
-static Color float_to_color(float intensity, Colormap cmap, SizeType cmap_size)
+static Color float_to_color(float intensity, Colormap cmap)
 {
-    const float clamped = clamp_unit(intensity);
-    const int index = (int)(clamped * ((float)cmap_size - 0.0001f));
-    return *(const Color*)cmap[index];
+    return *(const Color*)colormap_sample(cmap, intensity);
 }
 
 RMSVisualizer rms_vis_new(SizeType size, float w, float h, Vector2 origin)
 {
-    Image img = GenImageColor((int)size, 1, BLACK);
-    Texture2D texture = LoadTextureFromImage(img);
-    UnloadImage(img);
-    SetTextureFilter(texture, TEXTURE_FILTER_BILINEAR);
-
     return (RMSVisualizer){
-        .texture = texture,
+        .bars = calloc(size, sizeof(RMSBar)),
         .height = h,
         .width = w,
         .origin = origin,
@@ -32,23 +28,38 @@ RMSVisualizer rms_vis_new(SizeType size, float w, float h, Vector2 origin)
     };
 }
 
+bool rms_vis_ok(const RMSVisualizer* rv)
+{
+    if (!rv) {
+        return false;
+    }
+
+    return rv->bars != NULL;
+}
+
 void rms_vis_destroy(RMSVisualizer* rv)
 {
     if (!rv) {
         return;
     }
 
-    UnloadTexture(rv->texture);
+    free(rv->bars);
 }
 
 static void rms_vis_update_value(RMSVisualizer* rv, float value, SizeType index)
 {
     Colormap cmap = plasma_rgba;
     value = clamp_unit(value);
-    const Color color = float_to_color(value, cmap, COLORMAP_SIZE);
-    const Color* pixels = &color;  // 1 pixel
 
-    UpdateTextureRec(rv->texture, (Rectangle){(float)index, 0, 1, 1}, pixels);
+    // centred vertically, like a mirrored waveform
+    const float height = value * rv->height;
+    const float top = 0.5f * (rv->height - height) - rv->origin.y;
+
+    rv->bars[index] = (RMSBar){
+        .top = top,
+        .bottom = top + height,
+        .color = float_to_color(value, cmap),
+    };
 }
 
 // called after processing and before drawing block
@@ -70,31 +81,27 @@ void rms_vis_update(RMSVisualizer* rv,
 void rms_vis_render_wrap(const RMSVisualizer* rv,
                          const FloatHistory* rms_history)
 {
-    const float band_width = (float)rv->width / (float)rms_history->cap;
-
-    for (SizeType i = 0; i < rms_history->cap; i++) {
-        if (rms_history->len < rms_history->cap && i >= rms_history->tail) {
-            break;
-        }
-
-        // stretch this
-        const Rectangle src = {(float)i, 0, 1, 1};
-
-        // to this
-        const float height = clamp_unit(rms_history->data[i]) * rv->height;
-        const Vector2 corner = {
-            i * band_width,
-            0.5f * (rv->height - height),
-        };
-        const Rectangle dest = {
-            corner.x,
-            corner.y,
-            band_width,
-            height,
-        };
-
-        const float angle = 0.0f;
-        const Color tint = WHITE;  // no tint
-        DrawTexturePro(rv->texture, src, dest, rv->origin, angle, tint);
+    const float band_width = rv->width / (float)rms_history->cap;
+    const SizeType count = rms_history->len < rms_history->cap
+                               ? rms_history->tail
+                               : rms_history->cap;
+
+    // rlgl's 1x1 default white texture, bound explicitly: quads otherwise
+    // sample whatever texture the previous draw left bound. every bar
+    // shares one draw call; same winding as raylib's own rectangles
+    rlSetTexture(rlGetTextureIdDefault());
+    rlBegin(RL_QUADS);
+    for (SizeType i = 0; i < count; i++) {
+        const RMSBar bar = rv->bars[i];
+        const float left = (float)i * band_width - rv->origin.x;
+        const float right = left + band_width;
+
+        rlColor4ub(bar.color.r, bar.color.g, bar.color.b, bar.color.a);
+        rlVertex2f(left, bar.top);
+        rlVertex2f(left, bar.bottom);
+        rlVertex2f(right, bar.bottom);
+        rlVertex2f(right, bar.top);
     }
+    rlEnd();
+    rlSetTexture(0);
 }
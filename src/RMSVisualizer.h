@@ -1,20 +1,29 @@
 #pragma once
 
+#include <stdbool.h>
+
 #include <raylib.h>
 
 #include "core/History.h"
 #include "core/definitions.h"
 
+// one quad per history entry, kept on the CPU and only rewritten for new
+// values; the whole graph goes out as a single batch
+typedef struct {
+    float top;
+    float bottom;
+    Color color;
+} RMSBar;
+
 typedef struct {
-    // the texture is contains the same info as the history
-    // except it's on the GPU
-    Texture2D texture;
+    RMSBar* bars;
     float height, width;
     Vector2 origin;
     SizeType size;
 } RMSVisualizer;
 
 RMSVisualizer rms_vis_new(SizeType size, float w, float h, Vector2 origin);
+bool rms_vis_ok(const RMSVisualizer* rv);
 void rms_vis_destroy(RMSVisualizer* rv);
 void rms_vis_update(RMSVisualizer* rv,
                     const FloatHistory* rms_history,
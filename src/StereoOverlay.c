@@ -0,0 +1,93 @@
+#include "StereoOverlay.h"
+
+#include <math.h>
+
+#include "core/colormap/palette.h"
+
+#define STEREO_BAR_WIDTH 120.0f
+#define STEREO_BAR_HEIGHT 4.0f
+#define STEREO_CORRELATION_WIDTH 240.0f
+#define STEREO_CORRELATION_HEIGHT 8.0f
+#define STEREO_LABEL_GAP 4
+
+StereoOverlay stereo_overlay_new(Rectangle panel, AxisRange axis)
+{
+    return (StereoOverlay){
+        .panel = panel,
+        .axis = axis,
+        .font_size = 10,
+        .visible = true,
+    };
+}
+
+void stereo_overlay_toggle(StereoOverlay* overlay)
+{
+    overlay->visible = !overlay->visible;
+}
+
+static void stereo_overlay_render_correlation(const StereoOverlay* overlay,
+                                              float correlation)
+{
+    const Rectangle* panel = &overlay->panel;
+    const float middle = panel->x + 0.5f * panel->width;
+    const float y = panel->y + STEREO_LABEL_GAP;
+    const float half = 0.5f * STEREO_CORRELATION_WIDTH;
+
+    DrawRectangleLinesEx((Rectangle){middle - half, y,
+                                     STEREO_CORRELATION_WIDTH,
+                                     STEREO_CORRELATION_HEIGHT},
+                         1.0f, Fade(TEXT_COLOR, 0.3f));
+    const float length = fminf(fmaxf(correlation, -1.0f), 1.0f) * half;
+    const Color color = correlation < 0.0f ? STEREO_ANTIPHASE_COLOR
+                                           : STEREO_COLOR;
+    DrawRectangleRec((Rectangle){length < 0.0f ? middle + length : middle, y,
+                                 fabsf(length), STEREO_CORRELATION_HEIGHT},
+                     color);
+
+    const char* label =
+        TextFormat("correlation %+.2f", (double)correlation);
+    DrawText(label, (int)(middle + half) + STEREO_LABEL_GAP, (int)y,
+             overlay->font_size, TEXT_COLOR);
+}
+
+void stereo_overlay_render(const StereoOverlay* overlay,
+                           const StereoMeter* meter)
+{
+    const FFTHistory* h = &meter->coherency;
+    if (!overlay->visible || h->len == 0) {
+        return;
+    }
+
+    const Rectangle* panel = &overlay->panel;
+    const float bar_x = panel->x + panel->width - STEREO_BAR_WIDTH;
+    const SizeType newest = (h->tail + h->cap - 1) % h->cap;
+    const float* gamma = (const float*)fft_history_get_row(h, newest);
+
+    for (SizeType band = 0; band < meter->n_bands; ++band) {
+        const float f = meter->band_hz[band];
+        if (f < overlay->axis.f_min || f > overlay->axis.f_max) {
+            continue;
+        }
+
+        // low frequencies at the bottom, like the spectrogram
+        const float position = axis_range_position(&overlay->axis, f);
+        const float y = panel->y + panel->height * (1.0f - position);
+
+        const float re = gamma[2 * band];
+        const float im = gamma[2 * band + 1];
+        const float coherence = fminf(re * re + im * im, 1.0f);
+        const float phase = fabsf(atan2f(im, re)) / PI;
+
+        DrawRectangleRec((Rectangle){bar_x, y - 0.5f * STEREO_BAR_HEIGHT,
+                                     coherence * STEREO_BAR_WIDTH,
+                                     STEREO_BAR_HEIGHT},
+                         ColorLerp(STEREO_COLOR, STEREO_ANTIPHASE_COLOR,
+                                   phase));
+    }
+
+    const FloatHistory* correlation = &meter->correlation;
+    stereo_overlay_render_correlation(
+        overlay,
+        correlation->data[(correlation->tail + correlation->cap - 1) %
+                          correlation->cap]);
+}
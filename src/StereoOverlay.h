@@ -0,0 +1,25 @@
+#pragma once
+
+#include <raylib.h>
+#include <stdbool.h>
+
+#include "core/definitions.h"
+#include "core/frequency_axis.h"
+#include "dsp/stereo.h"
+
+// where a StereoMeter stands now, over the spectrogram it was fed from: a
+// bar per band at the band's height on the frequency axis, as long as the
+// band's coherence and shading from STEREO_COLOR in phase to
+// STEREO_ANTIPHASE_COLOR in antiphase, and the broadband correlation as a
+// bar from the middle of the panel's top edge, right for +1, left for -1
+typedef struct {
+    Rectangle panel;  // the spectrogram it sits on
+    AxisRange axis;   // and its frequency axis
+    int font_size;
+    bool visible;
+} StereoOverlay;
+
+StereoOverlay stereo_overlay_new(Rectangle panel, AxisRange axis);
+void stereo_overlay_toggle(StereoOverlay* overlay);
+void stereo_overlay_render(const StereoOverlay* overlay,
+                           const StereoMeter* meter);
@@ -0,0 +1,65 @@
+#include "ToneOverlay.h"
+
+#include <math.h>
+
+#include "core/colormap/palette.h"
+
+#define TONE_BAR_WIDTH 120.0f
+#define TONE_BAR_HEIGHT 6.0f
+#define TONE_LABEL_GAP 4
+
+ToneOverlay tone_overlay_new(Rectangle panel, AxisRange axis)
+{
+    return (ToneOverlay){
+        .panel = panel,
+        .axis = axis,
+        .min_dB = -90.0f,
+        .font_size = 10,
+        .visible = true,
+    };
+}
+
+void tone_overlay_toggle(ToneOverlay* overlay)
+{
+    overlay->visible = !overlay->visible;
+}
+
+void tone_overlay_render(const ToneOverlay* overlay, const ToneBank* bank)
+{
+    if (!overlay->visible) {
+        return;
+    }
+
+    const Rectangle* panel = &overlay->panel;
+    const float bar_x = panel->x + panel->width - TONE_BAR_WIDTH;
+
+    for (SizeType t = 0; t < bank->n_tones; ++t) {
+        const float f = bank->frequencies[t];
+        if (f < overlay->axis.f_min || f > overlay->axis.f_max) {
+            continue;
+        }
+
+        // low frequencies at the bottom, like the spectrogram
+        const float position = axis_range_position(&overlay->axis, f);
+        const float y = panel->y + panel->height * (1.0f - position);
+
+        const float amplitude = tone_bank_magnitude(bank, t);
+        const float dB =
+            amplitude > 0.0f ? 20.0f * log10f(amplitude) : overlay->min_dB;
+        const float fill =
+            fminf(fmaxf(1.0f - dB / overlay->min_dB, 0.0f), 1.0f);
+
+        DrawLineV((Vector2){panel->x, y}, (Vector2){bar_x, y},
+                  Fade(TEXT_COLOR, 0.3f));
+        DrawRectangleRec((Rectangle){bar_x, y - 0.5f * TONE_BAR_HEIGHT,
+                                     fill * TONE_BAR_WIDTH, TONE_BAR_HEIGHT},
+                         TEXT_COLOR);
+
+        const char* label = TextFormat("%.0f Hz %.1f dB", (double)f,
+                                       (double)dB);
+        const int label_width = MeasureText(label, overlay->font_size);
+        DrawText(label, (int)bar_x - label_width - TONE_LABEL_GAP,
+                 (int)y - overlay->font_size / 2,
+                 overlay->font_size, TEXT_COLOR);
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <raylib.h>
+#include <stdbool.h>
+
+#include "core/definitions.h"
+#include "core/frequency_axis.h"
+#include "dsp/tone_bank.h"
+
+// marks every tracked tone on the spectrogram's frequency axis with its live
+// level, a line and a short bar per tone, nothing else
+typedef struct {
+    Rectangle panel;  // the spectrogram it sits on
+    AxisRange axis;   // and its frequency axis
+    float min_dB;     // an empty bar
+    int font_size;
+    bool visible;
+} ToneOverlay;
+
+ToneOverlay tone_overlay_new(Rectangle panel, AxisRange axis);
+void tone_overlay_toggle(ToneOverlay* overlay);
+void tone_overlay_render(const ToneOverlay* overlay, const ToneBank* bank);
@@ -0,0 +1,64 @@
+#include "TraceOverlay.h"
+
+#include "core/colormap/palette.h"
+
+#define OVERLAY_LINE_SPACING 4
+#define OVERLAY_PADDING 8
+
+TraceOverlay trace_overlay_new(Vector2 origin)
+{
+    return (TraceOverlay){
+        .origin = origin,
+        .font_size = 10,
+        .visible = false,
+        .refresh_period = 30,  // twice a second at 60 fps
+        .frames_since_refresh = 0,
+        .stats = {{0}},
+    };
+}
+
+void trace_overlay_toggle(TraceOverlay* overlay)
+{
+    overlay->visible = !overlay->visible;
+    // refresh on the next render rather than showing stale numbers
+    overlay->frames_since_refresh = overlay->refresh_period;
+}
+
+void trace_overlay_render(TraceOverlay* overlay)
+{
+    if (!overlay->visible) {
+        return;
+    }
+
+    if (overlay->frames_since_refresh >= overlay->refresh_period) {
+        trace_stage_stats(overlay->stats);
+        overlay->frames_since_refresh = 0;
+    }
+    ++overlay->frames_since_refresh;
+
+    const int line_height = overlay->font_size + OVERLAY_LINE_SPACING;
+    const int n_lines = 1 + TRACE_STAGE_COUNT;
+    const int x = (int)overlay->origin.x;
+    const int y = (int)overlay->origin.y;
+
+    DrawRectangle(x, y, 320, n_lines * line_height + 2 * OVERLAY_PADDING,
+                  Fade(BACKGROUND_COLOR, 0.8f));
+
+    const int text_x = x + OVERLAY_PADDING;
+    int text_y = y + OVERLAY_PADDING;
+    DrawText("stage                   p50 us     p99 us", text_x, text_y,
+             overlay->font_size, TEXT_COLOR);
+
+    for (SizeType s = 0; s < TRACE_STAGE_COUNT; ++s) {
+        text_y += line_height;
+        const TraceStageStats* st = &overlay->stats[s];
+        const char* line =
+            (st->count == 0)
+                ? TextFormat("%-20s         -          -",
+                             trace_stage_name((TraceStage)s))
+                : TextFormat("%-20s %10.1f %10.1f",
+                             trace_stage_name((TraceStage)s),
+                             (double)st->p50_us, (double)st->p99_us);
+        DrawText(line, text_x, text_y, overlay->font_size, TEXT_COLOR);
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <raylib.h>
+#include <stdbool.h>
+
+#include "core/definitions.h"
+#include "trace/trace.h"
+
+// on-screen table of per-stage p50/p99, only meaningful with SPECTRE_TRACE
+typedef struct {
+    Vector2 origin;
+    int font_size;
+    bool visible;
+
+    // percentiles are recomputed every `refresh_period` renders, sorting a few
+    // thousand spans every frame would show up in the very stats we display
+    SizeType refresh_period;
+    SizeType frames_since_refresh;
+    TraceStageStats stats[TRACE_STAGE_COUNT];
+} TraceOverlay;
+
+TraceOverlay trace_overlay_new(Vector2 origin);
+void trace_overlay_toggle(TraceOverlay* overlay);
+void trace_overlay_render(TraceOverlay* overlay);
@@ -0,0 +1,104 @@
+#include "WaveformVisualizer.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "core/colormap/palette.h"
+
+WaveformVisualizer waveform_vis_new(Rectangle panel,
+                                    float sample_rate,
+                                    float max_seconds)
+{
+    const SizeType columns = panel.width > 1.0f ? (SizeType)panel.width : 1;
+    return (WaveformVisualizer){
+        .panel = panel,
+        .sample_rate = sample_rate,
+        .seconds = max_seconds,
+        .max_seconds = max_seconds,
+        // the envelope's strip, then the RMS'
+        .points = malloc(4 * columns * sizeof(Vector2)),
+        .columns = columns,
+    };
+}
+
+bool waveform_vis_ok(const WaveformVisualizer* vis)
+{
+    if (!vis) {
+        return false;
+    }
+
+    return vis->points != NULL;
+}
+
+void waveform_vis_destroy(WaveformVisualizer* vis)
+{
+    if (!vis) {
+        return;
+    }
+
+    free(vis->points);
+    vis->points = NULL;
+}
+
+void waveform_vis_zoom(WaveformVisualizer* vis, float factor)
+{
+    const float seconds = vis->seconds * factor;
+    const float lowest =
+        WAVEFORM_MIN_SECONDS < vis->max_seconds ? WAVEFORM_MIN_SECONDS
+                                                : vis->max_seconds;
+    vis->seconds = seconds < lowest            ? lowest
+                   : seconds > vis->max_seconds ? vis->max_seconds
+                                                : seconds;
+}
+
+static float waveform_vis_y(const WaveformVisualizer* vis, float amplitude)
+{
+    amplitude = amplitude < -1.0f ? -1.0f : amplitude > 1.0f ? 1.0f : amplitude;
+    const float half = 0.5f * vis->panel.height;
+    return vis->panel.y + half - amplitude * half;
+}
+
+void waveform_vis_render(WaveformVisualizer* vis,
+                         const WaveformPyramid* pyramid)
+{
+    const SizeType columns = vis->columns;
+    const uint64_t span = (uint64_t)(vis->seconds * vis->sample_rate);
+    const uint64_t end = pyramid->samples;
+    const SizeType level =
+        waveform_pyramid_level_for((float)span / (float)columns);
+
+    Vector2* envelope = vis->points;
+    Vector2* rms = vis->points + 2 * columns;
+    SizeType n = 0;
+    for (SizeType c = 0; c < columns; ++c) {
+        // in samples from the right edge, which is the newest one
+        const uint64_t back_from = span - span * c / columns;
+        const uint64_t back_to = span - span * (c + 1) / columns;
+        if (back_from > end) {
+            continue;
+        }
+        const WaveformSpan s = waveform_pyramid_span(
+            pyramid, level, end - back_from, end - back_to);
+        if (s.samples == 0) {
+            continue;
+        }
+
+        // down one column and up the next, so the strip joins them along
+        // the edges of the envelope rather than across it
+        const float x = vis->panel.x + (float)c + 0.5f;
+        const float r = waveform_span_rms(&s);
+        const SizeType top = n % 2 == 0 ? 0 : 1;
+        envelope[2 * n + top] = (Vector2){x, waveform_vis_y(vis, s.max)};
+        envelope[2 * n + 1 - top] = (Vector2){x, waveform_vis_y(vis, s.min)};
+        rms[2 * n + top] = (Vector2){x, waveform_vis_y(vis, r)};
+        rms[2 * n + 1 - top] = (Vector2){x, waveform_vis_y(vis, -r)};
+        ++n;
+    }
+
+    if (n > 0) {
+        DrawLineStrip(envelope, (int)(2 * n), WAVEFORM_COLOR);
+        DrawLineStrip(rms, (int)(2 * n), WAVEFORM_RMS_COLOR);
+    }
+    DrawText(TextFormat("%.1f s", (double)vis->seconds),
+             (int)vis->panel.x + 10, (int)vis->panel.y + 10, 10, TEXT_COLOR);
+}
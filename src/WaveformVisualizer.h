@@ -0,0 +1,33 @@
+#pragma once
+
+#include <raylib.h>
+#include <stdbool.h>
+
+#include "core/definitions.h"
+#include "core/waveform.h"
+
+// the last `seconds` of a WaveformPyramid, one column per pixel: the min/max
+// envelope, and the RMS over it, each one line strip zig-zagging through the
+// columns. every column reads the level whose entries fit in it, so a frame
+// costs the same for a second of audio as for an hour
+#define WAVEFORM_MIN_SECONDS 0.5f
+
+typedef struct {
+    Rectangle panel;
+    float sample_rate;
+    float seconds;      // on screen
+    float max_seconds;  // what the pyramid keeps
+    Vector2* points;    // [2 * columns], one strip's worth
+    SizeType columns;
+} WaveformVisualizer;
+
+WaveformVisualizer waveform_vis_new(Rectangle panel,
+                                    float sample_rate,
+                                    float max_seconds);
+bool waveform_vis_ok(const WaveformVisualizer* vis);
+void waveform_vis_destroy(WaveformVisualizer* vis);
+
+// more than 1 zooms out, within WAVEFORM_MIN_SECONDS and max_seconds
+void waveform_vis_zoom(WaveformVisualizer* vis, float factor);
+void waveform_vis_render(WaveformVisualizer* vis,
+                         const WaveformPyramid* pyramid);
@@ -0,0 +1,114 @@
+#include "ZoomAnalyzer.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dsp/window.h"
+
+ZoomAnalyzer zoom_analyzer_new(const ZoomConfig* cfg)
+{
+    ZoomAnalyzer zoom = {.cfg = *cfg};
+
+    if (!(cfg->resolution > 0.0f) || !(cfg->f_hi > cfg->f_lo) ||
+        cfg->overlap == 0) {
+        return zoom;
+    }
+
+    const SizeType size =
+        (SizeType)lroundf(cfg->sample_rate / cfg->resolution);
+    SizeType n_points =
+        1 + (SizeType)floorf((cfg->f_hi - cfg->f_lo) / cfg->resolution);
+    n_points = n_points > ZOOM_MAX_POINTS ? ZOOM_MAX_POINTS : n_points;
+    // the CZT wants a span, two points at least
+    n_points = n_points < 2 ? 2 : n_points;
+
+    zoom.size = size;
+    zoom.stride = size / cfg->overlap > 0 ? size / cfg->overlap : 1;
+    zoom.n_points = n_points;
+    zoom.czt = czt_new(size, n_points, cfg->f_lo, cfg->f_hi, cfg->sample_rate);
+    zoom.input = calloc(size, sizeof(float));
+    zoom.buffer = malloc(size * sizeof(float));
+    zoom.window = malloc(size * sizeof(float));
+    zoom.row = malloc(n_points * sizeof(Complex));
+    zoom.history = fft_history_new(cfg->history_size, n_points);
+
+    if (zoom.window != NULL) {
+        window_make_hann(zoom.window, size);
+    }
+
+    return zoom;
+}
+
+bool zoom_analyzer_ok(const ZoomAnalyzer* zoom)
+{
+    if (!zoom) {
+        return false;
+    }
+
+    return czt_ok(&zoom->czt) && zoom->input && zoom->buffer &&
+           zoom->window && zoom->row && zoom->history.data;
+}
+
+void zoom_analyzer_free(ZoomAnalyzer* zoom)
+{
+    if (!zoom) {
+        return;
+    }
+
+    czt_free(&zoom->czt);
+    free(zoom->input);
+    free(zoom->buffer);
+    free(zoom->window);
+    free(zoom->row);
+    fft_history_free(&zoom->history);
+}
+
+static void zoom_analyzer_frame(ZoomAnalyzer* zoom)
+{
+    memcpy(zoom->buffer, zoom->input, zoom->size * sizeof(float));
+    window_apply(zoom->buffer, zoom->window, zoom->size);
+
+    czt_process(&zoom->czt, zoom->buffer, zoom->row);
+    fft_history_push(&zoom->history, zoom->row);
+}
+
+SizeType zoom_analyzer_push(ZoomAnalyzer* zoom,
+                            const float* samples,
+                            SizeType size)
+{
+    const SizeType to_keep = zoom->size - zoom->stride;
+
+    SizeType n = 0;
+    while (size > 0) {
+        const SizeType missing = zoom->stride - zoom->pending;
+        const SizeType take = size < missing ? size : missing;
+        memcpy(zoom->input + to_keep + zoom->pending, samples,
+               take * sizeof(float));
+        zoom->pending += take;
+        samples += take;
+        size -= take;
+
+        if (zoom->pending < zoom->stride) {
+            break;
+        }
+
+        zoom_analyzer_frame(zoom);
+
+        // make way for the next frame
+        memmove(zoom->input, zoom->input + zoom->stride,
+                to_keep * sizeof(float));
+        zoom->pending = 0;
+        ++n;
+    }
+
+    zoom->unseen += n;
+    return n;
+}
+
+SizeType zoom_analyzer_take_new(ZoomAnalyzer* zoom)
+{
+    const SizeType n = zoom->unseen;
+    zoom->unseen = 0;
+    return n;
+}
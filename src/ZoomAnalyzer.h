@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "core/History.h"
+#include "core/definitions.h"
+#include "dsp/czt.h"
+
+#define ZOOM_MAX_POINTS 4096
+
+// a narrow band at a resolution the full-spectrum FFT can't afford
+//
+// frames are sample_rate / resolution long (10 s for 0.1 Hz), and the band is
+// evaluated with a chirp-Z transform at one point per resolution step, so the
+// cost scales with the frame length and the points in the band, never with
+// the bins outside it
+typedef struct {
+    const float f_lo;
+    const float f_hi;
+    const float resolution;  // Hz
+    const SizeType overlap;  // frames per frame length, stride = size / overlap
+    const float sample_rate;
+    const SizeType history_size;
+} ZoomConfig;
+
+typedef struct {
+    ZoomConfig cfg;
+    SizeType size;  // frame length, samples
+    SizeType stride;
+    SizeType n_points;
+
+    CZT czt;
+    float* input;   // where we collect the samples
+    float* buffer;  // where we window them
+    float* window;
+    Complex* row;
+    SizeType pending;  // fresh samples collected towards the next frame
+
+    FFTHistory history;
+    SizeType unseen;  // frames pushed since the last zoom_analyzer_take_new
+} ZoomAnalyzer;
+
+ZoomAnalyzer zoom_analyzer_new(const ZoomConfig* cfg);
+bool zoom_analyzer_ok(const ZoomAnalyzer* zoom);
+void zoom_analyzer_free(ZoomAnalyzer* zoom);
+
+// returns number of frames pushed onto the history
+SizeType zoom_analyzer_push(ZoomAnalyzer* zoom,
+                            const float* samples,
+                            SizeType size);
+
+// frames pushed since the previous call, for whoever draws the history
+SizeType zoom_analyzer_take_new(ZoomAnalyzer* zoom);
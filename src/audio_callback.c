@@ -5,30 +5,73 @@
 #include <stdlib.h>
 
 #include "core/definitions.h"
+#include "trace/trace.h"
 
 #define MONO_BUFFER_SIZE 1024
 
 static float mono_buffer[MONO_BUFFER_SIZE];
+static float side_buffer[MONO_BUFFER_SIZE];
 
 static _Atomic(LockFreeQueueProducer*) s_sample_tx = NULL;
+static _Atomic(LockFreeQueueProducer*) s_side_tx = NULL;
+static _Atomic(CaptureRecorder*) s_recorder = NULL;
+static _Atomic(LatencyTracker*) s_latency = NULL;
 
 void init_audio_processor(LockFreeQueueProducer* sample_tx_passed)
 {
     atomic_store_explicit(&s_sample_tx, sample_tx_passed, memory_order_release);
 }
 
-void deinit_audio_processor(void) {}
+void deinit_audio_processor(void)
+{
+    atomic_store_explicit(&s_side_tx, NULL, memory_order_release);
+    atomic_store_explicit(&s_recorder, NULL, memory_order_release);
+    atomic_store_explicit(&s_latency, NULL, memory_order_release);
+}
+
+void attach_side_queue(LockFreeQueueProducer* side_tx)
+{
+    atomic_store_explicit(&s_side_tx, side_tx, memory_order_release);
+}
+
+void attach_capture_recorder(CaptureRecorder* recorder)
+{
+    atomic_store_explicit(&s_recorder, recorder, memory_order_release);
+}
+
+void attach_latency_tracker(LatencyTracker* tracker)
+{
+    atomic_store_explicit(&s_latency, tracker, memory_order_release);
+}
 
-// always interleaved stereo
 void pull_samples_from_audio_thread(void* buffer, unsigned int frames)
 {
+    push_samples_from_audio_thread(buffer, frames);
+}
+
+// always interleaved stereo
+void push_samples_from_audio_thread(const void* buffer, unsigned int frames)
+{
+    TRACE_THREAD_NAME("audio");
+    TRACE_SCOPE(TRACE_AUDIO_CALLBACK);
+
     LockFreeQueueProducer* restrict sample_tx =
         atomic_load_explicit(&s_sample_tx, memory_order_acquire);
     assert(sample_tx != NULL);
 
+    LockFreeQueueProducer* restrict side_tx =
+        atomic_load_explicit(&s_side_tx, memory_order_acquire);
+
     const float* restrict samples = (const float*)buffer;
 
+    CaptureRecorder* recorder =
+        atomic_load_explicit(&s_recorder, memory_order_acquire);
+    if (recorder != NULL) {
+        capture_recorder_push(recorder, samples, frames);
+    }
+
     SizeType start = 0;
+    SizeType pushed = 0;
     while (frames != 0) {
         const SizeType to_pull =
             frames <= MONO_BUFFER_SIZE ? frames : MONO_BUFFER_SIZE;
@@ -38,12 +81,30 @@ void pull_samples_from_audio_thread(void* buffer, unsigned int frames)
             mono_buffer[i] = 0.5f * (samples[j] + samples[j + 1]);
         }
 
+        SizeType to_push = to_pull;
+        if (side_tx != NULL) {
+            for (SizeType i = 0; i < to_pull; i++) {
+                const SizeType j = 2 * (start + i);
+                side_buffer[i] = 0.5f * (samples[j] - samples[j + 1]);
+            }
+            // the mid queue never holds more than the side one, whatever
+            // side took fits
+            to_push = clfq_push_partial(side_tx, side_buffer, to_pull, 1);
+        }
+
         const SizeType transmitted =
-            clfq_push_partial(sample_tx, mono_buffer, to_pull, 1);
+            clfq_push_partial(sample_tx, mono_buffer, to_push, 1);
+        pushed += transmitted;
         if (transmitted < to_pull) {
             break;
         }
         start += transmitted;
         frames -= transmitted;
     }
+
+    LatencyTracker* latency =
+        atomic_load_explicit(&s_latency, memory_order_acquire);
+    if (latency != NULL) {
+        latency_tracker_on_block(latency, pushed);
+    }
 }
@@ -2,7 +2,28 @@
 
 #include "LockFreeQueue.h"
 
+#include "LatencyTracker.h"
+#include "capture/CaptureRecorder.h"
+
 void init_audio_processor(LockFreeQueueProducer* sample_tx_passed);
 void deinit_audio_processor(void);
 
+// optional, every block the callback sees is also handed to the recorder
+void attach_capture_recorder(CaptureRecorder* recorder);
+
+// optional, once attached the callback pushes the mid channel (L + R) / 2
+// onto the sample queue and the side channel (L - R) / 2 onto this one,
+// always side first and never more mid than side went through: a consumer
+// that pops mid before side always finds the side it needs
+//
+// attach before the audio starts, the two must start out in step
+void attach_side_queue(LockFreeQueueProducer* side_tx);
+
+// optional, every block is stamped for audio-to-pixel latency measurement
+void attach_latency_tracker(LatencyTracker* tracker);
+
+// raylib's mixed processor signature
 void pull_samples_from_audio_thread(void* buffer, unsigned int frames);
+
+// the same for any other audio thread, e.g. a capture device's
+void push_samples_from_audio_thread(const void* buffer, unsigned int frames);
@@ -0,0 +1,204 @@
+#if defined(__unix__) || defined(__APPLE__)
+// mmap is POSIX, not C11
+#define _POSIX_C_SOURCE 200112L
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CACHE_MMAP 1
+#endif
+
+#include "CacheReader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(CACHE_MMAP)
+static uint8_t* map_whole_file(const char* path, uint64_t* size)
+{
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    uint8_t* data = NULL;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* p = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            data = p;
+            *size = (uint64_t)st.st_size;
+        }
+    }
+
+    // the mapping outlives the descriptor
+    close(fd);
+    return data;
+}
+#else
+static uint8_t* read_whole_file(const char* path, uint64_t* size)
+{
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+
+    uint8_t* data = NULL;
+    if (fseek(f, 0, SEEK_END) != 0) {
+        goto done;
+    }
+    const long len = ftell(f);
+    if (len < 0 || fseek(f, 0, SEEK_SET) != 0) {
+        goto done;
+    }
+
+    data = malloc((size_t)len);
+    if (data != NULL && fread(data, 1, (size_t)len, f) != (size_t)len) {
+        free(data);
+        data = NULL;
+    }
+    *size = (uint64_t)len;
+
+done:
+    fclose(f);
+    return data;
+}
+#endif
+
+static void release(uint8_t* data, uint64_t size, bool mapped)
+{
+#if defined(CACHE_MMAP)
+    if (mapped) {
+        munmap(data, (size_t)size);
+        return;
+    }
+#endif
+    (void)size;
+    (void)mapped;
+    free(data);
+}
+
+static uint64_t storage_bytes(uint32_t storage)
+{
+    return storage == CACHE_STORAGE_COMPLEX ? sizeof(Complex) : sizeof(float);
+}
+
+CacheReader cache_reader_new(const char* path)
+{
+    CacheReader r = {0};
+
+    uint64_t size = 0;
+#if defined(CACHE_MMAP)
+    uint8_t* data = map_whole_file(path, &size);
+    const bool mapped = true;
+#else
+    uint8_t* data = read_whole_file(path, &size);
+    const bool mapped = false;
+#endif
+    if (data == NULL) {
+        return r;
+    }
+
+    CacheFileHeader header;
+    if (size < CACHE_PAGE_SIZE) {
+        release(data, size, mapped);
+        return r;
+    }
+    memcpy(&header, data, sizeof(header));
+
+    const bool known_storage = header.storage == CACHE_STORAGE_COMPLEX ||
+                               header.storage == CACHE_STORAGE_FLOAT;
+    const bool valid =
+        memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) == 0 &&
+        header.version == CACHE_VERSION && known_storage &&
+        header.n_bins != 0 && header.frames_per_tile != 0 &&
+        header.tile_bytes % CACHE_PAGE_SIZE == 0 &&
+        (uint64_t)header.frames_per_tile * header.n_bins *
+                storage_bytes(header.storage) <=
+            header.tile_bytes;
+    if (!valid) {
+        release(data, size, mapped);
+        return r;
+    }
+
+    // a header can only be ahead of its tiles if the file was cut short
+    const uint64_t whole_tiles = (size - CACHE_PAGE_SIZE) / header.tile_bytes;
+    const uint64_t on_disk = whole_tiles * header.frames_per_tile;
+
+    r.data = data;
+    r.size = size;
+    r.header = header;
+    r.n_frames = header.n_frames < on_disk ? header.n_frames : on_disk;
+    r.mapped = mapped;
+    return r;
+}
+
+bool cache_reader_ok(const CacheReader* r)
+{
+    if (!r) {
+        return false;
+    }
+
+    return r->data != NULL;
+}
+
+void cache_reader_free(CacheReader* r)
+{
+    if (!r || r->data == NULL) {
+        return;
+    }
+
+    release(r->data, r->size, r->mapped);
+    *r = (CacheReader){0};
+}
+
+bool cache_reader_matches(const CacheReader* r,
+                          const FFTConfig* cfg,
+                          uint64_t source_hash)
+{
+    const CacheFileHeader* h = &r->header;
+    const uint32_t decimation = cfg->decimation > 1 ? cfg->decimation : 1;
+
+    // only complex rows of the configuration's width stand in for an
+    // FFTHistory, e.g. a snapshot's |X|^2 never does
+    return cache_reader_ok(r) && h->source_hash == source_hash &&
+           h->storage == CACHE_STORAGE_COMPLEX &&
+           h->n_bins == cfg->size / 2 && h->fft_size == cfg->size &&
+           h->stride == cfg->stride &&
+           h->decimation == decimation &&
+           h->sample_rate == cfg->sample_rate &&
+           h->dc_blocker_frequency == cfg->dc_blocker_frequency;
+}
+
+const void* cache_reader_frame(const CacheReader* r, uint64_t i)
+{
+    const CacheFileHeader* h = &r->header;
+    const uint64_t tile = i / h->frames_per_tile;
+    const uint64_t in_tile = i % h->frames_per_tile;
+
+    return r->data + CACHE_PAGE_SIZE + tile * h->tile_bytes +
+           in_tile * h->n_bins * storage_bytes(h->storage);
+}
+
+SizeType cache_reader_n_tiles(const CacheReader* r)
+{
+    const uint64_t per_tile = r->header.frames_per_tile;
+    return (SizeType)((r->n_frames + per_tile - 1) / per_tile);
+}
+
+FFTHistory cache_reader_tile(const CacheReader* r, SizeType tile)
+{
+    const CacheFileHeader* h = &r->header;
+    const uint64_t first = (uint64_t)tile * h->frames_per_tile;
+    const uint64_t left = r->n_frames - first;
+    const SizeType len =
+        (SizeType)(left < h->frames_per_tile ? left : h->frames_per_tile);
+
+    Complex* data = (Complex*)(r->data + CACHE_PAGE_SIZE +
+                               (uint64_t)tile * h->tile_bytes);
+    FFTHistory history = fft_history_from(data, len, h->n_bins);
+    history.len = len;
+    return history;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "FFTAnalyzer.h"
+#include "cache/cache_file.h"
+#include "core/definitions.h"
+
+// reads back a spectrogram cache written by CacheWriter
+//
+// on POSIX systems the file is mapped, copy-on-write: opening costs nothing
+// up front and a frame is paged in when it's first read. elsewhere the whole
+// file is loaded, like a CaptureReplayer
+typedef struct {
+    uint8_t* data;
+    uint64_t size;
+    CacheFileHeader header;
+    uint64_t n_frames;  // committed frames that are actually in the file
+    bool mapped;
+} CacheReader;
+
+CacheReader cache_reader_new(const char* path);
+bool cache_reader_ok(const CacheReader* r);
+void cache_reader_free(CacheReader* r);
+
+// whether the frames came from these samples through this configuration,
+// i.e. can stand in for analyzing them again: CACHE_STORAGE_COMPLEX rows of
+// cfg->size / 2 bins
+bool cache_reader_matches(const CacheReader* r,
+                          const FFTConfig* cfg,
+                          uint64_t source_hash);
+
+// n_bins values of the file's storage, i < n_frames
+const void* cache_reader_frame(const CacheReader* r, uint64_t i);
+
+SizeType cache_reader_n_tiles(const CacheReader* r);
+
+// a CACHE_STORAGE_COMPLEX tile as a full history, oldest frame first, no
+// copy; writing to it never reaches the file
+FFTHistory cache_reader_tile(const CacheReader* r, SizeType tile);
@@ -0,0 +1,150 @@
+#include "CacheWriter.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+uint64_t cache_hash(uint64_t hash, const void* data, size_t size)
+{
+    const uint8_t* bytes = data;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static SizeType storage_bytes(CacheStorage storage)
+{
+    return storage == CACHE_STORAGE_COMPLEX ? (SizeType)sizeof(Complex)
+                                            : (SizeType)sizeof(float);
+}
+
+static bool write_header(CacheWriter* w)
+{
+    uint8_t page[CACHE_PAGE_SIZE] = {0};
+    memcpy(page, &w->header, sizeof(w->header));
+
+    return fseek(w->file, 0, SEEK_SET) == 0 &&
+           fwrite(page, sizeof(page), 1, w->file) == 1;
+}
+
+CacheWriter* cache_writer_new(const char* path,
+                              const FFTConfig* cfg,
+                              CacheStorage storage,
+                              SizeType n_bins,
+                              uint64_t source_hash)
+{
+    const SizeType frame_bytes = n_bins * storage_bytes(storage);
+    const SizeType payload = CACHE_FRAMES_PER_TILE * frame_bytes;
+    const SizeType tile_bytes =
+        (payload + CACHE_PAGE_SIZE - 1) / CACHE_PAGE_SIZE * CACHE_PAGE_SIZE;
+
+    CacheWriter* w = malloc(sizeof(*w));
+    uint8_t* tile = calloc(tile_bytes, 1);
+    FILE* file = fopen(path, "wb");
+    if (w == NULL || tile == NULL || file == NULL || n_bins == 0) {
+        goto fail;
+    }
+
+    *w = (CacheWriter){
+        .file = file,
+        .header = {
+            .version = CACHE_VERSION,
+            .storage = (uint32_t)storage,
+            .n_bins = n_bins,
+            .frames_per_tile = CACHE_FRAMES_PER_TILE,
+            .tile_bytes = tile_bytes,
+            .n_frames = 0,
+            .source_hash = source_hash,
+            .fft_size = cfg->size,
+            .stride = cfg->stride,
+            .decimation = cfg->decimation > 1 ? cfg->decimation : 1,
+            .features = cfg->features,
+            .sample_rate = cfg->sample_rate,
+            .dc_blocker_frequency = cfg->dc_blocker_frequency,
+        },
+        .tile = tile,
+        .frame_bytes = frame_bytes,
+        .staged = 0,
+    };
+    memcpy(w->header.magic, CACHE_MAGIC, sizeof(w->header.magic));
+    if (!write_header(w)) {
+        goto fail;
+    }
+
+    return w;
+
+fail:
+    if (file != NULL) {
+        fclose(file);
+    }
+    free(tile);
+    free(w);
+    return NULL;
+}
+
+// the staged frames, padded to a whole tile, then the count that makes them
+// visible; a tile is only flushed partial when the writer closes
+static bool flush_tile(CacheWriter* w)
+{
+    const CacheFileHeader* h = &w->header;
+    const uint64_t tile_index = h->n_frames / h->frames_per_tile;
+    const long offset =
+        (long)(CACHE_PAGE_SIZE + tile_index * (uint64_t)h->tile_bytes);
+
+    bool ok = fseek(w->file, offset, SEEK_SET) == 0 &&
+              fwrite(w->tile, h->tile_bytes, 1, w->file) == 1 &&
+              fflush(w->file) == 0;
+    if (!ok) {
+        return false;
+    }
+
+    w->header.n_frames = tile_index * h->frames_per_tile + w->staged;
+    ok = write_header(w) && fflush(w->file) == 0;
+
+    if (w->staged == w->header.frames_per_tile) {
+        memset(w->tile, 0, w->header.tile_bytes);
+        w->staged = 0;
+    }
+    return ok;
+}
+
+void cache_writer_free(CacheWriter* w)
+{
+    if (!w) {
+        return;
+    }
+
+    if (w->staged > 0 && !flush_tile(w)) {
+        fprintf(stderr, "cache: failed to write the last tile\n");
+    }
+
+    fclose(w->file);
+    free(w->tile);
+    free(w);
+}
+
+bool cache_writer_push(CacheWriter* w, const void* frame)
+{
+    memcpy(w->tile + (size_t)w->staged * w->frame_bytes, frame,
+           w->frame_bytes);
+    ++w->staged;
+
+    if (w->staged < w->header.frames_per_tile) {
+        return true;
+    }
+    return flush_tile(w);
+}
+
+bool cache_writer_push_history(CacheWriter* w,
+                               const FFTHistory* h,
+                               SizeType n)
+{
+    n = (n >= h->cap) ? h->cap : n;
+    const SizeType start = (h->tail - n + h->cap) % h->cap;
+
+    bool ok = true;
+    for (SizeType i = 0; i < n && ok; i++) {
+        ok = cache_writer_push(w, fft_history_get_row(h, (start + i) % h->cap));
+    }
+    return ok;
+}
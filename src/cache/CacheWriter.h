@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "FFTAnalyzer.h"
+#include "cache/cache_file.h"
+#include "core/definitions.h"
+
+// ~0.7 s of 48 kHz at a 512 stride, 512 KiB of FFT_SIZE frames
+#define CACHE_FRAMES_PER_TILE 64
+
+// FNV-1a, the seed and step for a source_hash over any bytes
+#define CACHE_HASH_SEED 0xcbf29ce484222325ull
+uint64_t cache_hash(uint64_t hash, const void* data, size_t size);
+
+// appends analysis frames to a spectrogram cache file, a tile at a time
+//
+// frames are staged in memory until a tile is full, then the tile goes to
+// disk followed by the header's frame count. meant for the main thread, or
+// any thread that already owns the frames: it does blocking I/O
+typedef struct {
+    FILE* file;
+    CacheFileHeader header;
+    uint8_t* tile;  // being filled
+    SizeType frame_bytes;
+    SizeType staged;  // frames in `tile`
+} CacheWriter;
+
+// NULL when the file can't be created
+CacheWriter* cache_writer_new(const char* path,
+                              const FFTConfig* cfg,
+                              CacheStorage storage,
+                              SizeType n_bins,
+                              uint64_t source_hash);
+void cache_writer_free(CacheWriter* w);  // flushes the last tile then closes
+
+// one frame of n_bins values of the writer's storage, returns false on I/O
+// errors
+bool cache_writer_push(CacheWriter* w, const void* frame);
+
+// the n newest rows of a history, oldest first; for CACHE_STORAGE_COMPLEX
+// writers with as many bins as the history
+bool cache_writer_push_history(CacheWriter* w,
+                               const FFTHistory* h,
+                               SizeType n);
@@ -0,0 +1,456 @@
+#if defined(__unix__) || defined(__APPLE__)
+// threads are POSIX, not C11
+#define _POSIX_C_SOURCE 200112L
+#include <pthread.h>
+#define SNAPSHOT_PTHREADS 1
+#endif
+
+#include "Snapshotter.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cache/CacheWriter.h"
+#include "core/intensity.h"
+
+typedef struct SnapshotTile SnapshotTile;
+struct SnapshotTile {
+    atomic_uint refs;
+    SizeType n_frames;
+    SnapshotTile* next;  // on the free list
+    float power[];       // [SNAPSHOT_FRAMES_PER_TILE][n_bins]
+};
+
+typedef struct {
+    char* path;
+    SnapshotFormat format;
+    SnapshotTile** tiles;  // one reference each, the last may be a copy
+    SizeType n_tiles;
+    SizeType skip;  // frames of the first tile before the export's first
+    SizeType n_frames;
+} SnapshotJob;
+
+struct Snapshotter {
+    FFTConfig cfg;
+    SizeType n_bins;
+    float power_reference;
+    float min_dB;
+    uint64_t source_hash;
+
+    // main thread only: full tiles, oldest at `head`, then the one being
+    // filled
+    SnapshotTile** ring;
+    SizeType cap;
+    SizeType head;
+    SizeType len;
+    SnapshotTile* open;
+    SnapshotTile* free_tiles;
+
+    // the main thread's while the status isn't SNAPSHOT_RUNNING, the
+    // exporter's while it is
+    SnapshotJob job;
+    _Atomic int status;  // SnapshotStatus
+
+#if defined(SNAPSHOT_PTHREADS)
+    pthread_t thread;
+    bool started;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;  // a new export, or quit
+    uint64_t requested;   // bumped by every export
+    bool quit;
+#endif
+};
+
+SnapshotFormat snapshot_format_for_path(const char* path)
+{
+    const char* dot = strrchr(path, '.');
+    if (dot == NULL) {
+        return SNAPSHOT_FORMAT_COUNT;
+    }
+    if (strcmp(dot, ".pgm") == 0) {
+        return SNAPSHOT_PGM;
+    }
+    if (strcmp(dot, ".f32") == 0) {
+        return SNAPSHOT_RAW;
+    }
+    if (strcmp(dot, ".spsc") == 0) {
+        return SNAPSHOT_CACHE;
+    }
+    return SNAPSHOT_FORMAT_COUNT;
+}
+
+static size_t tile_bytes(SizeType n_bins)
+{
+    return sizeof(SnapshotTile) +
+           (size_t)SNAPSHOT_FRAMES_PER_TILE * n_bins * sizeof(float);
+}
+
+// main thread, one reference and no frames
+static SnapshotTile* tile_take(Snapshotter* s)
+{
+    SnapshotTile* tile = s->free_tiles;
+    if (tile != NULL) {
+        s->free_tiles = tile->next;
+    } else {
+        tile = malloc(tile_bytes(s->n_bins));
+        if (tile == NULL) {
+            return NULL;
+        }
+    }
+    atomic_init(&tile->refs, 1);
+    tile->n_frames = 0;
+    tile->next = NULL;
+    return tile;
+}
+
+// main thread: a tile nobody else holds anymore is reused
+static void tile_drop(Snapshotter* s, SnapshotTile* tile)
+{
+    if (atomic_fetch_sub_explicit(&tile->refs, 1, memory_order_acq_rel) ==
+        1) {
+        tile->next = s->free_tiles;
+        s->free_tiles = tile;
+    }
+}
+
+// exporter: the main thread never sees a tile again once it dropped it
+static void tile_release(SnapshotTile* tile)
+{
+    if (atomic_fetch_sub_explicit(&tile->refs, 1, memory_order_acq_rel) ==
+        1) {
+        free(tile);
+    }
+}
+
+static const float* job_frame(const Snapshotter* s,
+                              const SnapshotJob* job,
+                              SizeType i)
+{
+    const SizeType f = job->skip + i;
+    const SnapshotTile* tile = job->tiles[f / SNAPSHOT_FRAMES_PER_TILE];
+    return tile->power + (size_t)(f % SNAPSHOT_FRAMES_PER_TILE) * s->n_bins;
+}
+
+static bool encode_raw(const Snapshotter* s, const SnapshotJob* job, FILE* f)
+{
+    for (SizeType i = 0; i < job->n_frames; ++i) {
+        if (fwrite(job_frame(s, job, i), sizeof(float), s->n_bins, f) !=
+            s->n_bins) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// a band of image rows at a time, the highest bins first: every frame is
+// read SNAPSHOT_PGM_BAND bins at once, and only band * n_frames bytes are
+// ever held
+static bool encode_pgm(const Snapshotter* s, const SnapshotJob* job, FILE* f)
+{
+    const SizeType width = job->n_frames;
+    if (fprintf(f, "P5\n%u %u\n255\n", (unsigned)width,
+                (unsigned)s->n_bins) < 0) {
+        return false;
+    }
+
+    uint8_t* band = malloc((size_t)SNAPSHOT_PGM_BAND * width);
+    if (band == NULL) {
+        return false;
+    }
+
+    bool ok = true;
+    for (SizeType top = s->n_bins; top > 0 && ok;) {
+        const SizeType rows =
+            top < SNAPSHOT_PGM_BAND ? top : SNAPSHOT_PGM_BAND;
+        for (SizeType x = 0; x < width; ++x) {
+            const float* power = job_frame(s, job, x);
+            for (SizeType r = 0; r < rows; ++r) {
+                const float intensity = intensity_from_power(
+                    power[top - 1 - r], s->power_reference, s->min_dB);
+                band[(size_t)r * width + x] =
+                    (uint8_t)(255.0f * intensity + 0.5f);
+            }
+        }
+        ok = fwrite(band, 1, (size_t)rows * width, f) == (size_t)rows * width;
+        top -= rows;
+    }
+
+    free(band);
+    return ok;
+}
+
+static bool encode_cache(const Snapshotter* s, const SnapshotJob* job)
+{
+    CacheWriter* w = cache_writer_new(job->path, &s->cfg, CACHE_STORAGE_FLOAT,
+                                      s->n_bins, s->source_hash);
+    if (w == NULL) {
+        return false;
+    }
+
+    bool ok = true;
+    for (SizeType i = 0; i < job->n_frames && ok; ++i) {
+        ok = cache_writer_push(w, job_frame(s, job, i));
+    }
+    cache_writer_free(w);
+    return ok;
+}
+
+// exporter: encodes the job, lets go of it, then publishes the status
+static void run_job(Snapshotter* s)
+{
+    SnapshotJob* job = &s->job;
+
+    bool ok = false;
+    if (job->format == SNAPSHOT_CACHE) {
+        ok = encode_cache(s, job);
+    } else {
+        FILE* f = fopen(job->path, "wb");
+        if (f != NULL) {
+            ok = job->format == SNAPSHOT_PGM ? encode_pgm(s, job, f)
+                                             : encode_raw(s, job, f);
+            ok = fclose(f) == 0 && ok;
+        }
+    }
+
+    for (SizeType t = 0; t < job->n_tiles; ++t) {
+        tile_release(job->tiles[t]);
+    }
+    free(job->tiles);
+    free(job->path);
+    *job = (SnapshotJob){0};
+
+    atomic_store_explicit(&s->status, ok ? SNAPSHOT_DONE : SNAPSHOT_FAILED,
+                          memory_order_release);
+}
+
+#if defined(SNAPSHOT_PTHREADS)
+static void* exporter_main(void* arg)
+{
+    Snapshotter* s = arg;
+
+    // an export asked for before quit still runs
+    uint64_t seen = 0;
+    pthread_mutex_lock(&s->lock);
+    for (;;) {
+        while (!s->quit && s->requested == seen) {
+            pthread_cond_wait(&s->wake, &s->lock);
+        }
+        if (s->requested == seen) {
+            break;
+        }
+        seen = s->requested;
+        pthread_mutex_unlock(&s->lock);
+
+        run_job(s);
+
+        pthread_mutex_lock(&s->lock);
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    return NULL;
+}
+#endif
+
+Snapshotter* snapshotter_new(const FFTConfig* cfg,
+                             SizeType n_bins,
+                             SizeType max_frames,
+                             float power_reference,
+                             float min_dB,
+                             uint64_t source_hash)
+{
+    if (n_bins == 0) {
+        return NULL;
+    }
+
+    Snapshotter* s = calloc(1, sizeof(*s));
+    if (s == NULL) {
+        return NULL;
+    }
+
+    memcpy(&s->cfg, cfg, sizeof(*cfg));
+    s->n_bins = n_bins;
+    s->power_reference = power_reference;
+    s->min_dB = min_dB;
+    s->source_hash = source_hash;
+    atomic_init(&s->status, SNAPSHOT_IDLE);
+
+    // the tile being filled holds the frames past the last full one
+    s->cap = (max_frames + SNAPSHOT_FRAMES_PER_TILE - 1) /
+             SNAPSHOT_FRAMES_PER_TILE;
+    s->cap = s->cap > 0 ? s->cap : 1;
+    s->ring = calloc(s->cap, sizeof(*s->ring));
+    s->open = s->ring != NULL ? tile_take(s) : NULL;
+    if (s->open == NULL) {
+        snapshotter_free(s);
+        return NULL;
+    }
+
+#if defined(SNAPSHOT_PTHREADS)
+    if (pthread_mutex_init(&s->lock, NULL) != 0) {
+        snapshotter_free(s);
+        return NULL;
+    }
+    pthread_cond_init(&s->wake, NULL);
+    s->started = pthread_create(&s->thread, NULL, exporter_main, s) == 0;
+    if (!s->started) {
+        pthread_cond_destroy(&s->wake);
+        pthread_mutex_destroy(&s->lock);
+        snapshotter_free(s);
+        return NULL;
+    }
+#endif
+
+    return s;
+}
+
+void snapshotter_free(Snapshotter* s)
+{
+    if (s == NULL) {
+        return;
+    }
+
+#if defined(SNAPSHOT_PTHREADS)
+    if (s->started) {
+        pthread_mutex_lock(&s->lock);
+        s->quit = true;
+        pthread_cond_broadcast(&s->wake);
+        pthread_mutex_unlock(&s->lock);
+        pthread_join(s->thread, NULL);
+
+        pthread_cond_destroy(&s->wake);
+        pthread_mutex_destroy(&s->lock);
+    }
+#endif
+
+    // the exporter is gone, every reference left is ours
+    for (SizeType t = 0; t < s->len; ++t) {
+        free(s->ring[(s->head + t) % s->cap]);
+    }
+    free(s->open);
+    while (s->free_tiles != NULL) {
+        SnapshotTile* next = s->free_tiles->next;
+        free(s->free_tiles);
+        s->free_tiles = next;
+    }
+    free(s->ring);
+    free(s);
+}
+
+// the open tile is full: into the ring, dropping the oldest if need be
+static bool seal_open_tile(Snapshotter* s)
+{
+    SnapshotTile* next = tile_take(s);
+    if (next == NULL) {
+        return false;
+    }
+
+    if (s->len == s->cap) {
+        tile_drop(s, s->ring[s->head]);
+        s->head = (s->head + 1) % s->cap;
+        --s->len;
+    }
+    s->ring[(s->head + s->len) % s->cap] = s->open;
+    ++s->len;
+    s->open = next;
+    return true;
+}
+
+bool snapshotter_push_history(Snapshotter* s, const FFTHistory* h, SizeType n)
+{
+    n = n > h->cap ? h->cap : n;
+
+    for (SizeType i = 0; i < n; ++i) {
+        // sealed on the next frame, so a failed allocation loses nothing
+        if (s->open->n_frames == SNAPSHOT_FRAMES_PER_TILE &&
+            !seal_open_tile(s)) {
+            return false;
+        }
+
+        const SizeType row = (h->tail + h->cap - n + i) % h->cap;
+        const Complex* bins = fft_history_get_row(h, row);
+        SnapshotTile* tile = s->open;
+        float* power = tile->power + (size_t)tile->n_frames * s->n_bins;
+        for (SizeType b = 0; b < s->n_bins; ++b) {
+            const float re = crealf(bins[b]);
+            const float im = cimagf(bins[b]);
+            power[b] = re * re + im * im;
+        }
+        ++tile->n_frames;
+    }
+    return true;
+}
+
+SizeType snapshotter_frames(const Snapshotter* s)
+{
+    return s->len * SNAPSHOT_FRAMES_PER_TILE + s->open->n_frames;
+}
+
+SnapshotStatus snapshotter_status(const Snapshotter* s)
+{
+    return (SnapshotStatus)atomic_load_explicit(&s->status,
+                                                memory_order_acquire);
+}
+
+bool snapshotter_export(Snapshotter* s,
+                        const char* path,
+                        SnapshotFormat format,
+                        SizeType n_frames)
+{
+    const SizeType kept = snapshotter_frames(s);
+    n_frames = n_frames == 0 || n_frames > kept ? kept : n_frames;
+    if (snapshotter_status(s) == SNAPSHOT_RUNNING ||
+        format >= SNAPSHOT_FORMAT_COUNT || n_frames == 0) {
+        return false;
+    }
+
+    // whole tiles are shared, the open one is copied: it's the only one
+    // that still changes, and it's at most a tile
+    const SizeType first = kept - n_frames;
+    const SizeType first_tile = first / SNAPSHOT_FRAMES_PER_TILE;
+    const SizeType open = s->open->n_frames > 0 ? 1 : 0;
+    const SizeType n_tiles = s->len + open - first_tile;
+    const size_t path_size = strlen(path) + 1;
+
+    SnapshotJob job = {
+        .path = malloc(path_size),
+        .format = format,
+        .tiles = malloc(n_tiles * sizeof(SnapshotTile*)),
+        .n_tiles = n_tiles,
+        .skip = first % SNAPSHOT_FRAMES_PER_TILE,
+        .n_frames = n_frames,
+    };
+    SnapshotTile* copy = open ? tile_take(s) : NULL;
+    if (job.path == NULL || job.tiles == NULL || (open && copy == NULL)) {
+        free(job.path);
+        free(job.tiles);
+        free(copy);
+        return false;
+    }
+    memcpy(job.path, path, path_size);
+
+    for (SizeType t = 0; t < s->len - first_tile; ++t) {
+        SnapshotTile* tile = s->ring[(s->head + first_tile + t) % s->cap];
+        atomic_fetch_add_explicit(&tile->refs, 1, memory_order_relaxed);
+        job.tiles[t] = tile;
+    }
+    if (open) {
+        copy->n_frames = s->open->n_frames;
+        memcpy(copy->power, s->open->power,
+               (size_t)copy->n_frames * s->n_bins * sizeof(float));
+        job.tiles[n_tiles - 1] = copy;
+    }
+
+    s->job = job;
+    atomic_store_explicit(&s->status, SNAPSHOT_RUNNING, memory_order_release);
+#if defined(SNAPSHOT_PTHREADS)
+    pthread_mutex_lock(&s->lock);
+    ++s->requested;
+    pthread_cond_signal(&s->wake);
+    pthread_mutex_unlock(&s->lock);
+#else
+    run_job(s);  // no thread to hand it to
+#endif
+    return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "FFTAnalyzer.h"
+#include "core/definitions.h"
+
+// keeps the last minutes of a history as power per bin, and exports any
+// stretch of it while the analyzer keeps running
+//
+// rows are kept in tiles of SNAPSHOT_FRAMES_PER_TILE frames. a full tile
+// never changes again and is reference counted: an export takes a reference
+// to the tiles it covers plus a private copy of the one being filled, then
+// a background thread encodes them. the main thread never waits on it, a
+// tile still held by an export when it falls out of the window is left to
+// the exporter to free and a new one takes its place
+#define SNAPSHOT_FRAMES_PER_TILE 64
+
+// image rows a PGM is encoded in at once, the whole image never is
+#define SNAPSHOT_PGM_BAND 64
+
+typedef enum {
+    SNAPSHOT_PGM,    // 8-bit gray, time left to right, low bins at the bottom
+    SNAPSHOT_RAW,    // n_frames * n_bins float |X|^2, oldest frame first
+    SNAPSHOT_CACHE,  // a cache file of CACHE_STORAGE_FLOAT |X|^2
+    SNAPSHOT_FORMAT_COUNT,
+} SnapshotFormat;
+
+// by extension: .pgm, .f32 and .spsc, SNAPSHOT_FORMAT_COUNT for others
+SnapshotFormat snapshot_format_for_path(const char* path);
+
+typedef enum {
+    SNAPSHOT_IDLE,
+    SNAPSHOT_RUNNING,
+    SNAPSHOT_DONE,
+    SNAPSHOT_FAILED,
+} SnapshotStatus;
+
+typedef struct Snapshotter Snapshotter;
+
+// keeps at least max_frames rows of n_bins; the power reference and floor
+// are the spectrogram's, for PGM; the config and hash go in cache headers
+Snapshotter* snapshotter_new(const FFTConfig* cfg,
+                             SizeType n_bins,
+                             SizeType max_frames,
+                             float power_reference,
+                             float min_dB,
+                             uint64_t source_hash);
+void snapshotter_free(Snapshotter* s);  // waits for an export in flight
+
+// main thread, the n newest rows of a history with n_bins bins, oldest
+// first; false when out of memory
+bool snapshotter_push_history(Snapshotter* s, const FFTHistory* h, SizeType n);
+
+// main thread, the newest n_frames rows kept, all of them for 0; false if
+// an export is still running or the format is unknown
+bool snapshotter_export(Snapshotter* s,
+                        const char* path,
+                        SnapshotFormat format,
+                        SizeType n_frames);
+
+// the last export's, until the next one starts
+SnapshotStatus snapshotter_status(const Snapshotter* s);
+SizeType snapshotter_frames(const Snapshotter* s);  // kept right now
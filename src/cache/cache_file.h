@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+
+// spectrogram cache file layout, native endianness (i.e. little-endian in
+// practice)
+//
+//   CacheFileHeader, zero padded to CACHE_PAGE_SIZE
+//   tile * n, each tile_bytes long, a multiple of CACHE_PAGE_SIZE
+//
+// a tile is frames_per_tile frames of n_bins values back to back, i.e. the
+// flattened data of an FFTHistory (CACHE_STORAGE_COMPLEX) or of any per-bin
+// float rows such as a pyramid level (CACHE_STORAGE_FLOAT). tiles start on
+// page boundaries so a mapped file can be handed out tile by tile without
+// copying
+//
+// tiles are written whole and n_frames is only raised once a tile is on
+// disk: a crash loses at most the tile being filled. the last tile may be
+// partial, frames past n_frames are padding
+
+#define CACHE_MAGIC "SPSC"
+#define CACHE_VERSION 1u
+#define CACHE_PAGE_SIZE 4096u
+
+typedef enum {
+    CACHE_STORAGE_COMPLEX = 1,  // Complex per bin, as pushed on FFTHistory
+    CACHE_STORAGE_FLOAT = 2,    // float per bin
+} CacheStorage;
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t storage;  // CacheStorage
+    uint32_t n_bins;   // values per frame
+    uint32_t frames_per_tile;
+    uint32_t tile_bytes;
+    uint64_t n_frames;     // committed, readers ignore anything past it
+    uint64_t source_hash;  // whatever identifies the analyzed samples
+
+    // the FFTConfig the frames came from
+    uint32_t fft_size;
+    uint32_t stride;
+    uint32_t decimation;
+    uint32_t features;
+    float sample_rate;
+    float dc_blocker_frequency;
+} CacheFileHeader;
+
+_Static_assert(sizeof(CacheFileHeader) == 64, "no padding on disk");
@@ -0,0 +1,127 @@
+#include "CaptureRecorder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "capture/capture_file.h"
+#include "trace/clock.h"
+
+// ~10 s of 48 kHz stereo, enough to ride out a few slow frames
+#define CAPTURE_RING_SIZE (1u << 22)
+
+CaptureRecorder* capture_recorder_new(const char* path,
+                                      uint32_t sample_rate,
+                                      uint32_t channels)
+{
+    CaptureRecorder* rec = malloc(sizeof(*rec));
+    uint8_t* ring = malloc(CAPTURE_RING_SIZE);
+    FILE* file = fopen(path, "wb");
+    if (rec == NULL || ring == NULL || file == NULL) {
+        goto fail;
+    }
+
+    CaptureFileHeader header = {
+        .version = CAPTURE_VERSION,
+        .sample_rate = sample_rate,
+        .channels = channels,
+    };
+    memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+    if (fwrite(&header, sizeof(header), 1, file) != 1) {
+        goto fail;
+    }
+
+    rec->file = file;
+    rec->ring = ring;
+    rec->cap = CAPTURE_RING_SIZE;
+    atomic_init(&rec->write, 0);
+    atomic_init(&rec->read, 0);
+    atomic_init(&rec->dropped_blocks, 0);
+    rec->t0_ns = clock_now_ns();
+    rec->channels = channels;
+    return rec;
+
+fail:
+    if (file != NULL) {
+        fclose(file);
+    }
+    free(ring);
+    free(rec);
+    return NULL;
+}
+
+void capture_recorder_free(CaptureRecorder* rec)
+{
+    if (!rec) {
+        return;
+    }
+
+    capture_recorder_drain(rec);
+
+    const unsigned dropped = atomic_load(&rec->dropped_blocks);
+    if (dropped != 0) {
+        fprintf(stderr, "capture: %u blocks dropped, ring was full\n",
+                dropped);
+    }
+
+    fclose(rec->file);
+    free(rec->ring);
+    free(rec);
+}
+
+static void ring_write(CaptureRecorder* rec,
+                       SizeType at,
+                       const void* src,
+                       SizeType size)
+{
+    const SizeType offset = at & (rec->cap - 1);
+    const SizeType room = rec->cap - offset;
+    const SizeType first = (size < room) ? size : room;
+
+    memcpy(rec->ring + offset, src, first);
+    memcpy(rec->ring, (const uint8_t*)src + first, size - first);
+}
+
+void capture_recorder_push(CaptureRecorder* rec,
+                           const float* interleaved,
+                           SizeType frames)
+{
+    const CaptureBlockHeader header = {
+        .t_ns = clock_now_ns() - rec->t0_ns,
+        .frames = frames,
+    };
+    const SizeType payload = frames * rec->channels * (SizeType)sizeof(float);
+    const SizeType size = (SizeType)sizeof(header) + payload;
+
+    const SizeType w = atomic_load_explicit(&rec->write, memory_order_relaxed);
+    const SizeType r = atomic_load_explicit(&rec->read, memory_order_acquire);
+    if (rec->cap - (w - r) < size) {
+        atomic_fetch_add_explicit(&rec->dropped_blocks, 1,
+                                  memory_order_relaxed);
+        return;
+    }
+
+    ring_write(rec, w, &header, sizeof(header));
+    ring_write(rec, w + (SizeType)sizeof(header), interleaved, payload);
+
+    atomic_store_explicit(&rec->write, w + size, memory_order_release);
+}
+
+bool capture_recorder_drain(CaptureRecorder* rec)
+{
+    const SizeType r = atomic_load_explicit(&rec->read, memory_order_relaxed);
+    const SizeType w = atomic_load_explicit(&rec->write, memory_order_acquire);
+    const SizeType size = w - r;
+    if (size == 0) {
+        return true;
+    }
+
+    const SizeType offset = r & (rec->cap - 1);
+    const SizeType room = rec->cap - offset;
+    const SizeType first = (size < room) ? size : room;
+
+    bool ok = fwrite(rec->ring + offset, 1, first, rec->file) == first;
+    ok = ok && fwrite(rec->ring, 1, size - first, rec->file) == size - first;
+
+    atomic_store_explicit(&rec->read, w, memory_order_release);
+    return ok;
+}
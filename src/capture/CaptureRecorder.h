@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "core/definitions.h"
+
+// records the blocks seen by the audio callback to a capture file
+//
+// the audio thread never touches the file: it appends records to a
+// single-producer single-consumer byte ring, which the main thread drains
+// to disk once per frame. if the ring is full the block is dropped and
+// counted, the audio thread never waits
+typedef struct {
+    FILE* file;
+    uint8_t* ring;
+    SizeType cap;  // power of 2
+    _Atomic SizeType write;  // free-running, wraps around SizeType
+    _Atomic SizeType read;
+    atomic_uint dropped_blocks;
+    uint64_t t0_ns;
+    SizeType channels;
+} CaptureRecorder;
+
+CaptureRecorder* capture_recorder_new(const char* path,
+                                      uint32_t sample_rate,
+                                      uint32_t channels);
+void capture_recorder_free(CaptureRecorder* rec);  // drains then closes
+
+// audio thread
+void capture_recorder_push(CaptureRecorder* rec,
+                           const float* interleaved,
+                           SizeType frames);
+
+// main thread, returns false on I/O errors
+bool capture_recorder_drain(CaptureRecorder* rec);
@@ -0,0 +1,126 @@
+#include "CaptureReplayer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "capture/capture_file.h"
+
+static uint8_t* read_whole_file(const char* path, uint64_t* size)
+{
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+
+    uint8_t* data = NULL;
+    if (fseek(f, 0, SEEK_END) != 0) {
+        goto done;
+    }
+    const long len = ftell(f);
+    if (len < 0 || fseek(f, 0, SEEK_SET) != 0) {
+        goto done;
+    }
+
+    data = malloc((size_t)len);
+    if (data != NULL && fread(data, 1, (size_t)len, f) != (size_t)len) {
+        free(data);
+        data = NULL;
+    }
+    *size = (uint64_t)len;
+
+done:
+    fclose(f);
+    return data;
+}
+
+CaptureReplayer capture_replayer_new(const char* path)
+{
+    CaptureReplayer rp = {0};
+
+    uint64_t size = 0;
+    uint8_t* data = read_whole_file(path, &size);
+    if (data == NULL) {
+        return rp;
+    }
+
+    CaptureFileHeader header;
+    if (size < sizeof(header)) {
+        free(data);
+        return rp;
+    }
+    memcpy(&header, data, sizeof(header));
+
+    // blocks go back through the audio callback, which reads interleaved
+    // stereo: anything else would be read past its end
+    const bool valid =
+        memcmp(header.magic, CAPTURE_MAGIC, sizeof(header.magic)) == 0 &&
+        header.version == CAPTURE_VERSION && header.channels == 2;
+    if (!valid) {
+        free(data);
+        return rp;
+    }
+
+    return (CaptureReplayer){
+        .data = data,
+        .size = size,
+        .cursor = sizeof(header),
+        .sample_rate = header.sample_rate,
+        .channels = header.channels,
+    };
+}
+
+bool capture_replayer_ok(const CaptureReplayer* rp)
+{
+    if (!rp) {
+        return false;
+    }
+
+    return rp->data != NULL;
+}
+
+void capture_replayer_free(CaptureReplayer* rp)
+{
+    if (!rp) {
+        return;
+    }
+
+    free(rp->data);
+    rp->data = NULL;
+}
+
+bool capture_replayer_next(CaptureReplayer* rp,
+                           uint64_t until_ns,
+                           CaptureBlock* block)
+{
+    CaptureBlockHeader header;
+    if (rp->size - rp->cursor < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, rp->data + rp->cursor, sizeof(header));
+
+    const uint64_t payload =
+        (uint64_t)header.frames * rp->channels * sizeof(float);
+    if (rp->size - rp->cursor - sizeof(header) < payload) {
+        // truncated tail, e.g. the recording process crashed: stop here
+        rp->cursor = rp->size;
+        return false;
+    }
+
+    if (header.t_ns > until_ns) {
+        return false;
+    }
+
+    *block = (CaptureBlock){
+        .t_ns = header.t_ns,
+        .frames = header.frames,
+        .samples = (float*)(rp->data + rp->cursor + sizeof(header)),
+    };
+    rp->cursor += sizeof(header) + payload;
+    return true;
+}
+
+bool capture_replayer_done(const CaptureReplayer* rp)
+{
+    return rp->size - rp->cursor < sizeof(CaptureBlockHeader);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "core/definitions.h"
+
+// reads back a capture file written by CaptureRecorder
+//
+// the whole file is loaded up front so that replaying never touches the disk
+typedef struct {
+    uint8_t* data;
+    uint64_t size;
+    uint64_t cursor;  // byte offset of the next block
+    uint32_t sample_rate;
+    uint32_t channels;
+} CaptureReplayer;
+
+typedef struct {
+    uint64_t t_ns;
+    SizeType frames;
+    float* samples;  // interleaved, frames * channels, owned by the replayer
+} CaptureBlock;
+
+// not ok unless the capture is interleaved stereo, all the audio callback
+// takes
+CaptureReplayer capture_replayer_new(const char* path);
+bool capture_replayer_ok(const CaptureReplayer* rp);
+void capture_replayer_free(CaptureReplayer* rp);
+
+// yields the next block if it was recorded at or before `until_ns`, pass
+// UINT64_MAX to replay as fast as possible
+bool capture_replayer_next(CaptureReplayer* rp,
+                           uint64_t until_ns,
+                           CaptureBlock* block);
+
+bool capture_replayer_done(const CaptureReplayer* rp);
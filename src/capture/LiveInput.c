@@ -0,0 +1,133 @@
+#include "LiveInput.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_callback.h"
+#include "core/definitions.h"
+
+// the configuration raylib's raudio.c builds miniaudio with: the context and
+// device structs depend on it, and the implementation lives in raylib
+#define MA_NO_JACK
+#define MA_NO_WAV
+#define MA_NO_FLAC
+#define MA_NO_MP3
+#define MA_NO_RESOURCE_MANAGER
+#define MA_NO_NODE_GRAPH
+#define MA_NO_ENGINE
+#define MA_NO_GENERATION
+#include "external/miniaudio.h"
+
+struct LiveInput {
+    ma_context context;
+    ma_device device;
+};
+
+static const char* const s_source_names[LIVE_INPUT_COUNT] = {
+    [LIVE_INPUT_DEFAULT] = "default",
+    [LIVE_INPUT_NULL] = "null",
+    [LIVE_INPUT_LOOPBACK] = "loopback",
+};
+
+LiveInputSource live_input_source_from_name(const char* name)
+{
+    for (SizeType s = 0; s < LIVE_INPUT_COUNT; ++s) {
+        if (strcmp(name, s_source_names[s]) == 0) {
+            return (LiveInputSource)s;
+        }
+    }
+    return LIVE_INPUT_COUNT;
+}
+
+const char* live_input_source_name(LiveInputSource source)
+{
+    return source < LIVE_INPUT_COUNT ? s_source_names[source] : "unknown";
+}
+
+// miniaudio's thread: the callback needs nothing but the samples, the rest
+// is audio_callback's
+static void live_input_callback(ma_device* device,
+                                void* output,
+                                const void* input,
+                                ma_uint32 frames)
+{
+    (void)device;
+    (void)output;
+    push_samples_from_audio_thread(input, frames);
+}
+
+LiveInput* live_input_new(const LiveInputConfig* cfg)
+{
+    if (cfg->source >= LIVE_INPUT_COUNT) {
+        return NULL;
+    }
+
+    LiveInput* input = malloc(sizeof(*input));
+    if (input == NULL) {
+        return NULL;
+    }
+
+    const ma_backend null_backend[] = {ma_backend_null};
+    const bool null = cfg->source == LIVE_INPUT_NULL;
+    const ma_context_config context_cfg = ma_context_config_init();
+    if (ma_context_init(null ? null_backend : NULL, null ? 1 : 0,
+                        &context_cfg, &input->context) != MA_SUCCESS) {
+        free(input);
+        return NULL;
+    }
+
+    // interleaved stereo f32 like the mixed processor's, so the callback,
+    // the recorder and the latency tracker see the same blocks either way;
+    // no fixed-size callbacks, they'd add a period of buffering
+    ma_device_config device_cfg = ma_device_config_init(
+        cfg->source == LIVE_INPUT_LOOPBACK ? ma_device_type_loopback
+                                           : ma_device_type_capture);
+    device_cfg.capture.format = ma_format_f32;
+    device_cfg.capture.channels = 2;
+    device_cfg.sampleRate = cfg->sample_rate;
+    device_cfg.periodSizeInFrames = cfg->period_frames;
+    device_cfg.performanceProfile = ma_performance_profile_low_latency;
+    device_cfg.noFixedSizedCallback = MA_TRUE;
+    device_cfg.dataCallback = live_input_callback;
+
+    if (ma_device_init(&input->context, &device_cfg, &input->device) !=
+        MA_SUCCESS) {
+        ma_context_uninit(&input->context);
+        free(input);
+        return NULL;
+    }
+
+    return input;
+}
+
+bool live_input_start(LiveInput* input)
+{
+    return ma_device_start(&input->device) == MA_SUCCESS;
+}
+
+void live_input_free(LiveInput* input)
+{
+    if (input == NULL) {
+        return;
+    }
+
+    // uninit stops the device and joins its thread
+    ma_device_uninit(&input->device);
+    ma_context_uninit(&input->context);
+    free(input);
+}
+
+uint32_t live_input_sample_rate(const LiveInput* input)
+{
+    return input->device.sampleRate;
+}
+
+uint32_t live_input_period(const LiveInput* input)
+{
+    return input->device.capture.internalPeriodSizeInFrames;
+}
+
+const char* live_input_backend(const LiveInput* input)
+{
+    return ma_get_backend_name(input->context.backend);
+}
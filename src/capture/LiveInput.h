@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// analyzes a capture device directly, no playback round trip: miniaudio's
+// capture callback (the copy raylib vendors) hands every period to the
+// same audio callback as the mixed processor, which writes it straight
+// into the sample queue
+typedef enum {
+    LIVE_INPUT_DEFAULT,   // the system's default capture device
+    LIVE_INPUT_NULL,      // miniaudio's null backend: silence, paced by the
+                          // clock, for headless boxes
+    LIVE_INPUT_LOOPBACK,  // what the default output plays, WASAPI only
+    LIVE_INPUT_COUNT,
+} LiveInputSource;
+
+// LIVE_INPUT_COUNT for unknown names
+LiveInputSource live_input_source_from_name(const char* name);
+const char* live_input_source_name(LiveInputSource source);
+
+// periods the backend is asked for: small ones are what keeps the input
+// to analysis latency low, the backend may round them
+#define LIVE_INPUT_DEFAULT_PERIOD 128
+#define LIVE_INPUT_MIN_PERIOD 16
+#define LIVE_INPUT_MAX_PERIOD 4096
+
+typedef struct {
+    LiveInputSource source;
+    uint32_t period_frames;
+    uint32_t sample_rate;  // 0: the device's own, no resampling
+} LiveInputConfig;
+
+typedef struct LiveInput LiveInput;
+
+// NULL if the backend or the device won't open; init_audio_processor must
+// have been called before it's started
+LiveInput* live_input_new(const LiveInputConfig* cfg);
+bool live_input_start(LiveInput* input);
+void live_input_free(LiveInput* input);  // stops then closes
+
+// what the device was opened with
+uint32_t live_input_sample_rate(const LiveInput* input);
+uint32_t live_input_period(const LiveInput* input);
+const char* live_input_backend(const LiveInput* input);
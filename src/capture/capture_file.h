@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+
+// capture file layout, native endianness (i.e. little-endian in practice)
+//
+//   CaptureFileHeader
+//   { CaptureBlockHeader, float samples[frames * channels] } * n
+//
+// one block per call of the audio callback, samples interleaved exactly as
+// the callback saw them. both headers are 16 bytes so the samples stay
+// 4-byte aligned when the file is loaded as a whole
+
+#define CAPTURE_MAGIC "SPCP"
+#define CAPTURE_VERSION 1u
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t sample_rate;
+    uint32_t channels;
+} CaptureFileHeader;
+
+typedef struct {
+    uint64_t t_ns;  // callback entry, relative to the start of the recording
+    uint32_t frames;
+    uint32_t reserved;
+} CaptureBlockHeader;
+
+_Static_assert(sizeof(CaptureFileHeader) == 16, "no padding on disk");
+_Static_assert(sizeof(CaptureBlockHeader) == 16, "no padding on disk");
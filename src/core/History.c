@@ -5,8 +5,11 @@
 
 FloatHistory fhistory_new(SizeType cap)
 {
-    float* data = malloc(cap * sizeof(*data));
+    return fhistory_from(malloc(cap * sizeof(float)), cap);
+}
 
+FloatHistory fhistory_from(float* data, SizeType cap)
+{
     return (FloatHistory){
         .head = 0,
         .tail = 0,
@@ -59,6 +62,12 @@ SplitSlice fhistory_get(const FloatHistory* fh)
 }
 
 FFTHistory fft_history_new(SizeType cap, SizeType n_bins)
+{
+    return fft_history_from(malloc(sizeof(Complex) * cap * n_bins), cap,
+                            n_bins);
+}
+
+FFTHistory fft_history_from(Complex* data, SizeType cap, SizeType n_bins)
 {
     return (FFTHistory){
         .head = 0,
@@ -66,7 +75,7 @@ FFTHistory fft_history_new(SizeType cap, SizeType n_bins)
         .len = 0,
         .cap = cap,
         .n_bins = n_bins,
-        .data = malloc(sizeof(Complex) * cap * n_bins),
+        .data = data,
     };
 }
 
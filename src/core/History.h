@@ -15,6 +15,9 @@ typedef struct {
 FloatHistory fhistory_new(SizeType cap);
 void fhistory_destroy(FloatHistory fh);
 
+// over cap floats the caller owns, e.g. from an Arena; not to be destroyed
+FloatHistory fhistory_from(float* data, SizeType cap);
+
 void fhistory_push(FloatHistory* fh, float f);
 SplitSlice fhistory_get(const FloatHistory* fh);
 
@@ -28,6 +31,9 @@ typedef struct {
 } FFTHistory;
 
 FFTHistory fft_history_new(SizeType cap, SizeType n_bins);
+
+// over cap * n_bins bins the caller owns, e.g. from an Arena; not to be freed
+FFTHistory fft_history_from(Complex* data, SizeType cap, SizeType n_bins);
 bool fft_history_ok(const FFTHistory* fft_history);
 void fft_history_free(FFTHistory* fft_history);
 void fft_history_push(FFTHistory* fh, const Complex* row);
@@ -0,0 +1,102 @@
+#if defined(SPECTRE_HUGE_PAGES) && defined(__linux__)
+// madvise and MADV_HUGEPAGE aren't C11
+#define _DEFAULT_SOURCE
+#include <sys/mman.h>
+#endif
+
+#include "arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static size_t round_up(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+size_t arena_footprint(size_t size)
+{
+    return round_up(size, ARENA_ALIGNMENT);
+}
+
+Arena arena_new(size_t capacity)
+{
+    // aligned_alloc wants the size to be a multiple of the alignment
+#if defined(SPECTRE_HUGE_PAGES)
+    const size_t alignment =
+        capacity >= ARENA_HUGE_PAGE ? ARENA_HUGE_PAGE : ARENA_ALIGNMENT;
+#else
+    const size_t alignment = ARENA_ALIGNMENT;
+#endif
+    capacity = round_up(capacity > 0 ? capacity : 1, alignment);
+
+    unsigned char* base = aligned_alloc(alignment, capacity);
+    if (base == NULL) {
+        return (Arena){0};
+    }
+
+#if defined(SPECTRE_HUGE_PAGES) && defined(__linux__)
+    if (alignment == ARENA_HUGE_PAGE) {
+        // only advice, the arena works the same without it
+        (void)madvise(base, capacity, MADV_HUGEPAGE);
+    }
+#endif
+
+    return (Arena){
+        .base = base,
+        .capacity = capacity,
+        .used = 0,
+    };
+}
+
+bool arena_ok(const Arena* arena)
+{
+    if (!arena) {
+        return false;
+    }
+
+    return arena->base != NULL;
+}
+
+void arena_free(Arena* arena)
+{
+    if (!arena) {
+        return;
+    }
+
+    free(arena->base);
+    *arena = (Arena){0};
+}
+
+bool arena_reset(Arena* arena, size_t capacity)
+{
+    if (arena_ok(arena) && capacity <= arena->capacity) {
+        arena->used = 0;
+        return true;
+    }
+
+    arena_free(arena);
+    *arena = arena_new(capacity);
+    return arena_ok(arena);
+}
+
+void* arena_push(Arena* arena, size_t size)
+{
+    const size_t footprint = arena_footprint(size);
+    if (!arena_ok(arena) || footprint > arena->capacity - arena->used) {
+        return NULL;
+    }
+
+    void* p = arena->base + arena->used;
+    arena->used += footprint;
+    return p;
+}
+
+void* arena_push_zero(Arena* arena, size_t size)
+{
+    void* p = arena_push(arena, size);
+    if (p != NULL) {
+        memset(p, 0, size);
+    }
+    return p;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "definitions.h"
+
+// every push starts on a cache line, which is also as wide as any SIMD load
+#define ARENA_ALIGNMENT 64
+
+// with SPECTRE_HUGE_PAGES, arenas at least this big start on a huge page
+// boundary, are rounded up to whole huge pages and advised to be backed by
+// them where the OS supports it; without it the rounding would only waste
+// up to a huge page per arena
+#define ARENA_HUGE_PAGE (2u << 20)
+
+// one block a configuration's buffers are carved from: sized up front, so
+// it fails as a unit, and freed as a unit. pushes are never freed one by one
+typedef struct {
+    unsigned char* base;
+    size_t capacity;
+    size_t used;
+} Arena;
+
+// what a push of `size` bytes takes out of an arena, sum these to size one
+size_t arena_footprint(size_t size);
+
+Arena arena_new(size_t capacity);
+bool arena_ok(const Arena* arena);
+void arena_free(Arena* arena);
+
+// forgets every push, and makes room for at least `capacity` bytes: the
+// block is only reallocated when it's too small. returns false when that
+// fails, the arena is then empty and not ok
+bool arena_reset(Arena* arena, size_t capacity);
+
+// NULL when the arena is full
+void* arena_push(Arena* arena, size_t size);
+void* arena_push_zero(Arena* arena, size_t size);
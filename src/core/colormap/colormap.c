@@ -1,7 +1,16 @@
 #include "colormap.h"
 
+#include <math.h>
+
 #include "cividis.inc"
 #include "inferno.inc"
 #include "magma.inc"
 #include "plasma.inc"
 #include "viridis.inc"
+
+const uint8_t* colormap_sample(Colormap cmap, float intensity)
+{
+    const float clamped = fminf(fmaxf(intensity, 0.0f), 1.0f);
+    const int index = (int)(clamped * ((float)COLORMAP_SIZE - 0.0001f));
+    return cmap[index];
+}
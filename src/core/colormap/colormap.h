@@ -11,3 +11,7 @@ extern const uint8_t plasma_rgba[256][4];
 extern const uint8_t inferno_rgba[256][4];
 extern const uint8_t magma_rgba[256][4];
 extern const uint8_t cividis_rgba[256][4];
+
+// maps an intensity to one of the COLORMAP_SIZE entries, clamping to [0, 1]
+// returns a pointer to the 4 RGBA bytes
+const uint8_t* colormap_sample(Colormap cmap, float intensity);
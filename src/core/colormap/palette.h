@@ -6,4 +6,10 @@
 #define BACKGROUND_COLOR CLITERAL(Color){10, 10, 10, 255}
 #define GRID_COLOR CLITERAL(Color){42, 42, 42, 255}
 #define TEXT_COLOR CLITERAL(Color){176, 176, 176, 255}
+#define PITCH_COLOR CLITERAL(Color){96, 224, 255, 255}
+#define PARTIAL_COLOR CLITERAL(Color){255, 176, 64, 255}
+#define STEREO_COLOR CLITERAL(Color){120, 220, 140, 255}
+#define STEREO_ANTIPHASE_COLOR CLITERAL(Color){240, 88, 88, 255}
+#define WAVEFORM_COLOR CLITERAL(Color){88, 88, 120, 255}
+#define WAVEFORM_RMS_COLOR CLITERAL(Color){160, 160, 220, 255}
 // clang-format on
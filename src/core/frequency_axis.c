@@ -0,0 +1,189 @@
+#include "frequency_axis.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* const s_axis_names[AXIS_COUNT] = {
+    [AXIS_LINEAR] = "linear",
+    [AXIS_LOG] = "log",
+    [AXIS_MEL] = "mel",
+    [AXIS_ERB] = "erb",
+};
+
+const char* frequency_axis_name(FrequencyAxis axis)
+{
+    return (axis < AXIS_COUNT) ? s_axis_names[axis] : "unknown";
+}
+
+FrequencyAxis frequency_axis_from_name(const char* name)
+{
+    for (SizeType a = 0; a < AXIS_COUNT; ++a) {
+        if (strcmp(name, s_axis_names[a]) == 0) {
+            return (FrequencyAxis)a;
+        }
+    }
+    return AXIS_COUNT;
+}
+
+static float warp(FrequencyAxis axis, float hz)
+{
+    switch (axis) {
+    case AXIS_LOG:
+        return log2f(hz);
+    case AXIS_MEL:
+        return 2595.0f * log10f(1.0f + hz / 700.0f);
+    case AXIS_ERB:
+        return 21.4f * log10f(1.0f + 0.00437f * hz);
+    case AXIS_LINEAR:
+    case AXIS_COUNT:
+        break;
+    }
+    return hz;
+}
+
+static float unwarp(FrequencyAxis axis, float w)
+{
+    switch (axis) {
+    case AXIS_LOG:
+        return exp2f(w);
+    case AXIS_MEL:
+        return 700.0f * (powf(10.0f, w / 2595.0f) - 1.0f);
+    case AXIS_ERB:
+        return (powf(10.0f, w / 21.4f) - 1.0f) / 0.00437f;
+    case AXIS_LINEAR:
+    case AXIS_COUNT:
+        break;
+    }
+    return w;
+}
+
+float axis_range_position(const AxisRange* range, float hz)
+{
+    const float lo = warp(range->axis, range->f_min);
+    const float hi = warp(range->axis, range->f_max);
+    return (warp(range->axis, hz) - lo) / (hi - lo);
+}
+
+float axis_range_frequency(const AxisRange* range, float position)
+{
+    const float lo = warp(range->axis, range->f_min);
+    const float hi = warp(range->axis, range->f_max);
+    return unwarp(range->axis, lo + position * (hi - lo));
+}
+
+AxisRange axis_range_for_bins(FrequencyAxis axis,
+                              SizeType n_bins,
+                              float bin_hz)
+{
+    // the outer edges of the first and last bin
+    float f_min = 0.5f * bin_hz;
+    const float f_max = ((float)n_bins + 0.5f) * bin_hz;
+
+    if (axis == AXIS_LOG) {
+        f_min = fmaxf(AXIS_LOG_MIN_HZ, bin_hz);
+    }
+
+    return (AxisRange){
+        .axis = axis,
+        .f_min = f_min,
+        .f_max = f_max,
+    };
+}
+
+// fractional bin index of a frequency, bin b is centred on (b + 1) * bin_hz
+static float bin_position(float hz, float bin_hz)
+{
+    return hz / bin_hz - 1.0f;
+}
+
+static SizeType clamp_bin(float b, SizeType n_bins)
+{
+    if (b <= 0.0f) {
+        return 0;
+    }
+    const SizeType i = (SizeType)b;
+    return i >= n_bins ? n_bins - 1 : i;
+}
+
+// weights of a row covering [lo, hi] in bin positions, each bin spanning
+// [b - 0.5, b + 0.5]; returns the first bin and writes the run length
+static SizeType box_row(float lo,
+                        float hi,
+                        SizeType n_bins,
+                        float* weights,
+                        SizeType* len)
+{
+    const SizeType first = clamp_bin(lo + 0.5f, n_bins);
+    const SizeType last = clamp_bin(hi + 0.5f, n_bins);
+
+    float total = 0.0f;
+    for (SizeType b = first; b <= last; ++b) {
+        const float left = fmaxf(lo, (float)b - 0.5f);
+        const float right = fminf(hi, (float)b + 0.5f);
+        weights[b - first] = fmaxf(right - left, 0.0f);
+        total += weights[b - first];
+    }
+
+    *len = last - first + 1;
+    for (SizeType i = 0; i < *len; ++i) {
+        weights[i] = total > 0.0f ? weights[i] / total : 1.0f / (float)*len;
+    }
+
+    return first;
+}
+
+SparseRows axis_remap_new(const AxisRange* range,
+                          SizeType n_bins,
+                          float bin_hz,
+                          SizeType n_rows)
+{
+    SparseRows m = sparse_rows_new(n_rows, n_bins);
+    if (!sparse_rows_ok(&m)) {
+        return m;
+    }
+
+    // scratch for one row, a row never covers more than every bin
+    float* weights = malloc(n_bins * sizeof(float));
+    if (weights == NULL) {
+        sparse_rows_free(&m);
+        return (SparseRows){0};
+    }
+
+    for (SizeType r = 0; r < n_rows; ++r) {
+        const float lo = bin_position(
+            axis_range_frequency(range, (float)r / (float)n_rows), bin_hz);
+        const float hi = bin_position(
+            axis_range_frequency(range, (float)(r + 1) / (float)n_rows),
+            bin_hz);
+
+        SizeType start;
+        SizeType len;
+        if (hi - lo <= 1.0f) {
+            // interpolate at the row's centre
+            const float centre = fminf(
+                fmaxf(0.5f * (lo + hi), 0.0f), (float)(n_bins - 1));
+            start = clamp_bin(centre, n_bins);
+            const float frac = centre - (float)start;
+            if (start + 1 < n_bins && frac > 0.0f) {
+                weights[0] = 1.0f - frac;
+                weights[1] = frac;
+                len = 2;
+            } else {
+                weights[0] = 1.0f;
+                len = 1;
+            }
+        } else {
+            start = box_row(lo, hi, n_bins, weights, &len);
+        }
+
+        if (!sparse_rows_push(&m, start, len, weights)) {
+            free(weights);
+            sparse_rows_free(&m);
+            return (SparseRows){0};
+        }
+    }
+
+    free(weights);
+    return m;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "definitions.h"
+#include "sparse.h"
+
+typedef enum {
+    AXIS_LINEAR,
+    AXIS_LOG,
+    AXIS_MEL,  // O'Shaughnessy, 2595 log10(1 + f / 700)
+    AXIS_ERB,  // Glasberg & Moore ERB-rate, 21.4 log10(1 + 0.00437 f)
+    AXIS_COUNT,
+} FrequencyAxis;
+
+const char* frequency_axis_name(FrequencyAxis axis);
+
+// AXIS_COUNT when the name is unknown
+FrequencyAxis frequency_axis_from_name(const char* name);
+
+// a frequency axis spread over [0, 1], bottom to top of a panel
+typedef struct {
+    FrequencyAxis axis;
+    float f_min;  // Hz at 0
+    float f_max;  // Hz at 1
+} AxisRange;
+
+float axis_range_position(const AxisRange* range, float hz);
+float axis_range_frequency(const AxisRange* range, float position);
+
+// lowest frequency a log axis starts at, it can't start at 0
+#define AXIS_LOG_MIN_HZ 20.0f
+
+// the range of an FFT with `n_bins` bins of `bin_hz` each, DC dropped, on a
+// given axis; log axes start at AXIS_LOG_MIN_HZ or the first bin
+AxisRange axis_range_for_bins(FrequencyAxis axis,
+                              SizeType n_bins,
+                              float bin_hz);
+
+// bins (bin b centred on (b + 1) * bin_hz) to n_rows rows evenly spaced on
+// the range: a row narrower than a bin interpolates between its two nearest
+// bins, a wider one averages the bins it covers, edges pro rata
+//
+// meant to be applied to power, row 0 is the lowest frequency
+SparseRows axis_remap_new(const AxisRange* range,
+                          SizeType n_bins,
+                          float bin_hz,
+                          SizeType n_rows);
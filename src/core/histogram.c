@@ -0,0 +1,73 @@
+#include "histogram.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+Histogram histogram_new(float bin_width, SizeType n_bins)
+{
+    return (Histogram){
+        .counts = calloc(n_bins, sizeof(uint32_t)),
+        .n_bins = n_bins,
+        .bin_width = bin_width,
+        .total = 0,
+    };
+}
+
+bool histogram_ok(const Histogram* h)
+{
+    if (!h) {
+        return false;
+    }
+
+    return h->counts != NULL;
+}
+
+void histogram_free(Histogram* h)
+{
+    if (!h) {
+        return;
+    }
+
+    free(h->counts);
+}
+
+void histogram_add(Histogram* h, float value)
+{
+    const float bin = value / h->bin_width;
+    SizeType i = 0;
+    if (bin >= (float)(h->n_bins - 1)) {
+        i = h->n_bins - 1;
+    } else if (bin > 0.0f) {
+        i = (SizeType)bin;
+    }
+
+    h->counts[i]++;
+    h->total++;
+}
+
+void histogram_reset(Histogram* h)
+{
+    memset(h->counts, 0, h->n_bins * sizeof(uint32_t));
+    h->total = 0;
+}
+
+float histogram_percentile(const Histogram* h, float p)
+{
+    if (h->total == 0) {
+        return 0.0f;
+    }
+
+    // rank of the sample we are after, 1-based
+    uint64_t rank = (uint64_t)(p * (float)h->total + 0.5f);
+    rank = (rank == 0) ? 1 : rank;
+
+    uint64_t seen = 0;
+    for (SizeType i = 0; i < h->n_bins; ++i) {
+        seen += h->counts[i];
+        if (seen >= rank) {
+            return (float)(i + 1) * h->bin_width;
+        }
+    }
+
+    return (float)h->n_bins * h->bin_width;
+}
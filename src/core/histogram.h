@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "definitions.h"
+
+// fixed-width bins starting at 0, anything past the last bin lands in it
+//
+// cheap enough to be fed every frame, percentiles are exact to a bin width
+typedef struct {
+    uint32_t* counts;
+    SizeType n_bins;
+    float bin_width;
+    uint64_t total;
+} Histogram;
+
+Histogram histogram_new(float bin_width, SizeType n_bins);
+bool histogram_ok(const Histogram* h);
+void histogram_free(Histogram* h);
+
+void histogram_add(Histogram* h, float value);
+void histogram_reset(Histogram* h);
+
+// upper edge of the bin holding the p-th quantile, p in [0, 1]
+// returns 0 for an empty histogram
+float histogram_percentile(const Histogram* h, float p);
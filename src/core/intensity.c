@@ -11,8 +11,11 @@ float intensity_from_bin(Complex bin, float power_reference, float min_db)
 {
     const float re = crealf(bin);
     const float im = cimagf(bin);
-    const float power = re * re + im * im;
+    return intensity_from_power(re * re + im * im, power_reference, min_db);
+}
 
+float intensity_from_power(float power, float power_reference, float min_db)
+{
     // +ε keeps log10 well-defined for silent bins (power → 0 ⇒ db → min_db).
     const float db = 10.0f * log10f((power / power_reference) + 1e-9f);
 
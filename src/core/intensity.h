@@ -10,3 +10,6 @@
 // The output is clamped to [0, 1]. Silent bins (power → 0) map to 0 via a
 // tiny epsilon that keeps log10 well-defined.
 float intensity_from_bin(Complex bin, float power_reference, float min_db);
+
+// Same mapping from an already computed |X|², e.g. after remapping bins.
+float intensity_from_power(float power, float power_reference, float min_db);
@@ -0,0 +1,184 @@
+#include "sparse.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// partial sums per row in sparse_rows_apply
+#define SPARSE_LANES 8
+
+SparseRows sparse_rows_new(SizeType n_rows, SizeType n_cols)
+{
+    // a guess: most rows of a display remap have one or two weights
+    const SizeType capacity = 2 * n_rows;
+
+    return (SparseRows){
+        .n_rows = n_rows,
+        .n_cols = n_cols,
+        .start = calloc(n_rows, sizeof(SizeType)),
+        .len = calloc(n_rows, sizeof(SizeType)),
+        .offset = calloc(n_rows, sizeof(SizeType)),
+        .weights = malloc(capacity * sizeof(float)),
+        .n_pushed = 0,
+        .n_weights = 0,
+        .capacity = capacity,
+    };
+}
+
+bool sparse_rows_ok(const SparseRows* m)
+{
+    if (!m) {
+        return false;
+    }
+
+    return m->start && m->len && m->offset && m->weights;
+}
+
+void sparse_rows_free(SparseRows* m)
+{
+    if (!m) {
+        return;
+    }
+
+    free(m->start);
+    free(m->len);
+    free(m->offset);
+    free(m->weights);
+}
+
+bool sparse_rows_push(SparseRows* m,
+                      SizeType start,
+                      SizeType len,
+                      const float* weights)
+{
+    const SizeType row = m->n_pushed;
+    if (row == m->n_rows || start + len > m->n_cols) {
+        return false;
+    }
+
+    if (m->n_weights + len > m->capacity) {
+        SizeType capacity = 2 * m->capacity;
+        capacity = capacity < m->n_weights + len ? m->n_weights + len
+                                                 : capacity;
+        float* grown = realloc(m->weights, capacity * sizeof(float));
+        if (grown == NULL) {
+            return false;
+        }
+        m->weights = grown;
+        m->capacity = capacity;
+    }
+
+    memcpy(m->weights + m->n_weights, weights, len * sizeof(float));
+    m->start[row] = start;
+    m->len[row] = len;
+    m->offset[row] = m->n_weights;
+    m->n_weights += len;
+    ++m->n_pushed;
+
+    return true;
+}
+
+void sparse_rows_apply(const SparseRows* restrict m,
+                       const float* restrict in,
+                       float* restrict out)
+{
+    for (SizeType r = 0; r < m->n_rows; ++r) {
+        const float* x = in + m->start[r];
+        const float* w = m->weights + m->offset[r];
+        const SizeType len = m->len[r];
+
+        // long runs (wide mel bands, treble on a log axis) in partial sums
+        // the compiler can vectorize, the short ones are a few products
+        float lanes[SPARSE_LANES] = {0};
+        const SizeType n_blocks = len / SPARSE_LANES;
+        for (SizeType blk = 0; blk < n_blocks; ++blk) {
+            for (SizeType l = 0; l < SPARSE_LANES; ++l) {
+                const size_t i = (size_t)blk * SPARSE_LANES + l;
+                lanes[l] += w[i] * x[i];
+            }
+        }
+
+        float sum = 0.0f;
+        for (SizeType l = 0; l < SPARSE_LANES; ++l) {
+            sum += lanes[l];
+        }
+        for (SizeType i = n_blocks * SPARSE_LANES; i < len; ++i) {
+            sum += w[i] * x[i];
+        }
+        out[r] = sum;
+    }
+}
+
+static const char* const s_pooling_names[POOL_COUNT] = {
+    [POOL_MEAN] = "mean",
+    [POOL_RMS] = "rms",
+    [POOL_MAX] = "max",
+};
+
+const char* row_pooling_name(RowPooling pooling)
+{
+    return (pooling < POOL_COUNT) ? s_pooling_names[pooling] : "unknown";
+}
+
+RowPooling row_pooling_from_name(const char* name)
+{
+    for (SizeType p = 0; p < POOL_COUNT; ++p) {
+        if (strcmp(name, s_pooling_names[p]) == 0) {
+            return (RowPooling)p;
+        }
+    }
+    return POOL_COUNT;
+}
+
+static void apply_rms(const SparseRows* restrict m,
+                      const float* restrict in,
+                      float* restrict out)
+{
+    for (SizeType r = 0; r < m->n_rows; ++r) {
+        const float* x = in + m->start[r];
+        const float* w = m->weights + m->offset[r];
+
+        float sum = 0.0f;
+        for (SizeType i = 0; i < m->len[r]; ++i) {
+            sum += w[i] * x[i] * x[i];
+        }
+        out[r] = sqrtf(sum);
+    }
+}
+
+static void apply_max(const SparseRows* restrict m,
+                      const float* restrict in,
+                      float* restrict out)
+{
+    for (SizeType r = 0; r < m->n_rows; ++r) {
+        const float* x = in + m->start[r];
+        const float* w = m->weights + m->offset[r];
+
+        float peak = 0.0f;
+        float w_max = 0.0f;
+        for (SizeType i = 0; i < m->len[r]; ++i) {
+            peak = fmaxf(peak, w[i] * x[i]);
+            w_max = fmaxf(w_max, w[i]);
+        }
+        out[r] = w_max > 0.0f ? peak / w_max : 0.0f;
+    }
+}
+
+void sparse_rows_apply_pooled(const SparseRows* restrict m,
+                              RowPooling pooling,
+                              const float* restrict in,
+                              float* restrict out)
+{
+    switch (pooling) {
+    case POOL_RMS:
+        apply_rms(m, in, out);
+        return;
+    case POOL_MAX:
+        apply_max(m, in, out);
+        return;
+    case POOL_MEAN:
+    case POOL_COUNT:
+        break;
+    }
+    sparse_rows_apply(m, in, out);
+}
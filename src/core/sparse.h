@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "definitions.h"
+
+// a matrix whose rows each touch one contiguous run of columns, e.g. bins to
+// display rows or a filterbank; row r reads columns
+// [start[r], start[r] + len[r]) against weights[offset[r]...]
+typedef struct {
+    SizeType n_rows;
+    SizeType n_cols;
+    SizeType* start;
+    SizeType* len;
+    SizeType* offset;
+    float* weights;
+    SizeType n_pushed;   // rows filled in so far
+    SizeType n_weights;  // used
+    SizeType capacity;   // allocated
+} SparseRows;
+
+// rows are then appended in order with sparse_rows_push
+SparseRows sparse_rows_new(SizeType n_rows, SizeType n_cols);
+bool sparse_rows_ok(const SparseRows* m);
+void sparse_rows_free(SparseRows* m);
+
+// appends the next row, returns false when out of memory, out of rows or if
+// the run goes past n_cols; apply expects all n_rows to be pushed
+bool sparse_rows_push(SparseRows* m,
+                      SizeType start,
+                      SizeType len,
+                      const float* weights);
+
+// out[r] = sum weights * in[run], for every row
+void sparse_rows_apply(const SparseRows* restrict m,
+                       const float* restrict in,
+                       float* restrict out);
+
+// how a row combines its run
+typedef enum {
+    POOL_MEAN,  // the weighted sum, exactly sparse_rows_apply
+    POOL_RMS,   // power mean of order 2, sqrt(sum w x^2), favours peaks
+    POOL_MAX,   // largest x scaled by its weight over the row's largest
+                // weight: pooled rows keep their peaks, edges count pro rata
+                // and two-bin interpolating rows stay continuous
+    POOL_COUNT,
+} RowPooling;
+
+const char* row_pooling_name(RowPooling pooling);
+
+// POOL_COUNT when the name is unknown
+RowPooling row_pooling_from_name(const char* name);
+
+void sparse_rows_apply_pooled(const SparseRows* restrict m,
+                              RowPooling pooling,
+                              const float* restrict in,
+                              float* restrict out);
@@ -0,0 +1,221 @@
+#include "waveform.h"
+
+#include <float.h>
+#include <math.h>
+
+static WaveformSpan waveform_span_empty(void)
+{
+    return (WaveformSpan){
+        .min = FLT_MAX,
+        .max = -FLT_MAX,
+        .sum_squares = 0.0f,
+        .samples = 0,
+    };
+}
+
+static void waveform_span_add(WaveformSpan* span, const WaveformSpan* other)
+{
+    span->min = other->min < span->min ? other->min : span->min;
+    span->max = other->max > span->max ? other->max : span->max;
+    span->sum_squares += other->sum_squares;
+    span->samples += other->samples;
+}
+
+float waveform_span_rms(const WaveformSpan* span)
+{
+    return span->samples > 0
+               ? sqrtf(span->sum_squares / (float)span->samples)
+               : 0.0f;
+}
+
+WaveformPyramid waveform_pyramid_new(uint64_t span)
+{
+    WaveformPyramid pyramid = {0};
+
+    SizeType block = WAVEFORM_BLOCK;
+    for (SizeType l = 0; l < WAVEFORM_LEVELS; ++l) {
+        // one more for the entry the oldest sample may fall in
+        const SizeType cap = (SizeType)((span + block - 1) / block) + 1;
+        pyramid.levels[l] = (WaveformLevel){
+            .block = block,
+            .min = fhistory_new(cap),
+            .max = fhistory_new(cap),
+            .rms = fhistory_new(cap),
+            .entries = 0,
+            .pending = waveform_span_empty(),
+        };
+        block *= WAVEFORM_FANOUT;
+    }
+
+    return pyramid;
+}
+
+bool waveform_pyramid_ok(const WaveformPyramid* pyramid)
+{
+    if (!pyramid) {
+        return false;
+    }
+
+    for (SizeType l = 0; l < WAVEFORM_LEVELS; ++l) {
+        const WaveformLevel* level = &pyramid->levels[l];
+        if (!level->min.data || !level->max.data || !level->rms.data) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void waveform_pyramid_free(WaveformPyramid* pyramid)
+{
+    if (!pyramid) {
+        return;
+    }
+
+    for (SizeType l = 0; l < WAVEFORM_LEVELS; ++l) {
+        fhistory_destroy(pyramid->levels[l].min);
+        fhistory_destroy(pyramid->levels[l].max);
+        fhistory_destroy(pyramid->levels[l].rms);
+    }
+    *pyramid = (WaveformPyramid){0};
+}
+
+// one run of samples into a span, in WAVEFORM_LANES partial minima, maxima
+// and sums the compiler can vectorize; a block is a few of these runs at most
+static void waveform_reduce(WaveformSpan* span,
+                            const float* restrict x,
+                            SizeType n)
+{
+    float lo[WAVEFORM_LANES];
+    float hi[WAVEFORM_LANES];
+    float squares[WAVEFORM_LANES];
+    for (SizeType l = 0; l < WAVEFORM_LANES; ++l) {
+        lo[l] = FLT_MAX;
+        hi[l] = -FLT_MAX;
+        squares[l] = 0.0f;
+    }
+
+    const SizeType n_blocks = n / WAVEFORM_LANES;
+    for (SizeType blk = 0; blk < n_blocks; ++blk) {
+        for (SizeType l = 0; l < WAVEFORM_LANES; ++l) {
+            const float v = x[blk * WAVEFORM_LANES + l];
+            lo[l] = v < lo[l] ? v : lo[l];
+            hi[l] = v > hi[l] ? v : hi[l];
+            squares[l] += v * v;
+        }
+    }
+
+    WaveformSpan run = waveform_span_empty();
+    for (SizeType l = 0; l < WAVEFORM_LANES; ++l) {
+        run.min = lo[l] < run.min ? lo[l] : run.min;
+        run.max = hi[l] > run.max ? hi[l] : run.max;
+        run.sum_squares += squares[l];
+    }
+    for (SizeType i = n_blocks * WAVEFORM_LANES; i < n; ++i) {
+        const float v = x[i];
+        run.min = v < run.min ? v : run.min;
+        run.max = v > run.max ? v : run.max;
+        run.sum_squares += v * v;
+    }
+    run.samples = n;
+
+    waveform_span_add(span, &run);
+}
+
+// the pending entry of level l is whole: into its rings, and into the
+// pending entry of the level above
+static void waveform_commit(WaveformPyramid* pyramid, SizeType l)
+{
+    WaveformLevel* level = &pyramid->levels[l];
+    const WaveformSpan entry = level->pending;
+
+    fhistory_push(&level->min, entry.min);
+    fhistory_push(&level->max, entry.max);
+    fhistory_push(&level->rms, waveform_span_rms(&entry));
+    ++level->entries;
+    level->pending = waveform_span_empty();
+
+    if (l + 1 < WAVEFORM_LEVELS) {
+        WaveformLevel* above = &pyramid->levels[l + 1];
+        waveform_span_add(&above->pending, &entry);
+        if (above->pending.samples == above->block) {
+            waveform_commit(pyramid, l + 1);
+        }
+    }
+}
+
+void waveform_pyramid_push(WaveformPyramid* pyramid,
+                           const float* samples,
+                           SizeType n)
+{
+    WaveformLevel* level = &pyramid->levels[0];
+
+    // never across the end of a block, so each run lands in one entry
+    SizeType i = 0;
+    while (i < n) {
+        const SizeType room = level->block - (SizeType)level->pending.samples;
+        const SizeType run = n - i < room ? n - i : room;
+        waveform_reduce(&level->pending, samples + i, run);
+        i += run;
+
+        if (level->pending.samples == level->block) {
+            waveform_commit(pyramid, 0);
+        }
+    }
+    pyramid->samples += n;
+}
+
+SizeType waveform_pyramid_level_for(float samples_per_column)
+{
+    SizeType l = 0;
+    float block = (float)(WAVEFORM_BLOCK * WAVEFORM_FANOUT);
+    while (l + 1 < WAVEFORM_LEVELS && block <= samples_per_column) {
+        ++l;
+        block *= (float)WAVEFORM_FANOUT;
+    }
+    return l;
+}
+
+WaveformSpan waveform_pyramid_span(const WaveformPyramid* pyramid,
+                                   SizeType l,
+                                   uint64_t from,
+                                   uint64_t to)
+{
+    WaveformSpan span = waveform_span_empty();
+    l = l < WAVEFORM_LEVELS ? l : WAVEFORM_LEVELS - 1;
+
+    for (;;) {
+        const WaveformLevel* level = &pyramid->levels[l];
+        const uint64_t block = level->block;
+        const uint64_t cap = level->min.cap;
+
+        // entries that overlap [from, to) and are still in the rings
+        const uint64_t oldest = level->entries - level->min.len;
+        uint64_t first = from / block;
+        uint64_t last = (to + block - 1) / block;
+        first = first > oldest ? first : oldest;
+        last = last < level->entries ? last : level->entries;
+        for (uint64_t k = first; k < last; ++k) {
+            const SizeType slot = (SizeType)(k % cap);
+            const float rms = level->rms.data[slot];
+            const WaveformSpan entry = {
+                .min = level->min.data[slot],
+                .max = level->max.data[slot],
+                .sum_squares = rms * rms * (float)block,
+                .samples = block,
+            };
+            waveform_span_add(&span, &entry);
+        }
+
+        // the rest is newer than this level's last entry
+        const uint64_t done = level->entries * block;
+        if (to <= done) {
+            return span;
+        }
+        from = from > done ? from : done;
+        if (l == 0) {
+            waveform_span_add(&span, &level->pending);
+            return span;
+        }
+        --l;
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "History.h"
+#include "definitions.h"
+
+// a min/max/RMS summary of a sample stream at a few resolutions, built as
+// the samples arrive: level 0 reduces WAVEFORM_BLOCK samples per entry and
+// every next level WAVEFORM_FANOUT entries of the one below, so 256, 4096
+// and 65536 samples per entry
+#define WAVEFORM_LEVELS 3
+#define WAVEFORM_BLOCK 256
+#define WAVEFORM_FANOUT 16
+
+// partial reductions the compiler can keep in one vector register each
+#define WAVEFORM_LANES 8
+
+typedef struct {
+    float min;
+    float max;
+    float sum_squares;
+    uint64_t samples;  // 0: nothing was summarized
+} WaveformSpan;
+
+typedef struct {
+    SizeType block;  // samples per entry
+    // entry k covers samples [k * block, (k + 1) * block) and sits in slot
+    // k % cap of every ring
+    FloatHistory min;
+    FloatHistory max;
+    FloatHistory rms;
+    uint64_t entries;  // pushed so far
+    WaveformSpan pending;  // the entry being built
+} WaveformLevel;
+
+typedef struct {
+    WaveformLevel levels[WAVEFORM_LEVELS];
+    uint64_t samples;  // pushed so far
+} WaveformPyramid;
+
+// every level keeps at least the last `span` samples
+WaveformPyramid waveform_pyramid_new(uint64_t span);
+bool waveform_pyramid_ok(const WaveformPyramid* pyramid);
+void waveform_pyramid_free(WaveformPyramid* pyramid);
+
+void waveform_pyramid_push(WaveformPyramid* pyramid,
+                           const float* samples,
+                           SizeType n);
+
+// the coarsest level whose entries are no longer than samples_per_column,
+// so a column never combines more than WAVEFORM_FANOUT of them
+SizeType waveform_pyramid_level_for(float samples_per_column);
+
+// samples [from, to) summarized from `level`'s entries that overlap them,
+// and from finer levels where `level` hasn't finished an entry yet; the
+// newest samples come from level 0's pending entry
+WaveformSpan waveform_pyramid_span(const WaveformPyramid* pyramid,
+                                   SizeType level,
+                                   uint64_t from,
+                                   uint64_t to);
+
+float waveform_span_rms(const WaveformSpan* span);
@@ -0,0 +1,311 @@
+#include "biquad.h"
+
+#include <math.h>
+#include <string.h>
+
+static float flush_denormal(float s)
+{
+    return fabsf(s) < BIQUAD_DENORMAL_FLOOR ? 0.0f : s;
+}
+
+Biquad biquad_init(BiquadCoeffs coeffs)
+{
+    return (Biquad){
+        .c = coeffs,
+        .s1 = 0,
+        .s2 = 0,
+    };
+}
+
+void biquad_flush_denormals(Biquad* f)
+{
+    f->s1 = flush_denormal(f->s1);
+    f->s2 = flush_denormal(f->s2);
+}
+
+// y[n]  = b0 x[n] + s1
+// s1'   = b1 x[n] - a1 y[n] + s2
+// s2'   = b2 x[n] - a2 y[n]
+void biquad_process(Biquad* restrict f,
+                    const float* in,
+                    float* out,
+                    SizeType size)
+{
+    const BiquadCoeffs c = f->c;
+    float s1 = f->s1;
+    float s2 = f->s2;
+
+    for (SizeType i = 0; i < size; ++i) {
+        const float x = in[i];
+        const float y = c.b0 * x + s1;
+        s1 = c.b1 * x - c.a1 * y + s2;
+        s2 = c.b2 * x - c.a2 * y;
+        out[i] = y;
+    }
+
+    f->s1 = flush_denormal(s1);
+    f->s2 = flush_denormal(s2);
+}
+
+// the BS.1770 filters are specified as coefficients at 48 kHz, these are the
+// analog prototypes they were derived from, as popularized by libebur128, so
+// that other rates get the same response
+BiquadCoeffs biquad_k_weighting_shelf(float sample_rate)
+{
+    const double f0 = 1681.974450955533;
+    const double gain_db = 3.999843853973347;
+    const double q = 0.7071752369554196;
+
+    const double k = tan((double)PI * f0 / (double)sample_rate);
+    const double vh = pow(10.0, gain_db / 20.0);
+    const double vb = pow(vh, 0.4996667741545416);
+    const double a0 = 1.0 + k / q + k * k;
+
+    return (BiquadCoeffs){
+        .b0 = (float)((vh + vb * k / q + k * k) / a0),
+        .b1 = (float)(2.0 * (k * k - vh) / a0),
+        .b2 = (float)((vh - vb * k / q + k * k) / a0),
+        .a1 = (float)(2.0 * (k * k - 1.0) / a0),
+        .a2 = (float)((1.0 - k / q + k * k) / a0),
+    };
+}
+
+BiquadCoeffs biquad_k_weighting_highpass(float sample_rate)
+{
+    const double f0 = 38.13547087602444;
+    const double q = 0.5003270373238773;
+
+    const double k = tan((double)PI * f0 / (double)sample_rate);
+    const double a0 = 1.0 + k / q + k * k;
+
+    return (BiquadCoeffs){
+        .b0 = 1.0f,
+        .b1 = -2.0f,
+        .b2 = 1.0f,
+        .a1 = (float)(2.0 * (k * k - 1.0) / a0),
+        .a2 = (float)((1.0 - k / q + k * k) / a0),
+    };
+}
+
+// everything below is designed in double, the coefficients of narrow or
+// low-frequency sections are sensitive to rounding before normalization
+static BiquadCoeffs normalize(double b0,
+                              double b1,
+                              double b2,
+                              double a0,
+                              double a1,
+                              double a2)
+{
+    return (BiquadCoeffs){
+        .b0 = (float)(b0 / a0),
+        .b1 = (float)(b1 / a0),
+        .b2 = (float)(b2 / a0),
+        .a1 = (float)(a1 / a0),
+        .a2 = (float)(a2 / a0),
+    };
+}
+
+BiquadCoeffs biquad_rbj(BiquadType type,
+                        float f0,
+                        float q,
+                        float gain_db,
+                        float sample_rate)
+{
+    const double w0 = 2.0 * (double)PI * (double)f0 / (double)sample_rate;
+    const double cw = cos(w0);
+    const double alpha = sin(w0) / (2.0 * (double)q);
+    const double a = pow(10.0, (double)gain_db / 40.0);
+
+    switch (type) {
+    case BIQUAD_LOWPASS:
+        return normalize((1.0 - cw) / 2.0, 1.0 - cw, (1.0 - cw) / 2.0,
+                         1.0 + alpha, -2.0 * cw, 1.0 - alpha);
+    case BIQUAD_HIGHPASS:
+        return normalize((1.0 + cw) / 2.0, -(1.0 + cw), (1.0 + cw) / 2.0,
+                         1.0 + alpha, -2.0 * cw, 1.0 - alpha);
+    case BIQUAD_BANDPASS:
+        return normalize(alpha, 0.0, -alpha, 1.0 + alpha, -2.0 * cw,
+                         1.0 - alpha);
+    case BIQUAD_NOTCH:
+        return normalize(1.0, -2.0 * cw, 1.0, 1.0 + alpha, -2.0 * cw,
+                         1.0 - alpha);
+    case BIQUAD_PEAK:
+        return normalize(1.0 + alpha * a, -2.0 * cw, 1.0 - alpha * a,
+                         1.0 + alpha / a, -2.0 * cw, 1.0 - alpha / a);
+    case BIQUAD_LOW_SHELF: {
+        const double k = 2.0 * sqrt(a) * alpha;
+        return normalize(a * ((a + 1.0) - (a - 1.0) * cw + k),
+                         2.0 * a * ((a - 1.0) - (a + 1.0) * cw),
+                         a * ((a + 1.0) - (a - 1.0) * cw - k),
+                         (a + 1.0) + (a - 1.0) * cw + k,
+                         -2.0 * ((a - 1.0) + (a + 1.0) * cw),
+                         (a + 1.0) + (a - 1.0) * cw - k);
+    }
+    case BIQUAD_HIGH_SHELF: {
+        const double k = 2.0 * sqrt(a) * alpha;
+        return normalize(a * ((a + 1.0) + (a - 1.0) * cw + k),
+                         -2.0 * a * ((a - 1.0) + (a + 1.0) * cw),
+                         a * ((a + 1.0) + (a - 1.0) * cw - k),
+                         (a + 1.0) - (a - 1.0) * cw + k,
+                         2.0 * ((a - 1.0) - (a + 1.0) * cw),
+                         (a + 1.0) - (a - 1.0) * cw - k);
+    }
+    }
+
+    // pass-through
+    return (BiquadCoeffs){.b0 = 1.0f};
+}
+
+// the analog prototype's poles sit on the unit circle at angles
+// (2k + 1 + N % 2) pi / 2N from the negative real axis, each conjugate pair is
+// one section with Q = 1 / 2cos(angle); odd orders also have a real pole
+SizeType biquad_butterworth(BiquadCoeffs* sections,
+                            SizeType order,
+                            bool highpass,
+                            float f0,
+                            float sample_rate)
+{
+    if (order == 0 || order > BUTTERWORTH_MAX_ORDER) {
+        return 0;
+    }
+
+    const BiquadType type = highpass ? BIQUAD_HIGHPASS : BIQUAD_LOWPASS;
+    const SizeType pairs = order / 2;
+
+    for (SizeType k = 0; k < pairs; ++k) {
+        const double angle =
+            (double)PI * (double)(2 * k + 1 + order % 2) / (double)(2 * order);
+        const double q = 1.0 / (2.0 * cos(angle));
+        sections[k] = biquad_rbj(type, f0, (float)q, 0.0f, sample_rate);
+    }
+
+    if (order % 2 == 0) {
+        return pairs;
+    }
+
+    // the real pole, bilinear transform of 1 / (s + 1)
+    const double k = tan((double)PI * (double)f0 / (double)sample_rate);
+    sections[pairs] =
+        highpass ? normalize(1.0, -1.0, 0.0, 1.0 + k, k - 1.0, 0.0)
+                 : normalize(k, k, 0.0, 1.0 + k, k - 1.0, 0.0);
+
+    return pairs + 1;
+}
+
+static void section_set(BiquadSection* s, SizeType lane, BiquadCoeffs c)
+{
+    s->b0[lane] = c.b0;
+    s->b1[lane] = c.b1;
+    s->b2[lane] = c.b2;
+    s->a1[lane] = c.a1;
+    s->a2[lane] = c.a2;
+}
+
+BiquadBank biquad_bank_new(void)
+{
+    BiquadBank bank;
+    memset(&bank, 0, sizeof(bank));
+
+    const BiquadCoeffs identity = {.b0 = 1.0f};
+    for (SizeType s = 0; s < BIQUAD_MAX_SECTIONS; ++s) {
+        for (SizeType lane = 0; lane < BIQUAD_LANES; ++lane) {
+            section_set(&bank.sections[s], lane, identity);
+        }
+    }
+
+    return bank;
+}
+
+bool biquad_bank_set_lane(BiquadBank* bank,
+                          SizeType lane,
+                          const BiquadCoeffs* sections,
+                          SizeType n_sections)
+{
+    if (lane >= BIQUAD_LANES || n_sections > BIQUAD_MAX_SECTIONS) {
+        return false;
+    }
+
+    const BiquadCoeffs identity = {.b0 = 1.0f};
+    for (SizeType s = 0; s < BIQUAD_MAX_SECTIONS; ++s) {
+        section_set(&bank->sections[s], lane,
+                    s < n_sections ? sections[s] : identity);
+    }
+
+    // never shrink, another lane may still need the sections
+    if (n_sections > bank->n_sections) {
+        bank->n_sections = n_sections;
+    }
+
+    return true;
+}
+
+void biquad_bank_reset(BiquadBank* bank)
+{
+    for (SizeType s = 0; s < BIQUAD_MAX_SECTIONS; ++s) {
+        memset(bank->sections[s].s1, 0, sizeof(bank->sections[s].s1));
+        memset(bank->sections[s].s2, 0, sizeof(bank->sections[s].s2));
+    }
+}
+
+// one frame through one section, every lane at once
+static void section_step(BiquadSection* restrict s, float* restrict x)
+{
+    for (SizeType lane = 0; lane < BIQUAD_LANES; ++lane) {
+        const float y = s->b0[lane] * x[lane] + s->s1[lane];
+        s->s1[lane] = s->b1[lane] * x[lane] - s->a1[lane] * y + s->s2[lane];
+        s->s2[lane] = s->b2[lane] * x[lane] - s->a2[lane] * y;
+        x[lane] = y;
+    }
+}
+
+static void bank_flush_denormals(BiquadBank* bank)
+{
+    for (SizeType s = 0; s < bank->n_sections; ++s) {
+        for (SizeType lane = 0; lane < BIQUAD_LANES; ++lane) {
+            bank->sections[s].s1[lane] =
+                flush_denormal(bank->sections[s].s1[lane]);
+            bank->sections[s].s2[lane] =
+                flush_denormal(bank->sections[s].s2[lane]);
+        }
+    }
+}
+
+void biquad_bank_process(BiquadBank* restrict bank,
+                         const float* in,
+                         float* out,
+                         SizeType frames)
+{
+    for (SizeType i = 0; i < frames; ++i) {
+        float x[BIQUAD_LANES];
+        memcpy(x, in + i * BIQUAD_LANES, sizeof(x));
+
+        for (SizeType s = 0; s < bank->n_sections; ++s) {
+            section_step(&bank->sections[s], x);
+        }
+
+        memcpy(out + i * BIQUAD_LANES, x, sizeof(x));
+    }
+
+    bank_flush_denormals(bank);
+}
+
+void biquad_bank_process_split(BiquadBank* restrict bank,
+                               const float* restrict in,
+                               float* restrict out,
+                               SizeType frames)
+{
+    for (SizeType i = 0; i < frames; ++i) {
+        float x[BIQUAD_LANES];
+        for (SizeType lane = 0; lane < BIQUAD_LANES; ++lane) {
+            x[lane] = in[i];
+        }
+
+        for (SizeType s = 0; s < bank->n_sections; ++s) {
+            section_step(&bank->sections[s], x);
+        }
+
+        memcpy(out + i * BIQUAD_LANES, x, sizeof(x));
+    }
+
+    bank_flush_denormals(bank);
+}
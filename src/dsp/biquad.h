@@ -0,0 +1,127 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "core/definitions.h"
+
+// state below this is flushed to zero at the end of every block, decaying
+// tails would otherwise crawl through denormals
+#define BIQUAD_DENORMAL_FLOOR 1e-15f
+
+// normalized so that a0 = 1
+//
+// H(z) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2)
+typedef struct {
+    float b0, b1, b2;
+    float a1, a2;
+} BiquadCoeffs;
+
+// transposed direct form II, the two state variables are all there is
+typedef struct {
+    BiquadCoeffs c;
+    float s1;
+    float s2;
+} Biquad;
+
+Biquad biquad_init(BiquadCoeffs coeffs);
+
+static inline float biquad_step(Biquad* restrict f, float x)
+{
+    const float y = f->c.b0 * x + f->s1;
+    f->s1 = f->c.b1 * x - f->c.a1 * y + f->s2;
+    f->s2 = f->c.b2 * x - f->c.a2 * y;
+    return y;
+}
+
+// biquad_process does this itself, callers of biquad_step should once a block
+void biquad_flush_denormals(Biquad* f);
+
+// in-place is fine
+void biquad_process(Biquad* restrict f,
+                    const float* in,
+                    float* out,
+                    SizeType size);
+
+// ITU-R BS.1770 K-weighting, designed for any sample rate
+// stage 1 is a high shelf modelling the head, +4 dB above ~1.7 kHz
+// stage 2 is the RLB high-pass, ~38 Hz
+BiquadCoeffs biquad_k_weighting_shelf(float sample_rate);
+BiquadCoeffs biquad_k_weighting_highpass(float sample_rate);
+
+typedef enum {
+    BIQUAD_LOWPASS,
+    BIQUAD_HIGHPASS,
+    BIQUAD_BANDPASS,  // 0 dB peak gain
+    BIQUAD_NOTCH,
+    BIQUAD_PEAK,
+    BIQUAD_LOW_SHELF,
+    BIQUAD_HIGH_SHELF,
+} BiquadType;
+
+// RBJ audio EQ cookbook, gain_db only matters for peak and shelves
+// for shelves q is the cookbook's Q, 1/sqrt(2) is the steepest monotone slope
+BiquadCoeffs biquad_rbj(BiquadType type,
+                        float f0,
+                        float q,
+                        float gain_db,
+                        float sample_rate);
+
+#define BUTTERWORTH_MAX_ORDER 16
+
+// fills `sections` with the cascade for a Butterworth low or high-pass,
+// odd orders end with a first-order section (b2 = a2 = 0)
+// returns the number of sections written, (order + 1) / 2, 0 if order is 0
+// or above BUTTERWORTH_MAX_ORDER
+SizeType biquad_butterworth(BiquadCoeffs* sections,
+                            SizeType order,
+                            bool highpass,
+                            float f0,
+                            float sample_rate);
+
+// independent biquad cascades in lock-step, one per lane: channels, or the
+// bands of a filter bank fed the same input
+//
+// coefficients and state are laid out lane-minor so the inner loops run over
+// a constant BIQUAD_LANES floats and vectorize without intrinsics
+#define BIQUAD_LANES 8
+#define BIQUAD_MAX_SECTIONS 8
+
+typedef struct {
+    float b0[BIQUAD_LANES];
+    float b1[BIQUAD_LANES];
+    float b2[BIQUAD_LANES];
+    float a1[BIQUAD_LANES];
+    float a2[BIQUAD_LANES];
+    float s1[BIQUAD_LANES];
+    float s2[BIQUAD_LANES];
+} BiquadSection;
+
+typedef struct {
+    BiquadSection sections[BIQUAD_MAX_SECTIONS];
+    SizeType n_sections;  // longest cascade among the lanes
+} BiquadBank;
+
+// every lane starts as a pass-through
+BiquadBank biquad_bank_new(void);
+
+// lanes with fewer sections than others pass through the extra ones
+// returns false if lane or n_sections is out of range
+bool biquad_bank_set_lane(BiquadBank* bank,
+                          SizeType lane,
+                          const BiquadCoeffs* sections,
+                          SizeType n_sections);
+
+void biquad_bank_reset(BiquadBank* bank);
+
+// in and out hold `frames` frames of BIQUAD_LANES interleaved samples,
+// in-place is fine
+void biquad_bank_process(BiquadBank* restrict bank,
+                         const float* in,
+                         float* out,
+                         SizeType frames);
+
+// filter bank: every lane sees the same mono input, out is interleaved
+void biquad_bank_process_split(BiquadBank* restrict bank,
+                               const float* restrict in,
+                               float* restrict out,
+                               SizeType frames);
@@ -0,0 +1,149 @@
+#include "czt.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+// e^{j phase}, with phase = scale * n^2 taken modulo 2 pi in double: n^2
+// reaches 1e11 for the multi-second frames this is meant for
+static kiss_fft_cpx chirp(double scale, SizeType n)
+{
+    const double n2 = (double)n * (double)n;
+    const double phase = fmod(scale * n2, 2.0 * (double)PI);
+    return (kiss_fft_cpx){
+        .r = (float)cos(phase),
+        .i = (float)sin(phase),
+    };
+}
+
+static kiss_fft_cpx cmul(kiss_fft_cpx a, kiss_fft_cpx b)
+{
+    return (kiss_fft_cpx){
+        .r = a.r * b.r - a.i * b.i,
+        .i = a.r * b.i + a.i * b.r,
+    };
+}
+
+CZT czt_new(SizeType size,
+            SizeType n_points,
+            float f_lo,
+            float f_hi,
+            float sample_rate)
+{
+    CZT czt = {0};
+
+    if (size == 0 || n_points < 2 || !(f_hi > f_lo)) {
+        return czt;
+    }
+
+    const SizeType fft_size =
+        (SizeType)kiss_fft_next_fast_size((int)(size + n_points - 1));
+
+    czt.size = size;
+    czt.n_points = n_points;
+    czt.fft_size = fft_size;
+    czt.forward = kiss_fft_alloc((int)fft_size, 0, NULL, NULL);
+    czt.inverse = kiss_fft_alloc((int)fft_size, 1, NULL, NULL);
+    czt.pre = malloc(size * sizeof(kiss_fft_cpx));
+    czt.kernel = calloc(fft_size, sizeof(kiss_fft_cpx));
+    czt.post = malloc(n_points * sizeof(kiss_fft_cpx));
+    czt.work = malloc(fft_size * sizeof(kiss_fft_cpx));
+    czt.spectrum = malloc(fft_size * sizeof(kiss_fft_cpx));
+
+    if (!czt_ok(&czt)) {
+        czt_free(&czt);
+        return (CZT){0};
+    }
+
+    // A = e^{j w0} is where we start, W = e^{-j dw} the step between points
+    const double w0 = 2.0 * (double)PI * (double)f_lo / (double)sample_rate;
+    const double dw = 2.0 * (double)PI * (double)(f_hi - f_lo) /
+                      ((double)sample_rate * (double)(n_points - 1));
+
+    for (SizeType n = 0; n < size; ++n) {
+        // A^-n W^(n^2/2) = e^{-j (w0 n + dw n^2 / 2)}
+        const kiss_fft_cpx a = {
+            .r = (float)cos(fmod(w0 * (double)n, 2.0 * (double)PI)),
+            .i = -(float)sin(fmod(w0 * (double)n, 2.0 * (double)PI)),
+        };
+        czt.pre[n] = cmul(a, chirp(-0.5 * dw, n));
+    }
+
+    for (SizeType k = 0; k < n_points; ++k) {
+        czt.post[k] = chirp(-0.5 * dw, k);
+    }
+
+    // W^(-m^2/2) for m in [-(size - 1), n_points - 1], negative m wrapped to
+    // the end of the buffer; the inverse FFT's factor L is folded in here
+    const float scale = 1.0f / (float)fft_size;
+    for (SizeType m = 0; m < n_points; ++m) {
+        const kiss_fft_cpx c = chirp(0.5 * dw, m);
+        czt.work[m] = (kiss_fft_cpx){c.r * scale, c.i * scale};
+    }
+    for (SizeType m = n_points; m < fft_size - size + 1; ++m) {
+        czt.work[m] = (kiss_fft_cpx){0.0f, 0.0f};
+    }
+    for (SizeType m = 1; m < size; ++m) {
+        const kiss_fft_cpx c = chirp(0.5 * dw, m);
+        czt.work[fft_size - m] = (kiss_fft_cpx){c.r * scale, c.i * scale};
+    }
+    kiss_fft(czt.forward, czt.work, czt.kernel);
+
+    return czt;
+}
+
+bool czt_ok(const CZT* czt)
+{
+    if (!czt) {
+        return false;
+    }
+
+    return czt->forward && czt->inverse && czt->pre && czt->kernel &&
+           czt->post && czt->work && czt->spectrum;
+}
+
+void czt_free(CZT* czt)
+{
+    if (!czt) {
+        return;
+    }
+
+    kiss_fft_free(czt->forward);
+    kiss_fft_free(czt->inverse);
+    free(czt->pre);
+    free(czt->kernel);
+    free(czt->post);
+    free(czt->work);
+    free(czt->spectrum);
+}
+
+void czt_process(CZT* restrict czt,
+                 const float* restrict frame,
+                 Complex* restrict out)
+{
+    kiss_fft_cpx* work = czt->work;
+
+    for (SizeType n = 0; n < czt->size; ++n) {
+        work[n] = (kiss_fft_cpx){
+            .r = frame[n] * czt->pre[n].r,
+            .i = frame[n] * czt->pre[n].i,
+        };
+    }
+    for (SizeType n = czt->size; n < czt->fft_size; ++n) {
+        work[n] = (kiss_fft_cpx){0.0f, 0.0f};
+    }
+
+    kiss_fft_cpx* spectrum = czt->spectrum;
+    kiss_fft(czt->forward, work, spectrum);
+
+    for (SizeType i = 0; i < czt->fft_size; ++i) {
+        spectrum[i] = cmul(spectrum[i], czt->kernel[i]);
+    }
+
+    kiss_fft(czt->inverse, spectrum, work);
+
+    // same layout, see FFTAnalyzer
+    kiss_fft_cpx* bins = (kiss_fft_cpx*)out;
+    for (SizeType k = 0; k < czt->n_points; ++k) {
+        bins[k] = cmul(work[k], czt->post[k]);
+    }
+}
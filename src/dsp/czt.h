@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "kiss_fft.h"
+
+#include "core/definitions.h"
+
+// chirp-Z transform: `n_points` spectrum samples evenly spaced over
+// [f_lo, f_hi] from a frame of `size` samples, for any span and any density
+//
+// Bluestein's algorithm turns it into a convolution of length
+// L >= size + n_points - 1, done with FFTs of size L; the chirp's FFT is
+// computed once, so each frame costs one forward and one inverse FFT
+//
+// the output has the same scale as kiss_fftr over the same frame, bins at
+// f_lo + k * (f_hi - f_lo) / (n_points - 1)
+typedef struct {
+    SizeType size;
+    SizeType n_points;
+    SizeType fft_size;  // L
+
+    kiss_fft_cfg forward;
+    kiss_fft_cfg inverse;
+    kiss_fft_cpx* pre;     // [size] A^-n W^(n^2/2), applied to the input
+    kiss_fft_cpx* kernel;  // [L] FFT of W^(-m^2/2), pre-scaled by 1/L
+    kiss_fft_cpx* post;    // [n_points] W^(k^2/2), applied to the output
+    kiss_fft_cpx* work;    // [L] x2, kiss_fft in place would allocate
+    kiss_fft_cpx* spectrum;
+} CZT;
+
+CZT czt_new(SizeType size,
+            SizeType n_points,
+            float f_lo,
+            float f_hi,
+            float sample_rate);
+bool czt_ok(const CZT* czt);
+void czt_free(CZT* czt);
+
+// frame holds `size` real samples, out receives `n_points` bins
+void czt_process(CZT* restrict czt,
+                 const float* restrict frame,
+                 Complex* restrict out);
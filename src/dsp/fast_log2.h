@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// log2 from the float's exponent plus the atanh series of its mantissa,
+// log2(m) = 2 / ln 2 * (t + t^3 / 3 + t^5 / 5 + t^7 / 7), t = (m - 1) / (m + 1)
+// in [0, 1/3]: within ~2e-5 of log2f and, unlike it, vectorized
+static inline float fast_log2(float x)
+{
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+
+    const float exponent = (float)(int32_t)((bits >> 23) & 0xff) - 127.0f;
+    bits = (bits & 0x007fffff) | 0x3f800000;  // mantissa in [1, 2)
+    float m;
+    memcpy(&m, &bits, sizeof(m));
+
+    const float t = (m - 1.0f) / (m + 1.0f);
+    const float t2 = t * t;
+    const float series =
+        t * (1.0f + t2 * (1.0f / 3.0f + t2 * (0.2f + t2 * (1.0f / 7.0f))));
+    return exponent + 2.8853901f * series;  // 2 / ln 2
+}
@@ -0,0 +1,416 @@
+#if defined(__unix__) || defined(__APPLE__)
+// threads and sysconf are POSIX, not C11
+#define _POSIX_C_SOURCE 200112L
+#include <pthread.h>
+#include <unistd.h>
+#define LARGE_FFT_PTHREADS 1
+#endif
+
+#include "large_fft.h"
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef struct {
+    LargeFFT* fft;
+    SizeType index;
+} Worker;
+
+struct LargeFFT {
+    SizeType size;
+    SizeType half;  // complex points, n1 * n2
+    SizeType n1;
+    SizeType n2;
+    SizeType n_threads;
+
+    kiss_fft_cfg plan1;  // length n1
+    kiss_fft_cfg plan2;  // length n2
+    kiss_fft_cpx* twiddles;        // [n2][n1] W^(j2 k1) over half points
+    kiss_fft_cpx* super_twiddles;  // [half / 2] as in kiss_fftr
+    kiss_fft_cpx* a;               // [half] the passes ping-pong between
+    kiss_fft_cpx* b;               // a and b
+
+    // the frame in flight
+    const kiss_fft_cpx* in;
+    kiss_fft_cpx* out;
+    atomic_bool done;
+
+#if defined(LARGE_FFT_PTHREADS)
+    Worker workers[LARGE_FFT_MAX_THREADS];
+    pthread_t threads[LARGE_FFT_MAX_THREADS];
+    SizeType n_started;
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;      // a new frame, or quit
+    pthread_cond_t step;      // everyone reached the barrier
+    pthread_cond_t finished;  // the last worker is done with the frame
+    uint64_t frame;           // bumped by every start
+    uint64_t generation;      // bumped by every barrier
+    SizeType arrived;         // workers waiting at the barrier
+    SizeType running;         // workers still on the frame
+    bool quit;
+#endif
+};
+
+static kiss_fft_cpx cmul(kiss_fft_cpx a, kiss_fft_cpx b)
+{
+    return (kiss_fft_cpx){
+        .r = a.r * b.r - a.i * b.i,
+        .i = a.r * b.i + a.i * b.r,
+    };
+}
+
+// the largest factor of n that's at most sqrt(n): rows as square as n allows
+static SizeType split_factor(SizeType n)
+{
+    SizeType best = 1;
+    for (SizeType f = 1; (uint64_t)f * f <= n; ++f) {
+        if (n % f == 0) {
+            best = f;
+        }
+    }
+    return best;
+}
+
+// [begin, end) of `count` items for worker w out of n
+static SizeType band_begin(SizeType count, SizeType w, SizeType n)
+{
+    return (SizeType)((uint64_t)count * w / n);
+}
+
+// dst = transpose of src, a rows x cols matrix; only dst rows [c0, c1)
+static void transpose_rows(const kiss_fft_cpx* restrict src,
+                           SizeType rows,
+                           SizeType cols,
+                           kiss_fft_cpx* restrict dst,
+                           SizeType c0,
+                           SizeType c1)
+{
+    for (SizeType cb = c0; cb < c1; cb += LARGE_FFT_TILE) {
+        const SizeType c_end = cb + LARGE_FFT_TILE < c1 ? cb + LARGE_FFT_TILE
+                                                        : c1;
+        for (SizeType rb = 0; rb < rows; rb += LARGE_FFT_TILE) {
+            const SizeType r_end =
+                rb + LARGE_FFT_TILE < rows ? rb + LARGE_FFT_TILE : rows;
+            for (SizeType c = cb; c < c_end; ++c) {
+                kiss_fft_cpx* row = dst + (size_t)c * rows;
+                for (SizeType r = rb; r < r_end; ++r) {
+                    row[r] = src[(size_t)r * cols + c];
+                }
+            }
+        }
+    }
+}
+
+static void barrier(LargeFFT* fft);
+
+// worker w's share of every pass, with a barrier wherever a pass reads what
+// another worker wrote
+static void run_passes(LargeFFT* fft, SizeType w)
+{
+    const SizeType n1 = fft->n1;
+    const SizeType n2 = fft->n2;
+    const SizeType t = fft->n_threads;
+
+    // x as n1 rows of n2 -> n2 rows of n1
+    transpose_rows(fft->in, n1, n2, fft->a, band_begin(n2, w, t),
+                   band_begin(n2, w + 1, t));
+    barrier(fft);
+
+    for (SizeType j2 = band_begin(n2, w, t); j2 < band_begin(n2, w + 1, t);
+         ++j2) {
+        kiss_fft_cpx* row = fft->b + (size_t)j2 * n1;
+        const kiss_fft_cpx* tw = fft->twiddles + (size_t)j2 * n1;
+        kiss_fft(fft->plan1, fft->a + (size_t)j2 * n1, row);
+        for (SizeType k1 = 0; k1 < n1; ++k1) {
+            row[k1] = cmul(row[k1], tw[k1]);
+        }
+    }
+    barrier(fft);
+
+    transpose_rows(fft->b, n2, n1, fft->a, band_begin(n1, w, t),
+                   band_begin(n1, w + 1, t));
+    barrier(fft);
+
+    for (SizeType k1 = band_begin(n1, w, t); k1 < band_begin(n1, w + 1, t);
+         ++k1) {
+        kiss_fft(fft->plan2, fft->a + (size_t)k1 * n2,
+                 fft->b + (size_t)k1 * n2);
+    }
+    barrier(fft);
+
+    // b[k1][k2] holds bin k1 + n1 * k2, one more transpose puts it in order
+    transpose_rows(fft->b, n1, n2, fft->a, band_begin(n2, w, t),
+                   band_begin(n2, w + 1, t));
+    barrier(fft);
+
+    // the even/odd samples went in as re/im, pull the real spectrum out
+    const kiss_fft_cpx* z = fft->a;
+    kiss_fft_cpx* out = fft->out;
+    const SizeType half = fft->half;
+    if (w == 0) {
+        out[0] = (kiss_fft_cpx){.r = z[0].r + z[0].i, .i = 0.0f};
+        out[half] = (kiss_fft_cpx){.r = z[0].r - z[0].i, .i = 0.0f};
+    }
+
+    const SizeType pairs = half / 2;
+    for (SizeType k = 1 + band_begin(pairs, w, t);
+         k < 1 + band_begin(pairs, w + 1, t); ++k) {
+        const kiss_fft_cpx fpk = z[k];
+        const kiss_fft_cpx fpnk = {.r = z[half - k].r, .i = -z[half - k].i};
+        const kiss_fft_cpx f1k = {.r = fpk.r + fpnk.r, .i = fpk.i + fpnk.i};
+        const kiss_fft_cpx f2k = {.r = fpk.r - fpnk.r, .i = fpk.i - fpnk.i};
+        const kiss_fft_cpx tw = cmul(f2k, fft->super_twiddles[k - 1]);
+
+        out[k] = (kiss_fft_cpx){
+            .r = 0.5f * (f1k.r + tw.r),
+            .i = 0.5f * (f1k.i + tw.i),
+        };
+        out[half - k] = (kiss_fft_cpx){
+            .r = 0.5f * (f1k.r - tw.r),
+            .i = 0.5f * (tw.i - f1k.i),
+        };
+    }
+}
+
+#if defined(LARGE_FFT_PTHREADS)
+static void barrier(LargeFFT* fft)
+{
+    pthread_mutex_lock(&fft->lock);
+    const uint64_t generation = fft->generation;
+    if (++fft->arrived == fft->n_threads) {
+        fft->arrived = 0;
+        ++fft->generation;
+        pthread_cond_broadcast(&fft->step);
+    } else {
+        while (generation == fft->generation) {
+            pthread_cond_wait(&fft->step, &fft->lock);
+        }
+    }
+    pthread_mutex_unlock(&fft->lock);
+}
+
+static void* worker_main(void* arg)
+{
+    const Worker* worker = arg;
+    LargeFFT* fft = worker->fft;
+
+    uint64_t seen = 0;
+    pthread_mutex_lock(&fft->lock);
+    for (;;) {
+        while (!fft->quit && fft->frame == seen) {
+            pthread_cond_wait(&fft->wake, &fft->lock);
+        }
+        if (fft->quit) {
+            break;
+        }
+        seen = fft->frame;
+        pthread_mutex_unlock(&fft->lock);
+
+        run_passes(fft, worker->index);
+
+        pthread_mutex_lock(&fft->lock);
+        if (--fft->running == 0) {
+            atomic_store_explicit(&fft->done, true, memory_order_release);
+            pthread_cond_broadcast(&fft->finished);
+        }
+    }
+    pthread_mutex_unlock(&fft->lock);
+
+    return NULL;
+}
+
+static bool start_workers(LargeFFT* fft)
+{
+    if (pthread_mutex_init(&fft->lock, NULL) != 0) {
+        return false;
+    }
+    pthread_cond_init(&fft->wake, NULL);
+    pthread_cond_init(&fft->step, NULL);
+    pthread_cond_init(&fft->finished, NULL);
+
+    for (SizeType w = 0; w < fft->n_threads; ++w) {
+        fft->workers[w] = (Worker){.fft = fft, .index = w};
+        if (pthread_create(&fft->threads[w], NULL, worker_main,
+                           &fft->workers[w]) != 0) {
+            return false;
+        }
+        ++fft->n_started;
+    }
+    return true;
+}
+
+static void stop_workers(LargeFFT* fft)
+{
+    if (fft->n_started == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&fft->lock);
+    fft->quit = true;
+    pthread_cond_broadcast(&fft->wake);
+    pthread_mutex_unlock(&fft->lock);
+
+    for (SizeType w = 0; w < fft->n_started; ++w) {
+        pthread_join(fft->threads[w], NULL);
+    }
+
+    pthread_cond_destroy(&fft->finished);
+    pthread_cond_destroy(&fft->step);
+    pthread_cond_destroy(&fft->wake);
+    pthread_mutex_destroy(&fft->lock);
+}
+#else
+static void barrier(LargeFFT* fft)
+{
+    (void)fft;  // a single pass runs everything in order
+}
+#endif
+
+LargeFFT* large_fft_new(SizeType size, SizeType n_threads)
+{
+    if (size < 4 || size % 2 != 0 || n_threads == 0 ||
+        n_threads > LARGE_FFT_MAX_THREADS) {
+        return NULL;
+    }
+
+    LargeFFT* fft = calloc(1, sizeof(*fft));
+    if (fft == NULL) {
+        return NULL;
+    }
+
+    const SizeType half = size / 2;
+    fft->size = size;
+    fft->half = half;
+    fft->n1 = split_factor(half);
+    fft->n2 = half / fft->n1;
+#if defined(LARGE_FFT_PTHREADS)
+    fft->n_threads = n_threads;
+#else
+    fft->n_threads = 1;
+#endif
+    atomic_init(&fft->done, true);
+
+    fft->plan1 = kiss_fft_alloc((int)fft->n1, 0, NULL, NULL);
+    fft->plan2 = kiss_fft_alloc((int)fft->n2, 0, NULL, NULL);
+    fft->twiddles = malloc(half * sizeof(kiss_fft_cpx));
+    fft->super_twiddles = malloc((half / 2) * sizeof(kiss_fft_cpx));
+    fft->a = malloc(half * sizeof(kiss_fft_cpx));
+    fft->b = malloc(half * sizeof(kiss_fft_cpx));
+    if (!fft->plan1 || !fft->plan2 || !fft->twiddles ||
+        !fft->super_twiddles || !fft->a || !fft->b) {
+        large_fft_free(fft);
+        return NULL;
+    }
+
+    // phases in double, j2 * k1 reduced exactly: it reaches 2.7e11 at 1M
+    for (SizeType j2 = 0; j2 < fft->n2; ++j2) {
+        for (SizeType k1 = 0; k1 < fft->n1; ++k1) {
+            const uint64_t m = (uint64_t)j2 * k1 % half;
+            const double phase = -2.0 * (double)PI * (double)m / (double)half;
+            fft->twiddles[(size_t)j2 * fft->n1 + k1] = (kiss_fft_cpx){
+                .r = (float)cos(phase),
+                .i = (float)sin(phase),
+            };
+        }
+    }
+    for (SizeType i = 0; i < half / 2; ++i) {
+        const double phase =
+            -(double)PI * ((double)(i + 1) / (double)half + 0.5);
+        fft->super_twiddles[i] = (kiss_fft_cpx){
+            .r = (float)cos(phase),
+            .i = (float)sin(phase),
+        };
+    }
+
+#if defined(LARGE_FFT_PTHREADS)
+    if (!start_workers(fft)) {
+        large_fft_free(fft);
+        return NULL;
+    }
+#endif
+
+    return fft;
+}
+
+void large_fft_free(LargeFFT* fft)
+{
+    if (!fft) {
+        return;
+    }
+
+#if defined(LARGE_FFT_PTHREADS)
+    if (fft->n_started == fft->n_threads) {
+        large_fft_wait(fft);
+    }
+    stop_workers(fft);
+#endif
+
+    kiss_fft_free(fft->plan1);
+    kiss_fft_free(fft->plan2);
+    free(fft->twiddles);
+    free(fft->super_twiddles);
+    free(fft->a);
+    free(fft->b);
+    free(fft);
+}
+
+void large_fft_start(LargeFFT* fft, const float* in, kiss_fft_cpx* out)
+{
+    atomic_store_explicit(&fft->done, false, memory_order_relaxed);
+
+#if defined(LARGE_FFT_PTHREADS)
+    pthread_mutex_lock(&fft->lock);
+    // same cast as kiss_fftr: pairs of samples are complex points
+    fft->in = (const kiss_fft_cpx*)in;
+    fft->out = out;
+    fft->running = fft->n_threads;
+    ++fft->frame;
+    pthread_cond_broadcast(&fft->wake);
+    pthread_mutex_unlock(&fft->lock);
+#else
+    fft->in = (const kiss_fft_cpx*)in;
+    fft->out = out;
+    run_passes(fft, 0);
+    atomic_store_explicit(&fft->done, true, memory_order_release);
+#endif
+}
+
+bool large_fft_done(LargeFFT* fft)
+{
+    return atomic_load_explicit(&fft->done, memory_order_acquire);
+}
+
+void large_fft_wait(LargeFFT* fft)
+{
+#if defined(LARGE_FFT_PTHREADS)
+    pthread_mutex_lock(&fft->lock);
+    while (!atomic_load_explicit(&fft->done, memory_order_acquire)) {
+        pthread_cond_wait(&fft->finished, &fft->lock);
+    }
+    pthread_mutex_unlock(&fft->lock);
+#else
+    (void)fft;  // start already did the work
+#endif
+}
+
+void large_fft_process(LargeFFT* fft, const float* in, kiss_fft_cpx* out)
+{
+    large_fft_start(fft, in, out);
+    large_fft_wait(fft);
+}
+
+SizeType large_fft_default_threads(void)
+{
+#if defined(LARGE_FFT_PTHREADS) && defined(_SC_NPROCESSORS_ONLN)
+    const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores > LARGE_FFT_MAX_THREADS) {
+        return LARGE_FFT_MAX_THREADS;
+    }
+    return cores > 1 ? (SizeType)cores : 1;
+#else
+    return 1;
+#endif
+}
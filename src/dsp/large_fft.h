@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "kiss_fft.h"
+
+#include "core/definitions.h"
+
+// real FFT of frames too large to transform within a display frame, 64k to
+// 1M points, split across worker threads
+//
+// the size / 2 point complex FFT kiss_fftr would do is decomposed six-step
+// style as n1 x n2, n1 * n2 = size / 2:
+//   transpose, n2 FFTs of length n1, twiddle, transpose,
+//   n1 FFTs of length n2, transpose
+// so every FFT runs over a contiguous row that fits in cache and each worker
+// owns a band of rows. the transposes go through LARGE_FFT_TILE square tiles
+// to keep both sides of the copy in cache. a last pass splits the real
+// spectrum out the way kiss_fftr does: same bins, same scale
+//
+// large_fft_start returns at once, the frame is done once large_fft_done
+// says so. without POSIX threads there are no workers and start does the
+// whole transform before returning
+#define LARGE_FFT_TILE 32
+#define LARGE_FFT_MAX_THREADS 64
+
+typedef struct LargeFFT LargeFFT;
+
+// size even, n_threads in [1, LARGE_FFT_MAX_THREADS]; NULL on failure
+LargeFFT* large_fft_new(SizeType size, SizeType n_threads);
+void large_fft_free(LargeFFT* fft);  // finishes a frame in flight first
+
+// `in` holds size samples, `out` receives size / 2 + 1 bins; neither may be
+// touched until the frame is done, nor may another frame start
+void large_fft_start(LargeFFT* fft, const float* in, kiss_fft_cpx* out);
+bool large_fft_done(LargeFFT* fft);
+void large_fft_wait(LargeFFT* fft);
+
+// start and wait
+void large_fft_process(LargeFFT* fft, const float* in, kiss_fft_cpx* out);
+
+// online cores, 1 where that can't be known
+SizeType large_fft_default_threads(void);
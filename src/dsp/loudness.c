@@ -0,0 +1,93 @@
+#include "loudness.h"
+
+#include <math.h>
+
+static SizeType seconds_to_samples(float seconds, float sample_rate)
+{
+    return (SizeType)lroundf(seconds * sample_rate);
+}
+
+LoudnessMeter loudness_meter_new(float sample_rate, SizeType rms_size)
+{
+    return (LoudnessMeter){
+        .shelf = biquad_init(biquad_k_weighting_shelf(sample_rate)),
+        .highpass = biquad_init(biquad_k_weighting_highpass(sample_rate)),
+        .true_peak = true_peak_init(),
+        .squares = sliding_sum_new(rms_size),
+        .momentary = sliding_sum_new(
+            seconds_to_samples(LOUDNESS_MOMENTARY_SECONDS, sample_rate)),
+        .short_term = sliding_sum_new(
+            seconds_to_samples(LOUDNESS_SHORT_TERM_SECONDS, sample_rate)),
+    };
+}
+
+bool loudness_meter_ok(const LoudnessMeter* m)
+{
+    if (!m) {
+        return false;
+    }
+
+    return sliding_sum_ok(&m->squares) && sliding_sum_ok(&m->momentary) &&
+           sliding_sum_ok(&m->short_term);
+}
+
+void loudness_meter_free(LoudnessMeter* m)
+{
+    if (!m) {
+        return;
+    }
+
+    sliding_sum_free(&m->squares);
+    sliding_sum_free(&m->momentary);
+    sliding_sum_free(&m->short_term);
+}
+
+float loudness_lufs(float mean_square)
+{
+    if (mean_square <= 0.0f) {
+        return LOUDNESS_SILENCE_LUFS;
+    }
+
+    const float lufs = -0.691f + 10.0f * log10f(mean_square);
+    return lufs > LOUDNESS_SILENCE_LUFS ? lufs : LOUDNESS_SILENCE_LUFS;
+}
+
+LoudnessReading loudness_meter_process(LoudnessMeter* restrict m,
+                                       const float* restrict samples,
+                                       SizeType size)
+{
+    float sample_peak = 0.0f;
+    float true_peak = 0.0f;
+
+    for (SizeType i = 0; i < size; ++i) {
+        const float x = samples[i];
+
+        sliding_sum_push(&m->squares, x * x);
+
+        const float magnitude = fabsf(x);
+        sample_peak = magnitude > sample_peak ? magnitude : sample_peak;
+
+        const float interpolated = true_peak_step(&m->true_peak, x);
+        true_peak = interpolated > true_peak ? interpolated : true_peak;
+
+        const float z =
+            biquad_step(&m->highpass, biquad_step(&m->shelf, x));
+        sliding_sum_push(&m->momentary, z * z);
+        sliding_sum_push(&m->short_term, z * z);
+    }
+
+    biquad_flush_denormals(&m->shelf);
+    biquad_flush_denormals(&m->highpass);
+
+    // the running sums may dip a hair under zero between renormalizations
+    const float mean_square = sliding_sum_mean(&m->squares);
+
+    return (LoudnessReading){
+        .rms = mean_square > 0.0f ? sqrtf(mean_square) : 0.0f,
+        .sample_peak = sample_peak,
+        // interpolation can undershoot a sample that sits on the peak
+        .true_peak = true_peak > sample_peak ? true_peak : sample_peak,
+        .momentary = loudness_lufs(sliding_sum_mean(&m->momentary)),
+        .short_term = loudness_lufs(sliding_sum_mean(&m->short_term)),
+    };
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "biquad.h"
+#include "sliding.h"
+#include "true_peak.h"
+
+#include "core/definitions.h"
+
+// BS.1770 gating floor, quieter than this reads as this
+#define LOUDNESS_SILENCE_LUFS (-70.0f)
+
+#define LOUDNESS_MOMENTARY_SECONDS 0.4f
+#define LOUDNESS_SHORT_TERM_SECONDS 3.0f
+
+typedef struct {
+    float rms;
+    float sample_peak;  // over the block, linear
+    float true_peak;    // over the block, linear
+    float momentary;    // LUFS, 400 ms window
+    float short_term;   // LUFS, 3 s window
+} LoudnessReading;
+
+// every metric from a single pass over the samples: running sums for the
+// windows, a polyphase FIR for true peak, a biquad pair for K-weighting
+//
+// mono, so the BS.1770 channel weight is 1
+typedef struct {
+    Biquad shelf;
+    Biquad highpass;
+    TruePeak true_peak;
+    SlidingSum squares;    // raw signal, rms window
+    SlidingSum momentary;  // K-weighted
+    SlidingSum short_term;
+} LoudnessMeter;
+
+LoudnessMeter loudness_meter_new(float sample_rate, SizeType rms_size);
+bool loudness_meter_ok(const LoudnessMeter* m);
+void loudness_meter_free(LoudnessMeter* m);
+
+// peaks cover the block, everything else the window ending with it
+LoudnessReading loudness_meter_process(LoudnessMeter* restrict m,
+                                       const float* restrict samples,
+                                       SizeType size);
+
+// -0.691 + 10 log10(mean square), clamped to LOUDNESS_SILENCE_LUFS
+float loudness_lufs(float mean_square);
@@ -0,0 +1,186 @@
+#include "mel.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "core/frequency_axis.h"
+
+SparseRows mel_filterbank_new(SizeType n_bins,
+                              float bin_hz,
+                              SizeType n_mels,
+                              float f_min,
+                              float f_max)
+{
+    SparseRows m = sparse_rows_new(n_mels, n_bins);
+    if (!sparse_rows_ok(&m)) {
+        return m;
+    }
+
+    // scratch for one band, a band never covers more than every bin
+    float* weights = malloc(n_bins * sizeof(float));
+    if (weights == NULL) {
+        sparse_rows_free(&m);
+        return (SparseRows){0};
+    }
+
+    const AxisRange mel = {.axis = AXIS_MEL, .f_min = f_min, .f_max = f_max};
+    const float n_edges = (float)(n_mels + 1);
+
+    for (SizeType band = 0; band < n_mels; ++band) {
+        const float lo = axis_range_frequency(&mel, (float)band / n_edges);
+        const float centre =
+            axis_range_frequency(&mel, (float)(band + 1) / n_edges);
+        const float hi =
+            axis_range_frequency(&mel, (float)(band + 2) / n_edges);
+
+        // bins strictly inside (lo, hi), in bin positions b = hz / bin_hz - 1
+        const float first_pos = floorf(lo / bin_hz - 1.0f) + 1.0f;
+        const float last_pos = ceilf(hi / bin_hz - 1.0f) - 1.0f;
+        const SizeType first = first_pos > 0.0f ? (SizeType)first_pos : 0;
+        SizeType last = last_pos > 0.0f ? (SizeType)last_pos : 0;
+        last = last < n_bins ? last : n_bins - 1;
+
+        SizeType start = first;
+        SizeType len = 0;
+        const float area = 2.0f / (hi - lo);
+        if (first <= last && last_pos >= 0.0f) {
+            len = last - first + 1;
+            for (SizeType i = 0; i < len; ++i) {
+                const float hz = (float)(first + i + 1) * bin_hz;
+                const float up = (hz - lo) / (centre - lo);
+                const float down = (hi - hz) / (hi - centre);
+                weights[i] = area * fmaxf(fminf(up, down), 0.0f);
+            }
+        }
+
+        if (len == 0) {
+            // narrower than a bin: read the spectrum at the centre, scaled
+            // like a band of one bin's width
+            const float pos =
+                fminf(fmaxf(centre / bin_hz - 1.0f, 0.0f), (float)(n_bins - 1));
+            start = (SizeType)pos;
+            const float frac = pos - (float)start;
+            const float scale = 1.0f / bin_hz;
+            if (start + 1 < n_bins && frac > 0.0f) {
+                weights[0] = scale * (1.0f - frac);
+                weights[1] = scale * frac;
+                len = 2;
+            } else {
+                weights[0] = scale;
+                len = 1;
+            }
+        }
+
+        if (!sparse_rows_push(&m, start, len, weights)) {
+            free(weights);
+            sparse_rows_free(&m);
+            return (SparseRows){0};
+        }
+    }
+
+    free(weights);
+    return m;
+}
+
+// orthonormal DCT-II, the same basis as scipy's dct(type=2, norm="ortho"),
+// stored band-major so the product is a run of axpys over the coefficients
+static void make_dct(float* dct, SizeType n_coeffs, SizeType n_mels)
+{
+    const double n = (double)n_mels;
+    for (SizeType k = 0; k < n_coeffs; ++k) {
+        const double scale = (k == 0) ? sqrt(1.0 / n) : sqrt(2.0 / n);
+        for (SizeType m = 0; m < n_mels; ++m) {
+            dct[m * n_coeffs + k] = (float)(
+                scale * cos((double)PI / n * ((double)m + 0.5) * (double)k));
+        }
+    }
+}
+
+MelExtractor mel_extractor_new(const MelConfig* cfg)
+{
+    if (cfg->n_bins == 0 || cfg->n_mels == 0 || cfg->n_coeffs > cfg->n_mels) {
+        return (MelExtractor){0};
+    }
+
+    MelExtractor ext = {
+        .filters = mel_filterbank_new(cfg->n_bins, cfg->bin_hz, cfg->n_mels,
+                                      cfg->f_min, cfg->f_max),
+        .dct = malloc(cfg->n_coeffs * cfg->n_mels * sizeof(float)),
+        .power = malloc(cfg->n_bins * sizeof(float)),
+        .mel = malloc(cfg->n_mels * sizeof(float)),
+        .n_bins = cfg->n_bins,
+        .n_mels = cfg->n_mels,
+        .n_coeffs = cfg->n_coeffs,
+        .power_reference = cfg->power_reference,
+        .min_power = powf(10.0f, 0.1f * cfg->min_dB),
+    };
+
+    if (!mel_extractor_ok(&ext)) {
+        mel_extractor_free(&ext);
+        return (MelExtractor){0};
+    }
+
+    make_dct(ext.dct, ext.n_coeffs, ext.n_mels);
+    return ext;
+}
+
+bool mel_extractor_ok(const MelExtractor* ext)
+{
+    if (!ext) {
+        return false;
+    }
+
+    return sparse_rows_ok(&ext->filters) && ext->power && ext->mel &&
+           (ext->dct || ext->n_coeffs == 0);
+}
+
+void mel_extractor_free(MelExtractor* ext)
+{
+    if (!ext) {
+        return;
+    }
+
+    sparse_rows_free(&ext->filters);
+    free(ext->dct);
+    free(ext->power);
+    free(ext->mel);
+    *ext = (MelExtractor){0};
+}
+
+void mel_extractor_process(MelExtractor* ext,
+                           const Complex* bins,
+                           float* restrict log_mel,
+                           float* restrict mfcc)
+{
+    // size_t: a 32 bit index could wrap as far as the vectorizer knows
+    const float* re_im = (const float*)bins;
+    float* restrict power = ext->power;
+    const float scale = 1.0f / ext->power_reference;
+    for (size_t b = 0; b < ext->n_bins; ++b) {
+        const float re = re_im[2 * b];
+        const float im = re_im[2 * b + 1];
+        power[b] = scale * (re * re + im * im);
+    }
+
+    sparse_rows_apply(&ext->filters, power, ext->mel);
+
+    for (SizeType m = 0; m < ext->n_mels; ++m) {
+        log_mel[m] = 10.0f * log10f(fmaxf(ext->mel[m], ext->min_power));
+    }
+
+    if (mfcc == NULL) {
+        return;
+    }
+
+    // a band at a time: no reduction, so nothing to reassociate
+    for (SizeType k = 0; k < ext->n_coeffs; ++k) {
+        mfcc[k] = 0.0f;
+    }
+    for (SizeType m = 0; m < ext->n_mels; ++m) {
+        const float* basis = ext->dct + m * ext->n_coeffs;
+        const float x = log_mel[m];
+        for (SizeType k = 0; k < ext->n_coeffs; ++k) {
+            mfcc[k] += basis[k] * x;
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "core/definitions.h"
+#include "core/sparse.h"
+
+// triangular filters evenly spaced on the mel scale of AXIS_MEL, each
+// normalized to unit area so a flat spectrum reads the same in every band
+// (what librosa calls norm="slaney"); band b rises from edge b to edge b + 1
+// and falls to edge b + 2 of n_mels + 2 edges spanning [f_min, f_max]
+//
+// bins are laid out like an FFTHistory row, bin b centred on (b + 1) * bin_hz;
+// a band narrower than a bin interpolates its centre instead of going empty
+SparseRows mel_filterbank_new(SizeType n_bins,
+                              float bin_hz,
+                              SizeType n_mels,
+                              float f_min,
+                              float f_max);
+
+typedef struct {
+    SizeType n_bins;
+    float bin_hz;
+    SizeType n_mels;
+    SizeType n_coeffs;  // MFCCs kept, at most n_mels
+    float f_min;
+    float f_max;
+    float power_reference;  // defines 0 dB
+    float min_dB;           // log-mel floor
+} MelConfig;
+
+// power spectrum -> mel bands -> dB -> DCT-II, one frame at a time
+//
+// the filterbank is a sparse (start, len, weights) table, the DCT a dense
+// orthonormal matrix; both are straight passes over contiguous floats
+typedef struct {
+    SparseRows filters;
+    float* dct;    // n_mels x n_coeffs, column k is DCT-II basis k
+    float* power;  // of the frame being processed, per bin
+    float* mel;    // per band, before the log
+    SizeType n_bins;
+    SizeType n_mels;
+    SizeType n_coeffs;
+    float power_reference;
+    float min_power;  // min_dB, relative to power_reference
+} MelExtractor;
+
+MelExtractor mel_extractor_new(const MelConfig* cfg);
+bool mel_extractor_ok(const MelExtractor* ext);
+void mel_extractor_free(MelExtractor* ext);
+
+// log_mel gets n_mels values in dB, mfcc n_coeffs; mfcc may be NULL
+void mel_extractor_process(MelExtractor* ext,
+                           const Complex* bins,
+                           float* restrict log_mel,
+                           float* restrict mfcc);
@@ -0,0 +1,482 @@
+#include "partials.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fast_log2.h"
+
+#define LOG2_TO_DB 3.0103000f  // 10 log10(2)
+
+PartialTracker partial_tracker_new(const PartialConfig* cfg)
+{
+    PartialTracker tracker = {0};
+    if (cfg->size < 4 || cfg->size % 2 != 0 || cfg->stride == 0 ||
+        !(cfg->sample_rate > 0.0f) || !(cfg->power_reference > 0.0f) ||
+        cfg->cap == 0) {
+        return tracker;
+    }
+
+    const SizeType n_bins = cfg->size / 2;
+    tracker.cfg = *cfg;
+    if (tracker.cfg.max_peaks == 0 ||
+        tracker.cfg.max_peaks > PARTIAL_MAX_PEAKS) {
+        tracker.cfg.max_peaks = PARTIAL_MAX_PEAKS;
+    }
+    tracker.n_bins = n_bins;
+    tracker.bin_hz = cfg->sample_rate / (float)cfg->size;
+
+    // the phase tells frequencies apart within size / (2 stride) bins of a
+    // peak: past a stride of half a frame that's less than a bin
+    tracker.phase_to_bins =
+        2 * cfg->stride <= cfg->size
+            ? (float)cfg->size / (2.0f * PI * (float)cfg->stride)
+            : 0.0f;
+    tracker.dB_offset = -10.0f * log10f(cfg->power_reference);
+    tracker.min_level = (cfg->min_dB - tracker.dB_offset) / LOG2_TO_DB;
+    tracker.threshold = cfg->threshold_dB / LOG2_TO_DB;
+
+    tracker.level = malloc(n_bins * sizeof(float));
+    tracker.floor = malloc(n_bins * sizeof(float));
+    // whole words past the end for the scan, never set
+    tracker.is_peak = calloc(n_bins + sizeof(uint64_t), 1);
+    tracker.peaks = malloc((n_bins / 2 + 1) * sizeof(SizeType));
+
+    PartialPoints* points = &tracker.points;
+    points->hz = malloc(cfg->cap * sizeof(float));
+    points->dB = malloc(cfg->cap * sizeof(float));
+    points->track = malloc(cfg->cap * sizeof(uint32_t));
+    points->frame = malloc(cfg->cap * sizeof(uint32_t));
+    points->link = malloc(cfg->cap * sizeof(SizeType));
+    points->cap = cfg->cap;
+
+    if (!partial_tracker_ok(&tracker)) {
+        partial_tracker_free(&tracker);
+    }
+
+    return tracker;
+}
+
+bool partial_tracker_ok(const PartialTracker* tracker)
+{
+    if (!tracker) {
+        return false;
+    }
+
+    const PartialPoints* points = &tracker->points;
+    return tracker->level && tracker->floor && tracker->is_peak &&
+           tracker->peaks && points->hz && points->dB && points->track &&
+           points->frame && points->link;
+}
+
+void partial_tracker_free(PartialTracker* tracker)
+{
+    if (!tracker) {
+        return;
+    }
+
+    free(tracker->level);
+    free(tracker->floor);
+    free(tracker->is_peak);
+    free(tracker->peaks);
+    free(tracker->points.hz);
+    free(tracker->points.dB);
+    free(tracker->points.track);
+    free(tracker->points.frame);
+    free(tracker->points.link);
+    *tracker = (PartialTracker){0};
+}
+
+bool partial_points_link(const PartialPoints* points,
+                         SizeType i,
+                         SizeType* link)
+{
+    const SizeType l = points->link[i];
+    const uint32_t since = points->frame[i] - points->frame[l];
+    if (l == i || points->track[l] != points->track[i] || since == 0 ||
+        since > PARTIAL_MAX_GAP + 1) {
+        return false;
+    }
+
+    *link = l;
+    return true;
+}
+
+// levels, the floor around them and the peak mask, one pass each
+static void partial_tracker_mask(PartialTracker* restrict tracker,
+                                 const float* restrict re_im)
+{
+    const SizeType n = tracker->n_bins;
+    float* restrict level = tracker->level;
+    float* restrict floor = tracker->floor;
+    uint8_t* restrict is_peak = tracker->is_peak;
+    const float min_level = tracker->min_level;
+
+    for (SizeType b = 0; b < n; ++b) {
+        // size_t: a 32 bit index could wrap as far as the vectorizer knows
+        const float re = re_im[2 * (size_t)b];
+        const float im = re_im[2 * (size_t)b + 1];
+        const float l = fast_log2(re * re + im * im);
+        level[b] = l > min_level ? l : min_level;
+    }
+
+    // a box around every bin, cut short at the edges; double, it runs over
+    // the whole row
+    const SizeType w = PARTIAL_FLOOR_BINS;
+    double sum = 0.0;
+    SizeType count = 0;
+    for (SizeType b = 0; b < w && b < n; ++b) {
+        sum += (double)level[b];
+        ++count;
+    }
+    for (SizeType b = 0; b < n; ++b) {
+        if (b + w < n) {
+            sum += (double)level[b + w];
+            ++count;
+        }
+        if (b > w) {
+            sum -= (double)level[b - w - 1];
+            --count;
+        }
+        const float mean = (float)(sum / (double)count);
+        floor[b] = (mean > min_level ? mean : min_level) + tracker->threshold;
+    }
+
+    // the first and last bins have no neighbour to place a parabola with
+    for (SizeType b = 1; b + 1 < n; ++b) {
+        const float l = level[b];
+        is_peak[b] = (uint8_t)((l > level[b - 1]) & (l >= level[b + 1]) &
+                               (l > floor[b]));
+    }
+}
+
+// bins of the peaks in the mask, the strongest max_peaks of them in order
+static SizeType partial_tracker_scan(PartialTracker* tracker)
+{
+    const SizeType n = tracker->n_bins;
+    const SizeType max_peaks = tracker->cfg.max_peaks;
+    const float* level = tracker->level;
+    SizeType* peaks = tracker->peaks;
+
+    // a word at a time, most of a row is no peak
+    SizeType n_found = 0;
+    for (SizeType b = 0; b < n; b += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, tracker->is_peak + b, sizeof(word));
+        if (word == 0) {
+            continue;
+        }
+        for (SizeType j = b; j < b + sizeof(uint64_t) && j < n; ++j) {
+            if (tracker->is_peak[j]) {
+                peaks[n_found++] = j;
+            }
+        }
+    }
+    if (n_found <= max_peaks) {
+        return n_found;
+    }
+
+    // the weakest kept one is replaced by anything louder, the kept ones
+    // then go back in order
+    SizeType weakest = 0;
+    for (SizeType k = 1; k < max_peaks; ++k) {
+        weakest = level[peaks[k]] < level[peaks[weakest]] ? k : weakest;
+    }
+    for (SizeType i = max_peaks; i < n_found; ++i) {
+        if (level[peaks[i]] <= level[peaks[weakest]]) {
+            continue;
+        }
+        peaks[weakest] = peaks[i];
+        for (SizeType k = 0; k < max_peaks; ++k) {
+            weakest = level[peaks[k]] < level[peaks[weakest]] ? k : weakest;
+        }
+    }
+    for (SizeType k = 1; k < max_peaks; ++k) {
+        const SizeType bin = peaks[k];
+        SizeType j = k;
+        for (; j > 0 && peaks[j - 1] > bin; --j) {
+            peaks[j] = peaks[j - 1];
+        }
+        peaks[j] = bin;
+    }
+    return max_peaks;
+}
+
+// frequency and level of every peak found
+static void partial_tracker_place(PartialTracker* tracker,
+                                  const Complex* row,
+                                  const Complex* previous,
+                                  SizeType n_found)
+{
+    const float* level = tracker->level;
+    const SizeType size = tracker->cfg.size;
+    const uint64_t stride = tracker->cfg.stride;
+    const bool phase = previous != NULL && tracker->phase_to_bins > 0.0f;
+
+    for (SizeType p = 0; p < n_found; ++p) {
+        const SizeType b = tracker->peaks[p];
+        const SizeType k = b + 1;  // DC isn't in the row
+
+        // parabola through the peak and its neighbours
+        const float a = level[b - 1];
+        const float m = level[b];
+        const float c = level[b + 1];
+        const float delta = 0.5f * (a - c) / (a - 2.0f * m + c);
+        float bins = (float)k + delta;
+
+        // a sinusoid at bin kappa advances by 2 pi kappa stride / size over a
+        // stride, what's left past bin k's advance gives kappa - k
+        if (phase) {
+            const float expected =
+                2.0f * PI * (float)(k * stride % size) / (float)size;
+            float advance = cargf(row[b]) - cargf(previous[b]) - expected;
+            advance -= 2.0f * PI * floorf(advance / (2.0f * PI) + 0.5f);
+            const float refined = (float)k + advance * tracker->phase_to_bins;
+            bins = fabsf(refined - bins) <= 0.5f ? refined : bins;
+        }
+
+        tracker->peak_hz[p] = bins * tracker->bin_hz;
+        tracker->peak_dB[p] =
+            LOG2_TO_DB * (m - 0.25f * (a - c) * delta) + tracker->dB_offset;
+    }
+    tracker->n_peaks = n_found;
+}
+
+static SizeType partial_points_push(PartialPoints* points,
+                                    float hz,
+                                    float dB,
+                                    uint32_t track,
+                                    uint32_t frame,
+                                    SizeType link)
+{
+    const SizeType slot = points->tail;
+    points->hz[slot] = hz;
+    points->dB[slot] = dB;
+    points->track[slot] = track;
+    points->frame[slot] = frame;
+    points->link[slot] = link;
+
+    points->tail = (slot + 1) % points->cap;
+    if (points->len == points->cap) {
+        points->head = points->tail;
+    } else {
+        ++points->len;
+    }
+    return slot;
+}
+
+// track t takes peak p, returns the number of points pushed
+static SizeType partial_tracker_continue(PartialTracker* tracker,
+                                         SizeType t,
+                                         SizeType p)
+{
+    const uint32_t frame = tracker->frames;
+    const float hz = tracker->peak_hz[p];
+    const float dB = tracker->peak_dB[p];
+    const SizeType n = ++tracker->tracks.frames[t];
+    tracker->tracks.slope[t] =
+        n > 1 ? (hz - tracker->tracks.hz[t]) /
+                    (float)(frame - tracker->tracks.last_frame[t])
+              : 0.0f;
+    tracker->tracks.hz[t] = hz;
+    tracker->tracks.dB[t] = dB;
+    tracker->tracks.last_frame[t] = frame;
+
+    if (n < PARTIAL_MIN_FRAMES) {
+        tracker->tracks.pending_hz[t][n - 1] = hz;
+        tracker->tracks.pending_dB[t][n - 1] = dB;
+        return 0;
+    }
+
+    PartialPoints* points = &tracker->points;
+    SizeType pushed = 0;
+    if (n == PARTIAL_MIN_FRAMES) {
+        // born: the frames it waited for were consecutive
+        const uint32_t id = tracker->next_id++;
+        tracker->tracks.id[t] = id;
+        SizeType link = points->tail;
+        for (SizeType i = 0; i < PARTIAL_MIN_FRAMES - 1; ++i) {
+            link = partial_points_push(
+                points, tracker->tracks.pending_hz[t][i],
+                tracker->tracks.pending_dB[t][i], id,
+                frame - (uint32_t)(PARTIAL_MIN_FRAMES - 1 - i), link);
+            ++pushed;
+        }
+        tracker->tracks.last_slot[t] = link;
+    }
+
+    tracker->tracks.last_slot[t] =
+        partial_points_push(points, hz, dB, tracker->tracks.id[t], frame,
+                            tracker->tracks.last_slot[t]);
+    return pushed + 1;
+}
+
+typedef struct {
+    float cost;
+    SizeType peak;
+    SizeType track;
+} PartialPair;
+
+static int partial_pair_cmp(const void* a, const void* b)
+{
+    const float x = ((const PartialPair*)a)->cost;
+    const float y = ((const PartialPair*)b)->cost;
+    return (x > y) - (x < y);
+}
+
+// peaks to tracks, returns the number of points pushed
+static SizeType partial_tracker_link(PartialTracker* tracker)
+{
+    const SizeType n_peaks = tracker->n_peaks;
+    const SizeType n_tracks = tracker->n_tracks;
+    const float max_jump = PARTIAL_MAX_JUMP_BINS * tracker->bin_hz;
+
+    // where the tracks should be by now, in order: mostly the order they
+    // were in last frame
+    float track_hz[PARTIAL_MAX_TRACKS];
+    SizeType order[PARTIAL_MAX_TRACKS];
+    for (SizeType i = 0; i < n_tracks; ++i) {
+        const uint32_t since = tracker->frames - tracker->tracks.last_frame[i];
+        track_hz[i] =
+            tracker->tracks.hz[i] + tracker->tracks.slope[i] * (float)since;
+
+        SizeType j = i;
+        for (; j > 0 && track_hz[order[j - 1]] > track_hz[i]; --j) {
+            order[j] = order[j - 1];
+        }
+        order[j] = i;
+    }
+
+    // every peak against the tracks within a jump, the nearest
+    // PARTIAL_CANDIDATES of them; peaks come in order too
+    PartialPair pairs[PARTIAL_MAX_PEAKS * PARTIAL_CANDIDATES];
+    SizeType n_pairs = 0;
+    SizeType lo = 0;
+    for (SizeType p = 0; p < n_peaks; ++p) {
+        const float hz = tracker->peak_hz[p];
+        while (lo < n_tracks && track_hz[order[lo]] < hz - max_jump) {
+            ++lo;
+        }
+        PartialPair* first = pairs + n_pairs;
+        SizeType n_candidates = 0;
+        for (SizeType j = lo; j < n_tracks; ++j) {
+            const SizeType t = order[j];
+            const float jump = fabsf(track_hz[t] - hz);
+            if (track_hz[t] > hz + max_jump) {
+                break;
+            }
+            const float cost =
+                jump / tracker->bin_hz +
+                fabsf(tracker->tracks.dB[t] - tracker->peak_dB[p]) /
+                    PARTIAL_LEVEL_DB_PER_BIN;
+            if (n_candidates == PARTIAL_CANDIDATES) {
+                // replaces the costliest so far, if it's cheaper
+                SizeType worst = 0;
+                for (SizeType c = 1; c < n_candidates; ++c) {
+                    worst = first[c].cost > first[worst].cost ? c : worst;
+                }
+                if (cost < first[worst].cost) {
+                    first[worst] = (PartialPair){cost, p, t};
+                }
+                continue;
+            }
+            first[n_candidates++] = (PartialPair){cost, p, t};
+        }
+        n_pairs += n_candidates;
+    }
+    qsort(pairs, n_pairs, sizeof(*pairs), partial_pair_cmp);
+
+    bool peak_taken[PARTIAL_MAX_PEAKS] = {0};
+    bool track_taken[PARTIAL_MAX_TRACKS] = {0};
+    SizeType pushed = 0;
+    for (SizeType i = 0; i < n_pairs; ++i) {
+        const PartialPair* pair = &pairs[i];
+        if (peak_taken[pair->peak] || track_taken[pair->track]) {
+            continue;
+        }
+        peak_taken[pair->peak] = true;
+        track_taken[pair->track] = true;
+        pushed += partial_tracker_continue(tracker, pair->track, pair->peak);
+    }
+
+    // tracks left without a peak end once past the gap, unborn ones right
+    // away; the last track fills the hole
+    SizeType n = n_tracks;
+    for (SizeType t = 0; t < n;) {
+        const bool alive =
+            track_taken[t] ||
+            (tracker->tracks.frames[t] >= PARTIAL_MIN_FRAMES &&
+             tracker->frames - tracker->tracks.last_frame[t] <=
+                 PARTIAL_MAX_GAP);
+        if (alive) {
+            ++t;
+            continue;
+        }
+        --n;
+        track_taken[t] = track_taken[n];
+        tracker->tracks.hz[t] = tracker->tracks.hz[n];
+        tracker->tracks.slope[t] = tracker->tracks.slope[n];
+        tracker->tracks.dB[t] = tracker->tracks.dB[n];
+        tracker->tracks.id[t] = tracker->tracks.id[n];
+        tracker->tracks.last_frame[t] = tracker->tracks.last_frame[n];
+        tracker->tracks.last_slot[t] = tracker->tracks.last_slot[n];
+        tracker->tracks.frames[t] = tracker->tracks.frames[n];
+        memcpy(tracker->tracks.pending_hz[t], tracker->tracks.pending_hz[n],
+               sizeof(tracker->tracks.pending_hz[t]));
+        memcpy(tracker->tracks.pending_dB[t], tracker->tracks.pending_dB[n],
+               sizeof(tracker->tracks.pending_dB[t]));
+    }
+    tracker->n_tracks = n;
+
+    // peaks left start tracks while there's room
+    for (SizeType p = 0; p < n_peaks && tracker->n_tracks < PARTIAL_MAX_TRACKS;
+         ++p) {
+        if (peak_taken[p]) {
+            continue;
+        }
+        const SizeType nt = tracker->n_tracks++;
+        tracker->tracks.frames[nt] = 0;
+        pushed += partial_tracker_continue(tracker, nt, p);
+    }
+
+    return pushed;
+}
+
+SizeType partial_tracker_process(PartialTracker* tracker,
+                                 const Complex* row,
+                                 const Complex* previous)
+{
+    partial_tracker_mask(tracker, (const float*)row);
+    const SizeType n_found = partial_tracker_scan(tracker);
+    partial_tracker_place(tracker, row, previous, n_found);
+    const SizeType pushed = partial_tracker_link(tracker);
+    ++tracker->frames;
+    return pushed;
+}
+
+SizeType partial_tracker_push_history(PartialTracker* tracker,
+                                      const FFTHistory* h,
+                                      SizeType n,
+                                      SizeType phase_rows)
+{
+    // rows gone before they were seen still count, their tracks end
+    if (n > h->len) {
+        tracker->frames += (uint32_t)(n - h->len);
+        n = h->len;
+    }
+
+    SizeType pushed = 0;
+    for (SizeType i = 0; i < n; ++i) {
+        const SizeType row = (h->tail + h->cap - n + i) % h->cap;
+        // the row before is still there unless it's the oldest, and both
+        // hold phase when n - i rows back still does
+        const bool has_previous = n - i < phase_rows && n - i < h->len;
+        const Complex* previous =
+            has_previous ? fft_history_get_row(h, (row + h->cap - 1) % h->cap)
+                         : NULL;
+        pushed +=
+            partial_tracker_process(tracker, fft_history_get_row(h, row),
+                                    previous);
+    }
+    return pushed;
+}
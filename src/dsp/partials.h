@@ -0,0 +1,143 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "core/History.h"
+#include "core/definitions.h"
+
+// a peak has to stand this far above the mean level of the bins around it,
+// PARTIAL_FLOOR_BINS on either side
+#define PARTIAL_THRESHOLD_DB 10.0f
+#define PARTIAL_FLOOR_BINS 24
+
+// strongest peaks kept per frame, and tracks alive at once
+#define PARTIAL_MAX_PEAKS 64
+#define PARTIAL_MAX_TRACKS (2 * PARTIAL_MAX_PEAKS)
+
+// a track continues with a peak at most this many bins from where its last
+// two would put it, a frame of level difference costs as much as a bin
+#define PARTIAL_MAX_JUMP_BINS 3.0f
+#define PARTIAL_LEVEL_DB_PER_BIN 12.0f
+
+// nearest tracks a peak is weighed against
+#define PARTIAL_CANDIDATES 4
+
+// frames a track survives without a peak
+#define PARTIAL_MAX_GAP 2
+
+// a track is only born once it has lasted this many frames in a row, its
+// first points wait in the track until then: noise peaks rarely line up
+#define PARTIAL_MIN_FRAMES 3
+
+typedef struct {
+    SizeType size;      // of the FFT, the rows have size / 2 bins
+    SizeType stride;    // between frames, for the phase
+    float sample_rate;  // the FFT's, after decimation
+    float power_reference;  // defines 0 dB
+    float min_dB;           // nothing below is picked
+    float threshold_dB;     // above the local floor
+    SizeType max_peaks;     // per frame, at most PARTIAL_MAX_PEAKS
+    SizeType cap;           // points kept
+} PartialConfig;
+
+// a ring of the points of every track, struct of arrays: 20 bytes a point,
+// pushed in the order tracks are born and continue, which within a track is
+// the order of its frames
+//
+// link is the slot of the track's point before it, its own for its first;
+// a slot overwritten since holds a point of another track or a later frame
+typedef struct {
+    float* hz;
+    float* dB;
+    uint32_t* track;
+    uint32_t* frame;  // PartialTracker.frames when it was found, wraps
+    SizeType* link;
+    SizeType head;  // always point to the oldest point
+    SizeType tail;  // the next slot to write to
+    SizeType len;
+    SizeType cap;
+} PartialPoints;
+
+// the point before the one in slot i, false for the first of a track or
+// one that's gone
+bool partial_points_link(const PartialPoints* points,
+                         SizeType i,
+                         SizeType* link);
+
+// sinusoidal partials over FFTHistory rows, in the spirit of McAulay and
+// Quatieri
+//
+// every row is turned into log2 levels, floored at min_dB; a bin is a peak
+// when it beats the bin below, holds against the one above and stands
+// threshold_dB above the mean level of its neighbourhood, which follows the
+// noise as it moves across the spectrum. the comparisons are made for every
+// bin at once into a mask, which vectorizes, and only the mask is scanned
+//
+// a peak is placed by a parabola through the levels around it; with phase,
+// i.e. rows that aren't merged, the phase advance from the previous row
+// over one stride refines the frequency further, unless the two disagree
+// by more than half a bin
+//
+// peaks are linked to the nearest tracks by level and by frequency, carried
+// along each track's slope, cheapest pairs first: at most
+// PARTIAL_CANDIDATES pairs per peak, so a frame costs O(max_peaks) past the
+// scan whatever the signal
+typedef struct {
+    PartialConfig cfg;
+    SizeType n_bins;
+    float bin_hz;
+    float phase_to_bins;  // size / (2 pi stride), 0 without phase
+    float min_level;      // min_dB and the threshold as log2 power
+    float threshold;
+    float dB_offset;      // dB = 10 log10(2) * level + dB_offset
+
+    float* level;  // [n_bins] of the row being processed
+    float* floor;  // [n_bins] the mean level around each bin + threshold
+    uint8_t* is_peak;  // [n_bins]
+    SizeType* peaks;   // [n_bins / 2 + 1] bins of this row's peaks
+
+    // this row's peaks once placed, by frequency
+    SizeType n_peaks;
+    float peak_hz[PARTIAL_MAX_PEAKS];
+    float peak_dB[PARTIAL_MAX_PEAKS];
+
+    // tracks alive, in no particular order; `pending` holds the first
+    // points of tracks not born yet, PARTIAL_MIN_FRAMES - 1 each
+    SizeType n_tracks;
+    struct {
+        float hz[PARTIAL_MAX_TRACKS];
+        float slope[PARTIAL_MAX_TRACKS];  // Hz per frame, at the last peak
+        float dB[PARTIAL_MAX_TRACKS];
+        uint32_t id[PARTIAL_MAX_TRACKS];
+        uint32_t last_frame[PARTIAL_MAX_TRACKS];
+        SizeType last_slot[PARTIAL_MAX_TRACKS];
+        SizeType frames[PARTIAL_MAX_TRACKS];  // points found so far
+        float pending_hz[PARTIAL_MAX_TRACKS][PARTIAL_MIN_FRAMES - 1];
+        float pending_dB[PARTIAL_MAX_TRACKS][PARTIAL_MIN_FRAMES - 1];
+    } tracks;
+    uint32_t next_id;
+
+    PartialPoints points;
+    uint32_t frames;  // rows processed
+} PartialTracker;
+
+PartialTracker partial_tracker_new(const PartialConfig* cfg);
+bool partial_tracker_ok(const PartialTracker* tracker);
+void partial_tracker_free(PartialTracker* tracker);
+
+// the next row; previous is the row before it when both hold phase, NULL
+// otherwise. returns the number of points pushed, the newest in the ring
+SizeType partial_tracker_process(PartialTracker* tracker,
+                                 const Complex* row,
+                                 const Complex* previous);
+
+// the n newest rows of a history, oldest first; phase for a row when it and
+// the one before it are among the `phase_rows` newest, i.e. neither was
+// merged, see FFTAnalyzer. returns the number of points pushed
+//
+// fed every row pushed onto h, frames - 1 is its newest row
+SizeType partial_tracker_push_history(PartialTracker* tracker,
+                                      const FFTHistory* h,
+                                      SizeType n,
+                                      SizeType phase_rows);
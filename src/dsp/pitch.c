@@ -0,0 +1,162 @@
+#include "pitch.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// lobes looked at per frame, noise has many more
+#define PITCH_MAX_KEYS 64
+
+SizeType pitch_frame_size_for(float sample_rate, float f_min)
+{
+    const float samples = 2.0f * sample_rate / f_min;
+    SizeType size = 2;
+    while ((float)size < samples && size < (1u << 30)) {
+        size *= 2;
+    }
+    return size;
+}
+
+PitchTracker pitch_tracker_new(SizeType size,
+                               float sample_rate,
+                               float f_min,
+                               float f_max)
+{
+    PitchTracker tracker = {0};
+    if (size < 4 || size % 2 != 0 || !(f_min > 0.0f) || !(f_max > f_min)) {
+        return tracker;
+    }
+
+    // past half the frame too few products are left for m to mean much
+    const float longest = sample_rate / f_min;
+    const float shortest = sample_rate / f_max;
+    tracker.max_lag =
+        longest < (float)(size / 2) ? (SizeType)longest : size / 2;
+    tracker.min_lag = shortest > 2.0f ? (SizeType)shortest : 2;
+    if (tracker.min_lag >= tracker.max_lag) {
+        return tracker;
+    }
+
+    tracker.size = size;
+    tracker.sample_rate = sample_rate;
+    tracker.forward = kiss_fftr_alloc((int)(2 * size), 0, NULL, NULL);
+    tracker.inverse = kiss_fftr_alloc((int)(2 * size), 1, NULL, NULL);
+    tracker.padded = calloc(2 * size, sizeof(float));
+    tracker.spectrum = malloc((size + 1) * sizeof(kiss_fft_cpx));
+    tracker.nsdf = malloc((tracker.max_lag + 2) * sizeof(float));
+
+    return tracker;
+}
+
+bool pitch_tracker_ok(const PitchTracker* tracker)
+{
+    if (!tracker) {
+        return false;
+    }
+
+    return tracker->forward && tracker->inverse && tracker->padded &&
+           tracker->spectrum && tracker->nsdf;
+}
+
+void pitch_tracker_free(PitchTracker* tracker)
+{
+    if (!tracker) {
+        return;
+    }
+
+    kiss_fftr_free(tracker->forward);
+    kiss_fftr_free(tracker->inverse);
+    free(tracker->padded);
+    free(tracker->spectrum);
+    free(tracker->nsdf);
+    *tracker = (PitchTracker){0};
+}
+
+// n(tau) for tau in [0, max_lag + 1]
+static void pitch_tracker_nsdf(PitchTracker* tracker, const float* frame)
+{
+    const SizeType size = tracker->size;
+
+    // the zeros past the frame were never written
+    memcpy(tracker->padded, frame, size * sizeof(float));
+    kiss_fftr(tracker->forward, tracker->padded, tracker->spectrum);
+
+    kiss_fft_cpx* spectrum = tracker->spectrum;
+    for (SizeType k = 0; k <= size; ++k) {
+        const float re = spectrum[k].r;
+        const float im = spectrum[k].i;
+        spectrum[k] = (kiss_fft_cpx){.r = re * re + im * im, .i = 0.0f};
+    }
+    kiss_fftri(tracker->inverse, spectrum, tracker->padded);
+    memset(tracker->padded + size, 0, size * sizeof(float));
+
+    // kiss_fftri leaves r scaled by the transform size
+    double m = 0.0;
+    for (SizeType j = 0; j < size; ++j) {
+        m += 2.0 * (double)frame[j] * (double)frame[j];
+    }
+
+    const float scale = 2.0f / (float)(2 * size);
+    for (SizeType tau = 0; tau <= tracker->max_lag + 1; ++tau) {
+        if (tau > 0) {
+            const double gone_head = (double)frame[tau - 1];
+            const double gone_tail = (double)frame[size - tau];
+            m -= gone_head * gone_head + gone_tail * gone_tail;
+        }
+        tracker->nsdf[tau] =
+            m > 0.0 ? scale * tracker->padded[tau] / (float)m : 0.0f;
+    }
+}
+
+Pitch pitch_tracker_process(PitchTracker* tracker, const float* frame)
+{
+    pitch_tracker_nsdf(tracker, frame);
+    const float* n = tracker->nsdf;
+    const SizeType max_lag = tracker->max_lag;
+
+    // key maxima: the highest point of every positive lobe after the first
+    // dip below zero, which leaves out the lobe around tau = 0; the last
+    // lobe ends at max_lag
+    SizeType keys[PITCH_MAX_KEYS];
+    SizeType n_keys = 0;
+    SizeType tau = 1;
+    while (tau <= max_lag && n[tau] > 0.0f) {
+        ++tau;
+    }
+
+    float clearest = 0.0f;
+    SizeType best = 0;
+    bool in_lobe = false;
+    for (; tau <= max_lag + 1; ++tau) {
+        if (tau <= max_lag && n[tau] > 0.0f) {
+            best = !in_lobe || n[tau] > n[best] ? tau : best;
+            in_lobe = true;
+            continue;
+        }
+        if (in_lobe && best >= tracker->min_lag && n_keys < PITCH_MAX_KEYS) {
+            keys[n_keys++] = best;
+            clearest = n[best] > clearest ? n[best] : clearest;
+        }
+        in_lobe = false;
+    }
+
+    for (SizeType k = 0; k < n_keys; ++k) {
+        const SizeType t = keys[k];
+        if (n[t] < PITCH_KEY_MAX_THRESHOLD * clearest) {
+            continue;
+        }
+
+        // parabola through the peak and its neighbours
+        const float a = n[t - 1];
+        const float b = n[t];
+        const float c = n[t + 1];
+        const float curvature = a - 2.0f * b + c;
+        const float delta = curvature < 0.0f ? 0.5f * (a - c) / curvature
+                                             : 0.0f;
+        return (Pitch){
+            .f0 = tracker->sample_rate / ((float)t + delta),
+            .clarity = b - 0.25f * (a - c) * delta,
+        };
+    }
+
+    return (Pitch){0};
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "kiss_fftr.h"
+
+#include "core/definitions.h"
+
+// what the tracker looks for unless told otherwise: low male voice to the
+// top of most melodic instruments
+#define PITCH_MIN_HZ 50.0f
+#define PITCH_MAX_HZ 2000.0f
+
+// a candidate period must reach this fraction of the clearest one, the
+// first that does wins: octave errors go down rather than up
+#define PITCH_KEY_MAX_THRESHOLD 0.9f
+
+typedef struct {
+    float f0;       // Hz, 0 when nothing periodic was found
+    float clarity;  // normalized correlation at the period, 1 for a pure tone
+} Pitch;
+
+// McLeod's pitch method, one frame at a time
+//
+// the normalized square difference function
+//   n(tau) = 2 r(tau) / m(tau),
+//   r(tau) = sum x[j] x[j + tau], m(tau) = sum x[j]^2 + x[j + tau]^2
+// gets r from the power spectrum of the frame zero-padded to twice its
+// size, one forward and one inverse real FFT, and m from a running sum;
+// O(size log size) where the direct form is O(size^2)
+//
+// the frame isn't windowed: m normalizes for the energy at every lag, a
+// taper would only pull the peaks towards short periods
+typedef struct {
+    SizeType size;
+    float sample_rate;
+    SizeType min_lag;  // periods of f_max and f_min, within size / 2
+    SizeType max_lag;
+
+    kiss_fftr_cfg forward;  // both 2 * size points
+    kiss_fftr_cfg inverse;
+    float* padded;         // [2 * size] frame, then r * 2 * size
+    kiss_fft_cpx* spectrum;  // [size + 1]
+    float* nsdf;           // [max_lag + 2]
+} PitchTracker;
+
+// smallest power of 2 holding two periods of f_min at sample_rate
+SizeType pitch_frame_size_for(float sample_rate, float f_min);
+
+PitchTracker pitch_tracker_new(SizeType size,
+                               float sample_rate,
+                               float f_min,
+                               float f_max);
+bool pitch_tracker_ok(const PitchTracker* tracker);
+void pitch_tracker_free(PitchTracker* tracker);
+
+// frame holds `size` samples
+Pitch pitch_tracker_process(PitchTracker* tracker, const float* frame);
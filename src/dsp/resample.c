@@ -0,0 +1,209 @@
+#include "resample.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// partial sums per dot product, n_taps is always a multiple of this
+#define RESAMPLER_LANES 8
+
+// zero crossings of the prototype sinc on each side, per input sample of the
+// slower of the two rates; 16 puts the Kaiser transition band well inside the
+// 10% left between the passband edge and the output Nyquist
+#define RESAMPLER_HALF_ZERO_CROSSINGS 16
+#define RESAMPLER_ROLLOFF 0.9
+#define RESAMPLER_KAISER_BETA 8.0  // ~80 dB stopband
+
+static SizeType gcd(SizeType a, SizeType b)
+{
+    while (b != 0) {
+        const SizeType t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// zeroth-order modified Bessel function of the first kind, power series
+static double bessel_i0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 64; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+// Kaiser-windowed sinc at the upsampled rate, cut off just under the lower
+// of the two Nyquists; each phase is scaled to unity DC gain
+static void design_taps(float* taps, SizeType up, SizeType down, SizeType n)
+{
+    const SizeType length = up * n;
+    const double center = (double)(length - 1) / 2.0;
+    const double cutoff =
+        RESAMPLER_ROLLOFF * 0.5 / (double)(up > down ? up : down);
+    const double i0_beta = bessel_i0(RESAMPLER_KAISER_BETA);
+
+    for (SizeType p = 0; p < up; ++p) {
+        double dc = 0.0;
+
+        for (SizeType k = 0; k < n; ++k) {
+            // reversed: k = n - 1 multiplies the newest input
+            const SizeType i = p + up * (n - 1 - k);
+            const double t = (double)i - center;
+            const double x = 2.0 * cutoff * t;
+            const double sinc =
+                x == 0.0 ? 1.0 : sin((double)PI * x) / ((double)PI * x);
+            const double r = t / (center + 0.5);
+            const double kaiser =
+                bessel_i0(RESAMPLER_KAISER_BETA * sqrt(1.0 - r * r)) /
+                i0_beta;
+
+            const double h = sinc * kaiser;
+            taps[p * n + k] = (float)h;
+            dc += h;
+        }
+
+        for (SizeType k = 0; k < n; ++k) {
+            taps[p * n + k] = (float)((double)taps[p * n + k] / dc);
+        }
+    }
+}
+
+Resampler resampler_new(SizeType up, SizeType down, SizeType max_block)
+{
+    Resampler rs = {0};
+
+    if (up == 0 || down == 0 || max_block == 0) {
+        return rs;
+    }
+
+    const SizeType g = gcd(up, down);
+    up /= g;
+    down /= g;
+    if (up > RESAMPLER_MAX_FACTOR || down > RESAMPLER_MAX_FACTOR) {
+        return rs;
+    }
+
+    // taps per phase cover the same span of the slower rate whatever the
+    // ratio, rounded up so the dot product splits evenly into lanes
+    const SizeType slow = up > down ? up : down;
+    SizeType n_taps = (2 * RESAMPLER_HALF_ZERO_CROSSINGS * slow + up - 1) / up;
+    n_taps = (n_taps + RESAMPLER_LANES - 1) / RESAMPLER_LANES * RESAMPLER_LANES;
+
+    rs.taps = malloc(up * n_taps * sizeof(float));
+    rs.work = malloc((n_taps - 1 + max_block) * sizeof(float));
+    if (!rs.taps || !rs.work) {
+        free(rs.taps);
+        free(rs.work);
+        return (Resampler){0};
+    }
+
+    design_taps(rs.taps, up, down, n_taps);
+
+    rs.up = up;
+    rs.down = down;
+    rs.n_taps = n_taps;
+    rs.max_block = max_block;
+    resampler_reset(&rs);
+
+    return rs;
+}
+
+bool resampler_ok(const Resampler* rs)
+{
+    if (!rs) {
+        return false;
+    }
+
+    return rs->taps != NULL && rs->work != NULL;
+}
+
+void resampler_free(Resampler* rs)
+{
+    if (!rs) {
+        return;
+    }
+
+    free(rs->taps);
+    free(rs->work);
+}
+
+void resampler_reset(Resampler* rs)
+{
+    memset(rs->work, 0, (rs->n_taps - 1) * sizeof(float));
+    rs->phase = 0;
+    rs->pos = rs->n_taps - 1;
+}
+
+SizeType resampler_max_output(const Resampler* rs, SizeType size)
+{
+    return (size * rs->up + rs->down - 1) / rs->down + 1;
+}
+
+static float dot(const float* restrict taps,
+                 const float* restrict x,
+                 SizeType n)
+{
+    float acc[RESAMPLER_LANES] = {0};
+
+    for (SizeType i = 0; i < n; i += RESAMPLER_LANES) {
+        for (SizeType lane = 0; lane < RESAMPLER_LANES; ++lane) {
+            acc[lane] += taps[i + lane] * x[i + lane];
+        }
+    }
+
+    float sum = 0.0f;
+    for (SizeType lane = 0; lane < RESAMPLER_LANES; ++lane) {
+        sum += acc[lane];
+    }
+    return sum;
+}
+
+// at most max_block inputs
+static SizeType process_block(Resampler* restrict rs,
+                              const float* restrict in,
+                              SizeType size,
+                              float* restrict out)
+{
+    const SizeType history = rs->n_taps - 1;
+    memcpy(rs->work + history, in, size * sizeof(float));
+
+    SizeType written = 0;
+    while (rs->pos < history + size) {
+        const float* taps = rs->taps + rs->phase * rs->n_taps;
+        out[written++] = dot(taps, rs->work + rs->pos - history, rs->n_taps);
+
+        rs->phase += rs->down;
+        rs->pos += rs->phase / rs->up;
+        rs->phase %= rs->up;
+    }
+
+    // keep the tail as history for the next block
+    memmove(rs->work, rs->work + size, history * sizeof(float));
+    rs->pos -= size;
+
+    return written;
+}
+
+SizeType resampler_process(Resampler* restrict rs,
+                           const float* restrict in,
+                           SizeType size,
+                           float* restrict out)
+{
+    SizeType written = 0;
+
+    while (size > 0) {
+        const SizeType block = size < rs->max_block ? size : rs->max_block;
+        written += process_block(rs, in, block, out + written);
+        in += block;
+        size -= block;
+    }
+
+    return written;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "core/definitions.h"
+
+// rational polyphase FIR resampler, output rate = input rate * up / down
+//
+// the prototype low-pass is designed once at construction and stored as `up`
+// phases of `n_taps` coefficients, time-reversed so every output is one
+// contiguous dot product over the input history
+//
+// decimation is just up = 1, e.g. 192 kHz -> 48 kHz is (1, 4) and an octave
+// step of a multirate transform is (1, 2)
+typedef struct {
+    float* taps;  // [up][n_taps]
+    float* work;  // n_taps - 1 samples of history, then up to max_block new
+    SizeType up;
+    SizeType down;
+    SizeType n_taps;
+    SizeType max_block;
+
+    SizeType phase;  // of the next output, in [0, up)
+    SizeType pos;    // index in work of the newest input the next output uses
+} Resampler;
+
+// the ratio is reduced, up and down can be at most RESAMPLER_MAX_FACTOR after
+// reduction; max_block only sizes the scratch, any input length is accepted
+#define RESAMPLER_MAX_FACTOR 1024
+
+Resampler resampler_new(SizeType up, SizeType down, SizeType max_block);
+bool resampler_ok(const Resampler* rs);
+void resampler_free(Resampler* rs);
+
+void resampler_reset(Resampler* rs);
+
+// upper bound on what resampler_process can write for size inputs
+SizeType resampler_max_output(const Resampler* rs, SizeType size);
+
+// returns the number of samples written to out
+SizeType resampler_process(Resampler* restrict rs,
+                           const float* restrict in,
+                           SizeType size,
+                           float* restrict out);
@@ -0,0 +1,33 @@
+#include "sliding.h"
+
+#include <stdlib.h>
+
+SlidingSum sliding_sum_new(SizeType size)
+{
+    // zeroed: the window starts full of silence
+    return (SlidingSum){
+        .ring = calloc(size, sizeof(float)),
+        .size = size,
+        .cursor = 0,
+        .since_renormalization = 0,
+        .sum = 0.0f,
+    };
+}
+
+bool sliding_sum_ok(const SlidingSum* s)
+{
+    if (!s) {
+        return false;
+    }
+
+    return s->ring != NULL;
+}
+
+void sliding_sum_free(SlidingSum* s)
+{
+    if (!s) {
+        return;
+    }
+
+    free(s->ring);
+}
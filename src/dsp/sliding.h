@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "core/definitions.h"
+
+// sum of the last `size` pushed values, O(1) per push
+//
+// the running sum accumulates rounding error, so it is recomputed from the
+// ring every `size` pushes, which keeps the amortized cost O(1)
+typedef struct {
+    float* ring;
+    SizeType size;
+    SizeType cursor;  // next slot to overwrite, i.e. the oldest value
+    SizeType since_renormalization;
+    float sum;
+} SlidingSum;
+
+SlidingSum sliding_sum_new(SizeType size);
+bool sliding_sum_ok(const SlidingSum* s);
+void sliding_sum_free(SlidingSum* s);
+
+static inline void sliding_sum_push(SlidingSum* s, float value)
+{
+    s->sum += value - s->ring[s->cursor];
+    s->ring[s->cursor] = value;
+    s->cursor = (s->cursor + 1 == s->size) ? 0 : s->cursor + 1;
+
+    if (++s->since_renormalization == s->size) {
+        float sum = 0.0f;
+        for (SizeType i = 0; i < s->size; ++i) {
+            sum += s->ring[i];
+        }
+        s->sum = sum;
+        s->since_renormalization = 0;
+    }
+}
+
+static inline float sliding_sum_mean(const SlidingSum* s)
+{
+    return s->sum / (float)s->size;
+}
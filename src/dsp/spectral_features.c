@@ -0,0 +1,162 @@
+#include "spectral_features.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "fast_log2.h"
+
+// partial sums per reduction, the bins are walked in blocks of this many
+#define SPECTRAL_LANES 8
+
+SpectralFeatureExtractor spectral_features_new(SizeType n_bins,
+                                               float bin_hz,
+                                               float power_floor)
+{
+    SpectralFeatureExtractor ext = {
+        .power = malloc(n_bins * sizeof(float)),
+        .previous = calloc(n_bins, sizeof(float)),
+        .level = malloc(n_bins * sizeof(float)),
+        .n_bins = n_bins,
+        .bin_hz = bin_hz,
+        .power_floor = power_floor > 0.0f ? power_floor : FLT_MIN,
+        .primed = false,
+    };
+
+    if (n_bins == 0 || !spectral_features_ok(&ext)) {
+        spectral_features_free(&ext);
+        return (SpectralFeatureExtractor){0};
+    }
+
+    return ext;
+}
+
+bool spectral_features_ok(const SpectralFeatureExtractor* ext)
+{
+    if (!ext) {
+        return false;
+    }
+
+    return ext->power && ext->previous && ext->level;
+}
+
+void spectral_features_free(SpectralFeatureExtractor* ext)
+{
+    if (!ext) {
+        return;
+    }
+
+    free(ext->power);
+    free(ext->previous);
+    free(ext->level);
+    *ext = (SpectralFeatureExtractor){0};
+}
+
+void spectral_features_reset(SpectralFeatureExtractor* ext)
+{
+    ext->primed = false;
+}
+
+// every reduction, one partial sum per lane
+typedef struct {
+    float power[SPECTRAL_LANES];
+    float weighted[SPECTRAL_LANES];     // f * p, f in bins
+    float weighted_sq[SPECTRAL_LANES];  // f^2 * p
+    float level[SPECTRAL_LANES];        // log2 p, floored
+    float rise[SPECTRAL_LANES];         // rectified level increase
+} Lanes;
+
+static inline void accumulate_bin(SpectralFeatureExtractor* restrict ext,
+                                  const float* restrict re_im,
+                                  Lanes* restrict acc,
+                                  SizeType lane,
+                                  SizeType b)
+{
+    // size_t: a 32 bit index could wrap as far as the vectorizer knows
+    const float re = re_im[2 * (size_t)b];
+    const float im = re_im[2 * (size_t)b + 1];
+    const float p = re * re + im * im;
+    const float f = (float)(b + 1);
+    const float floor = ext->power_floor;
+    const float lvl = fast_log2(p > floor ? p : floor);
+    const float rise = lvl - ext->previous[b];
+
+    ext->power[b] = p;
+    ext->level[b] = lvl;
+    acc->power[lane] += p;
+    acc->weighted[lane] += f * p;
+    acc->weighted_sq[lane] += f * f * p;
+    acc->level[lane] += lvl;
+    acc->rise[lane] += rise > 0.0f ? rise : 0.0f;
+}
+
+SpectralFeatures spectral_features_process(SpectralFeatureExtractor* ext,
+                                           const Complex* bins)
+{
+    const SizeType n = ext->n_bins;
+    const float* re_im = (const float*)bins;
+
+    // frequencies in bins and levels in log2 here, both scaled once at the
+    // end
+    Lanes acc = {0};
+    const SizeType n_blocks = n / SPECTRAL_LANES;
+    for (SizeType blk = 0; blk < n_blocks; ++blk) {
+        for (SizeType l = 0; l < SPECTRAL_LANES; ++l) {
+            accumulate_bin(ext, re_im, &acc, l, blk * SPECTRAL_LANES + l);
+        }
+    }
+    for (SizeType b = n_blocks * SPECTRAL_LANES; b < n; ++b) {
+        accumulate_bin(ext, re_im, &acc, 0, b);
+    }
+
+    float total = 0.0f;
+    float weighted = 0.0f;
+    float weighted_sq = 0.0f;
+    float level_sum = 0.0f;
+    float rise_sum = 0.0f;
+    for (SizeType l = 0; l < SPECTRAL_LANES; ++l) {
+        total += acc.power[l];
+        weighted += acc.weighted[l];
+        weighted_sq += acc.weighted_sq[l];
+        level_sum += acc.level[l];
+        rise_sum += acc.rise[l];
+    }
+
+    // this frame's levels are the next one's previous
+    float* const previous = ext->previous;
+    ext->previous = ext->level;
+    ext->level = previous;
+    const bool primed = ext->primed;
+    ext->primed = true;
+
+    if (!(total > 0.0f)) {
+        return (SpectralFeatures){0};
+    }
+
+    // the first bin whose running sum reaches the fraction, the power is
+    // still in cache from the pass above
+    const float target = SPECTRAL_ROLLOFF_FRACTION * total;
+    float running = 0.0f;
+    SizeType rolloff = n - 1;
+    for (SizeType b = 0; b < n; ++b) {
+        running += ext->power[b];
+        if (running >= target) {
+            rolloff = b;
+            break;
+        }
+    }
+
+    const float centroid = weighted / total;
+    const float spread = weighted_sq / total - centroid * centroid;
+    const float geometric = exp2f(level_sum / (float)n);
+    const float arithmetic = total / (float)n;
+    const float db_per_log2 = 3.0103f;  // 10 log10(2)
+
+    return (SpectralFeatures){
+        .centroid = centroid * ext->bin_hz,
+        .bandwidth = sqrtf(fmaxf(spread, 0.0f)) * ext->bin_hz,
+        .rolloff = (float)(rolloff + 1) * ext->bin_hz,
+        .flatness = fminf(geometric / arithmetic, 1.0f),
+        .flux = primed ? db_per_log2 * rise_sum / (float)n : 0.0f,
+    };
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "core/definitions.h"
+
+// fraction of the power below the rolloff frequency
+#define SPECTRAL_ROLLOFF_FRACTION 0.85f
+
+// per-frame descriptors of a power spectrum, all zero for a silent frame
+typedef struct {
+    float centroid;   // Hz, power weighted mean frequency
+    float bandwidth;  // Hz, power weighted spread around the centroid
+    float rolloff;    // Hz, SPECTRAL_ROLLOFF_FRACTION of the power is below
+    float flatness;   // geometric over arithmetic mean power, 0 tonal, 1 noise
+    float flux;       // dB, mean over bins of the rise in level since the
+                      // last frame, falls are ignored: onsets stand out
+} SpectralFeatures;
+
+// streams FFT frames through one pass that accumulates every sum in
+// SPECTRAL_LANES partial sums, then a short rolloff scan over the power it
+// left in cache; keeps the last frame's levels for the flux
+//
+// levels are log power clamped to power_floor, which keeps both the flux and
+// the flatness from chasing noise far below anything drawn
+//
+// bins are laid out like an FFTHistory row: DC ditched, bin b centred on
+// (b + 1) * bin_hz
+typedef struct {
+    float* power;     // of the frame being processed
+    float* previous;  // levels of the last frame
+    float* level;     // of the frame being processed, log2 power
+    SizeType n_bins;
+    float bin_hz;
+    float power_floor;
+    bool primed;  // there is a last frame to diff against
+} SpectralFeatureExtractor;
+
+SpectralFeatureExtractor spectral_features_new(SizeType n_bins,
+                                               float bin_hz,
+                                               float power_floor);
+bool spectral_features_ok(const SpectralFeatureExtractor* ext);
+void spectral_features_free(SpectralFeatureExtractor* ext);
+
+// the next frame's flux reads 0
+void spectral_features_reset(SpectralFeatureExtractor* ext);
+
+SpectralFeatures spectral_features_process(SpectralFeatureExtractor* ext,
+                                           const Complex* bins);
@@ -0,0 +1,159 @@
+#include "stereo.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+// band ends for n_bins bins of bin_hz into `end` if not NULL, returns how
+// many bands there are
+static SizeType stereo_bands(SizeType n_bins, float bin_hz, SizeType* end)
+{
+    SizeType n = 0;
+    SizeType start = 0;
+    SizeType edge = 1;
+    while (start < n_bins) {
+        // the first bin centred at or above the next edge that leaves the
+        // band a bin at least
+        SizeType stop = start;
+        while (stop <= start) {
+            const float hz = STEREO_MIN_HZ * exp2f((float)edge++ /
+                                                   STEREO_BANDS_PER_OCTAVE);
+            const float first = hz / bin_hz - 1.0f;
+            stop = first > (float)start ? (SizeType)ceilf(first) : start;
+        }
+        stop = stop < n_bins ? stop : n_bins;
+        if (end != NULL) {
+            end[n] = stop;
+        }
+        ++n;
+        start = stop;
+    }
+    return n;
+}
+
+StereoMeter stereo_meter_new(SizeType n_bins,
+                             float bin_hz,
+                             float frame_rate,
+                             SizeType history_size)
+{
+    if (n_bins == 0 || !(bin_hz > 0.0f) || !(frame_rate > 0.0f)) {
+        return (StereoMeter){0};
+    }
+
+    const SizeType n_bands = stereo_bands(n_bins, bin_hz, NULL);
+    StereoMeter meter = {
+        .n_bins = n_bins,
+        .n_bands = n_bands,
+        .band_end = malloc(n_bands * sizeof(SizeType)),
+        .band_hz = malloc(n_bands * sizeof(float)),
+        .smoothing =
+            1.0f - expf(-1.0f / (frame_rate * STEREO_SMOOTHING_SECONDS)),
+        .ll = calloc(n_bands, sizeof(float)),
+        .rr = calloc(n_bands, sizeof(float)),
+        .lr_re = calloc(n_bands, sizeof(float)),
+        .lr_im = calloc(n_bands, sizeof(float)),
+        .gamma = malloc(n_bands * sizeof(Complex)),
+        .coherency = fft_history_new(history_size, n_bands),
+        .correlation = fhistory_new(history_size),
+    };
+    if (!stereo_meter_ok(&meter)) {
+        stereo_meter_free(&meter);
+        return (StereoMeter){0};
+    }
+
+    stereo_bands(n_bins, bin_hz, meter.band_end);
+    SizeType start = 0;
+    for (SizeType band = 0; band < n_bands; ++band) {
+        const float first = (float)(start + 1) * bin_hz;
+        const float last = (float)meter.band_end[band] * bin_hz;
+        meter.band_hz[band] = sqrtf(first * last);
+        start = meter.band_end[band];
+    }
+
+    return meter;
+}
+
+bool stereo_meter_ok(const StereoMeter* meter)
+{
+    if (!meter) {
+        return false;
+    }
+
+    return meter->band_end && meter->band_hz && meter->ll && meter->rr &&
+           meter->lr_re && meter->lr_im && meter->gamma &&
+           fft_history_ok(&meter->coherency) && meter->correlation.data;
+}
+
+void stereo_meter_free(StereoMeter* meter)
+{
+    if (!meter) {
+        return;
+    }
+
+    free(meter->band_end);
+    free(meter->band_hz);
+    free(meter->ll);
+    free(meter->rr);
+    free(meter->lr_re);
+    free(meter->lr_im);
+    free(meter->gamma);
+    fft_history_free(&meter->coherency);
+    fhistory_destroy(meter->correlation);
+    *meter = (StereoMeter){0};
+}
+
+void stereo_meter_process(StereoMeter* meter,
+                          const Complex* mid,
+                          const Complex* side)
+{
+    const float* m = (const float*)mid;
+    const float* s = (const float*)side;
+    const float a = meter->smoothing;
+
+    SizeType b = 0;
+    for (SizeType band = 0; band < meter->n_bands; ++band) {
+        float ll = 0.0f;
+        float rr = 0.0f;
+        float lr_re = 0.0f;
+        float lr_im = 0.0f;
+        // size_t: a 32 bit index could wrap as far as the vectorizer knows
+        for (size_t i = b; i < meter->band_end[band]; ++i) {
+            const float l_re = m[2 * i] + s[2 * i];
+            const float l_im = m[2 * i + 1] + s[2 * i + 1];
+            const float r_re = m[2 * i] - s[2 * i];
+            const float r_im = m[2 * i + 1] - s[2 * i + 1];
+            ll += l_re * l_re + l_im * l_im;
+            rr += r_re * r_re + r_im * r_im;
+            lr_re += l_re * r_re + l_im * r_im;
+            lr_im += l_im * r_re - l_re * r_im;
+        }
+        b = meter->band_end[band];
+
+        meter->ll[band] += a * (ll - meter->ll[band]);
+        meter->rr[band] += a * (rr - meter->rr[band]);
+        meter->lr_re[band] += a * (lr_re - meter->lr_re[band]);
+        meter->lr_im[band] += a * (lr_im - meter->lr_im[band]);
+    }
+}
+
+void stereo_meter_push(StereoMeter* meter)
+{
+    float* gamma = (float*)meter->gamma;
+    double ll = 0.0;
+    double rr = 0.0;
+    double lr = 0.0;
+    for (SizeType band = 0; band < meter->n_bands; ++band) {
+        // each root on its own, the product of two powers can overflow
+        const float norm = sqrtf(meter->ll[band]) * sqrtf(meter->rr[band]);
+        gamma[2 * band] = norm > 0.0f ? meter->lr_re[band] / norm : 0.0f;
+        gamma[2 * band + 1] = norm > 0.0f ? meter->lr_im[band] / norm : 0.0f;
+
+        ll += (double)meter->ll[band];
+        rr += (double)meter->rr[band];
+        lr += (double)meter->lr_re[band];
+    }
+
+    const double norm = sqrt(ll) * sqrt(rr);
+    fft_history_push(&meter->coherency, meter->gamma);
+    fhistory_push(&meter->correlation,
+                  norm > 0.0 ? (float)(lr / norm) : 0.0f);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "core/History.h"
+#include "core/definitions.h"
+
+// bands start a third of an octave apart from STEREO_MIN_HZ, the first one
+// takes everything below; a band is at least a bin wide
+#define STEREO_BANDS_PER_OCTAVE 3
+#define STEREO_MIN_HZ 40.0f
+
+// the spectra are smoothed over about this long, a correlation meter's
+// usual ballistics
+#define STEREO_SMOOTHING_SECONDS 0.3f
+
+// inter-channel measures of a stereo stream, one frame at a time, from the
+// mid and side spectra the analyzer gets out of a single complex FFT
+//
+// L = M + S and R = M - S give the auto-spectra |L|^2, |R|^2 and the cross
+// spectrum L R*, one complex multiply a bin; each is summed per band and
+// smoothed by a one-pole over frames. a band's complex coherency
+//   gamma = <L R*> / sqrt(<|L|^2> <|R|^2>)
+// has the magnitude-squared coherence as |gamma|^2, 1 when one channel is a
+// filtered copy of the other and near 0 when they're unrelated, and the
+// phase of L over R as arg gamma; the broadband correlation is
+//   Re <sum L R*> / sqrt(<sum |L|^2> <sum |R|^2>),
+// which by Parseval is the correlation of the windowed frames: +1 mono, 0
+// unrelated, -1 out of phase
+//
+// bins are laid out like an FFTHistory row, bin b centred on (b + 1) * bin_hz
+typedef struct {
+    SizeType n_bins;
+    SizeType n_bands;
+    SizeType* band_end;  // [n_bands] one past the band's last bin
+    float* band_hz;      // [n_bands] geometric centres
+    float smoothing;     // the one-pole's coefficient per frame
+
+    // [n_bands] each, smoothed
+    float* ll;
+    float* rr;
+    float* lr_re;
+    float* lr_im;
+    Complex* gamma;  // [n_bands] the row being pushed
+
+    // one row of n_bands gammas and one correlation per stereo_meter_push
+    FFTHistory coherency;
+    FloatHistory correlation;
+} StereoMeter;
+
+// frame_rate is frames per second, history_size the rings' length
+StereoMeter stereo_meter_new(SizeType n_bins,
+                             float bin_hz,
+                             float frame_rate,
+                             SizeType history_size);
+bool stereo_meter_ok(const StereoMeter* meter);
+void stereo_meter_free(StereoMeter* meter);
+
+void stereo_meter_process(StereoMeter* meter,
+                          const Complex* mid,
+                          const Complex* side);
+
+// pushes where the smoothed spectra stand onto the rings
+void stereo_meter_push(StereoMeter* meter);
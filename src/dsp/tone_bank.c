@@ -0,0 +1,123 @@
+#include "tone_bank.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// an error decays with a time constant of 1 / (1 - r) samples, 100k here,
+// while the weight of the oldest sample in a one second window stays >60%
+#define TONE_BANK_DAMPING 0.99999
+
+ToneBank tone_bank_new(const float* frequencies,
+                       SizeType n_tones,
+                       SizeType window,
+                       float sample_rate)
+{
+    ToneBank bank = {0};
+
+    if (n_tones == 0 || window == 0) {
+        return bank;
+    }
+
+    bank.re = malloc(n_tones * sizeof(float));
+    bank.im = malloc(n_tones * sizeof(float));
+    bank.rot_re = malloc(n_tones * sizeof(float));
+    bank.rot_im = malloc(n_tones * sizeof(float));
+    bank.tail_re = malloc(n_tones * sizeof(float));
+    bank.tail_im = malloc(n_tones * sizeof(float));
+    bank.frequencies = malloc(n_tones * sizeof(float));
+    bank.ring = malloc(window * sizeof(float));
+    bank.n_tones = n_tones;
+    bank.window = window;
+
+    if (!tone_bank_ok(&bank)) {
+        tone_bank_free(&bank);
+        return (ToneBank){0};
+    }
+
+    const double r = TONE_BANK_DAMPING;
+    const double r_n = pow(r, (double)window);
+
+    for (SizeType t = 0; t < n_tones; ++t) {
+        const double w =
+            2.0 * (double)PI * (double)frequencies[t] / (double)sample_rate;
+        bank.rot_re[t] = (float)(r * cos(w));
+        bank.rot_im[t] = (float)(r * sin(w));
+        bank.tail_re[t] = (float)(r_n * cos(w * (double)window));
+        bank.tail_im[t] = (float)(r_n * sin(w * (double)window));
+        bank.frequencies[t] = frequencies[t];
+    }
+
+    bank.gain = (float)(2.0 * (1.0 - r) / (1.0 - r_n));
+    tone_bank_reset(&bank);
+
+    return bank;
+}
+
+bool tone_bank_ok(const ToneBank* bank)
+{
+    if (!bank) {
+        return false;
+    }
+
+    return bank->re && bank->im && bank->rot_re && bank->rot_im &&
+           bank->tail_re && bank->tail_im && bank->frequencies && bank->ring;
+}
+
+void tone_bank_free(ToneBank* bank)
+{
+    if (!bank) {
+        return;
+    }
+
+    free(bank->re);
+    free(bank->im);
+    free(bank->rot_re);
+    free(bank->rot_im);
+    free(bank->tail_re);
+    free(bank->tail_im);
+    free(bank->frequencies);
+    free(bank->ring);
+}
+
+void tone_bank_reset(ToneBank* bank)
+{
+    memset(bank->re, 0, bank->n_tones * sizeof(float));
+    memset(bank->im, 0, bank->n_tones * sizeof(float));
+    memset(bank->ring, 0, bank->window * sizeof(float));
+    bank->cursor = 0;
+}
+
+void tone_bank_process(ToneBank* restrict bank,
+                       const float* restrict samples,
+                       SizeType size)
+{
+    float* restrict re = bank->re;
+    float* restrict im = bank->im;
+    const float* restrict rot_re = bank->rot_re;
+    const float* restrict rot_im = bank->rot_im;
+    const float* restrict tail_re = bank->tail_re;
+    const float* restrict tail_im = bank->tail_im;
+
+    for (SizeType i = 0; i < size; ++i) {
+        const float x = samples[i];
+        const float leaving = bank->ring[bank->cursor];
+        bank->ring[bank->cursor] = x;
+        bank->cursor =
+            (bank->cursor + 1 == bank->window) ? 0 : bank->cursor + 1;
+
+        for (SizeType t = 0; t < bank->n_tones; ++t) {
+            const float r = rot_re[t] * re[t] - rot_im[t] * im[t];
+            const float j = rot_re[t] * im[t] + rot_im[t] * re[t];
+            re[t] = r + x - tail_re[t] * leaving;
+            im[t] = j - tail_im[t] * leaving;
+        }
+    }
+}
+
+float tone_bank_magnitude(const ToneBank* bank, SizeType tone)
+{
+    const float re = bank->re[tone];
+    const float im = bank->im[tone];
+    return bank->gain * sqrtf(re * re + im * im);
+}
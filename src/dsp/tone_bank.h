@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "core/definitions.h"
+
+// a handful of arbitrary frequencies tracked sample by sample with sliding
+// DFT resonators, no FFT and no hop
+//
+// each tone keeps the DTFT of the last `window` samples at its frequency:
+//
+//     X[n] = r e^{jw} X[n-1] + x[n] - r^N e^{jwN} x[n-N]
+//
+// which holds for any w, not just the bin centres of an N-point DFT. the
+// damping r < 1 keeps rounding errors from accumulating on the unit circle,
+// its small bias is divided back out of the magnitudes
+//
+// tones are stored structure-of-arrays so the per-sample update is one
+// vectorizable pass over them; cost is O(tones) per sample, latency one
+// sample
+typedef struct {
+    float* re;  // X, per tone
+    float* im;
+    float* rot_re;  // r e^{jw}
+    float* rot_im;
+    float* tail_re;  // r^N e^{jwN}
+    float* tail_im;
+    float* frequencies;
+    SizeType n_tones;
+
+    float* ring;  // the last `window` samples, shared by every tone
+    SizeType window;
+    SizeType cursor;  // oldest sample, about to leave the window
+    float gain;       // 2 / sum(r^m), full-scale sine reads 1
+} ToneBank;
+
+ToneBank tone_bank_new(const float* frequencies,
+                       SizeType n_tones,
+                       SizeType window,
+                       float sample_rate);
+bool tone_bank_ok(const ToneBank* bank);
+void tone_bank_free(ToneBank* bank);
+
+void tone_bank_reset(ToneBank* bank);
+
+void tone_bank_process(ToneBank* restrict bank,
+                       const float* restrict samples,
+                       SizeType size);
+
+// amplitude of a sine at the tone's frequency, as of the last sample
+float tone_bank_magnitude(const ToneBank* bank, SizeType tone);
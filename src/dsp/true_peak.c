@@ -0,0 +1,40 @@
+#include "true_peak.h"
+
+#include <math.h>
+
+#define TRUE_PEAK_TAPS (TRUE_PEAK_OVERSAMPLING * TRUE_PEAK_TAPS_PER_PHASE)
+
+// Hann-windowed sinc with its cutoff at the original Nyquist, split into
+// phases; each phase is scaled to unity DC gain so a constant reads exactly
+TruePeak true_peak_init(void)
+{
+    TruePeak tp = {0};
+
+    const float center = (float)(TRUE_PEAK_TAPS - 1) / 2.0f;
+
+    for (SizeType p = 0; p < TRUE_PEAK_OVERSAMPLING; ++p) {
+        float dc = 0.0f;
+
+        for (SizeType k = 0; k < TRUE_PEAK_TAPS_PER_PHASE; ++k) {
+            // phase p of the upsampled stream sits p/4 after input sample k,
+            // with the newest input at the end of the window
+            const SizeType n = (TRUE_PEAK_TAPS_PER_PHASE - 1 - k) *
+                                   TRUE_PEAK_OVERSAMPLING +
+                               p;
+            const float t = ((float)n - center) / TRUE_PEAK_OVERSAMPLING;
+            const float sinc = t == 0.0f ? 1.0f : sinf(PI * t) / (PI * t);
+            const float hann =
+                0.5f - 0.5f * cosf(2.0f * PI * ((float)n + 0.5f) /
+                                   (float)TRUE_PEAK_TAPS);
+
+            tp.taps[p][k] = sinc * hann;
+            dc += tp.taps[p][k];
+        }
+
+        for (SizeType k = 0; k < TRUE_PEAK_TAPS_PER_PHASE; ++k) {
+            tp.taps[p][k] /= dc;
+        }
+    }
+
+    return tp;
+}
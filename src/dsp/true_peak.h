@@ -0,0 +1,44 @@
+#pragma once
+
+#include <math.h>
+
+#include "core/definitions.h"
+
+#define TRUE_PEAK_OVERSAMPLING 4
+#define TRUE_PEAK_TAPS_PER_PHASE 12
+
+// inter-sample peak estimate per ITU-R BS.1770 annex 2: upsample 4x with a
+// polyphase FIR and take the largest magnitude
+//
+// the history is stored twice back to back so every phase reads a contiguous
+// window without wrapping
+typedef struct {
+    float taps[TRUE_PEAK_OVERSAMPLING][TRUE_PEAK_TAPS_PER_PHASE];
+    float history[2 * TRUE_PEAK_TAPS_PER_PHASE];
+    SizeType cursor;
+} TruePeak;
+
+TruePeak true_peak_init(void);
+
+// largest |y| among the 4 interpolated points ending at x
+static inline float true_peak_step(TruePeak* restrict tp, float x)
+{
+    tp->history[tp->cursor] = x;
+    tp->history[tp->cursor + TRUE_PEAK_TAPS_PER_PHASE] = x;
+    tp->cursor = (tp->cursor + 1) % TRUE_PEAK_TAPS_PER_PHASE;
+
+    // oldest sample first
+    const float* window = tp->history + tp->cursor;
+
+    float peak = 0.0f;
+    for (SizeType p = 0; p < TRUE_PEAK_OVERSAMPLING; ++p) {
+        float y = 0.0f;
+        for (SizeType k = 0; k < TRUE_PEAK_TAPS_PER_PHASE; ++k) {
+            y += tp->taps[p][k] * window[k];
+        }
+        y = fabsf(y);
+        peak = y > peak ? y : peak;
+    }
+
+    return peak;
+}
@@ -6,15 +6,71 @@
 #include "LockFreeQueue.h"
 
 #include "FFTAnalyzer.h"
+#include "FrameScheduler.h"
+#include "LatencyTracker.h"
 #include "LinearSpectrogram.h"
+#include "PartialOverlay.h"
+#include "PitchOverlay.h"
+#include "StereoOverlay.h"
+#include "ToneOverlay.h"
+#include "TraceOverlay.h"
+#include "WaveformVisualizer.h"
+#include "ZoomAnalyzer.h"
 #include "audio_callback.h"
+#include "cache/CacheWriter.h"
+#include "cache/Snapshotter.h"
+#include "capture/CaptureRecorder.h"
+#include "capture/CaptureReplayer.h"
+#include "capture/LiveInput.h"
 #include "core/colormap/palette.h"
 #include "core/definitions.h"
+#include "core/frequency_axis.h"
+#include "core/waveform.h"
+#include "dsp/partials.h"
+#include "dsp/tone_bank.h"
+#include "trace/clock.h"
+#include "trace/trace.h"
 
 #define WINDOW_NAME "spectre"
 #define WINDOW_WIDTH 1600
 #define WINDOW_HEIGHT 900
 
+// in --fast replay, how many recorded blocks are fed between two renders
+#define FAST_REPLAY_BLOCKS_PER_FRAME 64
+
+// --tones: how many, and how much signal each resonator integrates
+#define MAX_TONES 64
+#define TONE_WINDOW_SECONDS 0.1f
+
+// --zoom: resolution when none is given, frames per frame length, and the
+// share of the window height the zoom panel takes
+#define ZOOM_DEFAULT_RESOLUTION 0.1f
+#define ZOOM_OVERLAP 8
+#define ZOOM_PANEL_FRACTION (1.0f / 3.0f)
+#define ZOOM_HISTORY_SIZE 256
+
+// --waveform: the share of the window height its panel takes, and how much
+// audio it may keep
+#define WAVEFORM_PANEL_FRACTION 0.2f
+#define MAX_WAVEFORM_SECONDS 3600.0f
+
+// --fft-size: frames worth splitting across threads are also too large for
+// HISTORY_SIZE rows, the history gets at most this many bytes instead
+#define MIN_FFT_SIZE 256
+#define MAX_FFT_SIZE (1u << 20)
+#define LARGE_HISTORY_BYTES (256u << 20)
+
+// --frame-budget: analysis and column updates per display frame, and how
+// many FFT frames a history row may merge when that's not enough
+#define DEFAULT_FRAME_BUDGET_MS 4.0f
+#define MAX_MERGE 8
+
+// --snapshot: minutes kept for A, S only saves what's on screen
+#define DEFAULT_SNAPSHOT_MINUTES 5.0f
+
+// overridden by the SPECTRE_TRACE_FILE environment variable
+#define DEFAULT_TRACE_FILE "spectre_trace.json"
+
 typedef struct AppConfig AppConfig;
 struct AppConfig {
     const char* const window_name;
@@ -37,13 +93,305 @@ static float cfg_scroll_speed_px_per_frame(AppConfig cfg)
     return cfg.scroll_speed_px_per_sec / (float)cfg.target_fps;
 }
 
-int main(int ac, const char** av)
+typedef struct {
+    const char* music_path;   // NULL when replaying or live
+    const char* record_path;  // --record <capture>
+    const char* replay_path;  // --replay <capture>
+    bool replay_fast;         // --fast, ignore the recorded pacing
+    bool live;                // --input <device>
+    LiveInputSource input;
+    uint32_t period;          // --period <frames>
+    const char* latency_log;  // --latency-log <file>
+    const char* cache_path;   // --cache <file>
+    const char* snapshot_path;  // --snapshot <file.pgm|.f32|.spsc>
+    float snapshot_minutes;     // --snapshot-minutes <m>
+    SizeType fft_size;        // --fft-size <n>
+    float frame_budget_ms;    // --frame-budget <ms>, 0 for none
+    float tones[MAX_TONES];   // --tones <hz,hz,...>
+    SizeType n_tones;
+    bool pitch;               // --pitch
+    bool partials;            // --partials
+    bool stereo;              // --stereo
+    float waveform_seconds;   // --waveform <seconds>, 0 for no panel
+    FrequencyAxis axis;  // --axis <linear|log|mel|erb>
+    RowPooling pooling;       // --pooling <max|rms|mean>
+    RowPooling zoom_pooling;  // --zoom-pooling <max|rms|mean>
+    bool zoom;           // --zoom <lo>:<hi>[:<resolution>], all in Hz
+    float zoom_lo;
+    float zoom_hi;
+    float zoom_resolution;
+} AppArgs;
+
+static void usage_and_exit(void)
 {
-    if (ac != 2) {
-        printf("Usage: spectre [audio_file]\n");
-        exit(1);
+    printf("Usage: spectre [--record <capture>] [options] [audio_file]\n");
+    printf("       spectre --replay <capture> [--fast] [options]\n");
+    printf("       spectre --input <default|null|loopback> "
+           "[--period <frames>] [--record <capture>] [options]\n");
+    printf("options:\n");
+    printf("  --latency-log <file>  audio-to-pixel percentiles, every second\n");
+    printf("  --cache <file>        write the spectrogram to a cache file\n");
+    printf("  --snapshot <file>     S saves the screen: .pgm, .f32, .spsc\n");
+    printf("                        A the last --snapshot-minutes (%.0f)\n",
+           (double)DEFAULT_SNAPSHOT_MINUTES);
+    printf("  --fft-size <n>        samples per frame, even, up to %u\n",
+           MAX_FFT_SIZE);
+    printf("  --frame-budget <ms>   analysis and drawing per frame, 0: none\n");
+    printf("  --axis <name>         frequency axis: linear, log, mel or erb\n");
+    printf("  --pooling <name>      bins per pixel row: max, rms or mean\n");
+    printf("  --tones <hz,hz,...>   track these frequencies sample by sample\n");
+    printf("  --pitch               track the fundamental, P toggles it\n");
+    printf("  --partials            track sinusoids, K toggles them\n");
+    printf("  --stereo              correlation and coherence, C toggles\n");
+    printf("  --waveform <seconds>  waveform panel, the wheel zooms it\n");
+    printf("  --zoom <lo>:<hi>[:<resolution>]\n");
+    printf("                        high resolution panel for a band, in Hz\n");
+    printf("  --zoom-pooling <name> --pooling for the zoom panel\n");
+    exit(1);
+}
+
+// comma separated, positive, at most MAX_TONES
+static SizeType parse_tones(const char* list, float* tones)
+{
+    SizeType n = 0;
+    const char* cursor = list;
+
+    while (*cursor != '\0') {
+        char* end = NULL;
+        const float f = strtof(cursor, &end);
+        if (end == cursor || f <= 0.0f || n == MAX_TONES) {
+            usage_and_exit();
+        }
+        tones[n++] = f;
+
+        if (*end == ',') {
+            ++end;
+        } else if (*end != '\0') {
+            usage_and_exit();
+        }
+        cursor = end;
+    }
+
+    return n;
+}
+
+static void parse_zoom(const char* spec, AppArgs* args)
+{
+    args->zoom_resolution = ZOOM_DEFAULT_RESOLUTION;
+    const int n = sscanf(spec, "%f:%f:%f", &args->zoom_lo, &args->zoom_hi,
+                         &args->zoom_resolution);
+    if (n < 2 || args->zoom_lo < 0.0f || !(args->zoom_hi > args->zoom_lo) ||
+        !(args->zoom_resolution > 0.0f)) {
+        usage_and_exit();
+    }
+    args->zoom = true;
+}
+
+// even, MIN_FFT_SIZE to MAX_FFT_SIZE
+static SizeType parse_fft_size(const char* text)
+{
+    char* end = NULL;
+    const unsigned long size = strtoul(text, &end, 10);
+    if (end == text || *end != '\0' || size < MIN_FFT_SIZE ||
+        size > MAX_FFT_SIZE || size % 2 != 0) {
+        usage_and_exit();
     }
-    const char* music_path = av[1];
+    return (SizeType)size;
+}
+
+static RowPooling parse_pooling(const char* name)
+{
+    const RowPooling pooling = row_pooling_from_name(name);
+    if (pooling == POOL_COUNT) {
+        usage_and_exit();
+    }
+    return pooling;
+}
+
+static AppArgs parse_args(int ac, const char** av)
+{
+    // max keeps narrow lines visible however many bins share a pixel
+    AppArgs args = {
+        .axis = AXIS_LINEAR,
+        .pooling = POOL_MAX,
+        .zoom_pooling = POOL_MAX,
+        .fft_size = FFT_SIZE,
+        .frame_budget_ms = DEFAULT_FRAME_BUDGET_MS,
+        .period = LIVE_INPUT_DEFAULT_PERIOD,
+        .snapshot_minutes = DEFAULT_SNAPSHOT_MINUTES,
+    };
+
+    for (int i = 1; i < ac; ++i) {
+        if (strcmp(av[i], "--record") == 0 && i + 1 < ac) {
+            args.record_path = av[++i];
+        } else if (strcmp(av[i], "--replay") == 0 && i + 1 < ac) {
+            args.replay_path = av[++i];
+        } else if (strcmp(av[i], "--input") == 0 && i + 1 < ac) {
+            args.input = live_input_source_from_name(av[++i]);
+            if (args.input == LIVE_INPUT_COUNT) {
+                usage_and_exit();
+            }
+            args.live = true;
+        } else if (strcmp(av[i], "--period") == 0 && i + 1 < ac) {
+            char* end = NULL;
+            const unsigned long period = strtoul(av[++i], &end, 10);
+            if (*end != '\0' || period < LIVE_INPUT_MIN_PERIOD ||
+                period > LIVE_INPUT_MAX_PERIOD) {
+                usage_and_exit();
+            }
+            args.period = (uint32_t)period;
+        } else if (strcmp(av[i], "--latency-log") == 0 && i + 1 < ac) {
+            args.latency_log = av[++i];
+        } else if (strcmp(av[i], "--cache") == 0 && i + 1 < ac) {
+            args.cache_path = av[++i];
+        } else if (strcmp(av[i], "--snapshot") == 0 && i + 1 < ac) {
+            args.snapshot_path = av[++i];
+            if (snapshot_format_for_path(args.snapshot_path) ==
+                SNAPSHOT_FORMAT_COUNT) {
+                usage_and_exit();
+            }
+        } else if (strcmp(av[i], "--snapshot-minutes") == 0 && i + 1 < ac) {
+            char* end = NULL;
+            args.snapshot_minutes = strtof(av[++i], &end);
+            if (*end != '\0' || !(args.snapshot_minutes > 0.0f)) {
+                usage_and_exit();
+            }
+        } else if (strcmp(av[i], "--fft-size") == 0 && i + 1 < ac) {
+            args.fft_size = parse_fft_size(av[++i]);
+        } else if (strcmp(av[i], "--frame-budget") == 0 && i + 1 < ac) {
+            char* end = NULL;
+            args.frame_budget_ms = strtof(av[++i], &end);
+            if (*end != '\0' || !(args.frame_budget_ms >= 0.0f)) {
+                usage_and_exit();
+            }
+        } else if (strcmp(av[i], "--tones") == 0 && i + 1 < ac) {
+            args.n_tones = parse_tones(av[++i], args.tones);
+        } else if (strcmp(av[i], "--axis") == 0 && i + 1 < ac) {
+            args.axis = frequency_axis_from_name(av[++i]);
+            if (args.axis == AXIS_COUNT) {
+                usage_and_exit();
+            }
+        } else if (strcmp(av[i], "--pooling") == 0 && i + 1 < ac) {
+            args.pooling = parse_pooling(av[++i]);
+        } else if (strcmp(av[i], "--zoom") == 0 && i + 1 < ac) {
+            parse_zoom(av[++i], &args);
+        } else if (strcmp(av[i], "--zoom-pooling") == 0 && i + 1 < ac) {
+            args.zoom_pooling = parse_pooling(av[++i]);
+        } else if (strcmp(av[i], "--waveform") == 0 && i + 1 < ac) {
+            char* end = NULL;
+            args.waveform_seconds = strtof(av[++i], &end);
+            if (*end != '\0' || !(args.waveform_seconds > 0.0f) ||
+                args.waveform_seconds > MAX_WAVEFORM_SECONDS) {
+                usage_and_exit();
+            }
+        } else if (strcmp(av[i], "--pitch") == 0) {
+            args.pitch = true;
+        } else if (strcmp(av[i], "--partials") == 0) {
+            args.partials = true;
+        } else if (strcmp(av[i], "--stereo") == 0) {
+            args.stereo = true;
+        } else if (strcmp(av[i], "--fast") == 0) {
+            args.replay_fast = true;
+        } else if (av[i][0] != '-' && args.music_path == NULL) {
+            args.music_path = av[i];
+        } else {
+            usage_and_exit();
+        }
+    }
+
+    // exactly one source
+    const bool replaying = args.replay_path != NULL;
+    const int sources = (replaying ? 1 : 0) + (args.live ? 1 : 0) +
+                        (args.music_path != NULL ? 1 : 0);
+    if (sources != 1) {
+        usage_and_exit();
+    }
+    if (replaying && args.record_path != NULL) {
+        usage_and_exit();
+    }
+
+    return args;
+}
+
+// feeds recorded blocks through the very callback the audio thread uses,
+// analyzing after each one so the queue sees the same fill pattern as live
+static SizeType replay_blocks(CaptureReplayer* replayer,
+                              FFTAnalyzer* analyzer,
+                              uint64_t until_ns,
+                              SizeType max_blocks)
+{
+    SizeType processed = 0;
+    CaptureBlock block;
+
+    for (SizeType i = 0; i < max_blocks; ++i) {
+        if (!capture_replayer_next(replayer, until_ns, &block)) {
+            break;
+        }
+        pull_samples_from_audio_thread(block.samples, block.frames);
+        processed += fft_analyzer_update(analyzer);
+    }
+
+    return processed;
+}
+
+static void tone_bank_tap(void* ctx, const float* samples, SizeType size)
+{
+    tone_bank_process(ctx, samples, size);
+}
+
+static void zoom_analyzer_tap(void* ctx, const float* samples, SizeType size)
+{
+    zoom_analyzer_push(ctx, samples, size);
+}
+
+static void waveform_tap(void* ctx, const float* samples, SizeType size)
+{
+    waveform_pyramid_push(ctx, samples, size);
+}
+
+// path with -0001, -0002, ... before its extension
+static void numbered_path(char* out, size_t size, const char* path, unsigned n)
+{
+    const char* dot = strrchr(path, '.');
+    const int stem = dot != NULL ? (int)(dot - path) : (int)strlen(path);
+    snprintf(out, size, "%.*s-%04u%s", stem, path, n, dot != NULL ? dot : "");
+}
+
+static void draw_latency_report(const LatencyReport* report, Vector2 origin)
+{
+    const int font_size = 10;
+    const int line_height = font_size + 4;
+
+    DrawText("latency ms        p50     p95     p99", (int)origin.x,
+             (int)origin.y, font_size, TEXT_COLOR);
+    for (SizeType s = 0; s < LATENCY_STAGE_COUNT; ++s) {
+        const char* line = TextFormat(
+            "%-12s %7.2f %7.2f %7.2f", latency_stage_name((LatencyStage)s),
+            (double)report->p50_ms[s], (double)report->p95_ms[s],
+            (double)report->p99_ms[s]);
+        const int y = (int)origin.y + (int)(s + 1) * line_height;
+        DrawText(line, (int)origin.x, y, font_size, TEXT_COLOR);
+    }
+}
+
+#if defined(SPECTRE_TRACE)
+static void export_trace(void)
+{
+    const char* path = getenv("SPECTRE_TRACE_FILE");
+    path = (path != NULL) ? path : DEFAULT_TRACE_FILE;
+
+    if (trace_export_chrome(path)) {
+        printf("trace written to %s\n", path);
+    } else {
+        printf("failed to write trace to %s\n", path);
+    }
+}
+#endif
+
+int main(int ac, const char** av)
+{
+    const AppArgs args = parse_args(ac, av);
+    const bool replaying = args.replay_path != NULL;
 
     const AppConfig app_cfg = {
         .window_name = WINDOW_NAME,
@@ -56,7 +404,6 @@ int main(int ac, const char** av)
 
     InitWindow(app_cfg.window_width, app_cfg.window_height,
                app_cfg.window_name);
-    InitAudioDevice();
 
     LockFreeQueue* sample_queue = malloc(sizeof(*sample_queue));
     if (sample_queue == NULL) {
@@ -67,60 +414,550 @@ int main(int ac, const char** av)
 
     LockFreeQueueProducer sample_tx = clfq_producer(sample_queue);
     init_audio_processor(&sample_tx);
-    AttachAudioMixedProcessor(pull_samples_from_audio_thread);
 
-    Music music = LoadMusicStream(music_path);
-    if (!IsMusicValid(music)) {
-        printf("Failed to open %s\n", music_path);
-        exit(1);
+    // --stereo: the side channel has a queue of its own, attached before
+    // any audio runs so the two start out in step
+    LockFreeQueue* side_queue = NULL;
+    LockFreeQueueProducer side_tx = {0};
+    if (args.stereo) {
+        if (args.fft_size >= FFT_LARGE_SIZE) {
+            printf("--stereo needs an --fft-size below %u\n",
+                   FFT_LARGE_SIZE);
+            exit(1);
+        }
+        side_queue = malloc(sizeof(*side_queue));
+        if (side_queue == NULL) {
+            printf("oom\n");
+            exit(1);
+        }
+        clfq_new(side_queue);
+        side_tx = clfq_producer(side_queue);
+        attach_side_queue(&side_tx);
+    }
+
+    // either a music stream played through the audio device, a capture
+    // device analyzed as it records with no playback at all, or a capture
+    // file replayed on the main thread with no audio device at all
+    Music music = {0};
+    LiveInput* input = NULL;
+    CaptureReplayer replayer = {0};
+    CaptureRecorder* recorder = NULL;
+    float sample_rate = 0.0f;
+    uint32_t device_rate = 0;
+
+    if (replaying) {
+        replayer = capture_replayer_new(args.replay_path);
+        if (!capture_replayer_ok(&replayer)) {
+            printf("Failed to open capture %s\n", args.replay_path);
+            exit(1);
+        }
+        sample_rate = (float)replayer.sample_rate;
+    } else if (args.live) {
+        const LiveInputConfig input_cfg = {
+            .source = args.input,
+            .period_frames = args.period,
+        };
+        input = live_input_new(&input_cfg);
+        if (input == NULL) {
+            printf("Failed to open the %s input\n",
+                   live_input_source_name(args.input));
+            exit(1);
+        }
+        device_rate = live_input_sample_rate(input);
+        printf("input: %s, %u Hz, %u frames a period\n",
+               live_input_backend(input), device_rate,
+               live_input_period(input));
+    } else {
+        InitAudioDevice();
+        AttachAudioMixedProcessor(pull_samples_from_audio_thread);
+
+        music = LoadMusicStream(args.music_path);
+        if (!IsMusicValid(music)) {
+            printf("Failed to open %s\n", args.music_path);
+            exit(1);
+        }
+        device_rate = music.stream.sampleRate;
+    }
+
+    if (!replaying) {
+        sample_rate = (float)device_rate;
+        if (args.record_path != NULL) {
+            // both callbacks hand us interleaved stereo
+            recorder =
+                capture_recorder_new(args.record_path, device_rate, 2);
+            if (recorder == NULL) {
+                printf("Failed to open %s for recording\n", args.record_path);
+                exit(1);
+            }
+            attach_capture_recorder(recorder);
+        }
     }
 
     // analyzer
+    // the hop stays the default's whatever the frame size, large frames are
+    // transformed by every core and keep fewer rows
+    const SizeType fft_size = args.fft_size;
+    const SizeType fft_stride =
+        fft_size / 2 < FFT_SIZE / 2 ? fft_size / 2 : FFT_SIZE / 2;
+    const size_t row_bytes = fft_size / 2 * sizeof(Complex);
+    const SizeType history_size =
+        fft_size < FFT_LARGE_SIZE ? HISTORY_SIZE
+                                  : (SizeType)(LARGE_HISTORY_BYTES / row_bytes);
     const FFTConfig fft_config = {
-        .size = FFT_SIZE,
-        .stride = FFT_SIZE / 2,
+        .size = fft_size,
+        .stride = fft_stride,
         .dc_blocker_frequency = 10.0f,  // 10 Hz
-        .history_size = HISTORY_SIZE,
-        .sample_rate = music.stream.sampleRate,
+        .history_size = history_size < HISTORY_SIZE ? history_size
+                                                    : HISTORY_SIZE,
+        .sample_rate = sample_rate,
+        .decimation = fft_decimation_for(sample_rate),
+        .threads =
+            fft_size < FFT_LARGE_SIZE ? 0 : large_fft_default_threads(),
+        .pitch = args.pitch,
+        .stereo = args.stereo,
     };
     LockFreeQueueConsumer sample_rx = clfq_consumer(sample_queue);
     FFTAnalyzer analyzer = fft_analyzer_new(&fft_config, sample_rx);
+    if (!fft_analyzer_ok(&analyzer)) {
+        printf("oom\n");
+        exit(1);
+    }
+    if (args.stereo) {
+        fft_analyzer_attach_side(&analyzer, clfq_consumer(side_queue));
+    }
+
+    // --cache: every analyzed frame, a tile at a time; the source is only
+    // known by its path here, the offline tools hash the samples
+    const char* source = replaying   ? args.replay_path
+                         : args.live ? live_input_source_name(args.input)
+                                     : args.music_path;
+    const uint64_t source_hash =
+        cache_hash(CACHE_HASH_SEED, source, strlen(source));
+    CacheWriter* cache = NULL;
+    if (args.cache_path != NULL) {
+        cache = cache_writer_new(args.cache_path, &fft_config,
+                                 CACHE_STORAGE_COMPLEX, analyzer.n_bins,
+                                 source_hash);
+        if (cache == NULL) {
+            printf("Failed to open %s for caching\n", args.cache_path);
+            exit(1);
+        }
+    }
 
     // spectrogram
+    // the zoom panel, when there is one, takes the bottom of the window and
+    // the waveform panel what's right above it
+    const float zoom_height =
+        args.zoom ? ZOOM_PANEL_FRACTION * (float)WINDOW_HEIGHT : 0.0f;
+    const float waveform_height =
+        args.waveform_seconds > 0.0f
+            ? WAVEFORM_PANEL_FRACTION * (float)WINDOW_HEIGHT
+            : 0.0f;
     const Rectangle spectrogram_panel = {
         .x = 0,
         .y = 0,
         .width = WINDOW_WIDTH,
-        .height = WINDOW_HEIGHT,
+        .height = (float)WINDOW_HEIGHT - zoom_height - waveform_height,
     };
 
     const LinearSpectrogramConfig spectrogram_cfg =
-        linear_spectrogram_config(spectrogram_panel, plasma_rgba, &fft_config);
+        linear_spectrogram_config(spectrogram_panel, plasma_rgba, &fft_config,
+                                  args.axis, args.pooling);
     LinearSpectrogram spectrogram = linear_spectrogram_new(&spectrogram_cfg);
+    if (!linear_spectrogram_ok(&spectrogram)) {
+        printf("oom\n");
+        exit(1);
+    }
+
+    // --snapshot: the last minutes of rows, exported in the background
+    Snapshotter* snapshotter = NULL;
+    if (args.snapshot_path != NULL) {
+        const float frames_per_second =
+            sample_rate / (float)(fft_config.stride * fft_config.decimation);
+        snapshotter = snapshotter_new(
+            &fft_config, analyzer.n_bins,
+            (SizeType)(60.0f * args.snapshot_minutes * frames_per_second),
+            spectrogram_cfg.power_reference, spectrogram_cfg.min_dB,
+            source_hash);
+        if (snapshotter == NULL) {
+            printf("oom\n");
+            exit(1);
+        }
+    }
+    unsigned n_snapshots = 0;
+    char snapshot_file[1024] = {0};
+    bool exporting = false;
+
+    // --tones: resonators fed by the analyzer's tap, F toggles their overlay
+    const float analysis_rate = fft_analyzer_sample_rate(&analyzer);
+    ToneBank tones = {0};
+    ToneOverlay tone_overlay =
+        tone_overlay_new(spectrogram_panel, spectrogram_cfg.axis);
+    if (args.n_tones > 0) {
+        tones = tone_bank_new(args.tones, args.n_tones,
+                              (SizeType)(TONE_WINDOW_SECONDS * analysis_rate),
+                              analysis_rate);
+        if (!tone_bank_ok(&tones)) {
+            printf("oom\n");
+            exit(1);
+        }
+        fft_analyzer_add_tap(&analyzer, tone_bank_tap, &tones);
+    }
 
-    PlayMusicStream(music);
-    SetTargetFPS(app_cfg.target_fps);
+    // --pitch: the analyzer tracks it, P toggles the line
+    PitchOverlay pitch_overlay = {0};
+    if (args.pitch) {
+        pitch_overlay = pitch_overlay_new(spectrogram_panel,
+                                          spectrogram_cfg.axis,
+                                          fft_config.history_size);
+        if (!pitch_overlay_ok(&pitch_overlay)) {
+            printf("oom\n");
+            exit(1);
+        }
+    }
+
+    // --partials: tracked over the history rows, K toggles them; points for
+    // as many peaks as a row can have on every row on screen
+    PartialTracker partials = {0};
+    PartialOverlay partial_overlay = partial_overlay_new(
+        spectrogram_panel, spectrogram_cfg.axis, spectrogram_cfg.min_dB);
+    if (args.partials) {
+        const PartialConfig partial_cfg = {
+            .size = fft_config.size,
+            .stride = fft_config.stride,
+            .sample_rate = analysis_rate,
+            .power_reference = spectrogram_cfg.power_reference,
+            .min_dB = spectrogram_cfg.min_dB,
+            .threshold_dB = PARTIAL_THRESHOLD_DB,
+            .max_peaks = PARTIAL_MAX_PEAKS,
+            .cap = PARTIAL_MAX_PEAKS * fft_config.history_size,
+        };
+        partials = partial_tracker_new(&partial_cfg);
+        if (!partial_tracker_ok(&partials)) {
+            printf("oom\n");
+            exit(1);
+        }
+    }
+
+    // --stereo: the analyzer meters it, C toggles the bars
+    StereoOverlay stereo_overlay =
+        stereo_overlay_new(spectrogram_panel, spectrogram_cfg.axis);
+
+    // --waveform: a min/max pyramid of what the analyzer sees, fed by its
+    // tap as well
+    const Rectangle waveform_panel = {
+        .x = 0,
+        .y = spectrogram_panel.height,
+        .width = WINDOW_WIDTH,
+        .height = waveform_height,
+    };
+    WaveformPyramid waveform = {0};
+    WaveformVisualizer waveform_vis = {0};
+    if (args.waveform_seconds > 0.0f) {
+        waveform = waveform_pyramid_new(
+            (uint64_t)(args.waveform_seconds * analysis_rate));
+        waveform_vis = waveform_vis_new(waveform_panel, analysis_rate,
+                                        args.waveform_seconds);
+        if (!waveform_pyramid_ok(&waveform) ||
+            !waveform_vis_ok(&waveform_vis)) {
+            printf("oom\n");
+            exit(1);
+        }
+        fft_analyzer_add_tap(&analyzer, waveform_tap, &waveform);
+    }
+
+    // --zoom: chirp-Z over a band, fed by the analyzer's tap too
+    const ZoomConfig zoom_cfg = {
+        .f_lo = args.zoom_lo,
+        .f_hi = args.zoom_hi,
+        .resolution = args.zoom_resolution,
+        .overlap = ZOOM_OVERLAP,
+        .sample_rate = analysis_rate,
+        .history_size = ZOOM_HISTORY_SIZE,
+    };
+    if (args.zoom && args.zoom_hi > 0.5f * analysis_rate) {
+        printf("--zoom band ends above Nyquist (%.0f Hz)\n",
+               (double)(0.5f * analysis_rate));
+        exit(1);
+    }
+    ZoomAnalyzer zoom =
+        args.zoom ? zoom_analyzer_new(&zoom_cfg) : (ZoomAnalyzer){0};
+    if (args.zoom) {
+        if (!zoom_analyzer_ok(&zoom)) {
+            printf("oom\n");
+            exit(1);
+        }
+        fft_analyzer_add_tap(&analyzer, zoom_analyzer_tap, &zoom);
+    }
+    const Rectangle zoom_panel = {
+        .x = 0,
+        .y = spectrogram_panel.height + waveform_height,
+        .width = WINDOW_WIDTH,
+        .height = zoom_height,
+    };
+    const LinearSpectrogramConfig zoom_spectrogram_cfg =
+        linear_spectrogram_config_bins(zoom_panel, plasma_rgba, zoom.n_points,
+                                       zoom.size, ZOOM_HISTORY_SIZE,
+                                       args.zoom_pooling);
+    LinearSpectrogram zoom_spectrogram =
+        args.zoom ? linear_spectrogram_new(&zoom_spectrogram_cfg)
+                  : (LinearSpectrogram){0};
+    if (args.zoom && !linear_spectrogram_ok(&zoom_spectrogram)) {
+        printf("oom\n");
+        exit(1);
+    }
+
+    // L toggles the on-screen latency report
+    FILE* latency_log = NULL;
+    if (args.latency_log != NULL) {
+        latency_log = fopen(args.latency_log, "w");
+        if (latency_log == NULL) {
+            printf("Failed to open %s\n", args.latency_log);
+            exit(1);
+        }
+    }
+    // the tracker counts samples as they leave the callback, before any
+    // decimation
+    LatencyTracker* latency = latency_tracker_new(
+        fft_config.stride * fft_config.decimation, latency_log);
+    if (latency == NULL) {
+        printf("oom\n");
+        exit(1);
+    }
+    attach_latency_tracker(latency);
+    bool show_latency = false;
+
+    // the cache and the snapshots must hold every frame, one row per stride
+    // as their headers say and their windows are sized for, so with either
+    // the scheduler only spreads the columns out
+    const FrameSchedulerConfig scheduler_cfg = {
+        .budget_ns = (uint64_t)(args.frame_budget_ms * 1e6f),
+        .max_merge = (cache != NULL || snapshotter != NULL) ? 1 : MAX_MERGE,
+    };
+    FrameScheduler scheduler = frame_scheduler_new(&scheduler_cfg);
+
+#if defined(SPECTRE_TRACE)
+    // T dumps the trace, O toggles the overlay
+    TRACE_THREAD_NAME("main");
+    TraceOverlay trace_overlay = trace_overlay_new((Vector2){10, 10});
+#endif
+
+    if (replaying) {
+        // a fast replay is only bounded by how quickly we can analyze
+        SetTargetFPS(args.replay_fast ? 0 : app_cfg.target_fps);
+    } else {
+        if (args.live) {
+            if (!live_input_start(input)) {
+                printf("Failed to start the %s input\n",
+                       live_input_source_name(args.input));
+                exit(1);
+            }
+        } else {
+            PlayMusicStream(music);
+        }
+        SetTargetFPS(app_cfg.target_fps);
+    }
+    const uint64_t replay_start_ns = clock_now_ns();
 
     while (!WindowShouldClose()) {
-        UpdateMusicStream(music);
+        // includes EndDrawing, hence the vsync wait
+        TRACE_SCOPE(TRACE_FRAME);
+
+        const uint64_t frames_before = analyzer.frames;
+        const uint64_t analysis_start_ns = clock_now_ns();
+        SizeType processed = 0;
+        if (replaying) {
+            processed =
+                args.replay_fast
+                    ? replay_blocks(&replayer, &analyzer, UINT64_MAX,
+                                    FAST_REPLAY_BLOCKS_PER_FRAME)
+                    : replay_blocks(&replayer, &analyzer,
+                                    clock_now_ns() - replay_start_ns,
+                                    UINT32_MAX);
+        } else {
+            if (!args.live) {
+                UpdateMusicStream(music);
+            }
 
-        // pull samples from queue and push onto its history
-        const SizeType processed = fft_analyzer_update(&analyzer);
-        linear_spectrogram_update(&spectrogram, &analyzer.history, processed);
+            // pull samples from queue and push onto its history, as many
+            // as the budget affords
+            processed = fft_analyzer_update_until(
+                &analyzer, frame_scheduler_analysis_deadline(
+                               &scheduler, analysis_start_ns));
+
+            if (recorder != NULL && !capture_recorder_drain(recorder)) {
+                printf("Failed to write capture %s\n", args.record_path);
+                attach_capture_recorder(NULL);
+                capture_recorder_free(recorder);
+                recorder = NULL;
+            }
+        }
+        if (cache != NULL &&
+            !cache_writer_push_history(cache, &analyzer.history, processed)) {
+            printf("Failed to write cache %s\n", args.cache_path);
+            cache_writer_free(cache);
+            cache = NULL;
+        }
+        if (snapshotter != NULL &&
+            !snapshotter_push_history(snapshotter, &analyzer.history,
+                                      processed)) {
+            printf("oom, snapshots stop here\n");
+            snapshotter_free(snapshotter);
+            snapshotter = NULL;
+        }
+        if (args.partials) {
+            partial_tracker_push_history(&partials, &analyzer.history,
+                                         processed, analyzer.phase_rows);
+        }
+        latency_tracker_on_analyzed(
+            latency, (SizeType)(analyzer.frames - frames_before), processed,
+            analyzer.merged);
+
+        const uint64_t columns_start_ns = clock_now_ns();
+        frame_scheduler_on_analyzed(&scheduler, processed,
+                                    analyzer.history.cap,
+                                    columns_start_ns - analysis_start_ns);
+        linear_spectrogram_catch_up(&spectrogram, &analyzer.history,
+                                    scheduler.behind, scheduler.columns);
+        const SizeType uploaded = scheduler.columns;
+        frame_scheduler_on_columns(&scheduler,
+                                   clock_now_ns() - columns_start_ns);
+        latency_tracker_on_columns(latency, uploaded, scheduler.behind);
+        if (scheduler.merge != analyzer.merge) {
+            fft_analyzer_set_merge(&analyzer, scheduler.merge, args.pooling);
+        }
+        if (args.zoom) {
+            linear_spectrogram_update(&zoom_spectrogram, &zoom.history,
+                                      zoom_analyzer_take_new(&zoom));
+        }
 
         {
             BeginDrawing();
             ClearBackground(BACKGROUND_COLOR);
-            linear_spectrogram_render_wrap(&spectrogram, &analyzer.history);
+            linear_spectrogram_render_wrap(&spectrogram, &analyzer.history,
+                                           scheduler.behind);
+            if (args.zoom) {
+                linear_spectrogram_render_wrap(&zoom_spectrogram,
+                                               &zoom.history, 0);
+                DrawText(TextFormat("%.1f - %.1f Hz, %.2f Hz resolution",
+                                    (double)args.zoom_lo,
+                                    (double)args.zoom_hi,
+                                    (double)args.zoom_resolution),
+                         (int)zoom_panel.x + 10, (int)zoom_panel.y + 10, 10,
+                         TEXT_COLOR);
+            }
+            if (args.waveform_seconds > 0.0f) {
+                waveform_vis_render(&waveform_vis, &waveform);
+            }
+            if (args.n_tones > 0) {
+                tone_overlay_render(&tone_overlay, &tones);
+            }
+            if (args.partials) {
+                partial_overlay_render(&partial_overlay, &partials,
+                                       &analyzer.history);
+            }
+            if (args.pitch) {
+                pitch_overlay_render(&pitch_overlay, &analyzer.pitch.f0,
+                                     &analyzer.pitch.clarity);
+            }
+            if (args.stereo) {
+                stereo_overlay_render(&stereo_overlay, &analyzer.stereo);
+            }
+            if (show_latency) {
+                draw_latency_report(latency_tracker_report(latency),
+                                    (Vector2){10, WINDOW_HEIGHT - 80});
+            }
+#if defined(SPECTRE_TRACE)
+            trace_overlay_render(&trace_overlay);
+#endif
             EndDrawing();
         }
+        latency_tracker_on_present(latency);
+
+        if (IsKeyPressed(KEY_L)) {
+            show_latency = !show_latency;
+        }
+        if (IsKeyPressed(KEY_F)) {
+            tone_overlay_toggle(&tone_overlay);
+        }
+        if (IsKeyPressed(KEY_P)) {
+            pitch_overlay_toggle(&pitch_overlay);
+        }
+        if (IsKeyPressed(KEY_K)) {
+            partial_overlay_toggle(&partial_overlay);
+        }
+        if (IsKeyPressed(KEY_C)) {
+            stereo_overlay_toggle(&stereo_overlay);
+        }
+        // S: the rows on screen, A: everything kept
+        const bool snapshot_screen = IsKeyPressed(KEY_S);
+        if (snapshotter != NULL && !exporting &&
+            (snapshot_screen || IsKeyPressed(KEY_A))) {
+            numbered_path(snapshot_file, sizeof(snapshot_file),
+                          args.snapshot_path, ++n_snapshots);
+            exporting = snapshotter_export(
+                snapshotter, snapshot_file,
+                snapshot_format_for_path(args.snapshot_path),
+                snapshot_screen ? analyzer.history.len : 0);
+        }
+        if (exporting && snapshotter_status(snapshotter) != SNAPSHOT_RUNNING) {
+            printf(snapshotter_status(snapshotter) == SNAPSHOT_DONE
+                       ? "snapshot written to %s\n"
+                       : "failed to write snapshot %s\n",
+                   snapshot_file);
+            exporting = false;
+        }
+        const float wheel = GetMouseWheelMove();
+        if (wheel != 0.0f && args.waveform_seconds > 0.0f &&
+            CheckCollisionPointRec(GetMousePosition(), waveform_panel)) {
+            waveform_vis_zoom(&waveform_vis, wheel > 0.0f ? 0.5f : 2.0f);
+        }
+
+#if defined(SPECTRE_TRACE)
+        if (IsKeyPressed(KEY_T)) {
+            export_trace();
+        }
+        if (IsKeyPressed(KEY_O)) {
+            trace_overlay_toggle(&trace_overlay);
+        }
+#endif
     }
 
+#if defined(SPECTRE_TRACE)
+    export_trace();
+#endif
+
+    cache_writer_free(cache);
+    snapshotter_free(snapshotter);
     fft_analyzer_free(&analyzer);
+    tone_bank_free(&tones);
+    pitch_overlay_free(&pitch_overlay);
+    partial_tracker_free(&partials);
+    waveform_vis_destroy(&waveform_vis);
+    waveform_pyramid_free(&waveform);
+    if (args.zoom) {
+        linear_spectrogram_destroy(&zoom_spectrogram);
+    }
+    zoom_analyzer_free(&zoom);
     linear_spectrogram_destroy(&spectrogram);
     deinit_audio_processor();
-    UnloadMusicStream(music);
-    CloseAudioDevice();
+    if (replaying) {
+        capture_replayer_free(&replayer);
+    } else {
+        if (args.live) {
+            live_input_free(input);
+        } else {
+            UnloadMusicStream(music);
+            CloseAudioDevice();
+        }
+        // the audio thread is gone, nothing can be pushing anymore
+        capture_recorder_free(recorder);
+    }
+    latency_tracker_free(latency);
+    if (latency_log != NULL) {
+        fclose(latency_log);
+    }
     free(sample_queue);
+    free(side_queue);
     CloseWindow();
 }
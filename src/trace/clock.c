@@ -0,0 +1,13 @@
+// clock_gettime is POSIX, not C11
+#define _POSIX_C_SOURCE 199309L
+
+#include "clock.h"
+
+#include <time.h>
+
+uint64_t clock_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
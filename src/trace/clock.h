@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stdint.h>
+
+// monotonic clock, in nanoseconds since some unspecified origin
+//
+// on Linux and macOS this is a vDSO/commpage read, i.e. no syscall and in the
+// order of 20 ns, cheap enough to be called from the audio thread
+uint64_t clock_now_ns(void);
@@ -0,0 +1,252 @@
+#include "trace.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_MAX_THREADS 8
+#define TRACE_RING_SIZE (1u << 14)  // events per thread, power of 2
+#define TRACE_RING_MASK (TRACE_RING_SIZE - 1)
+#define TRACE_STATS_WINDOW 2048     // most recent events looked at per thread
+
+// stage in the top 16 bits, duration in ns in the bottom 48
+#define TRACE_DURATION_MASK ((1ull << 48) - 1)
+
+typedef struct {
+    _Atomic uint64_t begin_ns;
+    _Atomic uint64_t stage_duration;
+} TraceEvent;
+
+typedef struct {
+    _Atomic uint64_t written;  // monotonic, only ever stored by the owner
+    const char* _Atomic name;
+    TraceEvent events[TRACE_RING_SIZE];
+} TraceRing;
+
+static TraceRing s_rings[TRACE_MAX_THREADS];
+static atomic_uint s_n_rings = 0;
+
+static _Thread_local TraceRing* t_ring = NULL;
+
+static const char* const s_stage_names[TRACE_STAGE_COUNT] = {
+    [TRACE_FRAME] = "frame",
+    [TRACE_AUDIO_CALLBACK] = "audio_callback",
+    [TRACE_QUEUE_POP] = "clfq_pop",
+    [TRACE_DECIMATE] = "resampler_process",
+    [TRACE_DC_BLOCKER] = "dc_blocker",
+    [TRACE_PITCH] = "pitch_tracker_process",
+    [TRACE_WINDOW] = "window_apply",
+    [TRACE_FFT] = "kiss_fftr",
+    [TRACE_FEATURES] = "spectral_features_process",
+    [TRACE_STEREO] = "stereo_meter_process",
+    [TRACE_HISTORY_PUSH] = "fft_history_push",
+    [TRACE_REMAP] = "sparse_rows_apply",
+    [TRACE_COLOR] = "color",
+    [TRACE_UPLOAD] = "UpdateTextureRec",
+    [TRACE_DRAW] = "DrawTexturePro",
+};
+
+const char* trace_stage_name(TraceStage stage)
+{
+    return (stage < TRACE_STAGE_COUNT) ? s_stage_names[stage] : "unknown";
+}
+
+// NULL once all the rings are claimed, spans from extra threads are dropped.
+// The count stops at TRACE_MAX_THREADS: threads that come back for a ring on
+// every span would otherwise wrap it around and claim rings already in use
+static TraceRing* trace_this_thread_ring(void)
+{
+    if (t_ring == NULL) {
+        unsigned idx = atomic_load_explicit(&s_n_rings, memory_order_relaxed);
+        do {
+            if (idx >= TRACE_MAX_THREADS) {
+                return NULL;
+            }
+        } while (!atomic_compare_exchange_weak_explicit(
+            &s_n_rings, &idx, idx + 1, memory_order_relaxed,
+            memory_order_relaxed));
+        t_ring = &s_rings[idx];
+    }
+    return t_ring;
+}
+
+void trace_record(TraceStage stage, uint64_t begin_ns, uint64_t end_ns)
+{
+    TraceRing* ring = trace_this_thread_ring();
+    if (ring == NULL) {
+        return;
+    }
+
+    const uint64_t w =
+        atomic_load_explicit(&ring->written, memory_order_relaxed);
+    TraceEvent* e = &ring->events[w & TRACE_RING_MASK];
+
+    const uint64_t duration = (end_ns - begin_ns) & TRACE_DURATION_MASK;
+    atomic_store_explicit(&e->begin_ns, begin_ns, memory_order_relaxed);
+    atomic_store_explicit(&e->stage_duration,
+                          ((uint64_t)stage << 48) | duration,
+                          memory_order_relaxed);
+
+    atomic_store_explicit(&ring->written, w + 1, memory_order_release);
+}
+
+void trace_thread_name(const char* name)
+{
+    TraceRing* ring = trace_this_thread_ring();
+    if (ring == NULL) {
+        return;
+    }
+    atomic_store_explicit(&ring->name, name, memory_order_relaxed);
+}
+
+static SizeType trace_ring_count(void)
+{
+    const unsigned n = atomic_load_explicit(&s_n_rings, memory_order_acquire);
+    return n < TRACE_MAX_THREADS ? n : TRACE_MAX_THREADS;
+}
+
+typedef struct {
+    uint64_t begin_ns;
+    uint64_t duration_ns;
+    TraceStage stage;
+} TraceSpan;
+
+// copies up to `max` of the most recent spans of a ring, oldest first
+// returns the number of spans copied
+//
+// the writer may lap us while we copy: events are re-validated against the
+// write counter afterwards and the ones that may have been clobbered dropped
+static SizeType trace_ring_snapshot(TraceRing* ring,
+                                    TraceSpan* out,
+                                    SizeType max)
+{
+    const uint64_t end =
+        atomic_load_explicit(&ring->written, memory_order_acquire);
+    const uint64_t available = end < TRACE_RING_SIZE ? end : TRACE_RING_SIZE;
+    const uint64_t n = available < max ? available : max;
+    const uint64_t start = end - n;
+
+    for (uint64_t i = 0; i < n; ++i) {
+        const TraceEvent* e = &ring->events[(start + i) & TRACE_RING_MASK];
+        const uint64_t packed =
+            atomic_load_explicit(&e->stage_duration, memory_order_relaxed);
+        out[i] = (TraceSpan){
+            .begin_ns =
+                atomic_load_explicit(&e->begin_ns, memory_order_relaxed),
+            .duration_ns = packed & TRACE_DURATION_MASK,
+            .stage = (TraceStage)(packed >> 48),
+        };
+    }
+
+    atomic_thread_fence(memory_order_acquire);
+    const uint64_t end_after =
+        atomic_load_explicit(&ring->written, memory_order_relaxed);
+
+    // the slot of index `end_after` may be being written to right now, which
+    // clobbers index end_after - RING_SIZE: everything up to it is suspect
+    const uint64_t safe_from = (end_after + 1 > TRACE_RING_SIZE)
+                                   ? end_after + 1 - TRACE_RING_SIZE
+                                   : 0;
+    const uint64_t dropped = safe_from > start ? safe_from - start : 0;
+    if (dropped >= n) {
+        return 0;
+    }
+    const SizeType valid = (SizeType)(n - dropped);
+    memmove(out, out + dropped, valid * sizeof(*out));
+    return valid;
+}
+
+bool trace_export_chrome(const char* path)
+{
+    FILE* f = fopen(path, "w");
+    if (f == NULL) {
+        return false;
+    }
+
+    TraceSpan* spans = malloc(TRACE_RING_SIZE * sizeof(*spans));
+    if (spans == NULL) {
+        fclose(f);
+        return false;
+    }
+
+    fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+    bool first = true;
+    const SizeType n_rings = trace_ring_count();
+    for (SizeType r = 0; r < n_rings; ++r) {
+        TraceRing* ring = &s_rings[r];
+
+        const char* name =
+            atomic_load_explicit(&ring->name, memory_order_relaxed);
+        if (name != NULL) {
+            fprintf(f,
+                    "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                    "\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                    first ? "" : ",\n", r, name);
+            first = false;
+        }
+
+        const SizeType n = trace_ring_snapshot(ring, spans, TRACE_RING_SIZE);
+        for (SizeType i = 0; i < n; ++i) {
+            // trace-event timestamps are in (fractional) microseconds
+            fprintf(f,
+                    "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+                    "\"ts\":%.3f,\"dur\":%.3f}",
+                    first ? "" : ",\n", trace_stage_name(spans[i].stage), r,
+                    (double)spans[i].begin_ns * 1e-3,
+                    (double)spans[i].duration_ns * 1e-3);
+            first = false;
+        }
+    }
+
+    fprintf(f, "\n]}\n");
+    free(spans);
+
+    const bool ok = !ferror(f);
+    return (fclose(f) == 0) && ok;
+}
+
+static int compare_u64(const void* a, const void* b)
+{
+    const uint64_t x = *(const uint64_t*)a;
+    const uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static float percentile_us(const uint64_t* sorted, SizeType n, float p)
+{
+    const SizeType i = (SizeType)(p * (float)(n - 1) + 0.5f);
+    return (float)sorted[i] * 1e-3f;
+}
+
+void trace_stage_stats(TraceStageStats stats[TRACE_STAGE_COUNT])
+{
+    enum { CAP = TRACE_MAX_THREADS * TRACE_STATS_WINDOW };
+    static TraceSpan spans[TRACE_STATS_WINDOW];
+    static uint64_t durations[TRACE_STAGE_COUNT][CAP];
+    SizeType counts[TRACE_STAGE_COUNT] = {0};
+
+    const SizeType n_rings = trace_ring_count();
+    for (SizeType r = 0; r < n_rings; ++r) {
+        const SizeType n =
+            trace_ring_snapshot(&s_rings[r], spans, TRACE_STATS_WINDOW);
+        for (SizeType i = 0; i < n; ++i) {
+            const TraceStage s = spans[i].stage;
+            if (s < TRACE_STAGE_COUNT) {
+                durations[s][counts[s]++] = spans[i].duration_ns;
+            }
+        }
+    }
+
+    for (SizeType s = 0; s < TRACE_STAGE_COUNT; ++s) {
+        const SizeType n = counts[s];
+        stats[s] = (TraceStageStats){.count = n};
+        if (n == 0) {
+            continue;
+        }
+        qsort(durations[s], n, sizeof(uint64_t), compare_u64);
+        stats[s].p50_us = percentile_us(durations[s], n, 0.50f);
+        stats[s].p99_us = percentile_us(durations[s], n, 0.99f);
+    }
+}
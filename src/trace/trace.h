@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "core/definitions.h"
+
+// per-stage tracing
+//
+// every thread that records a span gets its own single-producer ring, so the
+// hot path is two clock reads and two relaxed stores, no locks, no CAS
+//
+// readers (the exporter and the overlay stats) may run concurrently with the
+// writers: they only look at the events that cannot have been overwritten
+// while they were reading them
+//
+// everything below the API compiles away unless SPECTRE_TRACE is defined,
+// see the SPECTRE_TRACE CMake option
+
+typedef enum {
+    TRACE_FRAME,
+    TRACE_AUDIO_CALLBACK,
+    TRACE_QUEUE_POP,
+    TRACE_DECIMATE,
+    TRACE_DC_BLOCKER,
+    TRACE_PITCH,
+    TRACE_WINDOW,
+    TRACE_FFT,
+    TRACE_FEATURES,
+    TRACE_STEREO,
+    TRACE_HISTORY_PUSH,
+    TRACE_REMAP,
+    TRACE_COLOR,
+    TRACE_UPLOAD,
+    TRACE_DRAW,
+    TRACE_STAGE_COUNT,
+} TraceStage;
+
+const char* trace_stage_name(TraceStage stage);
+
+// records a finished span on the calling thread's ring
+void trace_record(TraceStage stage, uint64_t begin_ns, uint64_t end_ns);
+
+// names the calling thread in the exported trace, optional
+void trace_thread_name(const char* name);
+
+// Chrome/Perfetto trace-event JSON, loadable in chrome://tracing or
+// ui.perfetto.dev. returns false if the file could not be written
+bool trace_export_chrome(const char* path);
+
+typedef struct {
+    SizeType count;  // number of spans the percentiles are computed over
+    float p50_us;
+    float p99_us;
+} TraceStageStats;
+
+// percentiles over the most recent spans of each stage
+// uses static scratch space: call it from a single thread, e.g. the main one
+void trace_stage_stats(TraceStageStats stats[TRACE_STAGE_COUNT]);
+
+#if defined(SPECTRE_TRACE)
+
+#include "trace/clock.h"
+
+typedef struct {
+    TraceStage stage;
+    uint64_t begin_ns;
+} TraceScope;
+
+static inline TraceScope trace_scope_begin(TraceStage stage)
+{
+    return (TraceScope){.stage = stage, .begin_ns = clock_now_ns()};
+}
+
+static inline void trace_scope_end(const TraceScope* scope)
+{
+    trace_record(scope->stage, scope->begin_ns, clock_now_ns());
+}
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+// times everything from here to the end of the enclosing block
+#define TRACE_SCOPE(stage)                                              \
+    __attribute__((cleanup(trace_scope_end))) const TraceScope         \
+        TRACE_CONCAT(trace_scope_, __LINE__) = trace_scope_begin(stage)
+
+#define TRACE_THREAD_NAME(name) trace_thread_name(name)
+
+#else
+
+#define TRACE_SCOPE(stage) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+
+#endif
@@ -0,0 +1,162 @@
+#include "offline.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "LockFreeQueue.h"
+
+#define DR_WAV_IMPLEMENTATION
+#include "dr_wav.h"
+
+static bool str_ends_with(const char* s, const char* suffix)
+{
+    if (strlen(suffix) > strlen(s)) {
+        return false;
+    }
+
+    const char* s_suffix = s + strlen(s) - strlen(suffix);
+
+    return (strcmp(s_suffix, suffix) == 0);
+}
+
+MonoAudioBuffer decode_wav_or_exit(const char* path)
+{
+    if (!str_ends_with(path, ".wav")) {
+        fprintf(stderr, "Not a wav file\n");
+        exit(1);
+    }
+
+    drwav decoder;
+    if (!drwav_init_file(&decoder, path, NULL)) {
+        fprintf(stderr, "drwav: failed to init wav decoder from file %s\n",
+                path);
+        exit(1);
+    }
+
+    uint32_t channels = decoder.channels;
+    uint64_t frames = decoder.totalPCMFrameCount;
+    if (frames == 0) {
+        fprintf(stderr, "empty wav file\n");
+        exit(1);
+    }
+    if (channels == 0) {
+        fprintf(stderr, "invalid channel layout: somehow no channels\n");
+        exit(1);
+    }
+
+    float* interleaved = calloc(channels * frames, sizeof(float));
+    if (interleaved == NULL) {
+        fprintf(stderr, "oom\n");
+        exit(1);
+    }
+    drwav_read_pcm_frames_f32(&decoder, frames, interleaved);
+    drwav_uninit(&decoder);
+
+    float* mono = calloc(frames, sizeof(float));
+    if (mono == NULL) {
+        fprintf(stderr, "oom\n");
+        exit(1);
+    }
+
+    const float gain = 1.0f / (float)channels;
+    for (uint64_t i = 0; i < frames; ++i) {
+        float sample = 0.0f;
+        for (uint32_t c = 0; c < channels; ++c) {
+            sample += interleaved[channels * i + c];
+        }
+
+        mono[i] = gain * sample;
+    }
+    free(interleaved);
+
+    return (MonoAudioBuffer){
+        .samples = mono,
+        .sample_rate = decoder.sampleRate,
+        .size = decoder.totalPCMFrameCount,
+    };
+}
+
+void mono_audio_free(MonoAudioBuffer* audio)
+{
+    if (!audio) {
+        return;
+    }
+
+    free(audio->samples);
+    audio->samples = NULL;
+}
+
+typedef struct {
+    OfflineRowFn on_row;
+    void* ctx;
+} RowForwarder;
+
+static void forward_new_rows(const FFTAnalyzer* analyzer,
+                             SizeType n,
+                             void* ctx)
+{
+    const RowForwarder* fwd = ctx;
+    const FFTHistory* h = &analyzer->history;
+
+    n = (n >= h->cap) ? h->cap : n;
+    const SizeType start = (h->tail - n + h->cap) % h->cap;
+
+    for (SizeType i = 0; i < n; i++) {
+        fwd->on_row(fft_history_get_row(h, (start + i) % h->cap), h->n_bins,
+                    fwd->ctx);
+    }
+}
+
+uint64_t offline_analyze(const MonoAudioBuffer* audio,
+                         const FFTConfig* cfg,
+                         OfflineRowFn on_row,
+                         void* ctx)
+{
+    RowForwarder fwd = {.on_row = on_row, .ctx = ctx};
+    return offline_analyze_frames(audio, cfg, forward_new_rows, &fwd);
+}
+
+uint64_t offline_analyze_frames(const MonoAudioBuffer* audio,
+                                const FFTConfig* cfg,
+                                OfflineFramesFn on_frames,
+                                void* ctx)
+{
+    LockFreeQueue* queue = malloc(sizeof(*queue));
+    if (queue == NULL) {
+        fprintf(stderr, "oom\n");
+        exit(1);
+    }
+    clfq_new(queue);
+    LockFreeQueueProducer tx = clfq_producer(queue);
+
+    FFTAnalyzer analyzer = fft_analyzer_new(cfg, clfq_consumer(queue));
+    if (!fft_analyzer_ok(&analyzer)) {
+        fprintf(stderr, "oom\n");
+        exit(1);
+    }
+
+    // one stride at a time: the analyzer drains the queue after every push,
+    // frames split across threads included
+    uint64_t frames = 0;
+    uint64_t cursor = 0;
+    while (cursor < audio->size) {
+        const uint64_t left = audio->size - cursor;
+        const SizeType chunk =
+            (left < cfg->stride) ? (SizeType)left : cfg->stride;
+
+        cursor += clfq_push_partial(&tx, audio->samples + cursor, chunk, 1);
+
+        const SizeType n = fft_analyzer_flush(&analyzer);
+        if (n > 0) {
+            on_frames(&analyzer, n, ctx);
+        }
+        frames += n;
+    }
+
+    fft_analyzer_free(&analyzer);
+    free(queue);
+
+    return frames;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "FFTAnalyzer.h"
+#include "core/definitions.h"
+
+// the offline analysis path shared by the test tools: decode a file, then
+// push it through the sample queue and the analyzer as fast as possible
+
+typedef struct {
+    float* samples;
+    uint32_t sample_rate;
+    uint64_t size;
+} MonoAudioBuffer;
+
+// sloppy ressource management; shouldn't matter here
+MonoAudioBuffer decode_wav_or_exit(const char* path);
+void mono_audio_free(MonoAudioBuffer* audio);
+
+// called once per analyzed frame, bins as pushed onto the history
+typedef void (*OfflineRowFn)(const Complex* bins, SizeType n_bins, void* ctx);
+
+// cfg->stride must fit in the sample queue
+// returns the number of analyzed frames
+uint64_t offline_analyze(const MonoAudioBuffer* audio,
+                         const FFTConfig* cfg,
+                         OfflineRowFn on_row,
+                         void* ctx);
+
+// called after every analyzer update that produced frames, the n newest
+// entries of its histories are new
+typedef void (*OfflineFramesFn)(const FFTAnalyzer* analyzer,
+                                SizeType n,
+                                void* ctx);
+
+// same as offline_analyze, for callers that want more than the bins
+uint64_t offline_analyze_frames(const MonoAudioBuffer* audio,
+                                const FFTConfig* cfg,
+                                OfflineFramesFn on_frames,
+                                void* ctx);
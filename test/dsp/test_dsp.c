@@ -1,9 +1,37 @@
 #include "unity.h"
 
+#include "kiss_fftr.h"
+
+#include "FFTAnalyzer.h"
+#include "FrameScheduler.h"
+#include "LatencyTracker.h"
+#include "cache/CacheReader.h"
+#include "cache/CacheWriter.h"
+#include "cache/Snapshotter.h"
+#include "core/arena.h"
+#include "core/frequency_axis.h"
+#include "core/sparse.h"
+#include "core/waveform.h"
+#include "dsp/biquad.h"
+#include "dsp/czt.h"
 #include "dsp/filters.h"
+#include "dsp/large_fft.h"
+#include "dsp/loudness.h"
+#include "dsp/mel.h"
+#include "dsp/partials.h"
+#include "dsp/pitch.h"
+#include "dsp/resample.h"
+#include "dsp/sliding.h"
+#include "dsp/spectral_features.h"
+#include "dsp/stereo.h"
+#include "dsp/tone_bank.h"
 #include "dsp/window.h"
 
 #include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 void setUp(void) {}
 void tearDown(void) {}
@@ -118,6 +146,1765 @@ void test_filter_hpf_removes_dc_from_mixed_signal(void)
     TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.0f, mean);
 }
 
+void test_sliding_sum_matches_direct_sum(void)
+{
+    // push well past several renormalizations and compare against summing
+    // the last `size` values directly
+    enum { SIZE = 100, PUSHES = 1037 };
+
+    SlidingSum s = sliding_sum_new(SIZE);
+    TEST_ASSERT_TRUE(sliding_sum_ok(&s));
+
+    float values[PUSHES];
+    for (SizeType i = 0; i < PUSHES; ++i) {
+        values[i] = sinf(0.37f * (float)i) + 0.5f;
+        sliding_sum_push(&s, values[i]);
+    }
+
+    float expected = 0.0f;
+    for (SizeType i = PUSHES - SIZE; i < PUSHES; ++i) {
+        expected += values[i];
+    }
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, expected, s.sum);
+    sliding_sum_free(&s);
+}
+
+void test_loudness_full_scale_1k_sine_reads_minus_3_lufs(void)
+{
+    // BS.1770 calibration: a 0 dBFS 997 Hz sine in one channel is -3.01 LUFS
+    const float fs = 48000.0f;
+    const SizeType n = (SizeType)(4.0f * fs);
+
+    float* x = malloc(n * sizeof(float));
+    TEST_ASSERT_NOT_NULL(x);
+    for (SizeType i = 0; i < n; ++i) {
+        x[i] = sinf(2.0f * PI * 997.0f * (float)i / fs);
+    }
+
+    LoudnessMeter m = loudness_meter_new(fs, 1024);
+    TEST_ASSERT_TRUE(loudness_meter_ok(&m));
+    const LoudnessReading r = loudness_meter_process(&m, x, n);
+
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, -3.01f, r.momentary);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, -3.01f, r.short_term);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 1.0f / sqrtf(2.0f), r.rms);
+
+    loudness_meter_free(&m);
+    free(x);
+}
+
+void test_true_peak_finds_intersample_peak(void)
+{
+    // fs/4 sine offset by 45 degrees: every sample lands at +-0.707, the
+    // crests fall exactly between them
+    enum { N = 4096 };
+
+    float x[N];
+    for (SizeType i = 0; i < N; ++i) {
+        x[i] = sinf(0.5f * PI * (float)i + 0.25f * PI);
+    }
+
+    LoudnessMeter m = loudness_meter_new(48000.0f, 1024);
+    TEST_ASSERT_TRUE(loudness_meter_ok(&m));
+    const LoudnessReading r = loudness_meter_process(&m, x, N);
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 1.0f / sqrtf(2.0f), r.sample_peak);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 1.0f, r.true_peak);
+
+    loudness_meter_free(&m);
+}
+
+// steady-state gain of a scalar cascade at f, ratio of output to input rms
+// over whole periods once the transient is gone
+static float cascade_gain_at(const BiquadCoeffs* sections,
+                             SizeType n_sections,
+                             float f,
+                             float fs)
+{
+    enum { N = 1 << 15 };
+    static float x[N];
+
+    for (SizeType i = 0; i < N; ++i) {
+        x[i] = sinf(2.0f * PI * f * (float)i / fs);
+    }
+    for (SizeType s = 0; s < n_sections; ++s) {
+        Biquad b = biquad_init(sections[s]);
+        biquad_process(&b, x, x, N);
+    }
+
+    const SizeType period = (SizeType)lroundf(fs / f);
+    const SizeType periods = (N / 2) / period;
+    float sum = 0.0f;
+    for (SizeType i = N - periods * period; i < N; ++i) {
+        sum += x[i] * x[i];
+    }
+
+    return sqrtf(sum / (float)(periods * period)) * sqrtf(2.0f);
+}
+
+static float to_db(float gain)
+{
+    return 20.0f * log10f(gain);
+}
+
+void test_butterworth_lowpass_response(void)
+{
+    // -3 dB at the cutoff, flat in the passband, 24 dB/octave per order 4
+    const float fs = 48000.0f;
+    const float fc = 1000.0f;
+
+    BiquadCoeffs sections[BUTTERWORTH_MAX_ORDER];
+    const SizeType n = biquad_butterworth(sections, 4, false, fc, fs);
+    TEST_ASSERT_EQUAL_UINT(2, n);
+
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, -3.01f,
+                             to_db(cascade_gain_at(sections, n, fc, fs)));
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.0f,
+                             to_db(cascade_gain_at(sections, n, 100.0f, fs)));
+    TEST_ASSERT_LESS_THAN_FLOAT(
+        -70.0f, to_db(cascade_gain_at(sections, n, 8000.0f, fs)));
+}
+
+void test_butterworth_odd_order_highpass(void)
+{
+    const float fs = 48000.0f;
+    const float fc = 200.0f;
+
+    BiquadCoeffs sections[BUTTERWORTH_MAX_ORDER];
+    const SizeType n = biquad_butterworth(sections, 3, true, fc, fs);
+    TEST_ASSERT_EQUAL_UINT(2, n);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, sections[1].a2);
+
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, -3.01f,
+                             to_db(cascade_gain_at(sections, n, fc, fs)));
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.0f,
+                             to_db(cascade_gain_at(sections, n, 4000.0f, fs)));
+}
+
+void test_rbj_peak_hits_its_gain(void)
+{
+    const float fs = 48000.0f;
+    const BiquadCoeffs peak = biquad_rbj(BIQUAD_PEAK, 2000.0f, 2.0f, 6.0f, fs);
+
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 6.0f,
+                             to_db(cascade_gain_at(&peak, 1, 2000.0f, fs)));
+}
+
+void test_biquad_bank_lanes_match_scalar(void)
+{
+    // each lane gets its own cascade and its own input, the interleaved
+    // output must match running the scalar filters one lane at a time
+    enum { FRAMES = 1000 };
+    const float fs = 48000.0f;
+
+    BiquadBank bank = biquad_bank_new();
+    BiquadCoeffs lanes[BIQUAD_LANES][BUTTERWORTH_MAX_ORDER];
+    SizeType n_sections[BIQUAD_LANES];
+    for (SizeType lane = 0; lane < BIQUAD_LANES; ++lane) {
+        const SizeType order = 1 + lane % 5;
+        n_sections[lane] = biquad_butterworth(
+            lanes[lane], order, lane % 2, 300.0f * (float)(lane + 1), fs);
+        TEST_ASSERT_TRUE(biquad_bank_set_lane(&bank, lane, lanes[lane],
+                                              n_sections[lane]));
+    }
+
+    static float interleaved[FRAMES * BIQUAD_LANES];
+    static float scalar[BIQUAD_LANES][FRAMES];
+    for (SizeType i = 0; i < FRAMES; ++i) {
+        for (SizeType lane = 0; lane < BIQUAD_LANES; ++lane) {
+            const float x = sinf(0.01f * (float)((lane + 1) * i)) +
+                            ((i * 7919 + lane) % 13 == 0 ? 0.5f : 0.0f);
+            interleaved[i * BIQUAD_LANES + lane] = x;
+            scalar[lane][i] = x;
+        }
+    }
+
+    biquad_bank_process(&bank, interleaved, interleaved, FRAMES);
+
+    for (SizeType lane = 0; lane < BIQUAD_LANES; ++lane) {
+        for (SizeType s = 0; s < n_sections[lane]; ++s) {
+            Biquad b = biquad_init(lanes[lane][s]);
+            biquad_process(&b, scalar[lane], scalar[lane], FRAMES);
+        }
+        for (SizeType i = 0; i < FRAMES; ++i) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-5f, scalar[lane][i],
+                                     interleaved[i * BIQUAD_LANES + lane]);
+        }
+    }
+}
+
+void test_biquad_bank_split_feeds_every_lane(void)
+{
+    enum { FRAMES = 256 };
+
+    BiquadBank bank = biquad_bank_new();
+    const BiquadCoeffs half = {.b0 = 0.5f};
+    TEST_ASSERT_TRUE(biquad_bank_set_lane(&bank, 3, &half, 1));
+    TEST_ASSERT_FALSE(biquad_bank_set_lane(&bank, BIQUAD_LANES, &half, 1));
+
+    float in[FRAMES];
+    static float out[FRAMES * BIQUAD_LANES];
+    for (SizeType i = 0; i < FRAMES; ++i) {
+        in[i] = (float)i;
+    }
+
+    biquad_bank_process_split(&bank, in, out, FRAMES);
+
+    for (SizeType i = 0; i < FRAMES; ++i) {
+        for (SizeType lane = 0; lane < BIQUAD_LANES; ++lane) {
+            const float expected = lane == 3 ? 0.5f * in[i] : in[i];
+            TEST_ASSERT_EQUAL_FLOAT(expected, out[i * BIQUAD_LANES + lane]);
+        }
+    }
+}
+
+void test_biquad_state_decays_to_exact_zero(void)
+{
+    // a resonant low-pass rings for a long time after an impulse; the tail
+    // must be flushed rather than left to decay through denormals
+    enum { BLOCK = 512, BLOCKS = 200 };
+
+    Biquad b = biquad_init(biquad_rbj(BIQUAD_LOWPASS, 100.0f, 4.0f, 0.0f,
+                                      48000.0f));
+    float x[BLOCK] = {1.0f};
+    for (SizeType k = 0; k < BLOCKS; ++k) {
+        biquad_process(&b, x, x, BLOCK);
+        memset(x, 0, sizeof(x));
+    }
+
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, b.s1);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, b.s2);
+}
+
+static float rms_of(const float* x, SizeType n)
+{
+    float sum = 0.0f;
+    for (SizeType i = 0; i < n; ++i) {
+        sum += x[i] * x[i];
+    }
+    return sqrtf(sum / (float)n);
+}
+
+void test_decimator_keeps_passband_and_rejects_aliases(void)
+{
+    // 192 kHz -> 48 kHz: a 1 kHz tone passes untouched, a 30 kHz tone would
+    // fold to 18 kHz and must be gone instead; the tones are generated in
+    // double, sinf of a large phase has a noise floor around -70 dB itself
+    enum { N = 192000 / 4, SETTLE = 1024 };
+    const double fs = 192000.0;
+
+    static float in[N];
+    static float out[N];
+
+    Resampler rs = resampler_new(1, 4, 1024);
+    TEST_ASSERT_TRUE(resampler_ok(&rs));
+
+    for (SizeType i = 0; i < N; ++i) {
+        in[i] = (float)sin(2.0 * (double)PI * 1000.0 * (double)i / fs);
+    }
+    const SizeType n_pass = resampler_process(&rs, in, N, out);
+    TEST_ASSERT_EQUAL_UINT(N / 4, n_pass);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f / sqrtf(2.0f),
+                             rms_of(out + SETTLE / 4, n_pass - SETTLE / 4));
+
+    resampler_reset(&rs);
+    for (SizeType i = 0; i < N; ++i) {
+        in[i] = (float)sin(2.0 * (double)PI * 30000.0 * (double)i / fs);
+    }
+    const SizeType n_stop = resampler_process(&rs, in, N, out);
+    TEST_ASSERT_LESS_THAN_FLOAT(
+        -70.0f, 20.0f * log10f(rms_of(out + SETTLE / 4, n_stop - SETTLE / 4)));
+
+    resampler_free(&rs);
+}
+
+void test_resampler_chunking_is_transparent(void)
+{
+    // 2 -> 3, fed in odd-sized pieces smaller and larger than its scratch,
+    // must produce the same stream as a single call
+    enum { N = 3001 };
+
+    static float in[N];
+    static float whole[2 * N];
+    static float pieces[2 * N];
+    for (SizeType i = 0; i < N; ++i) {
+        in[i] = sinf(0.05f * (float)i) + 0.3f * sinf(0.71f * (float)i);
+    }
+
+    Resampler a = resampler_new(3, 2, 4096);
+    Resampler b = resampler_new(6, 4, 100);
+    TEST_ASSERT_TRUE(resampler_ok(&a));
+    TEST_ASSERT_TRUE(resampler_ok(&b));
+    TEST_ASSERT_EQUAL_UINT(3, b.up);
+    TEST_ASSERT_EQUAL_UINT(2, b.down);
+
+    const SizeType n_whole = resampler_process(&a, in, N, whole);
+
+    SizeType n_pieces = 0;
+    for (SizeType offset = 0, chunk = 1; offset < N; chunk = chunk * 3 + 1) {
+        const SizeType size = offset + chunk > N ? N - offset : chunk;
+        const SizeType got =
+            resampler_process(&b, in + offset, size, pieces + n_pieces);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT(resampler_max_output(&b, size), got);
+        n_pieces += got;
+        offset += size;
+    }
+
+    TEST_ASSERT_EQUAL_UINT(n_whole, n_pieces);
+    TEST_ASSERT_UINT_WITHIN(1, N * 3 / 2, n_whole);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(whole, pieces, n_whole);
+
+    resampler_free(&a);
+    resampler_free(&b);
+}
+
+void test_tone_bank_reads_its_tone_and_rejects_others(void)
+{
+    // off-bin frequencies on purpose, the resonators don't care
+    enum { N = 48000 };
+    const float fs = 48000.0f;
+    const float frequencies[] = {1234.5f, 1734.5f, 60.0f};
+
+    ToneBank bank = tone_bank_new(frequencies, 3, 4800, fs);
+    TEST_ASSERT_TRUE(tone_bank_ok(&bank));
+
+    static float x[N];
+    for (SizeType i = 0; i < N; ++i) {
+        x[i] = 0.5f * (float)sin(2.0 * (double)PI * 1234.5 * (double)i /
+                                 (double)fs);
+    }
+    tone_bank_process(&bank, x, N);
+
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, 0.5f, tone_bank_magnitude(&bank, 0));
+    TEST_ASSERT_LESS_THAN_FLOAT(0.005f, tone_bank_magnitude(&bank, 1));
+    TEST_ASSERT_LESS_THAN_FLOAT(0.005f, tone_bank_magnitude(&bank, 2));
+
+    tone_bank_free(&bank);
+}
+
+void test_tone_bank_matches_direct_dtft_after_long_run(void)
+{
+    // the recursion must not drift from the sum it stands for, even after
+    // several seconds of noise
+    enum { WINDOW = 1000, N = 5 * 48000 };
+    const float frequencies[] = {440.0f, 3000.3f, 17000.0f};
+    const double r = 0.99999;  // TONE_BANK_DAMPING
+
+    ToneBank bank = tone_bank_new(frequencies, 3, WINDOW, 48000.0f);
+    TEST_ASSERT_TRUE(tone_bank_ok(&bank));
+
+    static float x[N];
+    uint32_t seed = 12345;
+    for (SizeType i = 0; i < N; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        x[i] = (float)(seed >> 8) / (float)(1u << 24) - 0.5f;
+    }
+    tone_bank_process(&bank, x, N);
+
+    for (SizeType t = 0; t < 3; ++t) {
+        const double w = 2.0 * (double)PI * (double)frequencies[t] / 48000.0;
+        double re = 0.0;
+        double im = 0.0;
+        double weight = 1.0;
+        for (SizeType m = 0; m < WINDOW; ++m) {
+            re += weight * cos(w * (double)m) * (double)x[N - 1 - m];
+            im += weight * sin(w * (double)m) * (double)x[N - 1 - m];
+            weight *= r;
+        }
+        const float expected = bank.gain * (float)sqrt(re * re + im * im);
+
+        TEST_ASSERT_FLOAT_WITHIN(1e-4f, expected,
+                                 tone_bank_magnitude(&bank, t));
+    }
+
+    tone_bank_free(&bank);
+}
+
+void test_czt_over_the_full_band_is_the_dft(void)
+{
+    // N/2 + 1 points from 0 to Nyquist land exactly on the DFT bins
+    enum { N = 1000 };
+    const float fs = 8000.0f;
+
+    float x[N];
+    for (SizeType i = 0; i < N; ++i) {
+        x[i] = sinf(0.3f * (float)i) + 0.25f * cosf(1.7f * (float)i + 0.4f);
+    }
+
+    kiss_fftr_cfg plan = kiss_fftr_alloc(N, 0, NULL, NULL);
+    static kiss_fft_cpx reference[N / 2 + 1];
+    kiss_fftr(plan, x, reference);
+    kiss_fftr_free(plan);
+
+    CZT czt = czt_new(N, N / 2 + 1, 0.0f, 0.5f * fs, fs);
+    TEST_ASSERT_TRUE(czt_ok(&czt));
+    static Complex out[N / 2 + 1];
+    czt_process(&czt, x, out);
+
+    for (SizeType k = 0; k <= N / 2; ++k) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-2f, reference[k].r, crealf(out[k]));
+        TEST_ASSERT_FLOAT_WITHIN(1e-2f, reference[k].i, cimagf(out[k]));
+    }
+
+    czt_free(&czt);
+}
+
+void test_czt_resolves_close_partials_in_a_narrow_band(void)
+{
+    // hum at 60 Hz with a sideband 0.5 Hz away: a 10 s frame zoomed on
+    // 58-62 Hz shows two peaks with a clear dip between them
+    const float fs = 4000.0f;
+    const SizeType n = (SizeType)(10.0f * fs);
+    const SizeType points = 401;  // 0.01 Hz apart
+    const float lo = 58.0f;
+    const float hi = 62.0f;
+
+    float* x = malloc(n * sizeof(float));
+    float* window = malloc(n * sizeof(float));
+    TEST_ASSERT_NOT_NULL(x);
+    TEST_ASSERT_NOT_NULL(window);
+    window_make_hann(window, n);
+    for (SizeType i = 0; i < n; ++i) {
+        const double t = (double)i / (double)fs;
+        x[i] = (float)(sin(2.0 * (double)PI * 60.0 * t) +
+                       0.5 * sin(2.0 * (double)PI * 60.5 * t));
+    }
+    window_apply(x, window, n);
+
+    CZT czt = czt_new(n, points, lo, hi, fs);
+    TEST_ASSERT_TRUE(czt_ok(&czt));
+    static Complex out[401];
+    czt_process(&czt, x, out);
+
+    const float step = (hi - lo) / (float)(points - 1);
+    const SizeType at_60 = (SizeType)lroundf((60.0f - lo) / step);
+    const SizeType at_60_5 = (SizeType)lroundf((60.5f - lo) / step);
+    const SizeType between = (at_60 + at_60_5) / 2;
+
+    // a full-scale sine under a Hann window peaks at n / 4
+    TEST_ASSERT_FLOAT_WITHIN(0.02f * (float)n, 0.25f * (float)n,
+                             cabsf(out[at_60]));
+    TEST_ASSERT_FLOAT_WITHIN(0.02f * (float)n, 0.125f * (float)n,
+                             cabsf(out[at_60_5]));
+    TEST_ASSERT_LESS_THAN_FLOAT(0.1f * cabsf(out[at_60_5]),
+                                cabsf(out[between]));
+
+    czt_free(&czt);
+    free(window);
+    free(x);
+}
+
+void test_axis_range_round_trips(void)
+{
+    for (SizeType a = 0; a < AXIS_COUNT; ++a) {
+        const AxisRange range = {(FrequencyAxis)a, 20.0f, 20000.0f};
+
+        TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.0f,
+                                 axis_range_position(&range, 20.0f));
+        TEST_ASSERT_FLOAT_WITHIN(1e-4f, 1.0f,
+                                 axis_range_position(&range, 20000.0f));
+        for (float p = 0.0f; p <= 1.0f; p += 0.125f) {
+            const float hz = axis_range_frequency(&range, p);
+            TEST_ASSERT_FLOAT_WITHIN(1e-3f, p,
+                                     axis_range_position(&range, hz));
+        }
+    }
+
+    TEST_ASSERT_EQUAL(AXIS_MEL, frequency_axis_from_name("mel"));
+    TEST_ASSERT_EQUAL(AXIS_COUNT, frequency_axis_from_name("bark"));
+}
+
+void test_axis_remap_rows_are_normalized(void)
+{
+    // every row is a weighted mean, so flat power stays flat on any axis,
+    // whether the row interpolates (bass on log) or pools (treble on log)
+    enum { N_BINS = 1024, N_ROWS = 900 };
+    const float bin_hz = 48000.0f / 2048.0f;
+
+    static float flat[N_BINS];
+    static float rows[N_ROWS];
+    for (SizeType b = 0; b < N_BINS; ++b) {
+        flat[b] = 3.0f;
+    }
+
+    for (SizeType a = 0; a < AXIS_COUNT; ++a) {
+        const AxisRange range =
+            axis_range_for_bins((FrequencyAxis)a, N_BINS, bin_hz);
+        SparseRows remap = axis_remap_new(&range, N_BINS, bin_hz, N_ROWS);
+        TEST_ASSERT_TRUE(sparse_rows_ok(&remap));
+        TEST_ASSERT_EQUAL_UINT(N_ROWS, remap.n_pushed);
+
+        sparse_rows_apply(&remap, flat, rows);
+        for (SizeType r = 0; r < N_ROWS; ++r) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-4f, 3.0f, rows[r]);
+        }
+
+        sparse_rows_free(&remap);
+    }
+}
+
+void test_log_remap_gives_the_bass_more_rows(void)
+{
+    // a single bin lit at ~100 Hz spans many rows on a log axis, and lands
+    // on the row whose frequency it is
+    enum { N_BINS = 1024, N_ROWS = 900 };
+    const float bin_hz = 48000.0f / 2048.0f;
+    const SizeType lit = 3;  // centred on 4 * bin_hz, ~94 Hz
+
+    static float power[N_BINS];
+    static float rows[N_ROWS];
+    power[lit] = 1.0f;
+
+    const AxisRange range = axis_range_for_bins(AXIS_LOG, N_BINS, bin_hz);
+    SparseRows remap = axis_remap_new(&range, N_BINS, bin_hz, N_ROWS);
+    TEST_ASSERT_TRUE(sparse_rows_ok(&remap));
+    sparse_rows_apply(&remap, power, rows);
+
+    SizeType touched = 0;
+    SizeType brightest = 0;
+    for (SizeType r = 0; r < N_ROWS; ++r) {
+        touched += rows[r] > 0.0f;
+        brightest = rows[r] > rows[brightest] ? r : brightest;
+    }
+    TEST_ASSERT_GREATER_THAN_UINT(20, touched);
+
+    const float hz = axis_range_frequency(
+        &range, ((float)brightest + 0.5f) / (float)N_ROWS);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f * bin_hz, (float)(lit + 1) * bin_hz, hz);
+
+    sparse_rows_free(&remap);
+}
+
+void test_max_pooling_keeps_a_narrow_line(void)
+{
+    // 4096 linear bins down to 300 pixel rows: the mean dilutes a single lit
+    // bin by the ~14 bins sharing its row, max keeps it at full strength and
+    // every pooling leaves flat power flat
+    enum { N_BINS = 4096, N_ROWS = 300 };
+    const SizeType lit = 1000;
+
+    static float power[N_BINS];
+    static float flat[N_BINS];
+    static float rows[N_ROWS];
+    power[lit] = 1.0f;
+    for (SizeType b = 0; b < N_BINS; ++b) {
+        flat[b] = 3.0f;
+    }
+
+    const AxisRange range = axis_range_for_bins(AXIS_LINEAR, N_BINS, 1.0f);
+    SparseRows remap = axis_remap_new(&range, N_BINS, 1.0f, N_ROWS);
+    TEST_ASSERT_TRUE(sparse_rows_ok(&remap));
+
+    float peaks[POOL_COUNT];
+    for (SizeType p = 0; p < POOL_COUNT; ++p) {
+        const RowPooling pooling = (RowPooling)p;
+        TEST_ASSERT_EQUAL(pooling,
+                          row_pooling_from_name(row_pooling_name(pooling)));
+
+        sparse_rows_apply_pooled(&remap, pooling, flat, rows);
+        for (SizeType r = 0; r < N_ROWS; ++r) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-4f, 3.0f, rows[r]);
+        }
+
+        sparse_rows_apply_pooled(&remap, pooling, power, rows);
+        peaks[p] = 0.0f;
+        for (SizeType r = 0; r < N_ROWS; ++r) {
+            peaks[p] = rows[r] > peaks[p] ? rows[r] : peaks[p];
+        }
+    }
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 1.0f, peaks[POOL_MAX]);
+    TEST_ASSERT_LESS_THAN_FLOAT(0.1f, peaks[POOL_MEAN]);
+    TEST_ASSERT_GREATER_THAN_FLOAT(peaks[POOL_MEAN], peaks[POOL_RMS]);
+    TEST_ASSERT_LESS_THAN_FLOAT(peaks[POOL_MAX], peaks[POOL_RMS]);
+    TEST_ASSERT_EQUAL(POOL_COUNT, row_pooling_from_name("median"));
+
+    sparse_rows_free(&remap);
+}
+
+void test_spectral_features_of_a_line_and_of_noise(void)
+{
+    // an odd bin count walks the tail after the lanes too
+    enum { N_BINS = 1001 };
+    const float bin_hz = 10.0f;
+    const SizeType lit = 99;  // centred on 1 kHz
+
+    static Complex line[N_BINS];
+    static Complex flat[N_BINS];
+    static Complex louder[N_BINS];
+    line[lit] = 3.0f;
+    for (SizeType b = 0; b < N_BINS; ++b) {
+        flat[b] = 1.0f;
+        louder[b] = 2.0f * I;  // phase doesn't matter, +6 dB does
+    }
+
+    SpectralFeatureExtractor ext =
+        spectral_features_new(N_BINS, bin_hz, 1e-12f);
+    TEST_ASSERT_TRUE(spectral_features_ok(&ext));
+
+    const SpectralFeatures tonal = spectral_features_process(&ext, line);
+    TEST_ASSERT_FLOAT_WITHIN(1e-2f, 1000.0f, tonal.centroid);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 0.0f, tonal.bandwidth);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 1000.0f, tonal.rolloff);
+    TEST_ASSERT_LESS_THAN_FLOAT(1e-6f, tonal.flatness);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, tonal.flux);  // nothing to diff against
+
+    // uniform over bins 1..N: mean (N + 1) / 2, deviation N / sqrt(12)
+    const SpectralFeatures noise = spectral_features_process(&ext, flat);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 0.5f * (N_BINS + 1) * bin_hz,
+                             noise.centroid);
+    TEST_ASSERT_FLOAT_WITHIN(5.0f, N_BINS / sqrtf(12.0f) * bin_hz,
+                             noise.bandwidth);
+    TEST_ASSERT_FLOAT_WITHIN(bin_hz, 0.85f * N_BINS * bin_hz, noise.rolloff);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 1.0f, noise.flatness);
+    TEST_ASSERT_GREATER_THAN_FLOAT(100.0f, noise.flux);  // from the floor
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.0f,
+                             spectral_features_process(&ext, flat).flux);
+    TEST_ASSERT_FLOAT_WITHIN(1e-2f, 6.02f,
+                             spectral_features_process(&ext, louder).flux);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.0f,
+                             spectral_features_process(&ext, flat).flux);
+
+    spectral_features_reset(&ext);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, spectral_features_process(&ext, line).flux);
+
+    spectral_features_free(&ext);
+}
+
+void test_mel_bands_read_flat_power_evenly(void)
+{
+    // area-normalized triangles: a flat spectrum gives every band the same
+    // value, 1 / bin_hz, down to the bass bands narrower than a bin; bands
+    // only a few bins wide sample their triangle coarsely, hence the slack
+    enum { N_BINS = 1024, N_MELS = 128 };
+    const float bin_hz = 48000.0f / 2048.0f;
+
+    static float flat[N_BINS];
+    static float bands[N_MELS];
+    for (SizeType b = 0; b < N_BINS; ++b) {
+        flat[b] = 1.0f;
+    }
+
+    SparseRows filters =
+        mel_filterbank_new(N_BINS, bin_hz, N_MELS, 0.0f, 24000.0f);
+    TEST_ASSERT_TRUE(sparse_rows_ok(&filters));
+    TEST_ASSERT_EQUAL_UINT(N_MELS, filters.n_pushed);
+
+    sparse_rows_apply(&filters, flat, bands);
+    for (SizeType m = 0; m < N_MELS; ++m) {
+        const float slack = filters.len[m] >= 8 ? 0.03f : 0.15f;
+        TEST_ASSERT_FLOAT_WITHIN(slack / bin_hz, 1.0f / bin_hz, bands[m]);
+    }
+
+    sparse_rows_free(&filters);
+}
+
+void test_mfcc_of_a_flat_log_mel_is_its_mean(void)
+{
+    // orthonormal DCT-II: a constant c over n bands is c sqrt(n) in the
+    // first coefficient and nothing elsewhere
+    enum { N_BINS = 1024, N_MELS = 40, N_COEFFS = 13 };
+    const MelConfig cfg = {
+        .n_bins = N_BINS,
+        .bin_hz = 48000.0f / 2048.0f,
+        .n_mels = N_MELS,
+        .n_coeffs = N_COEFFS,
+        .f_min = 100.0f,
+        .f_max = 8000.0f,
+        .power_reference = 1.0f,
+        .min_dB = -100.0f,
+    };
+
+    static Complex silence[N_BINS];
+    float log_mel[N_MELS];
+    float mfcc[N_COEFFS];
+
+    MelExtractor ext = mel_extractor_new(&cfg);
+    TEST_ASSERT_TRUE(mel_extractor_ok(&ext));
+    mel_extractor_process(&ext, silence, log_mel, mfcc);
+
+    for (SizeType m = 0; m < N_MELS; ++m) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-4f, -100.0f, log_mel[m]);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(1e-2f, -100.0f * sqrtf((float)N_MELS), mfcc[0]);
+    for (SizeType k = 1; k < N_COEFFS; ++k) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.0f, mfcc[k]);
+    }
+
+    mel_extractor_free(&ext);
+}
+
+void test_arena_pushes_are_aligned_and_bounded(void)
+{
+    Arena arena = arena_new(3 * arena_footprint(100));
+    TEST_ASSERT_TRUE(arena_ok(&arena));
+
+    for (SizeType i = 0; i < 3; ++i) {
+        const unsigned char* p = arena_push(&arena, 100);
+        TEST_ASSERT_NOT_NULL(p);
+        TEST_ASSERT_EQUAL_UINT(0, (uintptr_t)p % ARENA_ALIGNMENT);
+    }
+    TEST_ASSERT_NULL(arena_push(&arena, 1));
+
+    // big enough already: same block, empty again
+    unsigned char* const base = arena.base;
+    TEST_ASSERT_TRUE(arena_reset(&arena, 2 * arena_footprint(100)));
+    TEST_ASSERT_EQUAL_PTR(base, arena.base);
+    TEST_ASSERT_EQUAL_PTR(base, arena_push(&arena, 1));
+
+    TEST_ASSERT_TRUE(arena_reset(&arena, 100 * arena_footprint(100)));
+    TEST_ASSERT_NOT_NULL(arena_push(&arena, 99 * arena_footprint(100)));
+
+    // huge pages only when asked for, a bit over one isn't rounded to two
+    TEST_ASSERT_TRUE(arena_reset(&arena, ARENA_HUGE_PAGE + ARENA_ALIGNMENT));
+#if defined(SPECTRE_HUGE_PAGES)
+    TEST_ASSERT_EQUAL_UINT(2 * ARENA_HUGE_PAGE, arena.capacity);
+#else
+    TEST_ASSERT_EQUAL_UINT(ARENA_HUGE_PAGE + ARENA_ALIGNMENT, arena.capacity);
+#endif
+
+    arena_free(&arena);
+    TEST_ASSERT_FALSE(arena_ok(&arena));
+}
+
+void test_analyzer_reconfigure_reuses_its_arena(void)
+{
+    LockFreeQueue* queue = malloc(sizeof(*queue));
+    TEST_ASSERT_NOT_NULL(queue);
+    clfq_new(queue);
+    LockFreeQueueProducer tx = clfq_producer(queue);
+
+    const FFTConfig big = {
+        .size = 2048,
+        .stride = 1024,
+        .sample_rate = 48000.0f,
+        .dc_blocker_frequency = 10.0f,
+        .history_size = 64,
+        .features = true,
+    };
+    const FFTConfig small = {
+        .size = 512,
+        .stride = 256,
+        .sample_rate = 48000.0f,
+        .dc_blocker_frequency = 10.0f,
+        .history_size = 64,
+    };
+
+    FFTAnalyzer first = fft_analyzer_new(&big, clfq_consumer(queue));
+    TEST_ASSERT_TRUE(fft_analyzer_ok(&first));
+    TEST_ASSERT_EQUAL_UINT(0, (uintptr_t)first.input % ARENA_ALIGNMENT);
+    TEST_ASSERT_EQUAL_UINT(0, (uintptr_t)first.window % ARENA_ALIGNMENT);
+    const unsigned char* const base = first.arena.base;
+
+    FFTAnalyzer second = fft_analyzer_reconfigure(&first, &small);
+    TEST_ASSERT_TRUE(fft_analyzer_ok(&second));
+    TEST_ASSERT_EQUAL_PTR(base, second.arena.base);
+    TEST_ASSERT_EQUAL_UINT(256, second.n_bins);
+
+    // and it still analyzes: a 3 kHz sine peaks in bin 32 - 1, DC ditched
+    static float samples[256];
+    SizeType frames = 0;
+    for (SizeType hop = 0; hop < 8; ++hop) {
+        for (SizeType i = 0; i < 256; ++i) {
+            const double t = (double)(hop * 256 + i) / 48000.0;
+            samples[i] = (float)sin(2.0 * (double)PI * 3000.0 * t);
+        }
+        TEST_ASSERT_TRUE(clfq_push(&tx, samples, 256));
+        frames += fft_analyzer_update(&second);
+    }
+    TEST_ASSERT_EQUAL_UINT(8, frames);
+
+    const Complex* row = fft_history_get_row(
+        &second.history, (second.history.tail + 63) % 64);
+    SizeType peak = 0;
+    for (SizeType b = 0; b < second.n_bins; ++b) {
+        peak = cabsf(row[b]) > cabsf(row[peak]) ? b : peak;
+    }
+    TEST_ASSERT_EQUAL_UINT(31, peak);
+
+    fft_analyzer_free(&second);
+    free(queue);
+}
+
+static void fill_noise(float* data, SizeType n, uint32_t seed)
+{
+    uint32_t state = seed;
+    for (SizeType i = 0; i < n; ++i) {
+        state = state * 1664525u + 1013904223u;
+        data[i] = (float)(state >> 8) / (float)(1u << 23) - 1.0f;
+    }
+}
+
+void test_large_fft_matches_kiss_fftr(void)
+{
+    // a power of two, and 2 * 2 * 3 * 5 * 7 * 11 * 13 for uneven rows
+    const SizeType sizes[] = {65536, 60060};
+    const SizeType threads[] = {4, 3};
+
+    for (SizeType s = 0; s < 2; ++s) {
+        const SizeType n = sizes[s];
+        float* in = malloc(n * sizeof(float));
+        kiss_fft_cpx* expected = malloc((n / 2 + 1) * sizeof(kiss_fft_cpx));
+        kiss_fft_cpx* actual = malloc((n / 2 + 1) * sizeof(kiss_fft_cpx));
+        TEST_ASSERT_NOT_NULL(in);
+        TEST_ASSERT_NOT_NULL(expected);
+        TEST_ASSERT_NOT_NULL(actual);
+        fill_noise(in, n, 0x12345678u + s);
+
+        kiss_fftr_cfg plan = kiss_fftr_alloc((int)n, 0, NULL, NULL);
+        TEST_ASSERT_NOT_NULL(plan);
+        kiss_fftr(plan, in, expected);
+        kiss_fftr_free(plan);
+
+        LargeFFT* fft = large_fft_new(n, threads[s]);
+        TEST_ASSERT_NOT_NULL(fft);
+        // twice: the workers must pick up a second frame too
+        large_fft_process(fft, in, actual);
+        large_fft_process(fft, in, actual);
+        TEST_ASSERT_TRUE(large_fft_done(fft));
+        large_fft_free(fft);
+
+        // noise spreads ~sqrt(n / 3) per bin, float rounding grows with
+        // log2(n) passes of it
+        float worst = 0.0f;
+        for (SizeType k = 0; k <= n / 2; ++k) {
+            worst = fmaxf(worst, fabsf(actual[k].r - expected[k].r));
+            worst = fmaxf(worst, fabsf(actual[k].i - expected[k].i));
+        }
+        TEST_ASSERT_LESS_THAN_FLOAT(1e-2f, worst);
+
+        free(in);
+        free(expected);
+        free(actual);
+    }
+}
+
+void test_threaded_analyzer_pushes_the_same_frames(void)
+{
+    enum { SIZE = 8192, STRIDE = 1024, HOPS = 40, HISTORY = 64 };
+
+    LockFreeQueue* queues = malloc(2 * sizeof(*queues));
+    TEST_ASSERT_NOT_NULL(queues);
+    clfq_new(&queues[0]);
+    clfq_new(&queues[1]);
+    LockFreeQueueProducer tx_inline = clfq_producer(&queues[0]);
+    LockFreeQueueProducer tx_threaded = clfq_producer(&queues[1]);
+
+    const FFTConfig inline_cfg = {
+        .size = SIZE,
+        .stride = STRIDE,
+        .sample_rate = 48000.0f,
+        .dc_blocker_frequency = 10.0f,
+        .history_size = HISTORY,
+        .features = true,
+    };
+    const FFTConfig threaded_cfg = {
+        .size = SIZE,
+        .stride = STRIDE,
+        .sample_rate = 48000.0f,
+        .dc_blocker_frequency = 10.0f,
+        .history_size = HISTORY,
+        .features = true,
+        .threads = 4,
+    };
+    FFTAnalyzer a = fft_analyzer_new(&inline_cfg, clfq_consumer(&queues[0]));
+    FFTAnalyzer b =
+        fft_analyzer_new(&threaded_cfg, clfq_consumer(&queues[1]));
+    TEST_ASSERT_TRUE(fft_analyzer_ok(&a));
+    TEST_ASSERT_TRUE(fft_analyzer_ok(&b));
+    TEST_ASSERT_NULL(b.plan);
+
+    static float samples[STRIDE];
+    SizeType frames_a = 0;
+    SizeType frames_b = 0;
+    for (SizeType hop = 0; hop < HOPS; ++hop) {
+        fill_noise(samples, STRIDE, hop);
+        TEST_ASSERT_TRUE(clfq_push(&tx_inline, samples, STRIDE));
+        frames_a += fft_analyzer_update(&a);
+
+        // a busy analyzer leaves its samples queued, wait once it's full
+        while (!clfq_push(&tx_threaded, samples, STRIDE)) {
+            frames_b += fft_analyzer_flush(&b);
+        }
+        frames_b += fft_analyzer_update(&b);
+    }
+    frames_b += fft_analyzer_flush(&b);
+
+    // one frame per hop, the first ones mostly zeros
+    TEST_ASSERT_EQUAL_UINT(HOPS, frames_a);
+    TEST_ASSERT_EQUAL_UINT(frames_a, frames_b);
+    TEST_ASSERT_EQUAL_UINT(a.history.tail, b.history.tail);
+    TEST_ASSERT_EQUAL_UINT(a.features.flux.tail, b.features.flux.tail);
+
+    for (SizeType r = 0; r < a.history.len; ++r) {
+        const Complex* ra = fft_history_get_row(&a.history, r);
+        const Complex* rb = fft_history_get_row(&b.history, r);
+        for (SizeType k = 0; k < a.n_bins; ++k) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-2f, crealf(ra[k]), crealf(rb[k]));
+            TEST_ASSERT_FLOAT_WITHIN(1e-2f, cimagf(ra[k]), cimagf(rb[k]));
+        }
+    }
+
+    // strides queued behind a frame in flight are caught up with in one
+    // update, whichever of them is still in flight pushed by the flush
+    for (SizeType hop = 0; hop < 3; ++hop) {
+        fill_noise(samples, STRIDE, HOPS + hop);
+        TEST_ASSERT_TRUE(clfq_push(&tx_threaded, samples, STRIDE));
+    }
+    const SizeType caught_up = fft_analyzer_update(&b);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT(2, caught_up);
+    TEST_ASSERT_EQUAL_UINT(3, caught_up + fft_analyzer_flush(&b));
+
+    fft_analyzer_free(&a);
+    fft_analyzer_free(&b);
+    free(queues);
+}
+
+// min, max and RMS of samples [from, to), the slow way
+static WaveformSpan direct_span(const float* x, SizeType from, SizeType to)
+{
+    WaveformSpan span = {.min = x[from], .max = x[from]};
+    for (SizeType i = from; i < to; ++i) {
+        span.min = x[i] < span.min ? x[i] : span.min;
+        span.max = x[i] > span.max ? x[i] : span.max;
+        span.sum_squares += x[i] * x[i];
+    }
+    span.samples = to - from;
+    return span;
+}
+
+void test_waveform_pyramid_spans_match_the_samples(void)
+{
+    enum { N = 300000, CHUNK = 1000, SPAN = 200000 };
+
+    static float x[N];
+    fill_noise(x, N, 7);
+    // a loud click the coarse levels must keep
+    x[N - 70000] = 4.0f;
+
+    WaveformPyramid pyramid = waveform_pyramid_new(SPAN);
+    TEST_ASSERT_TRUE(waveform_pyramid_ok(&pyramid));
+    for (SizeType i = 0; i < N; i += CHUNK) {
+        waveform_pyramid_push(&pyramid, x + i, CHUNK);
+    }
+    TEST_ASSERT_EQUAL_UINT64(N, pyramid.samples);
+    TEST_ASSERT_EQUAL_UINT64(N / 65536, pyramid.levels[2].entries);
+
+    TEST_ASSERT_EQUAL_UINT(0, waveform_pyramid_level_for(100.0f));
+    TEST_ASSERT_EQUAL_UINT(1, waveform_pyramid_level_for(4096.0f));
+    TEST_ASSERT_EQUAL_UINT(2, waveform_pyramid_level_for(1e6f));
+
+    // whole entries of the level that overlap the range, then the finer
+    // levels and the pending samples up to the newest one; the last 300
+    // samples are past any whole entry of level 1, so level 0 starts them.
+    // all within the last SPAN samples, which every level keeps
+    enum { FROMS = 3 };
+    const SizeType from[FROMS] = {3 * 65536, 30 * 4096 + 100, N - 300};
+    const SizeType start[WAVEFORM_LEVELS][FROMS] = {
+        {3 * 65536, 30 * 4096, (N - 300) / 256 * 256},
+        {3 * 65536, 30 * 4096, (N - 300) / 256 * 256},
+        {3 * 65536, 65536, (N - 300) / 256 * 256},
+    };
+    for (SizeType level = 0; level < WAVEFORM_LEVELS; ++level) {
+        for (SizeType f = 0; f < FROMS; ++f) {
+            const WaveformSpan expected = direct_span(x, start[level][f], N);
+            const WaveformSpan actual =
+                waveform_pyramid_span(&pyramid, level, from[f], N);
+            TEST_ASSERT_EQUAL_UINT64(expected.samples, actual.samples);
+            TEST_ASSERT_EQUAL_FLOAT(expected.min, actual.min);
+            TEST_ASSERT_EQUAL_FLOAT(expected.max, actual.max);
+            TEST_ASSERT_FLOAT_WITHIN(1e-4f, waveform_span_rms(&expected),
+                                     waveform_span_rms(&actual));
+        }
+    }
+
+    waveform_pyramid_free(&pyramid);
+}
+
+void test_pitch_tracker_finds_a_harmonic_tone(void)
+{
+    enum { SIZE = 2048 };
+    const float fs = 48000.0f;
+    const float f0 = 220.0f;
+
+    PitchTracker tracker =
+        pitch_tracker_new(SIZE, fs, PITCH_MIN_HZ, PITCH_MAX_HZ);
+    TEST_ASSERT_TRUE(pitch_tracker_ok(&tracker));
+    TEST_ASSERT_EQUAL_UINT(2048, pitch_frame_size_for(fs, PITCH_MIN_HZ));
+
+    // a weak fundamental under louder harmonics, where picking the highest
+    // peak of the spectrum would read an octave up
+    static float x[SIZE];
+    for (SizeType i = 0; i < SIZE; ++i) {
+        const float t = 2.0f * PI * f0 * (float)i / fs;
+        x[i] = 0.3f * sinf(t) + sinf(2.0f * t) + 0.6f * sinf(3.0f * t + 1.0f);
+    }
+    const Pitch tone = pitch_tracker_process(&tracker, x);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, f0, tone.f0);
+    TEST_ASSERT_TRUE(tone.clarity > 0.9f);
+
+    memset(x, 0, sizeof(x));
+    const Pitch silence = pitch_tracker_process(&tracker, x);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, silence.f0);
+
+    pitch_tracker_free(&tracker);
+}
+
+void test_partials_follow_two_tones_through_noise(void)
+{
+    enum { SIZE = 1024, STRIDE = 512, HOPS = 40 };
+    const float fs = 48000.0f;
+    const float tones[2] = {1000.0f, 3456.7f};
+
+    LockFreeQueue* queue = malloc(sizeof(*queue));
+    TEST_ASSERT_NOT_NULL(queue);
+    clfq_new(queue);
+    LockFreeQueueProducer tx = clfq_producer(queue);
+    const FFTConfig cfg = {
+        .size = SIZE,
+        .stride = STRIDE,
+        .sample_rate = fs,
+        .dc_blocker_frequency = 10.0f,
+        .history_size = 16,
+    };
+    FFTAnalyzer analyzer = fft_analyzer_new(&cfg, clfq_consumer(queue));
+    TEST_ASSERT_TRUE(fft_analyzer_ok(&analyzer));
+
+    // with phase and without
+    const PartialConfig partial_cfg = {
+        .size = SIZE,
+        .stride = STRIDE,
+        .sample_rate = fs,
+        // a full-scale sine through the analyzer's window
+        .power_reference = 0.25f / analyzer.power_reference,
+        .min_dB = -100.0f,
+        .threshold_dB = PARTIAL_THRESHOLD_DB,
+        .max_peaks = PARTIAL_MAX_PEAKS,
+        .cap = 2 * HOPS,
+    };
+    PartialTracker trackers[2] = {partial_tracker_new(&partial_cfg),
+                                  partial_tracker_new(&partial_cfg)};
+    TEST_ASSERT_TRUE(partial_tracker_ok(&trackers[0]));
+    TEST_ASSERT_TRUE(partial_tracker_ok(&trackers[1]));
+
+    // -6 dB and -12 dB over white noise at -60 dB, which has plenty of local
+    // maxima but none that last
+    static float samples[STRIDE];
+    uint32_t seed = 1;
+    for (SizeType hop = 0; hop < HOPS; ++hop) {
+        for (SizeType i = 0; i < STRIDE; ++i) {
+            const float t = (float)(hop * STRIDE + i) / fs;
+            seed = seed * 1664525u + 1013904223u;
+            const float noise = (float)seed / 4294967296.0f - 0.5f;
+            samples[i] = 0.5f * sinf(2.0f * PI * tones[0] * t) +
+                         0.25f * sinf(2.0f * PI * tones[1] * t) +
+                         0.002f * noise;
+        }
+        TEST_ASSERT_TRUE(clfq_push(&tx, samples, STRIDE));
+        const SizeType rows = fft_analyzer_update(&analyzer);
+        partial_tracker_push_history(&trackers[0], &analyzer.history, rows,
+                                     analyzer.phase_rows);
+        partial_tracker_push_history(&trackers[1], &analyzer.history, rows, 0);
+    }
+
+    // the phase pins the frequency down to a hundredth of a Hz, the parabola
+    // alone to a few percent of a bin; the first two frames, and the phase
+    // between them, see the zeros the analyzer starts from
+    const float within_hz[2] = {0.05f, 0.05f * fs / (float)SIZE};
+    for (SizeType k = 0; k < 2; ++k) {
+        const PartialPoints* points = &trackers[k].points;
+        TEST_ASSERT_EQUAL_UINT32(2, trackers[k].next_id);
+        TEST_ASSERT_EQUAL_UINT(2 * HOPS, points->len);
+
+        // whichever track a tone got, it keeps it
+        SizeType tone_of[2] = {2, 2};
+        SizeType firsts = 0;
+        for (SizeType i = 0; i < points->len; ++i) {
+            const uint32_t track = points->track[i];
+            TEST_ASSERT_TRUE(track < 2);
+            const SizeType tone = points->hz[i] < 2000.0f ? 0 : 1;
+            tone_of[track] = tone_of[track] == 2 ? tone : tone_of[track];
+            TEST_ASSERT_EQUAL_UINT(tone_of[track], tone);
+            if (points->frame[i] >= SIZE / STRIDE) {
+                TEST_ASSERT_FLOAT_WITHIN(within_hz[k], tones[tone],
+                                         points->hz[i]);
+                TEST_ASSERT_FLOAT_WITHIN(0.5f, tone == 0 ? -6.02f : -12.04f,
+                                         points->dB[i]);
+            }
+
+            SizeType link;
+            if (partial_points_link(points, i, &link)) {
+                TEST_ASSERT_EQUAL_UINT32(points->frame[i] - 1,
+                                         points->frame[link]);
+            } else {
+                ++firsts;
+            }
+        }
+        TEST_ASSERT_EQUAL_UINT(2, firsts);
+    }
+
+    partial_tracker_free(&trackers[0]);
+    partial_tracker_free(&trackers[1]);
+    fft_analyzer_free(&analyzer);
+    free(queue);
+}
+
+typedef enum {
+    STEREO_MONO,
+    STEREO_ANTIPHASE,
+    STEREO_UNRELATED,
+    STEREO_QUARTER_DELAY,
+} StereoCase;
+
+// left and right for one hop of a case; the tone sits at 1 kHz
+static void stereo_case_fill(StereoCase c,
+                             SizeType hop,
+                             SizeType stride,
+                             float* left,
+                             float* right)
+{
+    const float hz = 1000.0f / 48000.0f;
+    fill_noise(left, stride, 2 * hop + 1);
+    fill_noise(right, stride, 2 * hop + 2);
+    for (SizeType i = 0; i < stride; ++i) {
+        const float n = (float)(hop * stride + i);
+        switch (c) {
+        case STEREO_MONO:
+            right[i] = left[i];
+            break;
+        case STEREO_ANTIPHASE:
+            right[i] = -left[i];
+            break;
+        case STEREO_UNRELATED:
+            break;
+        case STEREO_QUARTER_DELAY:
+            left[i] = sinf(2.0f * PI * hz * n);
+            right[i] = sinf(2.0f * PI * (hz * n - 0.25f));
+            break;
+        }
+    }
+}
+
+void test_stereo_meter_reads_the_image_of_its_channels(void)
+{
+    enum { SIZE = 1024, STRIDE = 512, HOPS = 120 };
+
+    // mid and side of the stereo analyzer, and the mid alone for a mono one
+    LockFreeQueue* queues = malloc(3 * sizeof(*queues));
+    TEST_ASSERT_NOT_NULL(queues);
+
+    const FFTConfig stereo_cfg = {
+        .size = SIZE,
+        .stride = STRIDE,
+        .sample_rate = 48000.0f,
+        .dc_blocker_frequency = 10.0f,
+        .history_size = 16,
+        .stereo = true,
+    };
+    const FFTConfig mono_cfg = {
+        .size = SIZE,
+        .stride = STRIDE,
+        .sample_rate = 48000.0f,
+        .dc_blocker_frequency = 10.0f,
+        .history_size = 16,
+    };
+
+    static float left[STRIDE];
+    static float right[STRIDE];
+    static float mid[STRIDE];
+    static float side[STRIDE];
+    for (StereoCase c = STEREO_MONO; c <= STEREO_QUARTER_DELAY; ++c) {
+        for (SizeType q = 0; q < 3; ++q) {
+            clfq_new(&queues[q]);
+        }
+        LockFreeQueueProducer tx_mid = clfq_producer(&queues[0]);
+        LockFreeQueueProducer tx_side = clfq_producer(&queues[1]);
+        LockFreeQueueProducer tx_mono = clfq_producer(&queues[2]);
+
+        FFTAnalyzer a =
+            fft_analyzer_new(&stereo_cfg, clfq_consumer(&queues[0]));
+        FFTAnalyzer mono =
+            fft_analyzer_new(&mono_cfg, clfq_consumer(&queues[2]));
+        TEST_ASSERT_TRUE(fft_analyzer_ok(&a));
+        TEST_ASSERT_TRUE(fft_analyzer_ok(&mono));
+        fft_analyzer_attach_side(&a, clfq_consumer(&queues[1]));
+
+        for (SizeType hop = 0; hop < HOPS; ++hop) {
+            stereo_case_fill(c, hop, STRIDE, left, right);
+            for (SizeType i = 0; i < STRIDE; ++i) {
+                mid[i] = 0.5f * (left[i] + right[i]);
+                side[i] = 0.5f * (left[i] - right[i]);
+            }
+            // side first, like the audio callback
+            TEST_ASSERT_TRUE(clfq_push(&tx_side, side, STRIDE));
+            TEST_ASSERT_TRUE(clfq_push(&tx_mid, mid, STRIDE));
+            TEST_ASSERT_TRUE(clfq_push(&tx_mono, mid, STRIDE));
+            TEST_ASSERT_EQUAL_UINT(1, fft_analyzer_update(&a));
+            TEST_ASSERT_EQUAL_UINT(1, fft_analyzer_update(&mono));
+        }
+
+        // the history gets the mid's spectrum, as if the stream were mono
+        const SizeType newest = (a.history.tail + 15) % 16;
+        const Complex* row = fft_history_get_row(&a.history, newest);
+        const Complex* mono_row = fft_history_get_row(&mono.history, newest);
+        for (SizeType k = 0; k < a.n_bins; ++k) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-3f, crealf(mono_row[k]),
+                                     crealf(row[k]));
+            TEST_ASSERT_FLOAT_WITHIN(1e-3f, cimagf(mono_row[k]),
+                                     cimagf(row[k]));
+        }
+
+        const StereoMeter* meter = &a.stereo;
+        const SizeType last = (meter->coherency.tail + 15) % 16;
+        const float correlation = meter->correlation.data[last];
+        const float* gamma =
+            (const float*)fft_history_get_row(&meter->coherency, last);
+
+        if (c == STEREO_QUARTER_DELAY) {
+            // the band of the tone's bin, 1 kHz = (b + 1) * bin_hz
+            const SizeType bin = (SizeType)(1000.0f * SIZE / 48000.0f) - 1;
+            SizeType band = 0;
+            while (meter->band_end[band] <= bin) {
+                ++band;
+            }
+            const float re = gamma[2 * band];
+            const float im = gamma[2 * band + 1];
+            TEST_ASSERT_FLOAT_WITHIN(0.02f, 1.0f, re * re + im * im);
+            TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.5f * PI, atan2f(im, re));
+            TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.0f, correlation);
+            fft_analyzer_free(&a);
+            fft_analyzer_free(&mono);
+            continue;
+        }
+
+        // every band: 1 in phase or in antiphase, next to nothing unrelated
+        float mean_coherence = 0.0f;
+        for (SizeType band = 0; band < meter->n_bands; ++band) {
+            const float re = gamma[2 * band];
+            const float im = gamma[2 * band + 1];
+            const float coherence = re * re + im * im;
+            if (c != STEREO_UNRELATED) {
+                TEST_ASSERT_FLOAT_WITHIN(1e-3f, 1.0f, coherence);
+                TEST_ASSERT_FLOAT_WITHIN(1e-3f,
+                                         c == STEREO_MONO ? 1.0f : -1.0f, re);
+            }
+            mean_coherence += coherence / (float)meter->n_bands;
+        }
+
+        switch (c) {
+        case STEREO_MONO:
+            TEST_ASSERT_FLOAT_WITHIN(1e-3f, 1.0f, correlation);
+            break;
+        case STEREO_ANTIPHASE:
+            TEST_ASSERT_FLOAT_WITHIN(1e-3f, -1.0f, correlation);
+            break;
+        default:
+            TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.0f, correlation);
+            TEST_ASSERT_LESS_THAN_FLOAT(0.1f, mean_coherence);
+            break;
+        }
+
+        fft_analyzer_free(&a);
+        fft_analyzer_free(&mono);
+    }
+    free(queues);
+}
+
+void test_decimation_longer_than_the_stride_stays_in_bounds(void)
+{
+    enum { SIZE = 8, STRIDE = 4, HOPS = 16 };
+
+    TEST_ASSERT_EQUAL_UINT(1, fft_decimation_for(8000.0f));
+    TEST_ASSERT_EQUAL_UINT(RESAMPLER_MAX_FACTOR, fft_decimation_for(1e12f));
+
+    LockFreeQueue* queue = malloc(sizeof(*queue));
+    TEST_ASSERT_NOT_NULL(queue);
+    clfq_new(queue);
+    LockFreeQueueProducer tx = clfq_producer(queue);
+
+    // a tiny frame at 384 kHz: every pop is a whole step of 8 raw samples,
+    // twice the stride
+    const FFTConfig cfg = {
+        .size = SIZE,
+        .stride = STRIDE,
+        .sample_rate = 384000.0f,
+        .dc_blocker_frequency = 10.0f,
+        .history_size = 4,
+        .decimation = fft_decimation_for(384000.0f),
+    };
+    TEST_ASSERT_EQUAL_UINT(8, cfg.decimation);
+    FFTAnalyzer analyzer = fft_analyzer_new(&cfg, clfq_consumer(queue));
+    TEST_ASSERT_TRUE(fft_analyzer_ok(&analyzer));
+
+    static float samples[HOPS * STRIDE * 8];
+    fill_noise(samples, HOPS * STRIDE * 8, 3);
+    TEST_ASSERT_TRUE(clfq_push(&tx, samples, HOPS * STRIDE * 8));
+    TEST_ASSERT_EQUAL_UINT(HOPS, fft_analyzer_update(&analyzer));
+
+    fft_analyzer_free(&analyzer);
+    free(queue);
+}
+
+void test_update_until_a_past_deadline_leaves_the_rest_queued(void)
+{
+    enum { SIZE = 512, STRIDE = 256 };
+
+    LockFreeQueue* queue = malloc(sizeof(*queue));
+    TEST_ASSERT_NOT_NULL(queue);
+    clfq_new(queue);
+    LockFreeQueueProducer tx = clfq_producer(queue);
+
+    const FFTConfig cfg = {
+        .size = SIZE,
+        .stride = STRIDE,
+        .sample_rate = 48000.0f,
+        .dc_blocker_frequency = 10.0f,
+        .history_size = 8,
+    };
+    FFTAnalyzer analyzer = fft_analyzer_new(&cfg, clfq_consumer(queue));
+    TEST_ASSERT_TRUE(fft_analyzer_ok(&analyzer));
+
+    static float samples[4 * STRIDE];
+    fill_noise(samples, 4 * STRIDE, 1);
+    TEST_ASSERT_TRUE(clfq_push(&tx, samples, 4 * STRIDE));
+
+    // a frame whatever the deadline, then the rest once there's time
+    TEST_ASSERT_EQUAL_UINT(1, fft_analyzer_update_until(&analyzer, 0));
+    TEST_ASSERT_EQUAL_UINT(1, fft_analyzer_update_until(&analyzer, 0));
+    TEST_ASSERT_EQUAL_UINT(2, fft_analyzer_update(&analyzer));
+    TEST_ASSERT_EQUAL_UINT(0, fft_analyzer_update_until(&analyzer, 0));
+
+    fft_analyzer_free(&analyzer);
+    free(queue);
+}
+
+static void count_tap(void* ctx, const float* samples, SizeType size)
+{
+    (void)samples;
+    *(SizeType*)ctx += size;
+}
+
+void test_taps_see_samples_before_the_hop_completes(void)
+{
+    enum { SIZE = 2048, STRIDE = 1024 };
+
+    // straight from the queue, and through a decimator by 2
+    const float rates[] = {48000.0f, 96000.0f};
+    for (SizeType r = 0; r < 2; ++r) {
+        LockFreeQueue* queue = malloc(sizeof(*queue));
+        TEST_ASSERT_NOT_NULL(queue);
+        clfq_new(queue);
+        LockFreeQueueProducer tx = clfq_producer(queue);
+
+        const FFTConfig cfg = {
+            .size = SIZE,
+            .stride = STRIDE,
+            .sample_rate = rates[r],
+            .dc_blocker_frequency = 10.0f,
+            .history_size = 4,
+            .decimation = fft_decimation_for(rates[r]),
+        };
+        FFTAnalyzer analyzer = fft_analyzer_new(&cfg, clfq_consumer(queue));
+        TEST_ASSERT_TRUE(fft_analyzer_ok(&analyzer));
+        SizeType tapped = 0;
+        TEST_ASSERT_TRUE(fft_analyzer_add_tap(&analyzer, count_tap, &tapped));
+
+        // a quarter of a hop, no frame but every whole block already tapped
+        static float samples[STRIDE];
+        const SizeType decimation = r + 1;
+        const SizeType quarter = STRIDE * decimation / 4;
+        TEST_ASSERT_TRUE(clfq_push(&tx, samples, (uint32_t)quarter));
+        TEST_ASSERT_EQUAL_UINT(0, fft_analyzer_update(&analyzer));
+        TEST_ASSERT_EQUAL_UINT(STRIDE / 4, tapped);
+
+        // the rest of the hop completes the frame, nothing tapped twice
+        TEST_ASSERT_TRUE(
+            clfq_push(&tx, samples, (uint32_t)(STRIDE * decimation - quarter)));
+        TEST_ASSERT_EQUAL_UINT(1, fft_analyzer_update(&analyzer));
+        TEST_ASSERT_EQUAL_UINT(STRIDE, tapped);
+
+        fft_analyzer_free(&analyzer);
+        free(queue);
+    }
+}
+
+void test_merged_rows_pool_the_power_of_their_frames(void)
+{
+    enum { SIZE = 512, STRIDE = 256, HOPS = 12, BIN = 31 };
+
+    LockFreeQueue* queues = malloc(2 * sizeof(*queues));
+    TEST_ASSERT_NOT_NULL(queues);
+    clfq_new(&queues[0]);
+    clfq_new(&queues[1]);
+    LockFreeQueueProducer tx_frames = clfq_producer(&queues[0]);
+    LockFreeQueueProducer tx_merged = clfq_producer(&queues[1]);
+
+    const FFTConfig cfg = {
+        .size = SIZE,
+        .stride = STRIDE,
+        .sample_rate = 48000.0f,
+        .dc_blocker_frequency = 10.0f,
+        .history_size = 16,
+    };
+    FFTAnalyzer frames = fft_analyzer_new(&cfg, clfq_consumer(&queues[0]));
+    FFTAnalyzer merged = fft_analyzer_new(&cfg, clfq_consumer(&queues[1]));
+    TEST_ASSERT_TRUE(fft_analyzer_ok(&frames));
+    TEST_ASSERT_TRUE(fft_analyzer_ok(&merged));
+
+    // a sine growing louder, merged by 4 from the fifth frame on: averaged
+    // first, then pooled with max
+    static float samples[STRIDE];
+    float power[HOPS];
+    SizeType rows = 0;
+    for (SizeType hop = 0; hop < HOPS; ++hop) {
+        if (hop == 4) {
+            fft_analyzer_set_merge(&merged, 4, POOL_MEAN);
+        }
+        if (hop == 8) {
+            fft_analyzer_set_merge(&merged, 4, POOL_MAX);
+        }
+        for (SizeType i = 0; i < STRIDE; ++i) {
+            const float n = (float)(hop * STRIDE + i);
+            samples[i] = n / (float)(HOPS * STRIDE) *
+                         sinf(2.0f * PI * 32.0f * n / (float)SIZE);
+        }
+        TEST_ASSERT_TRUE(clfq_push(&tx_frames, samples, STRIDE));
+        TEST_ASSERT_TRUE(clfq_push(&tx_merged, samples, STRIDE));
+        TEST_ASSERT_EQUAL_UINT(1, fft_analyzer_update(&frames));
+        rows += fft_analyzer_update(&merged);
+
+        const Complex x = fft_history_get_row(&frames.history,
+                                              frames.history.tail - 1)[BIN];
+        power[hop] = crealf(x) * crealf(x) + cimagf(x) * cimagf(x);
+    }
+    TEST_ASSERT_EQUAL_UINT(4 + 1 + 1, rows);
+    TEST_ASSERT_EQUAL_UINT64(HOPS, merged.frames);
+
+    const float mean = 0.25f * (power[4] + power[5] + power[6] + power[7]);
+    const Complex m1 =
+        fft_history_get_row(&merged.history, merged.history.tail - 2)[BIN];
+    const Complex m2 =
+        fft_history_get_row(&merged.history, merged.history.tail - 1)[BIN];
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, cimagf(m1));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f * mean, mean, crealf(m1) * crealf(m1));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f * power[11], power[11],
+                             crealf(m2) * crealf(m2));
+    TEST_ASSERT_EQUAL_UINT(HOPS, frames.phase_rows);
+    TEST_ASSERT_EQUAL_UINT(0, merged.phase_rows);
+
+    // back to one frame per row half way through a row: that row is still
+    // merged, only the ones after it hold phase
+    fft_analyzer_set_merge(&merged, 2, POOL_MEAN);
+    TEST_ASSERT_TRUE(clfq_push(&tx_merged, samples, STRIDE));
+    TEST_ASSERT_EQUAL_UINT(0, fft_analyzer_update(&merged));
+    fft_analyzer_set_merge(&merged, 1, POOL_MEAN);
+    for (SizeType hop = 0; hop < 3; ++hop) {
+        TEST_ASSERT_TRUE(clfq_push(&tx_merged, samples, STRIDE));
+        TEST_ASSERT_EQUAL_UINT(1, fft_analyzer_update(&merged));
+        TEST_ASSERT_EQUAL_UINT(hop, merged.phase_rows);
+    }
+
+    fft_analyzer_free(&frames);
+    fft_analyzer_free(&merged);
+    free(queues);
+}
+
+void test_cache_round_trip_commits_whole_tiles(void)
+{
+    enum { N_BINS = 16, N_FRAMES = CACHE_FRAMES_PER_TILE + 6 };
+    const char* path = "test_dsp_cache.bin";
+    const FFTConfig cfg = {
+        .size = 2 * N_BINS,
+        .stride = N_BINS,
+        .sample_rate = 48000.0f,
+        .dc_blocker_frequency = 10.0f,
+        .history_size = 8,
+    };
+
+    CacheWriter* w =
+        cache_writer_new(path, &cfg, CACHE_STORAGE_COMPLEX, N_BINS, 42);
+    TEST_ASSERT_NOT_NULL(w);
+
+    Complex frame[N_BINS];
+    for (SizeType f = 0; f < N_FRAMES; ++f) {
+        for (SizeType b = 0; b < N_BINS; ++b) {
+            frame[b] = (float)f + (float)b * I;
+        }
+        TEST_ASSERT_TRUE(cache_writer_push(w, frame));
+    }
+
+    // as if the writer crashed now: only the full tile is visible
+    CacheReader r = cache_reader_new(path);
+    TEST_ASSERT_TRUE(cache_reader_ok(&r));
+    TEST_ASSERT_EQUAL_UINT64(CACHE_FRAMES_PER_TILE, r.n_frames);
+    cache_reader_free(&r);
+
+    cache_writer_free(w);
+    r = cache_reader_new(path);
+    TEST_ASSERT_TRUE(cache_reader_ok(&r));
+    TEST_ASSERT_EQUAL_UINT64(N_FRAMES, r.n_frames);
+    TEST_ASSERT_TRUE(cache_reader_matches(&r, &cfg, 42));
+    TEST_ASSERT_FALSE(cache_reader_matches(&r, &cfg, 43));
+    TEST_ASSERT_EQUAL_UINT(0, (uintptr_t)cache_reader_frame(&r, 0) %
+                                  CACHE_PAGE_SIZE);
+
+    const Complex* last = cache_reader_frame(&r, N_FRAMES - 1);
+    TEST_ASSERT_EQUAL_FLOAT(N_FRAMES - 1, crealf(last[3]));
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, cimagf(last[3]));
+
+    TEST_ASSERT_EQUAL_UINT(2, cache_reader_n_tiles(&r));
+    const FFTHistory tail = cache_reader_tile(&r, 1);
+    TEST_ASSERT_EQUAL_UINT(N_FRAMES - CACHE_FRAMES_PER_TILE, tail.len);
+    TEST_ASSERT_EQUAL_FLOAT(CACHE_FRAMES_PER_TILE,
+                            crealf(fft_history_get_row(&tail, 0)[0]));
+
+    cache_reader_free(&r);
+
+    // the same frames as floats, or rows of another width, don't stand in
+    const SizeType n_bins[] = {N_BINS, N_BINS / 2};
+    const CacheStorage storage[] = {CACHE_STORAGE_FLOAT,
+                                    CACHE_STORAGE_COMPLEX};
+    for (SizeType i = 0; i < 2; ++i) {
+        w = cache_writer_new(path, &cfg, storage[i], n_bins[i], 42);
+        TEST_ASSERT_NOT_NULL(w);
+        TEST_ASSERT_TRUE(cache_writer_push(w, frame));
+        cache_writer_free(w);
+        r = cache_reader_new(path);
+        TEST_ASSERT_TRUE(cache_reader_ok(&r));
+        TEST_ASSERT_FALSE(cache_reader_matches(&r, &cfg, 42));
+        cache_reader_free(&r);
+    }
+    remove(path);
+}
+
+static SnapshotStatus wait_for_export(const Snapshotter* s)
+{
+    SnapshotStatus status;
+    while ((status = snapshotter_status(s)) == SNAPSHOT_RUNNING) {
+    }
+    return status;
+}
+
+void test_snapshot_holds_its_frames_while_rows_keep_coming(void)
+{
+    enum { N_BINS = 8, KEEP = 3 * SNAPSHOT_FRAMES_PER_TILE, BURST = 16 };
+    const char* raw_path = "test_dsp_snapshot.f32";
+    const char* pgm_path = "test_dsp_snapshot.pgm";
+    const FFTConfig cfg = {
+        .size = 2 * N_BINS,
+        .stride = N_BINS,
+        .sample_rate = 48000.0f,
+        .dc_blocker_frequency = 10.0f,
+        .history_size = BURST,
+    };
+
+    FFTHistory history = fft_history_new(BURST, N_BINS);
+    TEST_ASSERT_TRUE(fft_history_ok(&history));
+    Snapshotter* s = snapshotter_new(&cfg, N_BINS, KEEP, 1.0f, -60.0f, 42);
+    TEST_ASSERT_NOT_NULL(s);
+    TEST_ASSERT_EQUAL(SNAPSHOT_RAW, snapshot_format_for_path(raw_path));
+    TEST_ASSERT_EQUAL(SNAPSHOT_PGM, snapshot_format_for_path(pgm_path));
+
+    // frame f has every bin at f, i.e. a power of f^2
+    Complex row[N_BINS];
+    SizeType pushed = 0;
+    const SizeType bursts[] = {200, 300};
+    for (SizeType k = 0; k < 2; ++k) {
+        for (SizeType end = pushed + bursts[k]; pushed < end;) {
+            const SizeType n = end - pushed < BURST ? end - pushed : BURST;
+            for (SizeType i = 0; i < n; ++i) {
+                for (SizeType b = 0; b < N_BINS; ++b) {
+                    row[b] = (float)(pushed + i);
+                }
+                fft_history_push(&history, row);
+            }
+            TEST_ASSERT_TRUE(snapshotter_push_history(s, &history, n));
+            pushed += n;
+        }
+        TEST_ASSERT_TRUE(snapshotter_frames(s) >= KEEP);
+
+        // the last 100 frames, while the next burst recycles their tiles
+        if (k == 0) {
+            TEST_ASSERT_TRUE(
+                snapshotter_export(s, raw_path, SNAPSHOT_RAW, 100));
+        }
+    }
+    TEST_ASSERT_EQUAL(SNAPSHOT_DONE, wait_for_export(s));
+
+    FILE* f = fopen(raw_path, "rb");
+    TEST_ASSERT_NOT_NULL(f);
+    static float frames[100 * N_BINS + 1];
+    TEST_ASSERT_EQUAL_UINT(100 * N_BINS,
+                           fread(frames, sizeof(float), 100 * N_BINS + 1, f));
+    fclose(f);
+    for (SizeType i = 0; i < 100; ++i) {
+        const float value = (float)(100 + i);
+        TEST_ASSERT_EQUAL_FLOAT(value * value, frames[i * N_BINS + 3]);
+    }
+
+    // everything kept, as an image as wide as that
+    TEST_ASSERT_TRUE(snapshotter_export(s, pgm_path, SNAPSHOT_PGM, 0));
+    TEST_ASSERT_EQUAL(SNAPSHOT_DONE, wait_for_export(s));
+    f = fopen(pgm_path, "rb");
+    TEST_ASSERT_NOT_NULL(f);
+    unsigned width = 0;
+    unsigned height = 0;
+    TEST_ASSERT_EQUAL_INT(2, fscanf(f, "P5 %u %u 255", &width, &height));
+    TEST_ASSERT_EQUAL_UINT(snapshotter_frames(s), width);
+    TEST_ASSERT_EQUAL_UINT(N_BINS, height);
+    fclose(f);
+
+    snapshotter_free(s);
+    fft_history_free(&history);
+    remove(raw_path);
+    remove(pgm_path);
+}
+
+// rows are only counted once their column is uploaded, and a merged row only
+// once all its frames are in
+void test_latency_waits_for_deferred_and_merged_rows(void)
+{
+    enum { STRIDE = 4 };
+    LatencyTracker* tracker = latency_tracker_new(STRIDE, NULL);
+    TEST_ASSERT_NOT_NULL(tracker);
+    const Histogram* total = &tracker->histograms[LATENCY_TOTAL];
+
+    latency_tracker_on_block(tracker, 4 * STRIDE);
+    latency_tracker_on_analyzed(tracker, 4, 4, 0);
+    latency_tracker_on_columns(tracker, 1, 3);
+    latency_tracker_on_present(tracker);
+    TEST_ASSERT_EQUAL_UINT64(1, total->total);
+
+    // the scheduler's backlog, drawn a frame later
+    latency_tracker_on_analyzed(tracker, 0, 0, 0);
+    latency_tracker_on_columns(tracker, 3, 0);
+    latency_tracker_on_present(tracker);
+    TEST_ASSERT_EQUAL_UINT64(4, total->total);
+
+    // 3 frames of a 4-frame row, then the one that completes it
+    latency_tracker_on_block(tracker, 4 * STRIDE);
+    latency_tracker_on_analyzed(tracker, 3, 0, 3);
+    latency_tracker_on_columns(tracker, 0, 0);
+    latency_tracker_on_present(tracker);
+    TEST_ASSERT_EQUAL_UINT64(4, total->total);
+    latency_tracker_on_analyzed(tracker, 1, 1, 0);
+    latency_tracker_on_columns(tracker, 1, 0);
+    latency_tracker_on_present(tracker);
+    TEST_ASSERT_EQUAL_UINT64(5, total->total);
+
+    // rows the history dropped before they were drawn are not counted
+    latency_tracker_on_block(tracker, 4 * STRIDE);
+    latency_tracker_on_analyzed(tracker, 4, 4, 0);
+    latency_tracker_on_columns(tracker, 1, 1);
+    latency_tracker_on_present(tracker);
+    TEST_ASSERT_EQUAL_UINT64(6, total->total);
+    TEST_ASSERT_EQUAL_UINT(tracker->rows_pushed - 1, tracker->rows_uploaded);
+
+    latency_tracker_free(tracker);
+}
+
+// display frames that push `rows` rows each onto a history of `cap` and pay
+// column_ns per column drawn, with no time spent analyzing; the frames it
+// took merge to reach `until`, or `frames` when it didn't
+static SizeType run_scheduler(FrameScheduler* s,
+                              SizeType frames,
+                              SizeType rows,
+                              SizeType cap,
+                              uint64_t column_ns,
+                              SizeType until)
+{
+    for (SizeType i = 0; i < frames; ++i) {
+        frame_scheduler_on_analyzed(s, rows, cap, 0);
+        TEST_ASSERT_TRUE(s->columns <= s->behind);
+        frame_scheduler_on_columns(s, s->columns * column_ns);
+        TEST_ASSERT_TRUE(s->merge >= 1 && s->merge <= s->cfg.max_merge);
+        if (s->merge == until) {
+            return i + 1;
+        }
+    }
+    return frames;
+}
+
+void test_frame_scheduler_merges_under_overload_and_unmerges_after(void)
+{
+    enum { CAP = 1024, MAX = 4, FRAMES = 4 * CAP };
+    // 1 ms a frame at 0.2 ms a column: room for 5 columns a frame
+    const FrameSchedulerConfig cfg = {.budget_ns = 1000000, .max_merge = MAX};
+    const uint64_t column_ns = 200000;
+    FrameScheduler s = frame_scheduler_new(&cfg);
+    TEST_ASSERT_EQUAL_UINT(1, s.merge);
+
+    // 10 rows a frame: it falls behind, but only merges once that's lasted
+    const SizeType to_2 = run_scheduler(&s, FRAMES, 10, CAP, column_ns, 2);
+    TEST_ASSERT_EQUAL_UINT(2, s.merge);
+    TEST_ASSERT_TRUE(to_2 > FRAME_SCHEDULER_PATIENCE);
+    TEST_ASSERT_TRUE(s.behind > 0);
+
+    // and doubles up to max_merge, never past it
+    const SizeType to_max = run_scheduler(&s, FRAMES, 10, CAP, column_ns, MAX);
+    TEST_ASSERT_EQUAL_UINT(MAX, s.merge);
+    TEST_ASSERT_TRUE(to_max >= FRAME_SCHEDULER_PATIENCE);
+    run_scheduler(&s, 4 * FRAME_SCHEDULER_PATIENCE, 10, CAP, column_ns, 0);
+    TEST_ASSERT_EQUAL_UINT(MAX, s.merge);
+
+    // 3 rows a frame fit, but 6 wouldn't: the backlog goes, the merge stays
+    run_scheduler(&s, FRAMES, 3, CAP, column_ns, 0);
+    TEST_ASSERT_EQUAL_UINT(MAX, s.merge);
+    TEST_ASSERT_EQUAL_UINT(0, s.behind);
+
+    // 1 row a frame: merging halves once there has been room for twice the
+    // rows for long enough
+    const SizeType to_half =
+        run_scheduler(&s, FRAMES, 1, CAP, column_ns, MAX / 2);
+    TEST_ASSERT_EQUAL_UINT(MAX / 2, s.merge);
+    TEST_ASSERT_EQUAL_UINT(0, s.behind);
+    TEST_ASSERT_TRUE(to_half >= FRAME_SCHEDULER_PATIENCE);
+    const SizeType to_1 = run_scheduler(&s, FRAMES, 1, CAP, column_ns, 1);
+    TEST_ASSERT_EQUAL_UINT(1, s.merge);
+    TEST_ASSERT_EQUAL_UINT(FRAME_SCHEDULER_PATIENCE, to_1);
+}
+
+void test_frame_scheduler_draws_a_column_and_forgets_lost_rows(void)
+{
+    enum { CAP = 16 };
+    const FrameSchedulerConfig cfg = {.budget_ns = 1000000, .max_merge = 8};
+    FrameScheduler s = frame_scheduler_new(&cfg);
+    TEST_ASSERT_EQUAL_UINT64(1000000 + 5,
+                             frame_scheduler_analysis_deadline(&s, 5));
+
+    // unmeasured, everything is drawn: that's the first measurement
+    frame_scheduler_on_analyzed(&s, 4, CAP, 0);
+    TEST_ASSERT_EQUAL_UINT(4, s.columns);
+    frame_scheduler_on_columns(&s, 4 * 100000);
+    TEST_ASSERT_EQUAL_UINT(0, s.behind);
+
+    // the analysis took the whole budget: still one column
+    frame_scheduler_on_analyzed(&s, 4, CAP, 2000000);
+    TEST_ASSERT_EQUAL_UINT(1, s.columns);
+    frame_scheduler_on_columns(&s, 100000);
+    TEST_ASSERT_EQUAL_UINT(3, s.behind);
+
+    // rows older than the history can't be drawn anymore
+    frame_scheduler_on_analyzed(&s, 3 * CAP, CAP, 0);
+    TEST_ASSERT_EQUAL_UINT(CAP, s.behind);
+    TEST_ASSERT_EQUAL_UINT(10, s.columns);
+
+    // no budget: every column, no deadline, no merging
+    const FrameSchedulerConfig unbounded = {.budget_ns = 0, .max_merge = 8};
+    FrameScheduler u = frame_scheduler_new(&unbounded);
+    TEST_ASSERT_EQUAL_UINT64(UINT64_MAX,
+                             frame_scheduler_analysis_deadline(&u, 5));
+    for (SizeType i = 0; i < 4 * FRAME_SCHEDULER_PATIENCE; ++i) {
+        frame_scheduler_on_analyzed(&u, 3 * CAP, CAP, 2000000);
+        TEST_ASSERT_EQUAL_UINT(CAP, u.columns);
+        frame_scheduler_on_columns(&u, CAP * 1000000ull);
+        TEST_ASSERT_EQUAL_UINT(0, u.behind);
+        TEST_ASSERT_EQUAL_UINT(1, u.merge);
+    }
+}
+
 int main(void)
 {
     UNITY_BEGIN();
@@ -131,5 +1918,52 @@ int main(void)
 
     RUN_TEST(test_filter_hpf_removes_dc_from_mixed_signal);
 
+    RUN_TEST(test_butterworth_lowpass_response);
+    RUN_TEST(test_butterworth_odd_order_highpass);
+    RUN_TEST(test_rbj_peak_hits_its_gain);
+    RUN_TEST(test_biquad_bank_lanes_match_scalar);
+    RUN_TEST(test_biquad_bank_split_feeds_every_lane);
+    RUN_TEST(test_biquad_state_decays_to_exact_zero);
+
+    RUN_TEST(test_decimator_keeps_passband_and_rejects_aliases);
+    RUN_TEST(test_resampler_chunking_is_transparent);
+
+    RUN_TEST(test_tone_bank_reads_its_tone_and_rejects_others);
+    RUN_TEST(test_tone_bank_matches_direct_dtft_after_long_run);
+
+    RUN_TEST(test_czt_over_the_full_band_is_the_dft);
+    RUN_TEST(test_czt_resolves_close_partials_in_a_narrow_band);
+
+    RUN_TEST(test_axis_range_round_trips);
+    RUN_TEST(test_axis_remap_rows_are_normalized);
+    RUN_TEST(test_log_remap_gives_the_bass_more_rows);
+    RUN_TEST(test_max_pooling_keeps_a_narrow_line);
+    RUN_TEST(test_spectral_features_of_a_line_and_of_noise);
+    RUN_TEST(test_mel_bands_read_flat_power_evenly);
+    RUN_TEST(test_mfcc_of_a_flat_log_mel_is_its_mean);
+    RUN_TEST(test_arena_pushes_are_aligned_and_bounded);
+    RUN_TEST(test_analyzer_reconfigure_reuses_its_arena);
+    RUN_TEST(test_large_fft_matches_kiss_fftr);
+    RUN_TEST(test_threaded_analyzer_pushes_the_same_frames);
+    RUN_TEST(test_merged_rows_pool_the_power_of_their_frames);
+    RUN_TEST(test_taps_see_samples_before_the_hop_completes);
+    RUN_TEST(test_update_until_a_past_deadline_leaves_the_rest_queued);
+    RUN_TEST(test_decimation_longer_than_the_stride_stays_in_bounds);
+    RUN_TEST(test_pitch_tracker_finds_a_harmonic_tone);
+    RUN_TEST(test_partials_follow_two_tones_through_noise);
+    RUN_TEST(test_stereo_meter_reads_the_image_of_its_channels);
+    RUN_TEST(test_waveform_pyramid_spans_match_the_samples);
+    RUN_TEST(test_cache_round_trip_commits_whole_tiles);
+    RUN_TEST(test_snapshot_holds_its_frames_while_rows_keep_coming);
+
+    RUN_TEST(test_sliding_sum_matches_direct_sum);
+
+    RUN_TEST(test_loudness_full_scale_1k_sine_reads_minus_3_lufs);
+    RUN_TEST(test_true_peak_finds_intersample_peak);
+
+    RUN_TEST(test_latency_waits_for_deferred_and_merged_rows);
+    RUN_TEST(test_frame_scheduler_merges_under_overload_and_unmerges_after);
+    RUN_TEST(test_frame_scheduler_draws_a_column_and_forgets_lost_rows);
+
     return UNITY_END();
 }
@@ -1,97 +1,320 @@
-#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-#define DR_WAV_IMPLEMENTATION
-#include "dr_wav.h"
+#include "cache/CacheReader.h"
+#include "cache/CacheWriter.h"
+#include "common/offline.h"
+#include "core/intensity.h"
+#include "dsp/mel.h"
+#include "dsp/partials.h"
 
-static bool str_ends_with(const char* s, const char* suffix)
+typedef struct {
+    uint8_t* pixels;  // n_bins * cap, one column per frame
+    SizeType n_bins;
+    uint64_t len;
+    uint64_t cap;
+    float power_reference;
+} Image;
+
+// same mapping as the live spectrogram, minus the colormap
+static void push_column(const Complex* bins, SizeType n_bins, void* ctx)
 {
-    if (strlen(suffix) > strlen(s)) {
-        return false;
+    Image* img = ctx;
+
+    if (img->len == img->cap) {
+        img->cap = (img->cap == 0) ? 256 : 2 * img->cap;
+        img->pixels = realloc(img->pixels, img->cap * n_bins);
+        if (img->pixels == NULL) {
+            fprintf(stderr, "oom\n");
+            exit(1);
+        }
     }
 
-    const char* s_suffix = s + strlen(s) - strlen(suffix);
+    uint8_t* column = img->pixels + img->len * n_bins;
+    for (SizeType b = 0; b < n_bins; ++b) {
+        const float intensity =
+            intensity_from_bin(bins[b], img->power_reference, -60.0f);
+        column[b] = (uint8_t)(255.0f * intensity + 0.5f);
+    }
 
-    return (strcmp(s_suffix, suffix) == 0);
+    img->n_bins = n_bins;
+    img->len++;
 }
 
-struct MonoAudioBuffer {
-    float* samples;
-    uint32_t sample_rate;
-    uint64_t size;
-};
-
-// sloppy ressource management; shouldn't matter here
-static struct MonoAudioBuffer decode_wav_or_exit(const char* path)
+// binary pgm, time left to right, low frequencies at the bottom
+static void write_pgm(const Image* img, FILE* out)
 {
-    if (!str_ends_with(path, ".wav")) {
-        fprintf(stderr, "Not a wav file\n");
-        exit(1);
+    fprintf(out, "P5\n%llu %u\n255\n", (unsigned long long)img->len,
+            img->n_bins);
+
+    for (SizeType row = 0; row < img->n_bins; ++row) {
+        const SizeType b = img->n_bins - 1 - row;
+        for (uint64_t t = 0; t < img->len; ++t) {
+            fputc(img->pixels[t * img->n_bins + b], out);
+        }
     }
+}
+
+// n-th newest entry, 0 being the latest
+static float newest(const FloatHistory* fh, SizeType back)
+{
+    return fh->data[(fh->tail + fh->cap - 1 - back) % fh->cap];
+}
 
-    drwav decoder;
-    if (!drwav_init_file(&decoder, path, NULL)) {
-        fprintf(stderr, "drwav: failed to init wav decoder from file %s\n",
-                path);
-        exit(1);
+// one csv line per frame, straight from the analyzer's feature rings
+static void write_features(const FFTAnalyzer* analyzer, SizeType n, void* ctx)
+{
+    uint64_t* frame = ctx;
+    n = (n >= analyzer->cfg.history_size) ? analyzer->cfg.history_size : n;
+
+    for (SizeType i = n; i-- > 0;) {
+        printf("%llu,%.2f,%.2f,%.2f,%.5f,%.3f\n", (unsigned long long)*frame,
+               (double)newest(&analyzer->features.centroid, i),
+               (double)newest(&analyzer->features.bandwidth, i),
+               (double)newest(&analyzer->features.rolloff, i),
+               (double)newest(&analyzer->features.flatness, i),
+               (double)newest(&analyzer->features.flux, i));
+        ++*frame;
     }
+}
 
-    uint32_t channels = decoder.channels;
-    uint64_t frames = decoder.totalPCMFrameCount;
-    if (frames == 0) {
-        fprintf(stderr, "empty wav file\n");
-        exit(1);
+// one csv line per frame from the pitch rings, f0 is 0 when unvoiced
+static void write_pitch(const FFTAnalyzer* analyzer, SizeType n, void* ctx)
+{
+    uint64_t* frame = ctx;
+    n = (n >= analyzer->cfg.history_size) ? analyzer->cfg.history_size : n;
+
+    for (SizeType i = n; i-- > 0;) {
+        printf("%llu,%.2f,%.4f\n", (unsigned long long)*frame,
+               (double)newest(&analyzer->pitch.f0, i),
+               (double)newest(&analyzer->pitch.clarity, i));
+        ++*frame;
     }
-    if (channels == 0) {
-        fprintf(stderr, "invalid channel layout: somehow no channels\n");
-        exit(1);
+}
+
+// one csv line per point as the tracker pushes them: a track's first
+// PARTIAL_MIN_FRAMES points come together, once it's born
+static void write_partials(const FFTAnalyzer* analyzer,
+                           SizeType n,
+                           void* ctx)
+{
+    PartialTracker* tracker = ctx;
+    const PartialPoints* points = &tracker->points;
+
+    const SizeType pushed =
+        partial_tracker_push_history(tracker, &analyzer->history, n,
+                                     analyzer->phase_rows);
+    for (SizeType i = 0; i < pushed; ++i) {
+        const SizeType slot =
+            (points->tail + points->cap - pushed + i) % points->cap;
+        printf("%u,%u,%.3f,%.2f\n", points->frame[slot], points->track[slot],
+               (double)points->hz[slot], (double)points->dB[slot]);
     }
+}
 
-    float* interleaved = calloc(channels * frames, sizeof(float));
-    if (interleaved == NULL) {
-        fprintf(stderr, "oom\n");
-        exit(1);
+// the usual defaults of the python side, so frames drop into existing models
+#define DUMP_MELS 128
+#define DUMP_MFCCS 20
+
+typedef struct {
+    MelExtractor mel;
+    float log_mel[DUMP_MELS];
+    float mfcc[DUMP_MFCCS];
+    bool want_mfcc;
+} MelDump;
+
+// raw native-endian float32, one frame after the other, no header
+static void write_mel(const Complex* bins, SizeType n_bins, void* ctx)
+{
+    (void)n_bins;
+    MelDump* dump = ctx;
+
+    mel_extractor_process(&dump->mel, bins, dump->log_mel,
+                          dump->want_mfcc ? dump->mfcc : NULL);
+    if (dump->want_mfcc) {
+        fwrite(dump->mfcc, sizeof(float), DUMP_MFCCS, stdout);
+    } else {
+        fwrite(dump->log_mel, sizeof(float), DUMP_MELS, stdout);
     }
-    drwav_read_pcm_frames_f32(&decoder, frames, interleaved);
-    drwav_uninit(&decoder);
+}
+
+typedef struct {
+    Image* img;
+    CacheWriter* cache;
+} CachingImage;
 
-    float* mono = calloc(frames, sizeof(float));
-    if (mono == NULL) {
-        fprintf(stderr, "oom\n");
-        exit(1);
+// the image as usual, and every row into the cache on the way
+static void push_column_and_cache(const Complex* bins,
+                                  SizeType n_bins,
+                                  void* ctx)
+{
+    CachingImage* c = ctx;
+    push_column(bins, n_bins, c->img);
+    if (c->cache != NULL && !cache_writer_push(c->cache, bins)) {
+        fprintf(stderr, "cache: write failed, no longer caching\n");
+        cache_writer_free(c->cache);
+        c->cache = NULL;
     }
+}
 
-    const float gain = 1.0f / (float)channels;
-    for (uint64_t i = 0; i < frames; ++i) {
-        float sample = 0.0f;
-        for (uint32_t c = 0; c < channels; ++c) {
-            sample += interleaved[channels * i + c];
-        }
+// from the cache when it holds these samples analyzed this way, otherwise
+// analyzes them and (re)writes the cache
+static void analyze_cached(const MonoAudioBuffer* audio,
+                           const FFTConfig* cfg,
+                           const char* cache_path,
+                           Image* img)
+{
+    const uint64_t hash =
+        cache_hash(CACHE_HASH_SEED, audio->samples,
+                   (size_t)audio->size * sizeof(*audio->samples));
 
-        mono[i] = gain * sample;
+    CacheReader reader = cache_reader_new(cache_path);
+    if (cache_reader_matches(&reader, cfg, hash)) {
+        for (uint64_t i = 0; i < reader.n_frames; ++i) {
+            push_column(cache_reader_frame(&reader, i), reader.header.n_bins,
+                        img);
+        }
+        cache_reader_free(&reader);
+        return;
     }
-    free(interleaved);
+    cache_reader_free(&reader);
 
-    return (struct MonoAudioBuffer){
-        .samples = mono,
-        .sample_rate = decoder.sampleRate,
-        .size = decoder.totalPCMFrameCount,
+    CachingImage c = {
+        .img = img,
+        .cache = cache_writer_new(cache_path, cfg, CACHE_STORAGE_COMPLEX,
+                                  cfg->size / 2, hash),
     };
+    if (c.cache == NULL) {
+        fprintf(stderr, "cache: can't create %s\n", cache_path);
+    }
+    offline_analyze(audio, cfg, push_column_and_cache, &c);
+    cache_writer_free(c.cache);
+}
+
+static void usage_and_exit(void)
+{
+    fprintf(stderr, "Usage: dump [--features | --pitch | --partials | --mel | "
+                    "--mfcc] <input audio>\n"
+                    "       dump --cache <file> <input audio>\n");
+    exit(1);
 }
 
 int main(int ac, char* av[])
 {
-    if (ac != 2) {
-        fprintf(stderr, "Usage: dump <input audio>\n");
-        return 1;
+    if (ac < 2 || ac > 4) {
+        usage_and_exit();
+    }
+
+    const char* mode = (ac >= 3) ? av[1] : "";
+    const bool features = strcmp(mode, "--features") == 0;
+    const bool pitch = strcmp(mode, "--pitch") == 0;
+    const bool partials = strcmp(mode, "--partials") == 0;
+    const bool mel = strcmp(mode, "--mel") == 0;
+    const bool mfcc = strcmp(mode, "--mfcc") == 0;
+    const bool cached = strcmp(mode, "--cache") == 0;
+    const bool known =
+        (ac == 3 && (features || pitch || partials || mel || mfcc)) ||
+                       (ac == 4 && cached) || ac == 2;
+    if (!known) {
+        usage_and_exit();
+    }
+
+    const char* input = av[ac - 1];
+
+    MonoAudioBuffer audio = decode_wav_or_exit(input);
+
+    const FFTConfig cfg = {
+        .size = FFT_SIZE,
+        .stride = FFT_SIZE / 2,
+        .dc_blocker_frequency = 10.0f,
+        .history_size = HISTORY_SIZE,
+        .sample_rate = (float)audio.sample_rate,
+        .features = features,
+        .pitch = pitch,
+    };
+
+    if (features) {
+        printf("frame,centroid_hz,bandwidth_hz,rolloff_hz,flatness,flux_db\n");
+        uint64_t frame = 0;
+        offline_analyze_frames(&audio, &cfg, write_features, &frame);
+        mono_audio_free(&audio);
+        return 0;
+    }
+
+    if (pitch) {
+        printf("frame,f0_hz,clarity\n");
+        uint64_t frame = 0;
+        offline_analyze_frames(&audio, &cfg, write_pitch, &frame);
+        mono_audio_free(&audio);
+        return 0;
+    }
+
+    if (partials) {
+        // room for all a history's worth of rows can push at once: a peak
+        // each, and the points tracks born on them waited with
+        const PartialConfig partial_cfg = {
+            .size = cfg.size,
+            .stride = cfg.stride,
+            .sample_rate = cfg.sample_rate,
+            .power_reference = 0.25f * (float)(cfg.size * cfg.size),
+            .min_dB = -100.0f,
+            .threshold_dB = PARTIAL_THRESHOLD_DB,
+            .max_peaks = PARTIAL_MAX_PEAKS,
+            .cap = PARTIAL_MAX_PEAKS * PARTIAL_MIN_FRAMES * cfg.history_size,
+        };
+        PartialTracker tracker = partial_tracker_new(&partial_cfg);
+        if (!partial_tracker_ok(&tracker)) {
+            fprintf(stderr, "oom\n");
+            return 1;
+        }
+
+        printf("frame,track,f_hz,level_db\n");
+        offline_analyze_frames(&audio, &cfg, write_partials, &tracker);
+        partial_tracker_free(&tracker);
+        mono_audio_free(&audio);
+        return 0;
     }
 
-    const char* input = av[1];
+    if (mel || mfcc) {
+        const MelConfig mel_cfg = {
+            .n_bins = cfg.size / 2,
+            .bin_hz = cfg.sample_rate / (float)cfg.size,
+            .n_mels = DUMP_MELS,
+            .n_coeffs = DUMP_MFCCS,
+            .f_min = 0.0f,
+            .f_max = 0.5f * cfg.sample_rate,
+            .power_reference = 0.25f * (float)(cfg.size * cfg.size),
+            .min_dB = -100.0f,
+        };
+        MelDump dump = {
+            .mel = mel_extractor_new(&mel_cfg),
+            .want_mfcc = mfcc,
+        };
+        if (!mel_extractor_ok(&dump.mel)) {
+            fprintf(stderr, "oom\n");
+            return 1;
+        }
+
+        offline_analyze(&audio, &cfg, write_mel, &dump);
+        mel_extractor_free(&dump.mel);
+        mono_audio_free(&audio);
+        return 0;
+    }
+
+    Image img = {
+        .power_reference = 0.25f * (float)(cfg.size * cfg.size),
+    };
+    if (cached) {
+        analyze_cached(&audio, &cfg, av[2], &img);
+    } else {
+        offline_analyze(&audio, &cfg, push_column, &img);
+    }
+    mono_audio_free(&audio);
 
-    struct MonoAudioBuffer audio = decode_wav_or_exit(input);
-    (void)audio;
+    write_pgm(&img, stdout);
+    free(img.pixels);
 
-    printf("ok\n");
     return 0;
 }
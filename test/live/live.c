@@ -0,0 +1,135 @@
+// nanosleep is POSIX, not C11
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "LockFreeQueue.h"
+
+#include "FFTAnalyzer.h"
+#include "LatencyTracker.h"
+#include "audio_callback.h"
+#include "capture/LiveInput.h"
+#include "core/definitions.h"
+#include "trace/clock.h"
+
+// how often the queue is drained, well under a period at any rate
+#define POLL_NS 500000ull
+
+static void usage_and_exit(void)
+{
+    fprintf(stderr,
+            "Usage: live <default|null|loopback> [seconds] "
+            "[--period <frames>]\n");
+    exit(1);
+}
+
+int main(int ac, char* av[])
+{
+    if (ac < 2) {
+        usage_and_exit();
+    }
+    LiveInputConfig input_cfg = {
+        .source = live_input_source_from_name(av[1]),
+        .period_frames = LIVE_INPUT_DEFAULT_PERIOD,
+    };
+    double seconds = 3.0;
+    for (int i = 2; i < ac; ++i) {
+        if (strcmp(av[i], "--period") == 0 && i + 1 < ac) {
+            const long frames = strtol(av[++i], NULL, 10);
+            if (frames < LIVE_INPUT_MIN_PERIOD ||
+                frames > LIVE_INPUT_MAX_PERIOD) {
+                usage_and_exit();
+            }
+            input_cfg.period_frames = (uint32_t)frames;
+        } else {
+            seconds = strtod(av[i], NULL);
+        }
+    }
+    if (input_cfg.source == LIVE_INPUT_COUNT || !(seconds > 0.0)) {
+        usage_and_exit();
+    }
+
+    LockFreeQueue* queue = malloc(sizeof(*queue));
+    if (queue == NULL) {
+        fprintf(stderr, "oom\n");
+        return 1;
+    }
+    clfq_new(queue);
+    LockFreeQueueProducer tx = clfq_producer(queue);
+    init_audio_processor(&tx);
+
+    LiveInput* input = live_input_new(&input_cfg);
+    if (input == NULL) {
+        fprintf(stderr, "failed to open the %s input\n", av[1]);
+        return 1;
+    }
+    const uint32_t sample_rate = live_input_sample_rate(input);
+    const uint32_t period = live_input_period(input);
+    const char* backend = live_input_backend(input);
+
+    const FFTConfig cfg = {
+        .size = FFT_SIZE,
+        .stride = FFT_SIZE / 2,
+        .dc_blocker_frequency = 10.0f,
+        .history_size = HISTORY_SIZE,
+        .sample_rate = (float)sample_rate,
+        .decimation = fft_decimation_for((float)sample_rate),
+    };
+    FFTAnalyzer analyzer = fft_analyzer_new(&cfg, clfq_consumer(queue));
+    LatencyTracker* latency =
+        latency_tracker_new(cfg.stride * cfg.decimation, NULL);
+    if (!fft_analyzer_ok(&analyzer) || latency == NULL) {
+        fprintf(stderr, "oom\n");
+        return 1;
+    }
+    attach_latency_tracker(latency);
+
+    if (!live_input_start(input)) {
+        fprintf(stderr, "failed to start the %s input\n", av[1]);
+        return 1;
+    }
+
+    // the app's loop with nothing to draw: analysis is all that's timed
+    const uint64_t start_ns = clock_now_ns();
+    const uint64_t end_ns = start_ns + (uint64_t)(seconds * 1e9);
+    const struct timespec poll = {.tv_sec = 0, .tv_nsec = (long)POLL_NS};
+    while (clock_now_ns() < end_ns) {
+        const uint64_t frames_before = analyzer.frames;
+        const SizeType rows = fft_analyzer_update(&analyzer);
+        latency_tracker_on_analyzed(
+            latency, (SizeType)(analyzer.frames - frames_before), rows, 0);
+        latency_tracker_on_columns(latency, rows, 0);
+        latency_tracker_on_present(latency);
+        nanosleep(&poll, NULL);
+    }
+    const double wall_s = (double)(clock_now_ns() - start_ns) * 1e-9;
+
+    // stops the callback before anything it uses goes away
+    live_input_free(input);
+    deinit_audio_processor();
+
+    const LatencyReport* report = latency_tracker_report(latency);
+    const double audio_s = (double)analyzer.frames * (double)cfg.stride *
+                           (double)cfg.decimation / (double)sample_rate;
+    printf("input:          %s (%s)\n",
+           live_input_source_name(input_cfg.source), backend);
+    printf("sample rate:    %u Hz\n", sample_rate);
+    printf("period:         %u frames\n", period);
+    printf("fft frames:     %llu\n", (unsigned long long)analyzer.frames);
+    printf("audio:          %.3f s in %.3f s\n", audio_s, wall_s);
+    printf("analysis ms:    p50 %.2f  p95 %.2f  p99 %.2f\n",
+           (double)report->p50_ms[LATENCY_ANALYSIS],
+           (double)report->p95_ms[LATENCY_ANALYSIS],
+           (double)report->p99_ms[LATENCY_ANALYSIS]);
+
+    const int status = analyzer.frames > 0 ? 0 : 1;
+    fft_analyzer_free(&analyzer);
+    latency_tracker_free(latency);
+    free(queue);
+
+    return status;
+}
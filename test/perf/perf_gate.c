@@ -0,0 +1,302 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include "common/offline.h"
+#include "core/colormap/colormap.h"
+#include "core/intensity.h"
+#include "trace/clock.h"
+
+// end-to-end regression gate: decode, analyze and colour-map one file with
+// one FFT preset, then compare against the matching line of the baseline
+//
+// - a coarse fingerprint of the spectrogram must match the golden one, in
+//   every build type. it is a grid of mean intensities rather than a hash:
+//   kissfft is built with -ffast-math, so bins differ in the last ulp from one
+//   compiler or optimization level to the next
+// - realtime factor and peak RSS are only gated in Release builds, Debug
+//   numbers (sanitizers, -O1) are printed but meaningless
+
+#if !defined(PERF_GATE_BUILD_TYPE)
+#define PERF_GATE_BUILD_TYPE "unknown"
+#endif
+
+#define N_RUNS 3  // best-of, for the realtime factor
+#define DEFAULT_TOLERANCE 0.25f
+
+#define GRID 16  // fingerprint is GRID time blocks * GRID frequency bands
+#define FINGERPRINT_SIZE (GRID * GRID)
+#define FINGERPRINT_TOLERANCE 2  // in 1/255 of full scale, per cell
+
+typedef struct {
+    const char* name;
+    SizeType size;
+    SizeType stride;
+} Preset;
+
+static const Preset presets[] = {
+    {.name = "fft1024", .size = 1024, .stride = 512},
+    {.name = "fft2048", .size = 2048, .stride = 1024},
+    {.name = "fft8192", .size = 8192, .stride = 2048},
+};
+
+typedef struct {
+    uint8_t (*pixels)[4];
+    float power_reference;
+
+    // GRID band means per frame, reduced over time once the length is known
+    float* bands;
+    uint64_t n_frames;
+    uint64_t cap_frames;
+} ColorPass;
+
+// the per-column work of LinearSpectrogram, minus the upload
+static void color_row(const Complex* bins, SizeType n_bins, void* ctx)
+{
+    ColorPass* pass = ctx;
+
+    if (pass->n_frames == pass->cap_frames) {
+        pass->cap_frames = (pass->cap_frames == 0) ? 256 : 2 * pass->cap_frames;
+        pass->bands =
+            realloc(pass->bands, pass->cap_frames * GRID * sizeof(float));
+        if (pass->bands == NULL) {
+            fprintf(stderr, "oom\n");
+            exit(1);
+        }
+    }
+    float* bands = pass->bands + pass->n_frames * GRID;
+    for (SizeType g = 0; g < GRID; ++g) {
+        bands[g] = 0.0f;
+    }
+
+    for (SizeType b = 0; b < n_bins; ++b) {
+        const float intensity =
+            intensity_from_bin(bins[b], pass->power_reference, -60.0f);
+        memcpy(pass->pixels[b], colormap_sample(plasma_rgba, intensity), 4);
+        bands[(uint64_t)b * GRID / n_bins] += intensity;
+    }
+
+    for (SizeType g = 0; g < GRID; ++g) {
+        bands[g] *= (float)GRID / (float)n_bins;
+    }
+    pass->n_frames++;
+}
+
+// mean intensity per (time block, band) cell, scaled to a byte
+static void fingerprint(const ColorPass* pass, uint8_t out[FINGERPRINT_SIZE])
+{
+    float sums[FINGERPRINT_SIZE] = {0};
+    uint64_t counts[GRID] = {0};
+
+    for (uint64_t t = 0; t < pass->n_frames; ++t) {
+        const uint64_t block = t * GRID / pass->n_frames;
+        for (SizeType g = 0; g < GRID; ++g) {
+            sums[block * GRID + g] += pass->bands[t * GRID + g];
+        }
+        counts[block]++;
+    }
+
+    for (SizeType i = 0; i < FINGERPRINT_SIZE; ++i) {
+        const uint64_t n = counts[i / GRID];
+        const float mean = (n == 0) ? 0.0f : sums[i] / (float)n;
+        out[i] = (uint8_t)(255.0f * mean + 0.5f);
+    }
+}
+
+static uint64_t peak_rss_kib(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return (uint64_t)usage.ru_maxrss / 1024;  // bytes on macOS
+#else
+    return (uint64_t)usage.ru_maxrss;
+#endif
+}
+
+static const char* basename_of(const char* path)
+{
+    const char* slash = strrchr(path, '/');
+    return (slash != NULL) ? slash + 1 : path;
+}
+
+typedef struct {
+    float min_realtime;
+    uint64_t max_rss_kib;
+    uint8_t fingerprint[FINGERPRINT_SIZE];
+} Baseline;
+
+static bool parse_hex(const char* hex, uint8_t* out, SizeType n)
+{
+    if (strlen(hex) != 2 * (size_t)n) {
+        return false;
+    }
+    for (SizeType i = 0; i < n; ++i) {
+        unsigned byte;
+        if (sscanf(hex + 2 * i, "%2x", &byte) != 1) {
+            return false;
+        }
+        out[i] = (uint8_t)byte;
+    }
+    return true;
+}
+
+// baseline lines are `<file> <preset> <realtime> <rss KiB> <fingerprint>`
+static bool find_baseline(const char* path,
+                          const char* file,
+                          const char* preset,
+                          Baseline* out)
+{
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "failed to open baseline %s\n", path);
+        return false;
+    }
+
+    char line[1024];
+    bool found = false;
+    while (!found && fgets(line, sizeof(line), f) != NULL) {
+        char line_file[128];
+        char line_preset[32];
+        char hex[2 * FINGERPRINT_SIZE + 1];
+        unsigned long long rss;
+        float realtime;
+
+        if (line[0] == '#') {
+            continue;
+        }
+        const int n = sscanf(line, "%127s %31s %f %llu %512s", line_file,
+                             line_preset, &realtime, &rss, hex);
+        if (n == 5 && strcmp(line_file, file) == 0 &&
+            strcmp(line_preset, preset) == 0) {
+            out->min_realtime = realtime;
+            out->max_rss_kib = rss;
+            found = parse_hex(hex, out->fingerprint, FINGERPRINT_SIZE);
+        }
+    }
+
+    fclose(f);
+    return found;
+}
+
+static float tolerance_from_env(void)
+{
+    const char* s = getenv("SPECTRE_PERF_TOLERANCE");
+    if (s == NULL) {
+        return DEFAULT_TOLERANCE;
+    }
+    return strtof(s, NULL);
+}
+
+int main(int ac, char* av[])
+{
+    if (ac != 4) {
+        fprintf(stderr, "Usage: perf_gate <input audio> <preset> <baseline>\n");
+        return 1;
+    }
+
+    const Preset* preset = NULL;
+    for (size_t i = 0; i < sizeof(presets) / sizeof(*presets); ++i) {
+        if (strcmp(presets[i].name, av[2]) == 0) {
+            preset = &presets[i];
+        }
+    }
+    if (preset == NULL) {
+        fprintf(stderr, "unknown preset %s\n", av[2]);
+        return 1;
+    }
+
+    MonoAudioBuffer audio = decode_wav_or_exit(av[1]);
+    const float audio_seconds =
+        (float)audio.size / (float)audio.sample_rate;
+
+    const FFTConfig cfg = {
+        .size = preset->size,
+        .stride = preset->stride,
+        .dc_blocker_frequency = 10.0f,
+        .history_size = 64,  // rows are consumed as soon as they are pushed
+        .sample_rate = (float)audio.sample_rate,
+    };
+
+    ColorPass pass = {
+        .pixels = malloc(4 * (size_t)(cfg.size / 2)),
+        .power_reference = 0.25f * (float)(cfg.size * cfg.size),
+    };
+    if (pass.pixels == NULL) {
+        fprintf(stderr, "oom\n");
+        return 1;
+    }
+
+    uint8_t print[FINGERPRINT_SIZE];
+    float realtime = 0.0f;
+    for (int run = 0; run < N_RUNS; ++run) {
+        pass.n_frames = 0;
+
+        const uint64_t t0 = clock_now_ns();
+        offline_analyze(&audio, &cfg, color_row, &pass);
+        const uint64_t elapsed = clock_now_ns() - t0;
+
+        const float rtf = audio_seconds / ((float)elapsed * 1e-9f);
+        realtime = (rtf > realtime) ? rtf : realtime;
+    }
+    fingerprint(&pass, print);
+    free(pass.pixels);
+    free(pass.bands);
+    mono_audio_free(&audio);
+
+    const uint64_t rss = peak_rss_kib();
+    const char* file = basename_of(av[1]);
+
+    // in the baseline format, for when the numbers legitimately move
+    printf("measured: %s %s %.1f %llu ", file, preset->name, (double)realtime,
+           (unsigned long long)rss);
+    for (SizeType i = 0; i < FINGERPRINT_SIZE; ++i) {
+        printf("%02x", print[i]);
+    }
+    printf("\n");
+
+    Baseline baseline;
+    if (!find_baseline(av[3], file, preset->name, &baseline)) {
+        fprintf(stderr, "no baseline for %s %s\n", file, preset->name);
+        return 1;
+    }
+
+    bool ok = true;
+    for (SizeType i = 0; i < FINGERPRINT_SIZE; ++i) {
+        const int diff = abs((int)print[i] - (int)baseline.fingerprint[i]);
+        if (diff > FINGERPRINT_TOLERANCE) {
+            fprintf(stderr,
+                    "FAIL spectrogram differs from golden output at time "
+                    "block %u, band %u: %u, expected %u\n",
+                    i / GRID, i % GRID, print[i], baseline.fingerprint[i]);
+            ok = false;
+            break;
+        }
+    }
+
+    if (strcmp(PERF_GATE_BUILD_TYPE, "Release") != 0) {
+        printf("%s build: realtime factor and RSS not gated\n",
+               PERF_GATE_BUILD_TYPE);
+        return ok ? 0 : 1;
+    }
+
+    const float tolerance = tolerance_from_env();
+    const float min_realtime = baseline.min_realtime * (1.0f - tolerance);
+    const float max_rss = (float)baseline.max_rss_kib * (1.0f + tolerance);
+
+    if (realtime < min_realtime) {
+        fprintf(stderr, "FAIL realtime factor %.1fx, expected at least %.1fx\n",
+                (double)realtime, (double)min_realtime);
+        ok = false;
+    }
+    if ((float)rss > max_rss) {
+        fprintf(stderr, "FAIL peak RSS %llu KiB, expected at most %.0f KiB\n",
+                (unsigned long long)rss, (double)max_rss);
+        ok = false;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+// nanosleep is POSIX, not C11
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "LockFreeQueue.h"
+
+#include "FFTAnalyzer.h"
+#include "audio_callback.h"
+#include "capture/CaptureReplayer.h"
+#include "core/definitions.h"
+#include "trace/clock.h"
+
+// FNV-1a, enough to tell two runs apart
+static uint64_t hash_bytes(uint64_t h, const void* data, size_t size)
+{
+    const uint8_t* bytes = data;
+    for (size_t i = 0; i < size; ++i) {
+        h = (h ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return h;
+}
+
+static void sleep_until(uint64_t deadline_ns)
+{
+    const uint64_t now = clock_now_ns();
+    if (deadline_ns <= now) {
+        return;
+    }
+    const uint64_t dt = deadline_ns - now;
+    const struct timespec ts = {
+        .tv_sec = (time_t)(dt / 1000000000ull),
+        .tv_nsec = (long)(dt % 1000000000ull),
+    };
+    nanosleep(&ts, NULL);
+}
+
+// hashes the rows pushed by the last update, oldest first
+static uint64_t hash_new_rows(uint64_t h, const FFTHistory* history, SizeType n)
+{
+    n = (n >= history->cap) ? history->cap : n;
+    const SizeType start = (history->tail - n + history->cap) % history->cap;
+
+    for (SizeType i = 0; i < n; i++) {
+        const Complex* row =
+            fft_history_get_row(history, (start + i) % history->cap);
+        h = hash_bytes(h, row, history->n_bins * sizeof(*row));
+    }
+    return h;
+}
+
+int main(int ac, char* av[])
+{
+    const bool paced = (ac == 3 && strcmp(av[2], "--paced") == 0);
+    if (ac != 2 && !paced) {
+        fprintf(stderr, "Usage: replay <capture> [--paced]\n");
+        return 1;
+    }
+
+    CaptureReplayer replayer = capture_replayer_new(av[1]);
+    if (!capture_replayer_ok(&replayer)) {
+        fprintf(stderr, "failed to open capture %s\n", av[1]);
+        return 1;
+    }
+
+    LockFreeQueue* queue = malloc(sizeof(*queue));
+    if (queue == NULL) {
+        fprintf(stderr, "oom\n");
+        return 1;
+    }
+    clfq_new(queue);
+    LockFreeQueueProducer tx = clfq_producer(queue);
+    init_audio_processor(&tx);
+
+    const FFTConfig cfg = {
+        .size = FFT_SIZE,
+        .stride = FFT_SIZE / 2,
+        .dc_blocker_frequency = 10.0f,
+        .history_size = HISTORY_SIZE,
+        .sample_rate = (float)replayer.sample_rate,
+        .decimation = fft_decimation_for((float)replayer.sample_rate),
+    };
+    FFTAnalyzer analyzer = fft_analyzer_new(&cfg, clfq_consumer(queue));
+    if (!fft_analyzer_ok(&analyzer)) {
+        fprintf(stderr, "oom\n");
+        return 1;
+    }
+
+    uint64_t hash = 0xcbf29ce484222325ull;
+    uint64_t n_blocks = 0;
+    uint64_t n_samples = 0;
+    uint64_t n_frames = 0;
+
+    // same interleaving as the app: one callback, then one analyzer update
+    const uint64_t start_ns = clock_now_ns();
+    CaptureBlock block;
+    while (capture_replayer_next(&replayer, UINT64_MAX, &block)) {
+        if (paced) {
+            sleep_until(start_ns + block.t_ns);
+        }
+        pull_samples_from_audio_thread(block.samples, block.frames);
+        const SizeType processed = fft_analyzer_update(&analyzer);
+        hash = hash_new_rows(hash, &analyzer.history, processed);
+
+        ++n_blocks;
+        n_samples += block.frames;
+        n_frames += processed;
+    }
+    const uint64_t elapsed_ns = clock_now_ns() - start_ns;
+
+    const double audio_s = (double)n_samples / (double)replayer.sample_rate;
+    const double wall_s = (double)elapsed_ns * 1e-9;
+    printf("blocks:         %llu\n", (unsigned long long)n_blocks);
+    printf("audio:          %.3f s\n", audio_s);
+    printf("fft frames:     %llu\n", (unsigned long long)n_frames);
+    printf("wall:           %.3f s\n", wall_s);
+    printf("realtime:       %.1fx\n", audio_s / wall_s);
+    printf("hash:           %016llx\n", (unsigned long long)hash);
+
+    deinit_audio_processor();
+    fft_analyzer_free(&analyzer);
+    capture_replayer_free(&replayer);
+    free(queue);
+
+    return 0;
+}
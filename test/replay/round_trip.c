@@ -0,0 +1,128 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "LockFreeQueue.h"
+
+#include "audio_callback.h"
+#include "capture/CaptureRecorder.h"
+#include "capture/CaptureReplayer.h"
+#include "core/definitions.h"
+
+// records a few blocks of interleaved stereo, replays them and checks that
+// every sample comes back bit for bit, then again through the audio callback
+// into the sample queue; a mono capture has to be turned down, the callback
+// reads two floats a frame
+
+#define N_BLOCKS 3
+#define MAX_FRAMES 512
+#define SAMPLE_RATE 48000u
+
+static const SizeType s_frames[N_BLOCKS] = {300, MAX_FRAMES, 77};
+
+static float block_sample(SizeType block, SizeType i)
+{
+    return (float)((block * 7919u + i * 104729u) % 2001u) / 1000.0f - 1.0f;
+}
+
+static bool record(const char* path, uint32_t channels)
+{
+    CaptureRecorder* rec = capture_recorder_new(path, SAMPLE_RATE, channels);
+    if (rec == NULL) {
+        return false;
+    }
+
+    static float samples[2 * MAX_FRAMES];
+    for (SizeType b = 0; b < N_BLOCKS; ++b) {
+        for (SizeType i = 0; i < s_frames[b] * channels; ++i) {
+            samples[i] = block_sample(b, i);
+        }
+        capture_recorder_push(rec, samples, s_frames[b]);
+    }
+
+    const bool drained = capture_recorder_drain(rec);
+    capture_recorder_free(rec);
+    return drained;
+}
+
+static int fail(const char* what)
+{
+    fprintf(stderr, "round trip: %s\n", what);
+    return 1;
+}
+
+int main(int ac, char* av[])
+{
+    if (ac != 2) {
+        fprintf(stderr, "Usage: round_trip <capture>\n");
+        return 1;
+    }
+    const char* path = av[1];
+
+    if (!record(path, 1)) {
+        return fail("could not record the mono capture");
+    }
+    CaptureReplayer mono = capture_replayer_new(path);
+    if (capture_replayer_ok(&mono)) {
+        return fail("a mono capture was accepted");
+    }
+
+    // left where it is, for the replay test to run on
+    if (!record(path, 2)) {
+        return fail("could not record the stereo capture");
+    }
+    CaptureReplayer rp = capture_replayer_new(path);
+    if (!capture_replayer_ok(&rp)) {
+        return fail("could not open the stereo capture");
+    }
+    if (rp.sample_rate != SAMPLE_RATE || rp.channels != 2) {
+        return fail("wrong header");
+    }
+
+    LockFreeQueue* queue = malloc(sizeof(*queue));
+    if (queue == NULL) {
+        return fail("oom");
+    }
+    clfq_new(queue);
+    LockFreeQueueProducer tx = clfq_producer(queue);
+    LockFreeQueueConsumer rx = clfq_consumer(queue);
+    init_audio_processor(&tx);
+
+    static float mid[MAX_FRAMES];
+    CaptureBlock block;
+    SizeType b = 0;
+    for (; capture_replayer_next(&rp, UINT64_MAX, &block); ++b) {
+        if (b == N_BLOCKS || block.frames != s_frames[b]) {
+            return fail("wrong blocks");
+        }
+        for (SizeType i = 0; i < 2 * block.frames; ++i) {
+            if (block.samples[i] != block_sample(b, i)) {
+                return fail("samples differ");
+            }
+        }
+
+        pull_samples_from_audio_thread(block.samples, block.frames);
+        if (!clfq_pop(&rx, mid, block.frames)) {
+            return fail("the callback pushed too few samples");
+        }
+        for (SizeType i = 0; i < block.frames; ++i) {
+            const float expected = 0.5f * (block_sample(b, 2 * i) +
+                                           block_sample(b, 2 * i + 1));
+            if (mid[i] != expected) {
+                return fail("the callback's samples differ");
+            }
+        }
+    }
+    if (b != N_BLOCKS || !capture_replayer_done(&rp)) {
+        return fail("blocks missing");
+    }
+
+    deinit_audio_processor();
+    capture_replayer_free(&rp);
+    free(queue);
+
+    printf("round trip: %u blocks\n", (unsigned)N_BLOCKS);
+    return 0;
+}